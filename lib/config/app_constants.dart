@@ -208,10 +208,23 @@ class AppConstants {
   static const int kPauseSegmentThresholdCount = 15;
   /// 预分段：累计音频至少多少秒才允许分段（避免过短分段降低识别质量）
   static const double kPreSegmentMinDurationSec = 30.0;
-  /// 录音停止后等待 ASR 处理最后数据的延迟 (ms)
+  /// 边说边加标点：每段带上前文最后这么多个字一起送进标点模型（段首不当句首），结果里再去掉
+  static const int kPunctuationContextChars = 16;
+  /// 录音停止后等待 ASR 处理最后数据的延迟 (ms)。
+  /// 只给没有 drain 的平台用（见 NativeInputBase.canDrainAudio）：能 drain 的
+  /// 平台由 native 报出确切的结束位置，不用盲等。
   static const int kEngineShutdownDelayMs = 200;
+  /// 停止时等 native 把在途的最后一块收进 ring 的上限（ms）。一块 20ms，
+  /// 正常几十毫秒内返回；设备卡住时到点按已收到的算。
+  static const int kAudioDrainTimeoutMs = 200;
   /// 离线模型录音时长提醒阈值 (秒)，超过后提示用户效果可能下降
   static const int kOfflineModelDurationWarningSeconds = 30;
+  /// 有固定输入窗口的离线模型（[ModelInfo.type] → 秒）：Whisper 编码器只看 30 秒，
+  /// 更长的音频会被截掉或越往后越乱，Moonshine 同样按 30 秒以内训练。
+  /// 这些模型每次解码都按 DecodeWindowPlanner 切成不超过这个长度的窗口
+  static const Map<String, double> kOfflineDecodeWindowSec = {'whisper': 30.0, 'moonshine': 30.0};
+  /// 相邻解码窗口的重叠（秒）：切点落在说话中间时，两边都认得出的字靠它对齐去重
+  static const double kDecodeWindowOverlapSec = 1.0;
   /// ASR provider stop() 超时，云端识别可能需要较长时间
   static const Duration kAsrStopTimeout = Duration(seconds: 6);
   /// provider 的 `stop()` **内部**总等待上限（等握手 + 等服务端收尾帧）。
@@ -220,6 +233,52 @@ class AppConstants {
   /// 超时回调返回的是**空文本**。内层不留余量的话，引擎先放弃，
   /// provider 好不容易攒下的部分文本一起被丢掉 —— 用户看到的是「一个字都没有」。
   static const Duration kAsrFinalFrameWait = Duration(seconds: 4);
+  /// 常驻麦克风：按键时拼进录音开头的 pre-roll 长度（ms，native 上限 2000）
+  static const int kWarmMicPrerollMs = 500;
+  /// 采集降噪每 20ms 一块的 CPU 预算。实测一块二三十微秒，连续超过这个数说明机器
+  /// 已经被别的东西占满了 —— native 转旁路，采集线程不能因为降噪跟不上而丢块
+  static const Duration kNoiseSuppressionBudget = Duration(microseconds: 2000);
+  /// 采集自动增益：说话段帧 RMS 的目标（dBFS）和最多放大多少（dB）。
+  /// -20 大致是近讲麦克风正常说话的电平；30dB 够把远场笔记本麦克风上的轻声拉上来，
+  /// 再大底噪就比字还响了
+  static const int kAutoGainTargetDbfs = -20;
+  static const int kAutoGainMaxGainDb = 30;
+  /// 开发者模式下随调试录音一起存的增益轨迹帧数（10ms 一帧，和 native ring 一样 30 秒）
+  static const int kAutoGainTraceFrames = 3000;
+  /// 停顿压缩：连续静音超过 [kSilenceCompactMinMs] 的停顿压到 [kSilenceCompactKeepMs]
+  /// （一半留在停顿开头、一半留在下一句之前）。1 秒以内的停顿多半是句中换气、找词，
+  /// 模型靠它断句，不动；留 300ms 字尾、起音都还在，模型也还看得出这里断了一句
+  static const int kSilenceCompactMinMs = 1000;
+  static const int kSilenceCompactKeepMs = 300;
+  /// 停顿压缩只给这些 provider（[ASRProvider.type]）：整段解码 / 整段上传，结果不依赖停顿时长。
+  /// 流式的字幕是实时显示的，压了就和说话对不上
+  static const Set<String> kSilenceCompactProviders = {'local_sherpa_offline', 'openai_asr'};
+  /// 常驻麦克风：不录音累计多久自动释放设备（隐私 / 省电），下次录完再挂上
+  static const Duration kWarmMicIdleRelease = Duration(minutes: 10);
+  /// 云端 + 本地竞速（RacingASRProvider）：松键后云端结果最多等多久，过点就用本地结果。
+  ///
+  /// 云端平时 300~800ms 就回来，偶发的 3~5 秒长尾才是要挡的；本地模型松键时
+  /// 基本已解完。等得太短会在网络正常时也频繁落到准确率更低的本地结果上。
+  static const Duration kAsrRaceCloudDeadline = Duration(milliseconds: 1500);
+  /// 延迟追踪（LatencyTracer）保留最近多少次听写，开发者页导出的就是这些
+  static const int kLatencyTraceSessions = 20;
+  /// 单次听写最多记多少个事件。打字机每批一条，长段落流式润色能上百批；
+  /// 超出的丢掉并计数，不让一次异常长的会话把内存吃掉。
+  static const int kLatencyTraceMaxEvents = 512;
+  /// native 按键时刻离 Dart 收到回调超过这么久就不认：那不是触发这次录音的按键
+  /// （界面按钮、看门狗、切换模式超时都会在没有按键的情况下开始/结束录音）
+  static const Duration kLatencyTraceKeyWindow = Duration(seconds: 1);
+  /// UI 帧预算（60Hz）。录音期间 build 或 raster 超过它的帧计为掉帧，写进延迟追踪
+  static const Duration kLatencyTraceFrameBudget = Duration(microseconds: 16667);
+  /// 本地流式模型的热词加分（sherpa 默认 1.5）。再高会把发音相近的普通词也拉成术语
+  static const double kHotwordsScore = 1.5;
+  /// 流式云端 ASR 预热连接的最长闲置时间。
+  /// 服务端对「连上不发音频」有超时（腾讯约 15 秒），要留出余量，否则拿到的是死连接
+  static const Duration kAsrWarmIdleTimeout = Duration(seconds: 10);
+  /// 备用连接闲置到点后换一条新的继续备着，最多续到上次用连接之后这么久。
+  /// 「说一句、停一会、再说」的间隔常超过 [kAsrWarmIdleTimeout]，只备一条的话
+  /// 第二句照样现连；一直续下去又等于每 10 秒白做一次 TLS 握手
+  static const Duration kAsrWarmKeepAlive = Duration(minutes: 2);
   /// 失败响应体展示给用户时的截断长度（网关的 HTML 错误页可能有几千字）
   static const int kHttpErrorBodyMaxChars = 200;
   /// 错误信息在悬浮窗显示的持续时间
@@ -241,6 +300,12 @@ class AppConstants {
   static const double kLlmDefaultTemperature = 0.3;
   /// LLM 严格模式温度（意图路由，需要确定性输出）
   static const double kLlmStrictTemperature = 0.1;
+  /// 润色结果缓存：条目上限（LRU 淘汰）
+  static const int kLlmCacheMaxEntries = 500;
+  /// 润色结果缓存：过期时间。改了 prompt/模型会换 key，这里只防「很久以前的结果」
+  static const Duration kLlmCacheTtl = Duration(days: 7);
+  /// 只缓存短句（规整后字数）。长段口述几乎不会重复，缓存只会把原文堆在磁盘上
+  static const int kLlmCacheMaxInputChars = 64;
   /// Anthropic API 最大输出 token 数
   static const int kAnthropicMaxTokens = 1024;
   /// Anthropic API 版本号
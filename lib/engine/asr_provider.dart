@@ -1,7 +1,21 @@
 import 'dart:typed_data';
 import 'asr_result.dart';
+import 'pcm16.dart';
 import '../config/app_constants.dart';
 
+/// provider 希望 CoreEngine 喂进来的音频格式，见 [ASRProvider.preferredFormat]
+enum AudioSampleFormat {
+  /// 16kHz mono Float32，经 [ASRProvider.acceptWaveform]（本地 Sherpa 模型）
+  float32,
+
+  /// 16kHz mono int16 little-endian 原始字节，经 [ASRProvider.acceptPcm16]（云端上传）
+  pcm16,
+
+  /// 原生编码器压缩过的 FLAC 流，经 [ASRProvider.acceptEncoded]（接受压缩格式的云端上传）。
+  /// 当前平台没有原生编码器时 Core 退回 [pcm16]。
+  flac,
+}
+
 /// Abstract interface for ASR (Automatic Speech Recognition) Providers
 ///
 /// Designed to decouple CoreEngine from specific implementations (Sherpa/Aliyun).
@@ -22,6 +36,28 @@ abstract class ASRProvider {
   /// [samples] 16kHz Mono Float32 PCM
   void acceptWaveform(Float32List samples);
 
+  /// 希望 Core 以哪种格式喂音频。
+  ///
+  /// 原生采集的是 int16，云端上传的也是 int16：原先 Core 先转成 Float32，
+  /// 云端 provider 再逐样本转回 int16，每 50ms 一块白分配两个缓冲，
+  /// 还多一次有损往返（32767 → 32766）。声明 [AudioSampleFormat.pcm16] 的
+  /// provider 由 Core 直接调 [acceptPcm16]，拿到的就是原生采集的字节。
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.float32;
+
+  /// Feed raw audio bytes: 16kHz mono int16 little-endian.
+  ///
+  /// [pcm] 的所有权交给 provider（Core 每次给新缓冲，之后不再写）——
+  /// 可以直接放进待发队列或原样发出，不必再拷贝。
+  void acceptPcm16(Uint8List pcm) => acceptWaveform(pcm16ToFloat32(pcm));
+
+  /// Feed compressed audio bytes（[preferredFormat] 为 [AudioSampleFormat.flac] 时）。
+  ///
+  /// 多次调用的字节是同一条连续的流：第一块带文件头，按顺序拼起来就是完整文件。
+  /// 所有权同 [acceptPcm16]。Core 只在原生编码器可用时走这条路，否则照旧调
+  /// [acceptPcm16] —— 声明 flac 的 provider 两条路都得能收，但同一会话只会走一条。
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
   /// Stop recognition and return the final ASR result (text + optional tokens/confidence)
   Future<ASRResult> stop();
 
@@ -3,7 +3,7 @@ import 'dart:io';
 import 'dart:ffi' as ffi;
 import 'package:ffi/ffi.dart' as pkg_ffi;
 import 'package:flutter/foundation.dart';
-import 'package:sherpa_onnx/sherpa_onnx.dart' as sherpa;
+import 'package:flutter/scheduler.dart';
 import '../ffi/native_input_base.dart';
 import '../ffi/native_input_factory.dart';
 import '../config/app_constants.dart';
@@ -15,10 +15,19 @@ import '../services/notification_service.dart';
 import 'engine_status.dart';
 import 'asr_provider.dart';
 import 'asr_result.dart';
+import 'dictation_pipeline.dart';
+import 'latency_trace.dart';
+import 'native_audio_encoder.dart';
+import 'native_silence_compactor.dart';
+import 'pcm16.dart';
 import 'providers/sherpa_provider.dart';
 import 'providers/offline_sherpa_provider.dart';
+import 'speculative_correction.dart';
+import 'speculative_punctuation.dart';
+import 'punctuation_worker.dart';
 import 'providers/aliyun_provider.dart';
 import 'providers/asr_provider_factory.dart';
+import 'providers/racing_asr_provider.dart';
 import '../config/cloud_providers.dart';
 import '../services/cloud_account_service.dart';
 import '../services/diary_service.dart';
@@ -44,6 +53,11 @@ class CoreEngine {
   late final NativeInputBase? _nativeInput;
   Timer? _audioPollTimer;
   ffi.Pointer<ffi.Int16>? _pollBuffer;  // Reusable buffer for polling
+  NativeAudioEncoder? _audioEncoder;    // 本次录音的压缩编码（provider 要 FLAC 且平台支持时）
+  NativeSilenceCompactor? _silenceCompactor; // 本次录音的停顿压缩（整段解码 / 整段上传的 provider）
+  SilenceOffsetMap? _silenceOffsetMap;  // 上次录音压掉的停顿，识别结果的时间戳据此映射回去
+  double _silenceRemovedSec = 0;        // 上次录音压掉的秒数（含结尾那段，对照点里没有它）
+  int _audioSamplesRead = 0;            // 本次录音已从 ring 读出的样本数（drain 对齐结束位置用）
   static const int _pollBufferSamples = AppConstants.kAudioPollBufferSamples;
   
   // Audio Device Management
@@ -75,6 +89,15 @@ class CoreEngine {
   DateTime? _lastSilenceNotify;
   int _pauseSegmentPollCount = 0; // Pre-segment: consecutive silence polls
 
+  /// 边说边润色：离线模型每解出一段预分段就送 LLM，松键后只补最后一段
+  SpeculativeCorrector? _speculative;
+  StreamSubscription<String>? _speculativeSub;
+
+  /// 边说边加标点：离线预分段 / 流式长停顿前的字幕在说话期间就送标点 worker
+  SpeculativePunctuator? _speculativePunct;
+  StreamSubscription<String>? _speculativePunctSub;
+  String _latestPartial = ''; // 本地模型最近一次字幕（流式按停顿切段用）
+
   // Recording state machine (replaces _isRecording, _isStopping, _audioStarted, _isDiaryMode)
   RecordingState _recordingState = RecordingState.idle;
 
@@ -156,19 +179,34 @@ class CoreEngine {
       _recordingState == RecordingState.stopping;
   RecordingMode _recordingMode = RecordingMode.ptt;
   bool _audioStarted = false; // hardware-level flag: native audio is running
+  /// 本次由 native 线程直接从 ring 解码（SherpaProvider.startNativeDecode），Dart 不轮询 ring
+  bool _nativeDecoding = false;
+  /// native 采集降噪开着（[applyNoiseSuppression] 最近一次设成功的值）
+  bool _noiseSuppressing = false;
+
+  /// native 采集自动增益开着（[applyAutoGain] 最近一次设成功的值）
+  bool _autoGaining = false;
   Future<void>? _recordingStartInFlight;
   Future<void>? _recordingStopInFlight;
 
   // Keep Offline Punctuation & Debugging related fields
-  sherpa.OfflinePunctuation? _punctuation;
+  PunctuationWorker? _punctuationWorker; // 标点模型在 worker isolate 上（见 PunctuationWorker）
   bool _punctuationEnabled = false;
-  bool _typewriterInjected = false;
+  /// 识别完的听写在这里排队收尾，录音状态机先回 idle（见 DictationPipeline）
+  final DictationPipeline _dictationPipeline = DictationPipeline();
   DateTime? _recordingStartTime;
   bool _isOrganizing = false;
   /// 最近一次 ASR 原文（供 UI 做对比展示）
   String? lastAsrOriginal;
   /// 最近一次 LLM 润色是否成功（null=未调用，true=成功，false=失败）
   bool? lastLlmSuccess;
+  /// 最近几次听写的分阶段耗时，开发者页导出为 Chrome trace
+  final LatencyTracer latencyTrace = LatencyTracer();
+  String? _traceModel; // 当前 ASR 模型名，随每次会话记进 trace
+  bool _traceSawPartial = false;
+  TraceSpan? _traceRecordingSpan;
+  final FrameStats _traceFrames = FrameStats();
+  TimingsCallback? _frameTimingsHook;
 
   // Configuration
   int pttKeyCode = 58; 
@@ -239,7 +277,10 @@ class CoreEngine {
     }
     await _recordingStartInFlight;
     await _recordingStopInFlight;
+    // 状态早回 idle 了，前几句可能还在润色 / 存笔记 —— 等它们交完再拆
+    await _dictationPipeline.drain();
     await _stopAudioSafely();
+    releaseWarmMic();
 
     // 原生设备变化监听同样要拆：AudioDeviceService.dispose() 写得没问题，
     // 但此前全仓无人调用，退出时 native listener 和它的 NativeCallable 都不释放。
@@ -259,12 +300,14 @@ class CoreEngine {
     _toggleMaxTimer?.cancel();
     _silenceCheckTimer?.cancel();
     _stopAudioPolling();
+    _discardAudioEncoder();
+    _discardSilenceCompactor();
     if (_pollBuffer != null) {
       pkg_ffi.calloc.free(_pollBuffer!);
       _pollBuffer = null;
     }
-    _punctuation?.free();
-    _punctuation = null;
+    _punctuationWorker?.dispose();
+    _punctuationWorker = null;
     _punctuationEnabled = false;
   }
 
@@ -405,6 +448,7 @@ class CoreEngine {
             code: 'keyboard_listener_started',
           ));
           _log("Listener start success.");
+          armWarmMic();
           // Listener running = Input Monitoring OK. Now verify Accessibility separately.
           final ax = _nativeInput.checkAccessibilityPermission();
           if (ax) {
@@ -530,10 +574,22 @@ class CoreEngine {
         final asrModel = (asrModelId != null
             ? cloudProvider.asrModels.where((m) => m.id == asrModelId).firstOrNull
             : null) ?? cloudProvider.asrModels.first;
-        provider = ASRProviderFactory.create(account.providerId);
-        config = ASRProviderFactory.buildConfig(account, asrModel);
+        // 开了本地兜底且调用方带了离线模型：两路并行，云端慢过竞速期限就用本地结果。
+        // modelPath 为空（设置页切账户时没带模型）照旧单跑云端。
+        final race = ConfigService().asrLocalRaceEnabled && modelPath.isNotEmpty;
+        if (race) {
+          provider = ASRProviderFactory.createRacing(account.providerId, localOffline: isOfflineModel);
+          config = ASRProviderFactory.buildRacingConfig(
+            ASRProviderFactory.buildConfig(account, asrModel),
+            {'modelPath': modelPath, 'modelType': modelType},
+          );
+        } else {
+          provider = ASRProviderFactory.create(account.providerId);
+          config = ASRProviderFactory.buildConfig(account, asrModel);
+        }
         _isOfflineASR = !asrModel.isStreaming;
-        _log("Initializing ${cloudProvider.name} ASR (model=${asrModel.name})...");
+        _traceModel = race ? '${asrModel.name} + $modelName' : asrModel.name;
+        _log("Initializing ${cloudProvider.name} ASR (model=${asrModel.name}${race ? ', racing $modelName' : ''})...");
         _statusController.add(EngineStatus.info(
           "Connecting to ${cloudProvider.name}...",
           code: 'connecting_provider',
@@ -543,7 +599,9 @@ class CoreEngine {
         try {
           await provider.initialize(config);
           _asrProvider = provider;
+          applyNoiseSuppression();
           _asrSubscription = provider.textStream.listen((text) {
+            _tracePartial(text);
             if (!_partialTextController.isClosed) {
               _partialTextController.add(text);
             }
@@ -611,6 +669,12 @@ class CoreEngine {
         'modelPath': modelPath,
         'modelType': modelType,
       };
+      // 词库编成解码热词：术语在识别阶段就认对，而不是等 LLM 事后纠。
+      // 热词在创建识别器时固定，词库改动要到下次 initASR 才进解码器。
+      if (ConfigService().vocabEnabled && SherpaProvider.supportsHotwords(modelType)) {
+        final hotwords = await VocabService().compileHotwords(modelPath);
+        if (hotwords != null) config['hotwordsFile'] = hotwords;
+      }
       _log("Initializing Sherpa Provider (Local)...");
       _statusController.add(EngineStatus.info(
         "Loading model: $modelName...",
@@ -618,13 +682,17 @@ class CoreEngine {
         params: {'model': modelName},
       ));
     }
+    _traceModel = type == 'aliyun' ? 'Aliyun NLS' : modelName;
 
     try {
       await provider.initialize(config);
       _asrProvider = provider;
+      applyNoiseSuppression();
       
       // Forward provider's partial text to persistent hub + overlay
       _asrSubscription = provider.textStream.listen((text) {
+         _tracePartial(text);
+         _latestPartial = text;
          if (!_partialTextController.isClosed) {
             _partialTextController.add(text);
          }
@@ -707,15 +775,13 @@ class CoreEngine {
       
       if (!await File(finalPath).exists()) throw "Model file not found";
 
-      final config = sherpa.OfflinePunctuationConfig(
-        model: sherpa.OfflinePunctuationModelConfig(ctTransformer: finalPath, numThreads: 2, debug: false),
-      );
       // sherpa 官方注释明写「The user has to invoke OfflinePunctuation.free()
       // to avoid memory leak」。设置页有 3 个入口会重复调用本方法
       // （切模型 / 切云账户 / 手动指定标点模型路径），直接覆盖就是每次泄漏一个
-      // 已加载的 CT-Transformer 原生模型。
-      _punctuation?.free();
-      _punctuation = sherpa.OfflinePunctuation(config: config);
+      // 已加载的 CT-Transformer 原生模型 —— 旧 worker 先 dispose（在 worker 里 free）。
+      final worker = await PunctuationWorker.spawn(finalPath);
+      _punctuationWorker?.dispose();
+      _punctuationWorker = worker;
       _punctuationEnabled = true;
       
       if (activeModelName.isNotEmpty) {
@@ -741,12 +807,13 @@ class CoreEngine {
     }
   }
   
-  String addPunctuation(String text) {
-    if (!_punctuationEnabled || _punctuation == null || text.isEmpty) {
+  Future<String> addPunctuation(String text) async {
+    final worker = _punctuationWorker;
+    if (!_punctuationEnabled || worker == null || text.isEmpty) {
       return text;
     }
     try {
-      return _punctuation!.addPunct(text);
+      return await worker.punctuate(text);
     } catch (e) { return text; }
   }
   
@@ -1181,6 +1248,7 @@ class CoreEngine {
     _recordingState = RecordingState.starting;
     _recordingMode = mode;
     _recordingController.add(true);
+    _traceBeginSession(mode);
 
     // 2. UI FEEDBACK (fire-and-forget)
     _overlay.recordingMode = mode == RecordingMode.diary ? "diary" : "ptt";
@@ -1205,7 +1273,9 @@ class CoreEngine {
         return;
       }
       startingProvider = _asrProvider!;
+      final asrStartSpan = latencyTrace.span('asr start', track: 'asr');
       await startingProvider.start();
+      asrStartSpan.end();
       _log("ASR Provider Started.");
 
       // cancelRecording() 只切换状态，不会在 start() 尚未完成时抢先
@@ -1246,7 +1316,11 @@ class CoreEngine {
 
       // 5. START NATIVE RECORDING (Ring Buffer)
       _log("Starting native audio recording (ring buffer)...");
+      applyNoiseSuppression();
+      applyAutoGain();
+      final deviceSpan = latencyTrace.span('device start');
       final success = _nativeInput.startAudioRecording();
+      deviceSpan.end(args: {'ok': success});
       if (!success) {
         _log("Native audio start failed!");
         _recordingState = RecordingState.stopping;
@@ -1261,8 +1335,66 @@ class CoreEngine {
       }
       _audioStarted = true;
 
-      // 6. START POLLING
-      _startAudioPolling();
+      // 接受压缩格式的 provider：录音时就地编码，平台没有编码器则照旧送 PCM
+      _discardAudioEncoder();
+      _audioEncoder = NativeAudioEncoder.open(_nativeInput, startingProvider.preferredFormat);
+      if (_audioEncoder != null) _log("Encoding audio (${startingProvider.preferredFormat.name}) while recording.");
+
+      // 整段解码 / 整段上传的 provider：长停顿压短了再送（设置开着、平台支持时）
+      _discardSilenceCompactor();
+      _silenceOffsetMap = null;
+      _silenceRemovedSec = 0;
+      if (ConfigService().silenceCompactionEnabled &&
+          AppConstants.kSilenceCompactProviders.contains(startingProvider.type)) {
+        _silenceCompactor = NativeSilenceCompactor.open(_nativeInput);
+        if (_silenceCompactor != null) _log("Compacting long pauses while recording.");
+      }
+
+      // 本地流式模型：解码挪到 native 线程，直接从 ring 取数（平台支持、设置开着时）。
+      // native 解码线程在 ring 上有自己的读位置：竞速里的本地一路也能这样解，
+      // Dart 照旧轮询自己那份喂云端（所以 _nativeDecoding 只管单独的本地 provider）
+      _nativeDecoding = startingProvider is SherpaProvider &&
+          ConfigService().nativeStreamDecodeEnabled &&
+          startingProvider.startNativeDecode(_nativeInput);
+      if (_nativeDecoding) _log("Streaming decode on native thread.");
+      if (startingProvider is SherpaProvider) {
+        latencyTrace.annotate({'decode': _nativeDecoding ? 'native' : 'dart'});
+      }
+      if (startingProvider is RacingASRProvider) {
+        final racingLocal = startingProvider.local;
+        if (racingLocal is SherpaProvider && startingProvider.localActive) {
+          startingProvider.localDecodesNatively = ConfigService().nativeStreamDecodeEnabled &&
+              racingLocal.startNativeDecode(_nativeInput);
+          if (startingProvider.localDecodesNatively) _log("Racing: local leg decodes on native thread.");
+          latencyTrace.annotate({'decode': startingProvider.localDecodesNatively ? 'native' : 'dart'});
+        }
+      }
+
+      // 离线模型的预分段在说话期间就送去润色（见 SpeculativeCorrector）
+      final offline = startingProvider;
+      if (offline is OfflineSherpaProvider &&
+          ConfigService().aiSpeculativeSegments &&
+          (ConfigService().aiCorrectionEnabled || _translateOverride != null)) {
+        final spec = SpeculativeCorrector.llm(
+          vocabHints: ConfigService().vocabEnabled ? VocabService().getVocabHints() : null,
+          translateTo: _translateOverride,
+        );
+        _speculative = spec;
+        _speculativeSub = offline.segmentStream.listen(spec.submit);
+      }
+
+      // 本地模型不自带标点时，预分段 / 流式停顿前的字幕说话期间就加好（worker 上跑，不占主 isolate）
+      _latestPartial = '';
+      if (_punctuationEnabled && ConfigService().asrEngineType == 'sherpa' && !_activeModelHasPunctuation) {
+        final punct = SpeculativePunctuator(addPunctuation);
+        _speculativePunct = punct;
+        if (offline is OfflineSherpaProvider) {
+          _speculativePunctSub = offline.segmentStream.listen(punct.submit);
+        }
+      }
+
+      // 6. START POLLING（native 解码线程自己读 ring，不用轮询）
+      if (!_nativeDecoding) _startAudioPolling();
 
       // 7. SILENCE DETECTION — soft reminder if mic captures nothing for 2s
       _silenceCheckTimer?.cancel();
@@ -1290,7 +1422,10 @@ class CoreEngine {
           }
         }
         // 8. OFFLINE DURATION WARNING — toggle mode + offline model + exceeds threshold
-        if (_isToggleMode && _isOfflineASR && _recordingStartTime != null) {
+        // （Whisper 这类有窗口的模型按窗口切着解，长了也不掉质量，不提醒）
+        final windowed = _asrProvider is OfflineSherpaProvider &&
+            (_asrProvider as OfflineSherpaProvider).isWindowed;
+        if (_isToggleMode && _isOfflineASR && !windowed && _recordingStartTime != null) {
           final elapsed = DateTime.now().difference(_recordingStartTime!).inSeconds;
           if (elapsed == AppConstants.kOfflineModelDurationWarningSeconds) {
               _overlay.updateText(_localizedText(
@@ -1346,12 +1481,20 @@ class CoreEngine {
             provider.flushSegment();
           }
         }
+        // 流式模型没有预分段：停顿满 3 秒时，上次之后新出的字幕作为一段先加标点
+        if (_pauseSegmentPollCount == AppConstants.kPauseSegmentThresholdCount &&
+            _asrProvider is SherpaProvider) {
+          _speculativePunct?.submitUpTo(_latestPartial);
+        }
+        // 有窗口的模型一直没停顿时不在这里切：解一个 30 秒窗口是主 isolate 上的同步 FFI，
+        // 会把轮询和悬浮窗卡住几百毫秒到几秒。攒着的音频留给 stop() 里按窗口切着解
       });
 
       // Transition: starting → recording
       _recordingState = RecordingState.recording;
       startingProvider = null;
       _recordingStartTime = DateTime.now();
+      _traceRecordingSpan = latencyTrace.span('recording');
       _log("Recording started (mode=${mode.name}).");
 
       // Handle deferred stop (key released during async startup)
@@ -1415,6 +1558,7 @@ class CoreEngine {
     
     // Allocate a reusable native buffer for polling
     _pollBuffer ??= pkg_ffi.calloc<ffi.Int16>(_pollBufferSamples);
+    _audioSamplesRead = 0;
     
     _audioPollTimer = Timer.periodic(Duration(milliseconds: AppConstants.kAudioPollIntervalMs), (_) {
       _pollAudioRingBuffer();
@@ -1429,46 +1573,136 @@ class CoreEngine {
     // It will be freed when the engine is disposed
   }
   
-  /// Poll the C ring buffer and feed audio to ASR pipeline
-  void _pollAudioRingBuffer() {
-    if (!_shouldConsumeAudio || _nativeInput == null || _pollBuffer == null) {
-      return;
+  /// Poll the C ring buffer and feed audio to ASR pipeline. 返回这次读到的样本数
+  int _pollAudioRingBuffer() {
+    if (!_shouldConsumeAudio || _nativeDecoding || _nativeInput == null || _pollBuffer == null) {
+      return 0;
     }
     
     final samplesRead = _nativeInput.readAudioBuffer(_pollBuffer!, _pollBufferSamples);
-    if (samplesRead <= 0) return;
+    if (samplesRead <= 0) return 0;
+    _audioSamplesRead += samplesRead;
+
+    // 停顿压缩在编码之前：停顿里这一轮可能一个样本都不吐
+    final compactor = _silenceCompactor;
+    if (compactor != null) {
+      _feedSamples(compactor.output, compactor.process(_pollBuffer!, samplesRead));
+    } else {
+      _feedSamples(_pollBuffer!, samplesRead);
+    }
+    return samplesRead;
+  }
+
+  /// native 缓冲里的 [count] 个样本交给编码器或 provider
+  void _feedSamples(ffi.Pointer<ffi.Int16> samples, int count) {
+    if (count <= 0) return;
+
+    // 压缩路径：直接编码 native 缓冲，PCM 不进 Dart 堆
+    final encoder = _audioEncoder;
+    if (encoder != null) {
+      final encoded = encoder.encode(samples, count);
+      if (encoded != null) _asrProvider?.acceptEncoded(encoded);
+      return;
+    }
     
     // Convert Pointer<Int16> to Uint8List (matching _processAudioData interface)
-    final byteCount = samplesRead * 2;
-    final bytes = _pollBuffer!.cast<ffi.Uint8>().asTypedList(byteCount);
+    final bytes = samples.cast<ffi.Uint8>().asTypedList(count * 2);
     
-    // Uint8List.fromList creates a copy, safe to reuse _pollBuffer next poll
+    // Uint8List.fromList creates a copy, safe to reuse the native buffer next poll
     _processAudioData(Uint8List.fromList(bytes));
   }
 
   void _processAudioData(Uint8List data) {
     if (!_shouldConsumeAudio) return;
-    
-    // RAW 16k Int16 -> Float32 (direct passthrough, no gain)
-    final int sampleCount = data.length ~/ 2;
-    final floatSamples = Float32List(sampleCount);
-    final byteData = ByteData.sublistView(data);
+    final provider = _asrProvider;
+    if (provider == null) return;
 
-    for (int i = 0; i < sampleCount; i++) {
-      floatSamples[i] = byteData.getInt16(i * 2, Endian.little) / 32768.0;
+    // 云端 provider 上传的就是 int16：原始字节直接交过去（data 是上面刚拷出来的，
+    // 所有权随之交给 provider）。只有要 Float32 的本地模型才转换。
+    if (provider.preferredFormat == AudioSampleFormat.pcm16) {
+      provider.acceptPcm16(data);
+    } else {
+      // RAW 16k Int16 -> Float32 (direct passthrough, no gain)
+      provider.acceptWaveform(pcm16ToFloat32(data));
     }
+  }
 
-    if (_asrProvider != null) {
-      _asrProvider!.acceptWaveform(floatSamples);
+  /// 编码器里还压着不满一帧的尾巴（最多 256ms），必须在 provider.stop() 之前交出去
+  void _flushAudioEncoder() {
+    final encoder = _audioEncoder;
+    if (encoder == null) return;
+    _audioEncoder = null;
+    try {
+      final tail = encoder.finish();
+      if (tail != null) _asrProvider?.acceptEncoded(tail);
+      _log("[PERF] encoded ${encoder.inputSamples * 2} bytes PCM → ${encoder.encodedBytes} bytes");
+    } finally {
+      encoder.dispose();
     }
   }
 
-  void _cleanupRecordingState() {
+  void _discardAudioEncoder() {
+    _audioEncoder?.dispose();
+    _audioEncoder = null;
+  }
+
+  /// 停顿压缩里还压着的静音（最多 kSilenceCompactMinMs）—— 要赶在编码器冲刷之前交出去，
+  /// 编码器才能把它编进最后一帧
+  void _flushSilenceCompactor() {
+    final compactor = _silenceCompactor;
+    if (compactor == null) return;
+    _silenceCompactor = null;
+    try {
+      _feedSamples(compactor.output, compactor.finish());
+      _silenceOffsetMap = compactor.offsetMap();
+      _silenceRemovedSec = compactor.removedSeconds;
+      final originalSec = compactor.inputSamples / AppConstants.kSampleRate;
+      final stats = {
+        'silenceRemovedSec': double.parse(compactor.removedSeconds.toStringAsFixed(2)),
+        'silenceCuts': compactor.cuts,
+      };
+      latencyTrace.annotate(stats);
+      _log("[PERF] silence compaction: removed ${compactor.removedSeconds.toStringAsFixed(2)}s "
+          "of ${originalSec.toStringAsFixed(2)}s in ${compactor.cuts} pauses");
+    } finally {
+      compactor.dispose();
+    }
+  }
+
+  void _discardSilenceCompactor() {
+    _silenceCompactor?.dispose();
+    _silenceCompactor = null;
+  }
+
+  /// 离线解码按音频时长算：按压掉的比例估出这次省下的解码时间
+  void _traceSilenceDecodeSaved(OfflineSherpaProvider provider) {
+    final removedSec = _silenceRemovedSec;
+    final decodedSec = provider.lastDecodedSec;
+    if (removedSec <= 0 || decodedSec <= 0) return;
+    final savedMs = provider.lastDecodeMs * removedSec / decodedSec;
+    latencyTrace.annotate({'silenceDecodeSavedMs': savedMs.round()});
+    _log("[PERF] silence compaction saved ~${savedMs.round()}ms decode "
+        "(${provider.lastDecodeMs}ms for ${decodedSec.toStringAsFixed(2)}s)");
+  }
+
+  /// [hideOverlay] 为 false 时浮窗留给听写流水线收尾时再收：
+  /// 状态已回 idle，但「AI 润色中…」这类进度还要显示在上面
+  void _cleanupRecordingState({bool hideOverlay = true}) {
+     _discardAudioEncoder();
+     _discardSilenceCompactor();
      _recordingState = RecordingState.idle;
      _audioStarted = false;
      _deferredStop = false;
      _isToggleMode = false;
      _pauseSegmentPollCount = 0;
+     _speculativeSub?.cancel();
+     _speculativeSub = null;
+     _speculative?.cancel();
+     _speculative = null;
+     _speculativePunctSub?.cancel();
+     _speculativePunctSub = null;
+     _speculativePunct?.cancel();
+     _speculativePunct = null;
      _activeHotkeyCode = null;
      _translateOverride = null;
      _keyDownTime = null;
@@ -1478,7 +1712,10 @@ class CoreEngine {
      _watchdogTimer?.cancel();
      _silenceCheckTimer?.cancel();
      _recordingController.add(false);
-     _overlay.hide();
+     if (hideOverlay) _overlay.hide();
+     _nativeDecoding = false;
+     _traceRecordingSpan = null;
+     _traceEndSession();
   }
 
   /// Save recording WAV for debugging. Keeps last 10 files, rotating.
@@ -1493,32 +1730,150 @@ class CoreEngine {
     final existing = dir.listSync().whereType<File>().where((f) => f.path.endsWith('.wav')).toList()
       ..sort((a, b) => a.path.compareTo(b.path));
     while (existing.length >= 10) {
-      existing.removeAt(0).deleteSync();
+      final wav = existing.removeAt(0);
+      wav.deleteSync();
+      final agc = File(wav.path.replaceAll(RegExp(r'\.wav$'), '.agc.csv'));
+      if (agc.existsSync()) agc.deleteSync();
     }
 
     final timestamp = DateTime.now().toIso8601String().replaceAll(':', '-').split('.').first;
     final path = '${dir.path}/rec_$timestamp.wav';
     if (ni.saveRecordingWav(path)) {
       _log("Debug recording saved: $path");
+      _saveAutoGainTrace(path);
       return path;
     }
     return null;
   }
 
-  Future<void> _stopAudioSafely() async {
+  /// [drain]：停源后把 ring 里剩下的读到 native 报出的结束位置（见 [_drainAudioRingBuffer]），
+  /// 只在平台支持（[NativeInputBase.canDrainAudio]）且要用这段音频时传。
+  Future<void> _stopAudioSafely({bool drain = false}) async {
     _stopAudioPolling();  // Stop polling BEFORE stopping AudioQueue
     if (_audioStarted) {
       try {
-        final stopped = _nativeInput?.stopAudioRecording() ?? false;
-        if (!stopped) {
-          AppLog.e('CoreEngine: native audio queue stop/dispose failed');
+        final ni = _nativeInput;
+        if (drain && ni != null) {
+          final end = ni.stopAudioRecordingAndDrain(AppConstants.kAudioDrainTimeoutMs);
+          // native 解码时剩下的由解码线程读完（provider.stop 里 finish）
+          if (!_nativeDecoding) _drainAudioRingBuffer(end);
+        } else {
+          final stopped = ni?.stopAudioRecording() ?? false;
+          if (!stopped) {
+            AppLog.e('CoreEngine: native audio queue stop/dispose failed');
+          }
         }
       } catch (e, stackTrace) {
         AppLog.e('CoreEngine: stop audio threw: $e\n$stackTrace');
       } finally {
         _audioStarted = false;
       }
+      // 闲置释放之后的那次录音是冷启动，录完重新挂上
+      armWarmMic();
+    }
+  }
+
+  /// 读 ring 直到本次录音的第 [end] 个样本（native drain 报出的结束位置）。
+  /// ring 溢出丢过头部时永远读不满 [end]，读空即止。
+  void _drainAudioRingBuffer(int end) {
+    while (_audioSamplesRead < end) {
+      if (_pollAudioRingBuffer() <= 0) break;
     }
+    _log("[PERF] drained ring to $_audioSamplesRead/$end samples");
+  }
+
+  /// 常驻麦克风（设置里的低延迟模式，目前只有 Linux 导出）：热键就绪期间采集流
+  /// 一直开着，按键前 [AppConstants.kWarmMicPrerollMs] 的声音直接拼进录音开头 ——
+  /// 没有设备打开的空窗，第一个字不再被吞（docs/debug-log/2026-06-02-asr-startup-audio-gap.md）。
+  /// 不录音累计 [AppConstants.kWarmMicIdleRelease] 后 native 自己释放设备。
+  /// 没开、没有热键、平台不支持时什么都不做，重复调用无害。
+  void armWarmMic() {
+    final ni = _nativeInput;
+    if (ni == null || !_isListenerRunning || !ConfigService().warmMicEnabled) return;
+    if (ni.audioWarmStart(AppConstants.kWarmMicPrerollMs,
+        AppConstants.kWarmMicIdleRelease.inMilliseconds)) {
+      _log("Warm mic armed (pre-roll ${AppConstants.kWarmMicPrerollMs}ms)");
+    }
+  }
+
+  /// 立即释放常驻麦克风（关掉设置 / 退出）。正在录的那次照常录完再关设备。
+  void releaseWarmMic() => _nativeInput?.audioWarmStop();
+
+  /// 当前 ASR provider 的类型（[ASRProvider.type]），还没初始化时为 null
+  String? get asrProviderType => _asrProvider?.type;
+
+  /// 按当前 provider 的设置开关采集降噪（目前只有 Linux 导出）。
+  ///
+  /// provider 就绪时就调一次，不等按键：常驻麦克风开着时，开关那一刻流里会插进
+  /// 16ms 的延迟线静音，放在按键之前它只落在 pre-roll 最前面。开录前再调一次，
+  /// 兜住设置页刚改过的情况；重复调用无害。
+  void applyNoiseSuppression() {
+    final ni = _nativeInput;
+    final type = _asrProvider?.type;
+    if (ni == null || type == null) return;
+    final enabled = ConfigService().noiseSuppressionEnabledFor(type);
+    if (ni.setNoiseSuppression(enabled, AppConstants.kNoiseSuppressionBudget.inMicroseconds)) {
+      _noiseSuppressing = enabled;
+    }
+  }
+
+  /// 降噪的开销写进延迟追踪：每秒音频花多少 CPU、有没有超预算转旁路
+  void _traceNoiseSuppression() {
+    final ni = _nativeInput;
+    if (ni == null || !_noiseSuppressing) return;
+    final samples = ni.noiseSuppressionStat(kNoiseSuppressionStatSamples);
+    if (samples <= 0) return;
+    final cpuUs = ni.noiseSuppressionStat(kNoiseSuppressionStatCpuUs);
+    final stats = {
+      'nsCpuUsPerSec': (cpuUs * AppConstants.kSampleRate / samples).round(),
+      'nsMaxChunkUs': ni.noiseSuppressionStat(kNoiseSuppressionStatMaxChunkUs),
+      'nsOverBudget': ni.noiseSuppressionStat(kNoiseSuppressionStatOverBudget),
+      'nsBypassed': ni.noiseSuppressionStat(kNoiseSuppressionStatBypassed) == 1,
+    };
+    latencyTrace.annotate(stats);
+    _log("[PERF] noise suppression: $stats");
+  }
+
+  /// 按设置开关采集自动增益（目前只有 Linux 导出）。开录前调，设置页改了也调一次：
+  /// 常驻麦克风开着时 pre-roll 那一段也能先过上增益。
+  void applyAutoGain() {
+    final ni = _nativeInput;
+    if (ni == null) return;
+    final enabled = ConfigService().autoGainEnabled;
+    if (ni.setAutoGain(enabled, AppConstants.kAutoGainTargetDbfs, AppConstants.kAutoGainMaxGainDb)) {
+      _autoGaining = enabled;
+    }
+  }
+
+  /// 自动增益的概况写进延迟追踪：收尾时的增益、限幅器动作了几帧、门开着的比例。
+  /// 逐帧的轨迹太长，不进 trace；开发者模式下随调试录音另存（见 [_saveAutoGainTrace]）
+  void _traceAutoGain() {
+    final ni = _nativeInput;
+    if (ni == null || !_autoGaining) return;
+    final frames = ni.autoGainTrace(AppConstants.kAutoGainTraceFrames);
+    if (frames.isEmpty) return;
+    final stats = {
+      'agcGainDb': frames.last.gainDb.toStringAsFixed(1),
+      'agcLimitedFrames': frames.where((f) => f.limiterDb < -0.1).length,
+      'agcGateOpenPct': (frames.where((f) => f.gateOpen).length * 100 / frames.length).round(),
+    };
+    latencyTrace.annotate(stats);
+    _log("[PERF] auto gain: $stats");
+  }
+
+  /// 增益轨迹存成和 wav 同名的 .agc.csv，一帧（10ms）一行，对着波形看哪里被压、哪里门没开
+  void _saveAutoGainTrace(String wavPath) {
+    final ni = _nativeInput;
+    if (ni == null || !_autoGaining) return;
+    final frames = ni.autoGainTrace(AppConstants.kAutoGainTraceFrames);
+    if (frames.isEmpty) return;
+    final csv = StringBuffer('ms,level_dbfs,gain_db,limiter_db,gate\n');
+    for (var i = 0; i < frames.length; i++) {
+      final f = frames[i];
+      csv.writeln('${i * 10},${f.levelDbfs.toStringAsFixed(1)},${f.gainDb.toStringAsFixed(2)},'
+          '${f.limiterDb.toStringAsFixed(2)},${f.gateOpen ? 1 : 0}');
+    }
+    File(wavPath.replaceAll(RegExp(r'\.wav$'), '.agc.csv')).writeAsStringSync(csv.toString());
   }
 
   /// 用户主动取消录音：关闭音频硬件、丢弃 ASR 结果、不做注入或保存
@@ -1532,6 +1887,7 @@ class CoreEngine {
     }
     final wasStarting = _recordingState == RecordingState.starting;
     _log("[Cancel] User requested cancel (state=$_recordingState)");
+    latencyTrace.annotate({'outcome': 'cancelled'});
 
     // 立即 UI 切回
     _isToggleMode = false;
@@ -1549,6 +1905,8 @@ class CoreEngine {
     } catch (e) {
       _log("[Cancel] Audio stop error: $e");
     }
+    _discardAudioEncoder();
+    _discardSilenceCompactor();
 
     _activeHotkeyCode = null;
     _deferredStop = false;
@@ -1580,9 +1938,125 @@ class CoreEngine {
 
     // 复位状态
     _recordingState = RecordingState.idle;
+    _nativeDecoding = false;
+    _traceRecordingSpan = null;
+    _traceEndSession();
     _log("[Cancel] Done, state → idle");
   }
 
+  // LATENCY TRACE
+  /// native 线程上打的时刻换算到 [latencyTrace] 的钟上；平台没导出、本次没发生时为 null
+  int? _nativeTraceUs(int which) {
+    final ni = _nativeInput;
+    if (ni == null) return null;
+    final stamp = ni.nativeTraceStampUs(which);
+    if (stamp < 0) return null;
+    final now = ni.nativeTraceStampUs(kNativeTraceNow);
+    if (now < 0) return null;
+    return latencyTrace.alignNative(stamp, nativeNowUs: now);
+  }
+
+  /// 最近一次 native 按键时刻，太久以前的不算（这次不是按键触发的）
+  int? _recentKeyUs() {
+    final keyUs = _nativeTraceUs(kNativeTraceKeyEvent);
+    if (keyUs == null) return null;
+    final age = latencyTrace.nowUs() - keyUs;
+    return age <= AppConstants.kLatencyTraceKeyWindow.inMicroseconds ? keyUs : null;
+  }
+
+  /// 会话从按键那一刻算起（有 native 时刻的话），按键回调排队的那一截也在里面
+  void _traceBeginSession(RecordingMode mode) {
+    final keyUs = _recentKeyUs();
+    _traceSawPartial = false;
+    latencyTrace.beginSession(atUs: keyUs, args: {
+      'mode': mode.name,
+      'asr': _asrProvider?.type,
+      'model': _traceModel,
+    });
+    if (keyUs != null) {
+      latencyTrace.complete('key down → engine', keyUs, latencyTrace.nowUs(), track: 'native-key');
+    }
+    _traceWatchFrames();
+  }
+
+  /// 录音期间的 UI 帧耗时：解码在主 isolate 上时悬浮窗掉不掉帧，和挪到 native 之后对比
+  void _traceWatchFrames() {
+    _traceFrames.reset();
+    if (_frameTimingsHook != null) return;
+    void hook(List<FrameTiming> timings) {
+      for (final t in timings) {
+        _traceFrames.add(t.buildDuration.inMicroseconds, t.rasterDuration.inMicroseconds);
+      }
+    }
+    try {
+      SchedulerBinding.instance.addTimingsCallback(hook);
+      _frameTimingsHook = hook;
+    } catch (_) {
+      // 没有 Flutter binding（单测里直接驱动引擎）：不记帧
+    }
+  }
+
+  /// 帧时间是引擎攒一批（release 约 100ms）才报的，结束前的最后一批会漏掉，不影响比对
+  void _traceEndSession() {
+    _traceStopFrames();
+    latencyTrace.endSession();
+  }
+
+  /// 录音这一截记完，会话转到后台跟着收尾走；下一句开录另起新会话
+  TraceSession _traceDetachSession() {
+    _traceStopFrames();
+    return latencyTrace.detach();
+  }
+
+  void _traceStopFrames() {
+    final hook = _frameTimingsHook;
+    if (hook != null) {
+      SchedulerBinding.instance.removeTimingsCallback(hook);
+      _frameTimingsHook = null;
+    }
+    latencyTrace.annotate(_traceFrames.toArgs());
+  }
+
+  /// 本地流式解码的统计（native / dart 两条路径同名字段），外加 native 线程上
+  /// 第一条字幕产生的时刻 —— 和 Dart 收到的 'first partial' 之间就是 port 投递的那一截
+  void _traceDecodeStats(SherpaProvider provider) {
+    final stats = Map<String, Object?>.of(provider.lastDecodeStats);
+    final firstNative = stats.remove('firstPartialNativeUs') as int?;
+    latencyTrace.annotate(stats);
+    final now = _nativeInput?.nativeTraceStampUs(kNativeTraceNow) ?? -1;
+    if (firstNative != null && now >= 0) {
+      latencyTrace.instant('first partial (native)',
+          atUs: latencyTrace.alignNative(firstNative, nativeNowUs: now), track: 'asr');
+    }
+  }
+
+  void _traceKey(String name) {
+    final keyUs = _recentKeyUs();
+    if (keyUs != null) latencyTrace.complete(name, keyUs, latencyTrace.nowUs(), track: 'native-key');
+  }
+
+  /// 采集线程上的时刻在停止后才补记：第一块要等设备真出声才有，录音期间没处挂
+  void _traceCaptureStamps() {
+    final started = _nativeTraceUs(kNativeTraceCaptureStart);
+    final opened = _nativeTraceUs(kNativeTraceDeviceOpen);
+    final first = _nativeTraceUs(kNativeTraceFirstChunk);
+    if (started != null && opened != null) {
+      latencyTrace.complete('device open', started, opened, track: 'native-capture');
+    }
+    if (opened != null && first != null) {
+      latencyTrace.complete('first chunk', opened, first, track: 'native-capture');
+    }
+  }
+
+  void _tracePartial(String text) {
+    if (_traceSawPartial || text.isEmpty || _recordingState != RecordingState.recording) return;
+    _traceSawPartial = true;
+    latencyTrace.instant('first partial', track: 'asr');
+  }
+
+  /// 上一句还在收尾时，下一句已经开录了（状态不是 idle）
+  bool get _nextDictationRecording => _recordingState != RecordingState.idle;
+
   Future<void> stopRecording() async {
     final existing = _recordingStopInFlight;
     if (existing != null) {
@@ -1594,10 +2068,42 @@ class CoreEngine {
 
     final completion = Completer<void>();
     _recordingStopInFlight = completion.future;
+
+    // 识别结果一到手就 release：计费、状态回 idle，下一句马上能录；
+    // 这次听写剩下的收尾只用本地变量，排在 [_dictationPipeline] 里按顺序交出去
+    var released = false;
+    DictationTicket? ticket;
+    TraceSession? trace;
+    void release({bool keepOverlay = false}) {
+      if (released) return;
+      released = true;
+      // Report usage for billing (only when cloud services were consumed)
+      if (_recordingStartTime != null) {
+        final recordingSeconds = DateTime.now().difference(_recordingStartTime!).inSeconds;
+        // 云端 ASR，或 AI 润色（走云端 LLM）任一开启即消耗云服务
+        final usedCloud = ConfigService().workMode == 'cloud' ||
+            ConfigService().aiCorrectionEnabled;
+        if (usedCloud && recordingSeconds > 0) {
+          BillingService().reportUsage(recordingSeconds);
+        }
+        _recordingStartTime = null;
+      }
+      // Clear quick translate override
+      _translateOverride = null;
+      _cleanupRecordingState(hideOverlay: !keepOverlay);
+      if (identical(_recordingStopInFlight, completion.future)) {
+        _recordingStopInFlight = null;
+      }
+    }
+
     try {
 
     final sw = Stopwatch()..start();
     _log("[PERF] stopRecording BEGIN");
+    _traceRecordingSpan?.end();
+    _traceRecordingSpan = null;
+    _traceKey('key up → engine');
+    final audioStopSpan = latencyTrace.span('audio stop');
 
     // Clean up toggle state
     _isToggleMode = false;
@@ -1618,16 +2124,30 @@ class CoreEngine {
     await Future(() {});
     _log("[PERF] +${sw.elapsedMilliseconds}ms — yield done");
 
-    // Give ASR time to process the last audio chunks before stopping hardware
-    await Future.delayed(Duration(milliseconds: AppConstants.kEngineShutdownDelayMs));
-    _log("[PERF] +${sw.elapsedMilliseconds}ms — shutdown delay done");
+    // 能 drain 的平台由 native 报出确切的结束位置，读到那里就收齐了，松键即停。
+    // 其余平台照旧：Give ASR time to process the last audio chunks before stopping hardware
+    final drain = _audioStarted && (_nativeInput?.canDrainAudio ?? false);
+    if (!drain) {
+      await Future.delayed(Duration(milliseconds: AppConstants.kEngineShutdownDelayMs));
+      _log("[PERF] +${sw.elapsedMilliseconds}ms — shutdown delay done");
+    }
 
     // HARDWARE SHUTDOWN
     try {
-      await _stopAudioSafely();
+      await _stopAudioSafely(drain: drain);
     } catch (e) {
       _log("Audio Stop Error: $e");
     }
+    try {
+      _flushSilenceCompactor();
+    } catch (e) {
+      _log("Silence compactor flush error: $e");
+    }
+    try {
+      _flushAudioEncoder();
+    } catch (e) {
+      _log("Audio encoder flush error: $e");
+    }
 
     // Save recording for debugging (developer mode only)
     if (AppLog.enabled) {
@@ -1637,6 +2157,10 @@ class CoreEngine {
         _log("Save recording error: $e");
       }
     }
+    audioStopSpan.end(args: {'drain': drain});
+    _traceCaptureStamps();
+    _traceNoiseSuppression();
+    _traceAutoGain();
     _log("[PERF] +${sw.elapsedMilliseconds}ms — audio stopped");
 
     // Transition: stopping → processing
@@ -1646,6 +2170,7 @@ class CoreEngine {
     try {
     if (_asrProvider != null) {
       ASRResult asrResult = ASRResult.textOnly("");
+      final asrStopSpan = latencyTrace.span('asr stop', track: 'asr');
       try {
         asrResult = await _asrProvider!.stop().timeout(_asrProvider!.stopTimeout, onTimeout: () {
           _log("ASR Provider Stop Timeout!");
@@ -1654,6 +2179,22 @@ class CoreEngine {
       } catch (e) {
         _log("Provider Stop Error: $e");
       }
+      // 压掉停顿之后的时间戳映射回原始录音
+      final offsetMap = _silenceOffsetMap;
+      if (offsetMap != null) asrResult = offsetMap.apply(asrResult);
+      final stoppedProvider = _asrProvider;
+      asrStopSpan.end(args: {
+        'chars': asrResult.text.length,
+        if (asrResult.error != null) 'error': '${asrResult.error}',
+        if (stoppedProvider is RacingASRProvider) 'winner': stoppedProvider.lastWinner,
+      });
+      if (stoppedProvider is OfflineSherpaProvider) {
+        _traceSilenceDecodeSaved(stoppedProvider);
+      }
+      if (stoppedProvider is SherpaProvider) {
+        _traceDecodeStats(stoppedProvider);
+        _log("[PERF] decode stats: ${stoppedProvider.lastDecodeStats}");
+      }
       _log("[PERF] +${sw.elapsedMilliseconds}ms — ASR stop() returned (${asrResult.text.length}字): ${AppLog.redact(asrResult.text)}");
 
       // 云端 ASR 错误（鉴权失败、配额超限等）
@@ -1672,30 +2213,102 @@ class CoreEngine {
           ),
           AppConstants.kErrorDisplayDuration,
         );
+        latencyTrace.annotate({'outcome': 'asr error'});
         return; // finally block handles cleanup
       }
 
+      // 后面用到的录音期状态先拿到手，release 之后这些字段就归下一句了。
+      // ASR stop 本身还得在状态机里等：provider 是同一个实例，下一句的 start 要等它 stop 完
+      final translateTo = _translateOverride;
+      final asr = _asrProvider;
+      final hotwordsActive = asr is SherpaProvider && asr.hotwordsActive;
+      final specSegments = asr is OfflineSherpaProvider ? asr.lastSegments : null;
+      final spec = _speculative;
+      _speculativeSub?.cancel();
+      _speculativeSub = null;
+      _speculative = null;
+      final punct = _speculativePunct;
+      _speculativePunctSub?.cancel();
+      _speculativePunctSub = null;
+      _speculativePunct = null;
+      final turn = _dictationPipeline.enter();
+      ticket = turn;
+      final session = _traceDetachSession();
+      trace = session;
+      // 浮窗不在这里收：润色 / 翻译的进度还要写在上面，等这张票收尾再关
+      release(keepOverlay: true);
+      _log("[PERF] +${sw.elapsedMilliseconds}ms — state → idle, dictation #${turn.seq} post-processing "
+          "(${_dictationPipeline.inFlight} in flight)");
+
       String finalText = asrResult.text;
       final originalAsrText = asrResult.text; // 保留 ASR 原文用于 UI 对比
-      lastLlmSuccess = null; // 重置
+      bool? llmSuccess;
+      // 打字机模式已经边出边粘出去了，后面不再一次性注入
+      var typewriterInjected = false;
 
       // AI Polish (with vocab hints injected into LLM prompt)
       // Skip LLM for trivial input: pure punctuation, whitespace, or ≤2 chars
       final trimmedForCheck = finalText.replaceAll(RegExp(r'[\s\p{P}]', unicode: true), '');
-      final isQuickTranslate = _translateOverride != null;
+      final isQuickTranslate = translateTo != null;
       final shouldCallLlm = finalText.isNotEmpty && trimmedForCheck.length > 2 &&
           (ConfigService().aiCorrectionEnabled || isQuickTranslate);
-      if (shouldCallLlm) {
-        _statusController.add(EngineStatus.info(
-          isQuickTranslate ? "Translating..." : "AI polishing...",
-          code: isQuickTranslate ? 'translating' : 'polishing',
-        ));
-        _overlay.updateText(_localizedText(
-          isQuickTranslate ? "Translating..." : "AI polishing...",
-          isQuickTranslate ? 'translating' : 'polishing',
-        ));
+      // 解码器已带热词偏置、且这句确实命中了术语 → 术语已由解码认对，
+      // 省掉一次 LLM 往返，只做本地替换（落到下面的 vocab 分支）。
+      // 默认关闭：LLM 润色除术语外还管口语整理，是否舍弃由用户决定。翻译不走捷径。
+      final hotwordShortcut = shouldCallLlm && !isQuickTranslate &&
+          ConfigService().vocabEnabled && ConfigService().vocabHotwordsSkipLlm &&
+          hotwordsActive &&
+          VocabService().containsHotword(finalText);
+      if (hotwordShortcut) {
+        _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish skipped (hotword hit)");
+      }
+
+      // 说话期间已按段润色过 → 只补最后一段再拼起来；拼不成（没预分段、某段失败）
+      // 就落回下面的整段润色。两条路共用一份 kLlmPolishTimeout：
+      // 预分段卡住再给整段兜底一整份超时，用户最坏要等两倍
+      String? speculated;
+      var llmBudget = AppConstants.kLlmPolishTimeout;
+      if (spec != null && shouldCallLlm && !hotwordShortcut && specSegments != null) {
+        final specSpan = latencyTrace.span('llm speculative finish', track: 'llm', session: session);
+        final specWatch = Stopwatch()..start();
+        speculated = await spec
+            .finish(specSegments)
+            .timeout(llmBudget, onTimeout: () => null);
+        llmBudget -= specWatch.elapsed;
+        spec.cancel();
+        specSpan.end(args: {'segments': spec.submittedCount, 'ok': speculated != null});
+        if (speculated != null) {
+          _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish done via ${spec.submittedCount} speculative segments (${speculated.length}字)");
+        } else {
+          _log("[PERF] +${sw.elapsedMilliseconds}ms — speculative polish unusable, falling back to full text");
+        }
+      }
+
+      if (speculated != null) {
+        finalText = speculated;
+        llmSuccess = true;
+      } else if (shouldCallLlm && !hotwordShortcut && llmBudget <= Duration.zero) {
+        // 预分段等到超时，预算已经花完：不再整段重来，直接用 ASR 原文
+        llmSuccess = false;
+        _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish budget spent on speculative segments, using raw ASR text");
+      } else if (shouldCallLlm && !hotwordShortcut) {
+        // 下一句已经在录了就别抢它的状态和悬浮窗
+        if (!_nextDictationRecording) {
+          _statusController.add(EngineStatus.info(
+            isQuickTranslate ? "Translating..." : "AI polishing...",
+            code: isQuickTranslate ? 'translating' : 'polishing',
+          ));
+          _overlay.updateText(_localizedText(
+            isQuickTranslate ? "Translating..." : "AI polishing...",
+            isQuickTranslate ? 'translating' : 'polishing',
+          ));
+        }
         _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish starting...");
+        final llmSpan = latencyTrace.span(isQuickTranslate ? 'llm translate' : 'llm polish',
+            track: 'llm', args: {'model': ConfigService().llmModel}, session: session);
         bool typewriterBegan = false;
+        // 这一次调用自己的成败：上一句 / 下一句的 LLM 调用可能同时在跑
+        final llmStatus = LlmCallStatus();
         try {
           List<String>? vocabHints;
           if (ConfigService().vocabEnabled) {
@@ -1705,7 +2318,7 @@ class CoreEngine {
 
           final useTypewriter = mode == RecordingMode.ptt
               && ConfigService().typewriterEnabled;
-          final llmTimeout = AppConstants.kLlmPolishTimeout;
+          final llmTimeout = llmBudget;
 
           if (useTypewriter) {
             // Typewriter mode (alpha): streaming LLM + clipboard injection
@@ -1714,7 +2327,7 @@ class CoreEngine {
             bool firstChunk = true;
             // **语义是「至少有一段真的粘出去了」，不是「调用过 chunk」。**
             // 原先无条件置 true：唯一那段 chunk 失败时也算「部分成功」，
-            // 于是 _typewriterInjected=true 挡掉了一次性注入兜底，
+            // 于是 typewriterInjected=true 挡掉了一次性注入兜底，
             // 用户口述的话一个字都没进去，界面却显示就绪。
             bool streamInjected = false;
             // 只要有一段 chunk 没粘出去，整段流式注入就不算成功 ——
@@ -1724,6 +2337,8 @@ class CoreEngine {
             var lastInjectTime = DateTime.now();
             const batchInterval = Duration(milliseconds: AppConstants.kTypewriterBatchIntervalMs);
 
+            // 边出边粘：前一句没交完就开始粘会插到它中间去
+            await turn.turn;
             if (!_clipBegin()) {
               // 会话没开起来，别发 chunk —— 后面会走一次性注入兜底
               throw StateError('clipboard session unavailable');
@@ -1733,21 +2348,23 @@ class CoreEngine {
 
             // Wrap stream with timeout: if no data for 15s, abort
             bool timedOut = false;
-            await for (final chunk in LLMService().correctTextStream(finalText, vocabHints: vocabHints, translateTo: _translateOverride).timeout(llmTimeout, onTimeout: (sink) {
+            await for (final chunk in LLMService().correctTextStream(finalText, vocabHints: vocabHints, translateTo: translateTo, status: llmStatus).timeout(llmTimeout, onTimeout: (sink) {
               timedOut = true;
-              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish stream TIMEOUT (${llmTimeout.inSeconds}s)");
+              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish stream TIMEOUT (${llmTimeout.inMilliseconds}ms)");
               sink.close();
             })) {
               streamBuffer.write(chunk);
               batchBuffer.write(chunk);
               if (firstChunk) {
                 _log("[PERF] +${sw.elapsedMilliseconds}ms — first token received");
+                latencyTrace.instant('first token', track: 'llm', session: session);
                 firstChunk = false;
               }
 
               // Flush batch via clipboard paste
               final now = DateTime.now();
               if (now.difference(lastInjectTime) >= batchInterval && batchBuffer.isNotEmpty) {
+                final batchSpan = latencyTrace.span('typewriter batch', track: 'inject', session: session);
                 if (_nativeInput?.injectClipboardChunk(
                         batchBuffer.toString()) ==
                     true) {
@@ -1755,6 +2372,7 @@ class CoreEngine {
                 } else {
                   chunkFailed = true;
                 }
+                batchSpan.end(args: {'chars': batchBuffer.length});
                 batchBuffer.clear();
                 lastInjectTime = now;
               }
@@ -1762,6 +2380,7 @@ class CoreEngine {
 
             // Flush remaining batch
             if (batchBuffer.isNotEmpty) {
+              final batchSpan = latencyTrace.span('typewriter batch', track: 'inject', session: session);
               if (_nativeInput?.injectClipboardChunk(
                       batchBuffer.toString()) ==
                   true) {
@@ -1769,6 +2388,7 @@ class CoreEngine {
               } else {
                 chunkFailed = true;
               }
+              batchSpan.end(args: {'chars': batchBuffer.length});
             }
             _clipEnd();
             typewriterBegan = false;
@@ -1786,7 +2406,7 @@ class CoreEngine {
             // chunk 有失败就**不**标记「已注入」，让后面走一次性注入兜底。
             // 部分成功时重放全文会重复，所以只在一段都没成时才回退。
             if (streamInjected && !chunkFailed) {
-              _typewriterInjected = true;
+              typewriterInjected = true;
             } else if (chunkFailed) {
               _log("[Typewriter] chunk 注入失败 "
                   "(anySucceeded=$streamInjected)");
@@ -1794,7 +2414,7 @@ class CoreEngine {
               // 部分成功 → 重放会造成重复，只提示。
               if (streamInjected) {
                 // 已经粘出去一部分，回退重放会造成重复 —— 只提示，不重放
-                _typewriterInjected = true;
+                typewriterInjected = true;
                 _statusController.add(EngineStatus.error(
                     "Injection incomplete; full text saved to chat history",
                     code: 'inject_partial'));
@@ -1803,15 +2423,15 @@ class CoreEngine {
             _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish stream done (typewriter), len=${finalText.length}");
           } else if (mode != RecordingMode.diary) {
             // Normal mode: non-streaming LLM, inject once at end
-            finalText = await LLMService().correctText(finalText, vocabHints: vocabHints, translateTo: _translateOverride).timeout(llmTimeout, onTimeout: () {
-              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish TIMEOUT (${llmTimeout.inSeconds}s), using raw ASR text");
+            finalText = await LLMService().correctText(finalText, vocabHints: vocabHints, translateTo: translateTo, status: llmStatus).timeout(llmTimeout, onTimeout: () {
+              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish TIMEOUT (${llmTimeout.inMilliseconds}ms), using raw ASR text");
               return finalText;
             });
             _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish done (${finalText.length}字): ${AppLog.redact(finalText)}");
           } else {
             // Diary mode: non-streaming (need complete text for file save)
-            finalText = await LLMService().correctText(finalText, vocabHints: vocabHints, translateTo: _translateOverride).timeout(llmTimeout, onTimeout: () {
-              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish TIMEOUT (${llmTimeout.inSeconds}s), using raw ASR text");
+            finalText = await LLMService().correctText(finalText, vocabHints: vocabHints, translateTo: translateTo, status: llmStatus).timeout(llmTimeout, onTimeout: () {
+              _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish TIMEOUT (${llmTimeout.inMilliseconds}ms), using raw ASR text");
               return finalText;
             });
             _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish done (${finalText.length}字): ${AppLog.redact(finalText)}");
@@ -1823,7 +2443,8 @@ class CoreEngine {
             try { _clipEnd(); } catch (_) {}
           }
         }
-        lastLlmSuccess = LLMService().lastCallSucceeded;
+        llmSuccess = llmStatus.succeeded;
+        llmSpan.end(args: {'ok': llmSuccess, 'chars': finalText.length});
       } else if (finalText.isNotEmpty && ConfigService().aiCorrectionEnabled && trimmedForCheck.length <= 2) {
         _log("[PERF] +${sw.elapsedMilliseconds}ms — AI polish skipped (trivial input: ${AppLog.redact(finalText)})");
       } else if (finalText.isNotEmpty && ConfigService().vocabEnabled) {
@@ -1835,24 +2456,39 @@ class CoreEngine {
       // Fallback: Local Punctuation (Sherpa only, skip if model has built-in punctuation)
       final bool isLocalEngine = ConfigService().asrEngineType == 'sherpa';
       if (finalText.isNotEmpty && _punctuationEnabled && isLocalEngine && !_activeModelHasPunctuation) {
+        final punctSpan = latencyTrace.span('punctuation', session: session);
+        final punctWatch = Stopwatch()..start();
+        var presegmented = 0;
         if (!hasTerminalPunctuation(finalText)) {
-          final temp = addPunctuation(finalText);
+          // 说话期间已逐段加好 → 只补最后一段；对不上（润色 / 词库改过原文）就整段加
+          final incremental = punct == null ? null : await punct.finish(finalText);
+          if (incremental != null) presegmented = punct!.submittedCount;
+          final temp = incremental ?? await addPunctuation(finalText);
           if (temp != finalText) {
             finalText = temp;
           }
         }
-        _log("[PERF] +${sw.elapsedMilliseconds}ms — punctuation done");
+        punctSpan.end(args: {'chars': finalText.length, 'presegmented': presegmented});
+        _log("[PERF] +${sw.elapsedMilliseconds}ms — punctuation done (${punctWatch.elapsedMilliseconds}ms on key-up path, "
+            "${finalText.length}字, $presegmented segments punctuated while speaking)");
       }
+      punct?.cancel();
+
+      // 从这里开始往外交：等前面的听写都交完，注入 / 存笔记 / 聊天记录都按松键顺序
+      await turn.turn;
 
       // 保存 ASR 原文供主界面对比（仅当 LLM 有改动时）
+      lastLlmSuccess = llmSuccess;
       lastAsrOriginal = (originalAsrText != finalText) ? originalAsrText : null;
 
       _resultController.add(finalText);
 
       if (finalText.isNotEmpty) {
         if (mode == RecordingMode.diary) {
-          _statusController.add(
-              const EngineStatus.info("Saving Note...", code: 'saving_note'));
+          if (!_nextDictationRecording) {
+            _statusController.add(
+                const EngineStatus.info("Saving Note...", code: 'saving_note'));
+          }
 
           // 顺序要紧：**先**写聊天记录，再 await 笔记落盘。
           // ChatService 有自己的写入队列，且 AppService.dispose() 会 await
@@ -1866,12 +2502,16 @@ class CoreEngine {
           // 注：退出路径目前不会等待正在进行的 stopRecording()，
           // 所以这只缩小窗口、并不彻底关闭 —— 真正关闭要让退出流程等待
           // 在途的 stopRecording，属独立改动。
+          final saveSpan = latencyTrace.span('save note', track: 'inject', session: session);
           final err = await DiaryService().appendNote(finalText);
+          saveSpan.end(args: {'ok': err == null});
           if (err == null) {
-            _statusController.add(
-                const EngineStatus.info("Saved Note", code: 'note_saved'));
-            _overlay.showThenClear(_localizedText("Saved Note", 'note_saved'),
-                AppConstants.kSuccessDisplayDuration);
+            if (!_nextDictationRecording) {
+              _statusController.add(
+                  const EngineStatus.info("Saved Note", code: 'note_saved'));
+              _overlay.showThenClear(_localizedText("Saved Note", 'note_saved'),
+                  AppConstants.kSuccessDisplayDuration);
+            }
           } else {
             _statusController.add(const EngineStatus.error(
               "Save Failed",
@@ -1881,15 +2521,18 @@ class CoreEngine {
           }
         } else {
           var injected = true;
-          if (!_typewriterInjected) {
+          if (!typewriterInjected) {
+            final injectSpan = latencyTrace.span('inject', track: 'inject', session: session);
             injected = _nativeInput?.inject(finalText) ?? false;
+            injectSpan.end(args: {'chars': finalText.length, 'ok': injected});
           }
-          _typewriterInjected = false;
           // 文字仍然进聊天记录 —— 注入失败时那里是用户唯一能找回这段话的地方
           ChatService().addDictation(finalText, asrOriginal: originalAsrText);
           if (injected) {
-            _statusController.add(
-                const EngineStatus.ready("Ready", code: 'ready'));
+            if (!_nextDictationRecording) {
+              _statusController.add(
+                  const EngineStatus.ready("Ready", code: 'ready'));
+            }
           } else {
             // 注入失败绝不能静默：用户刚口述的整段话没进输入框，
             // 不说的话他只会对着没变化的界面发愣，还以为识别没成功。
@@ -1899,29 +2542,26 @@ class CoreEngine {
                 code: 'inject_failed'));
           }
         }
+        latencyTrace.annotate({'outcome': 'ok', 'chars': finalText.length}, session: session);
         _log("[PERF] +${sw.elapsedMilliseconds}ms — inject/save done");
       } else {
-        _statusController.add(
-            const EngineStatus.info("No Speech", code: 'no_speech'));
+        if (!_nextDictationRecording) {
+          _statusController.add(
+              const EngineStatus.info("No Speech", code: 'no_speech'));
+        }
+        latencyTrace.annotate({'outcome': 'no speech'}, session: session);
         _log("[PERF] +${sw.elapsedMilliseconds}ms — no speech detected");
       }
     }
     } finally {
-      // Report usage for billing (only when cloud services were consumed)
-      if (_recordingStartTime != null) {
-        final recordingSeconds = DateTime.now().difference(_recordingStartTime!).inSeconds;
-        // 云端 ASR，或 AI 润色（走云端 LLM）任一开启即消耗云服务
-        final usedCloud = ConfigService().workMode == 'cloud' ||
-            ConfigService().aiCorrectionEnabled;
-        if (usedCloud && recordingSeconds > 0) {
-          BillingService().reportUsage(recordingSeconds);
-        }
-        _recordingStartTime = null;
-      }
-      // Clear quick translate override
-      _translateOverride = null;
-      // Guarantee state recovery — no matter what happens above
-      _cleanupRecordingState();
+      // Guarantee state recovery — no matter what happens above.
+      // 已经 release 过的不再碰状态机：这时候可能已经在录下一句了
+      release();
+      // 已经在录下一句时浮窗归新的录音，不能替它关掉
+      if (ticket != null && !_nextDictationRecording) _overlay.hide();
+      ticket?.done();
+      final detached = trace;
+      if (detached != null) latencyTrace.endSession(session: detached);
       _log("[PERF] +${sw.elapsedMilliseconds}ms — stopRecording END");
     }
     } finally {
@@ -0,0 +1,210 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import '../config/app_constants.dart';
+
+/// 接上分开解出来的两段文本（窗口、预分段、逐段润色的结果）：两边都是拉丁字母 / 数字时
+/// 补一个空格 —— Whisper 英文的词间空格在 token 开头，各段 trim 过，直接连会粘成一个词
+String joinDecodedText(String a, String b) {
+  if (a.isEmpty) return b;
+  if (b.isEmpty) return a;
+  return _latinTail.hasMatch(a) && _latinHead.hasMatch(b) ? '$a $b' : '$a$b';
+}
+
+final RegExp _latinTail = RegExp(r'[A-Za-z0-9,.;:!?]$');
+final RegExp _latinHead = RegExp(r'^[A-Za-z0-9]');
+
+/// 一个解码窗口：[start, end) 样本
+class DecodeWindow {
+  final int start;
+  final int end;
+  const DecodeWindow(this.start, this.end);
+
+  int get length => end - start;
+
+  @override
+  String toString() => 'DecodeWindow($start, $end)';
+}
+
+/// 把一段录音切成不超过模型窗口的解码窗口。
+///
+/// Whisper 一类的离线模型只看 30 秒：原先整段送进去，超过的部分要么被截掉，
+/// 要么后半段越认越乱。这里保证每个窗口都不超过 [maxSamples]，
+/// 切点选在窗口后半段里最安静的一段停顿中间（10ms 一帧算能量，
+/// 按 300ms 滑动平均 —— 一两个字之间的换气压不下去，真正的停顿才压得下去），
+/// 下一个窗口从切点往前 [overlapSamples] 开始，切到说话中间时
+/// 两边都能认出重叠里的字，交给 [DecodeWindowMerger] 对齐去重。
+class DecodeWindowPlanner {
+  DecodeWindowPlanner({
+    required this.maxSamples,
+    this.overlapSamples = 0,
+  }) : assert(maxSamples > 0 && overlapSamples >= 0 && overlapSamples * 2 < maxSamples);
+
+  /// 按模型类型建；没有窗口限制的模型返回 null
+  static DecodeWindowPlanner? forModelType(String modelType,
+      {int sampleRate = AppConstants.kSampleRate}) {
+    final sec = AppConstants.kOfflineDecodeWindowSec[modelType];
+    if (sec == null) return null;
+    return DecodeWindowPlanner(
+      maxSamples: (sec * sampleRate).floor(),
+      overlapSamples: (AppConstants.kDecodeWindowOverlapSec * sampleRate).round(),
+    );
+  }
+
+  static const int _frame = 160; // 10ms
+  static const int _smoothFrames = 30; // 300ms
+
+  final int maxSamples;
+  final int overlapSamples;
+
+  /// 整段 [samples] 切成窗口，首尾相接（相邻两个重叠 [overlapSamples]）
+  List<DecodeWindow> plan(Float32List samples) {
+    final windows = <DecodeWindow>[];
+    var start = 0;
+    while (samples.length - start > maxSamples) {
+      final cut = firstCut(samples, start);
+      windows.add(DecodeWindow(start, cut));
+      start = cut - overlapSamples;
+    }
+    if (samples.length > start) windows.add(DecodeWindow(start, samples.length));
+    return windows;
+  }
+
+  /// 从 [start] 开始、且后面还有超过一个窗口的音频时，第一个窗口的切点
+  int firstCut(Float32List samples, int start) {
+    final limit = math.min(start + maxSamples, samples.length);
+    // 切点只在窗口后半段里找：窗口不会太碎，扣掉重叠之后每个窗口也一定往前走
+    final from = start + maxSamples ~/ 2;
+    if (limit - from < _frame) return limit;
+
+    final frames = (limit - from) ~/ _frame;
+    final energy = Float64List(frames);
+    for (var f = 0; f < frames; f++) {
+      var sum = 0.0;
+      final base = from + f * _frame;
+      for (var i = 0; i < _frame; i++) {
+        final v = samples[base + i];
+        sum += v * v;
+      }
+      energy[f] = sum / _frame;
+    }
+
+    // 前缀和求滑动平均，取最安静的；一样安静的取靠后的，窗口尽量长
+    final prefix = Float64List(frames + 1);
+    for (var f = 0; f < frames; f++) {
+      prefix[f + 1] = prefix[f] + energy[f];
+    }
+    const half = _smoothFrames ~/ 2;
+    var best = frames - 1;
+    var bestScore = double.infinity;
+    for (var f = 0; f < frames; f++) {
+      final lo = math.max(0, f - half), hi = math.min(frames, f + half + 1);
+      final score = (prefix[hi] - prefix[lo]) / (hi - lo);
+      if (score <= bestScore) {
+        bestScore = score;
+        best = f;
+      }
+    }
+    return from + best * _frame + _frame ~/ 2;
+  }
+}
+
+/// 按顺序接起各窗口的识别结果，去掉重叠里重复认出的字。
+///
+/// 新窗口和上一个窗口重叠的那段里，两边各自认出一串 token：
+/// 找两串里最长的一段相同 token 对齐，新窗口里对齐点之前的丢掉 ——
+/// 上一个窗口的结果已经交出去了（预分段会先送去润色），只能从新窗口这边删。
+/// 对不齐（重叠里只有一两个字、两边认得不一样）时按时间戳：
+/// 新窗口里不晚于上一个窗口最后一个 token 的丢掉。
+/// 时间戳全部换算成整段录音上的秒数。
+class DecodeWindowMerger {
+  DecodeWindowMerger({this.sampleRate = AppConstants.kSampleRate});
+
+  final int sampleRate;
+  final List<String> tokens = [];
+  final List<double> timestamps = [];
+  int _prevEnd = 0;
+
+  void reset() {
+    tokens.clear();
+    timestamps.clear();
+    _prevEnd = 0;
+  }
+
+  /// 接上 [start, end) 这一窗的结果（[windowTimestamps] 相对窗口开头），返回去重后的文本
+  String add({
+    required int start,
+    required int end,
+    required String text,
+    List<String> windowTokens = const [],
+    List<double> windowTimestamps = const [],
+  }) {
+    final offsetSec = start / sampleRate;
+    final hasTimes = windowTimestamps.length == windowTokens.length;
+    final ts = [
+      for (var i = 0; i < windowTokens.length; i++)
+        (hasTimes ? windowTimestamps[i] : 0.0) + offsetSec,
+    ];
+    final drop = start < _prevEnd && hasTimes ? _overlapCount(windowTokens, ts, start, _prevEnd) : 0;
+    _prevEnd = math.max(_prevEnd, end);
+
+    tokens.addAll(windowTokens.skip(drop));
+    timestamps.addAll(ts.skip(drop));
+    if (drop == 0) return text.trim();
+
+    // 文本就是 token 拼起来的（Whisper / Moonshine 都是）：用留下的 token 重拼；
+    // 否则从文本开头去掉丢掉的那几个 token；都对不上就整段保留 —— 重复几个字好过丢字
+    if (windowTokens.join().trim() == text.trim()) return windowTokens.skip(drop).join().trim();
+    final dropped = windowTokens.take(drop).join();
+    final trimmed = text.trimLeft();
+    if (trimmed.startsWith(dropped.trimLeft())) {
+      return trimmed.substring(dropped.trimLeft().length).trim();
+    }
+    return text.trim();
+  }
+
+  /// 新窗口开头要丢掉几个 token
+  int _overlapCount(List<String> next, List<double> nextTs, int start, int prevEnd) {
+    final startSec = start / sampleRate, prevEndSec = prevEnd / sampleRate;
+    var tailFrom = tokens.length;
+    while (tailFrom > 0 && timestamps[tailFrom - 1] >= startSec) {
+      tailFrom--;
+    }
+    final prevTail = tokens.sublist(tailFrom);
+    var headLen = 0;
+    while (headLen < next.length && nextTs[headLen] < prevEndSec) {
+      headLen++;
+    }
+    if (prevTail.isEmpty || headLen == 0) return 0;
+
+    // 最长公共连续子串（重叠 1 秒，两边各十来个 token，平方就够）
+    var bestLen = 0, bestI = 0, bestJ = 0;
+    var row = List<int>.filled(headLen + 1, 0);
+    for (var i = 1; i <= prevTail.length; i++) {
+      final cur = List<int>.filled(headLen + 1, 0);
+      for (var j = 1; j <= headLen; j++) {
+        if (prevTail[i - 1] == next[j - 1]) {
+          cur[j] = row[j - 1] + 1;
+          if (cur[j] > bestLen) {
+            bestLen = cur[j];
+            bestI = i;
+            bestJ = j;
+          }
+        }
+      }
+      row = cur;
+    }
+    // 单个 token 对上多半是巧合（「的」「the」），除非两边都只有一个
+    if (bestLen >= 2 || (bestLen == 1 && prevTail.length == 1 && headLen == 1)) {
+      // 对齐之后，上一个窗口结尾对应到新窗口的位置
+      return math.min(next.length, bestJ + (prevTail.length - bestI));
+    }
+
+    final lastPrev = timestamps.last;
+    var drop = 0;
+    while (drop < headLen && nextTs[drop] <= lastPrev) {
+      drop++;
+    }
+    return drop;
+  }
+}
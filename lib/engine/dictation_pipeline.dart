@@ -0,0 +1,52 @@
+import 'dart:async';
+
+/// 松键后的收尾（润色 / 标点 / 注入）排成流水线：每次听写拿一个 [DictationTicket]，
+/// 收尾各自并发跑，真正往外交文字（注入、打字机粘贴、存笔记、出结果）之前
+/// 先等 [DictationTicket.turn] —— 前面的都交完了才轮到它。
+///
+/// 原先整个收尾都在录音状态机里，processing 不回 idle 就不让开录：
+/// 连着口述的人每句之间要干等一次 LLM 往返。现在识别结果一到手状态就回 idle，
+/// 下一句马上能录；但前一句的润色可能比后一句慢，注入顺序不能跟着乱。
+class DictationPipeline {
+  Future<void> _tail = Future.value();
+  int _nextSeq = 1;
+  int _inFlight = 0;
+
+  /// 还没 [DictationTicket.done] 的听写数
+  int get inFlight => _inFlight;
+
+  /// 排一个号；调用方必须在 finally 里 [DictationTicket.done]，否则后面的全卡住
+  DictationTicket enter() {
+    final previous = _tail;
+    final ticket = DictationTicket._(this, _nextSeq++, previous);
+    // 没轮到就先 done 的（识别为空、出错提前收尾）也不能让后面的插到前面去
+    _tail = previous.then((_) => ticket._done.future);
+    _inFlight++;
+    return ticket;
+  }
+
+  /// 目前排着的都交完（退出前等一下，别把正在存的笔记丢了）
+  Future<void> drain() => _tail;
+}
+
+class DictationTicket {
+  DictationTicket._(this._pipeline, this.seq, this.turn);
+
+  final DictationPipeline _pipeline;
+
+  /// 第几次听写（从 1 开始），日志里对得上号
+  final int seq;
+
+  /// 前面的听写都交完了
+  final Future<void> turn;
+  final Completer<void> _done = Completer<void>();
+
+  bool get isDone => _done.isCompleted;
+
+  /// 这次交完了（或者放弃了），轮到下一个；重复调用忽略
+  void done() {
+    if (_done.isCompleted) return;
+    _done.complete();
+    _pipeline._inFlight--;
+  }
+}
@@ -0,0 +1,281 @@
+import 'dart:collection';
+import 'dart:convert';
+
+import '../config/app_constants.dart';
+
+/// 一个阶段（有起止）或一个时刻（[durUs] 为 null）。时间都是 [LatencyTracer] 的单调钟微秒。
+class TraceEvent {
+  TraceEvent(this.name, this.track, this.startUs, this.durUs, this.args);
+
+  final String name;
+
+  /// 画在哪一行：`native-key` / `native-capture` / `engine` / `asr` / `llm` / `inject`
+  final String track;
+  final int startUs;
+  final int? durUs;
+  final Map<String, Object?> args;
+}
+
+/// 一次听写：从按键到文字出现（或取消）。
+class TraceSession {
+  TraceSession._(this.id, this.startUs, this.args);
+
+  final int id;
+  final int startUs;
+
+  /// 会话级信息：mode / asr / model / llm 等，导出时写进进程名，方便按 provider、模型比对
+  final Map<String, Object?> args;
+  final List<TraceEvent> events = [];
+  final List<TraceSpan> _open = [];
+  int? endUs;
+
+  /// 超出 [AppConstants.kLatencyTraceMaxEvents] 被丢掉的事件数
+  int droppedEvents = 0;
+
+  bool get isFinished => endUs != null;
+}
+
+/// [LatencyTracer.span] 打开的阶段，[end] 时才落成事件。
+class TraceSpan {
+  TraceSpan._(this._tracer, this._session, this.name, this.track, this.startUs, this.args);
+
+  final LatencyTracer _tracer;
+  final TraceSession _session;
+  final String name;
+  final String track;
+  final int startUs;
+  final Map<String, Object?> args;
+  bool _ended = false;
+
+  /// 重复 end、或会话已经结束（结束时会把它按未完成收掉）都忽略
+  void end({Map<String, Object?>? args}) {
+    if (_ended || _session.isFinished) return;
+    _ended = true;
+    _session._open.remove(this);
+    if (args != null) this.args.addAll(args);
+    _tracer._add(_session, TraceEvent(name, track, startUs, _tracer.nowUs() - startUs, this.args));
+  }
+}
+
+/// 一次会话期间的 UI 帧耗时汇总，结束时作为会话信息写进 trace。
+/// Flutter 的 build（UI 线程）和 raster 是流水线，一帧的耗时取两者中长的那个。
+class FrameStats {
+  FrameStats({int? budgetUs})
+      : budgetUs = budgetUs ?? AppConstants.kLatencyTraceFrameBudget.inMicroseconds;
+
+  final int budgetUs;
+  int frames = 0;
+  int overBudget = 0;
+  int worstUs = 0;
+  int _totalUs = 0;
+
+  void add(int buildUs, int rasterUs) {
+    final us = buildUs > rasterUs ? buildUs : rasterUs;
+    frames++;
+    _totalUs += us;
+    if (us > worstUs) worstUs = us;
+    if (us > budgetUs) overBudget++;
+  }
+
+  void reset() {
+    frames = 0;
+    overBudget = 0;
+    worstUs = 0;
+    _totalUs = 0;
+  }
+
+  /// 没有帧（悬浮窗没动、或平台不报帧时间）时为空，不往会话里塞零
+  Map<String, Object?> toArgs() => frames == 0
+      ? const {}
+      : {
+          'frames': frames,
+          'frameAvgMs': (_totalUs / frames / 1000).toStringAsFixed(2),
+          'frameWorstMs': (worstUs / 1000).toStringAsFixed(2),
+          'framesOverBudget': overBudget,
+        };
+}
+
+/// 听写各阶段的耗时记录，保留最近 [capacity] 次会话，导出为 Chrome trace-event JSON
+/// （chrome://tracing 或 ui.perfetto.dev 直接打开）。
+///
+/// 原先只有 stopRecording 里的 `[PERF] +Nms` 日志：只从松键算起，按键回调排队多久、
+/// 设备开多久、第一条字幕什么时候出来都看不到；而且散在日志里，
+/// 没法把「换了 provider / 模型之后」和之前的几十次放在一起比。
+///
+/// 只在主 isolate 上用，不加锁。时间取自一个单调的 [Stopwatch]，不受系统改时间影响；
+/// native 线程上打的时刻用 [alignNative] 换算到这个钟上。
+class LatencyTracer {
+  LatencyTracer({
+    this.capacity = AppConstants.kLatencyTraceSessions,
+    this.maxEventsPerSession = AppConstants.kLatencyTraceMaxEvents,
+  });
+
+  final int capacity;
+  final int maxEventsPerSession;
+  final Stopwatch _clock = Stopwatch()..start();
+  final ListQueue<TraceSession> _sessions = ListQueue();
+  TraceSession? _current;
+  int _nextId = 1;
+
+  int nowUs() => _clock.elapsedMicroseconds;
+
+  /// 正在记的会话；没有时为 null
+  TraceSession? get current => _current;
+
+  /// 已结束的会话，旧的在前
+  List<TraceSession> get sessions => List.unmodifiable(_sessions);
+
+  /// 开始一次会话。上一次还没结束（异常路径没走到 [endSession]）就先按未完成收掉。
+  /// [atUs] 可以早于现在 —— 比如 native 按键时刻。
+  TraceSession beginSession({int? atUs, Map<String, Object?>? args}) {
+    if (_current != null) endSession(args: {'outcome': 'superseded'});
+    final session = TraceSession._(_nextId++, atUs ?? nowUs(), {...?args});
+    _current = session;
+    return session;
+  }
+
+  /// 当前会话转到后台收尾：不再是 [current]，下一次 [beginSession] 也不会把它当
+  /// superseded 收掉。之后往它上面记要显式传 `session:`，最后 `endSession(session:)`。
+  ///
+  /// 听写识别完就放下一句开录了（见 DictationPipeline），上一句的润色 / 注入
+  /// 还在跑，不能记到新会话上。没有会话时返回一个什么都不记的空会话。
+  TraceSession detach() {
+    final session = _current;
+    _current = null;
+    return session ?? _detached;
+  }
+
+  /// 补充会话级信息（provider 在会话中途才定下来的情况）
+  void annotate(Map<String, Object?> args, {TraceSession? session}) {
+    final target = session ?? _current;
+    if (target == null || target.isFinished) return;
+    target.args.addAll(args);
+  }
+
+  /// 从现在开始一个阶段。没有会话时返回一个什么都不记的 span，调用方不用判空。
+  /// [session] 为 null 时记在 [current] 上。
+  TraceSpan span(String name,
+      {String track = 'engine', Map<String, Object?>? args, TraceSession? session}) {
+    session ??= _current ?? _detached;
+    final span = TraceSpan._(this, session, name, track, nowUs(), {...?args});
+    if (!session.isFinished) session._open.add(span);
+    return span;
+  }
+
+  /// 起止都已知的阶段（比如从 native 时刻换算来的）。[endUs] 早于 [startUs] 时不记。
+  void complete(String name, int startUs, int endUs,
+      {String track = 'engine', Map<String, Object?>? args}) {
+    final session = _current;
+    if (session == null || endUs < startUs) return;
+    _add(session, TraceEvent(name, track, startUs, endUs - startUs, {...?args}));
+  }
+
+  void instant(String name,
+      {int? atUs, String track = 'engine', Map<String, Object?>? args, TraceSession? session}) {
+    session ??= _current;
+    if (session == null || session.isFinished) return;
+    _add(session, TraceEvent(name, track, atUs ?? nowUs(), null, {...?args}));
+  }
+
+  /// 把 native 单调钟上的时刻 [stampUs] 换算到本 tracer 的钟上。
+  /// [nativeNowUs] 是紧挨着调用时从 native 取的「现在」，两个钟的差就此对齐，
+  /// 误差是这一次 FFI 调用本身（几微秒）。
+  int alignNative(int stampUs, {required int nativeNowUs}) =>
+      nowUs() - (nativeNowUs - stampUs);
+
+  /// 结束当前会话（或 [detach] 出去的 [session]），进环形缓冲。还开着的阶段按未完成收到此刻 ——
+  /// 卡在哪一步（比如 LLM 超时）在导出里一眼能看到。
+  void endSession({Map<String, Object?>? args, TraceSession? session}) {
+    session ??= _current;
+    if (session == null || session.isFinished) return;
+    final now = nowUs();
+    for (final span in List.of(session._open)) {
+      span._ended = true;
+      _add(session, TraceEvent(span.name, span.track, span.startUs, now - span.startUs,
+          {...span.args, 'unfinished': true}));
+    }
+    session._open.clear();
+    if (args != null) session.args.addAll(args);
+    session.endUs = now;
+    if (identical(session, _current)) _current = null;
+    _sessions.addLast(session);
+    while (_sessions.length > capacity) {
+      _sessions.removeFirst();
+    }
+  }
+
+  void clear() {
+    _sessions.clear();
+    _current = null;
+  }
+
+  void _add(TraceSession session, TraceEvent event) {
+    if (session == _detached) return;
+    if (session.events.length >= maxEventsPerSession) {
+      session.droppedEvents++;
+      return;
+    }
+    session.events.add(event);
+  }
+
+  /// 没有会话时 [span] 挂在这上面，end 时直接丢弃
+  late final TraceSession _detached = TraceSession._(0, 0, {})..endUs = 0;
+
+  static const _tracks = ['native-key', 'native-capture', 'engine', 'asr', 'llm', 'inject'];
+
+  /// Chrome trace-event 格式：每次会话一个「进程」，各 track 一个「线程」。
+  /// 时间从各自会话开始算起，几十次会话上下排开、左端对齐，同一阶段直接比长短；
+  /// 按墙上时间排的话会话之间隔着几分钟，缩放到能看清一次就看不到别的。
+  Map<String, Object?> toChromeTrace() {
+    final events = <Map<String, Object?>>[];
+    for (final session in _sessions) {
+      final pid = session.id;
+      final label = [
+        '#${session.id}',
+        for (final key in ['mode', 'asr', 'model'])
+          if (session.args[key] != null) '${session.args[key]}',
+      ].join(' ');
+      events.add({
+        'name': 'process_name', 'ph': 'M', 'pid': pid, 'tid': 0,
+        'args': {'name': label},
+      });
+      events.add({
+        'name': 'process_sort_index', 'ph': 'M', 'pid': pid, 'tid': 0,
+        'args': {'sort_index': session.id},
+      });
+      final used = <String>{for (final e in session.events) e.track};
+      for (final track in used) {
+        events.add({
+          'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': _tid(track),
+          'args': {'name': track},
+        });
+      }
+      events.add({
+        'name': 'session', 'cat': 'session', 'ph': 'X', 'pid': pid, 'tid': _tid('engine'),
+        'ts': 0, 'dur': (session.endUs ?? session.startUs) - session.startUs,
+        'args': {...session.args, if (session.droppedEvents > 0) 'droppedEvents': session.droppedEvents},
+      });
+      for (final e in session.events) {
+        events.add({
+          'name': e.name,
+          'cat': e.track,
+          'ph': e.durUs == null ? 'i' : 'X',
+          if (e.durUs == null) 's': 't',
+          'pid': pid,
+          'tid': _tid(e.track),
+          'ts': e.startUs - session.startUs,
+          if (e.durUs != null) 'dur': e.durUs,
+          if (e.args.isNotEmpty) 'args': e.args,
+        });
+      }
+    }
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'};
+  }
+
+  String toChromeTraceJson() => jsonEncode(toChromeTrace());
+
+  static int _tid(String track) {
+    final i = _tracks.indexOf(track);
+    return i >= 0 ? i + 1 : _tracks.length + 1;
+  }
+}
@@ -0,0 +1,346 @@
+import 'dart:convert';
+import 'dart:io';
+import 'package:crypto/crypto.dart';
+import 'package:flutter/foundation.dart';
+import 'package:speakout/config/app_log.dart';
+
+/// 目录完整性检查结果
+enum BlobCheck {
+  /// 清单里没有这个目录（旧版本装的 / 入库前崩溃），调用方按原有规则判断
+  unknown,
+  /// 与清单一致
+  intact,
+  /// 与清单不符且重新哈希确认内容已变 —— 不能再当成可用模型
+  damaged,
+}
+
+/// 清单里的一条文件记录
+class BlobRecord {
+  final String sha256;
+  final int size;
+  final int mtimeMs;
+
+  /// 是否已硬链接进 blob 库。沙盒里 `ln` 不可用时只记哈希、不去重。
+  final bool linked;
+
+  const BlobRecord({
+    required this.sha256,
+    required this.size,
+    required this.mtimeMs,
+    required this.linked,
+  });
+
+  factory BlobRecord.fromJson(Map<String, dynamic> json) => BlobRecord(
+        sha256: json['sha256'] as String,
+        size: json['size'] as int,
+        mtimeMs: json['mtime'] as int,
+        linked: json['linked'] as bool? ?? false,
+      );
+
+  Map<String, dynamic> toJson() =>
+      {'sha256': sha256, 'size': size, 'mtime': mtimeMs, 'linked': linked};
+}
+
+/// 模型文件的内容寻址存储：`Models/.blobs/<前两位>/<sha256>`。
+///
+/// 每个模型目录里的大文件按 SHA-256 入库一次，再硬链接回模型目录 ——
+/// Provider 仍按原路径加载，`_isValidModelDir` 看到的仍是普通文件
+/// （用符号链接的话 `listSync(followLinks: false)` 会把它们列成 Link，校验全挂）。
+/// 共用同一份权重的模型（如 SenseVoice 的几个变体）因此只占一份磁盘。
+///
+/// `manifest.json` 记录每个目录的 {相对路径 → sha256/size/mtime}，
+/// 启动时的完整性检查只比 stat，不再重读几百 MB 的 .onnx；
+/// 只有 stat 对不上的文件才重新哈希确认。
+class ModelBlobStore {
+  ModelBlobStore(this.modelsRoot);
+
+  final Directory modelsRoot;
+
+  static const String blobDirName = '.blobs';
+  static const String _manifestName = 'manifest.json';
+
+  /// 小于此大小的文件（tokens.txt、config 之类）不值得入库，只记哈希
+  static const int kMinBlobBytes = 64 * 1024;
+
+  /// 同时哈希的文件数。大模型就两三个大文件，开满核反而抢 UI isolate 的 CPU。
+  static int get _hashConcurrency => Platform.numberOfProcessors.clamp(1, 4);
+
+  Directory get blobDir => Directory('${modelsRoot.path}/$blobDirName');
+  File get _manifestFile => File('${blobDir.path}/$_manifestName');
+
+  /// dirName → {相对路径 → 记录}。懒加载，之后只在内存里改、整体落盘。
+  Map<String, Map<String, BlobRecord>>? _manifest;
+
+  File blobFile(String sha256) =>
+      File('${blobDir.path}/${sha256.substring(0, 2)}/$sha256');
+
+  String _dirKey(Directory dir) =>
+      dir.path.substring(modelsRoot.path.length + 1).replaceAll('\\', '/');
+
+  Future<Map<String, Map<String, BlobRecord>>> _load() async {
+    if (_manifest != null) return _manifest!;
+    final result = <String, Map<String, BlobRecord>>{};
+    try {
+      if (await _manifestFile.exists()) {
+        final json = jsonDecode(await _manifestFile.readAsString())
+            as Map<String, dynamic>;
+        final dirs = json['dirs'] as Map<String, dynamic>? ?? {};
+        for (final entry in dirs.entries) {
+          final files = entry.value as Map<String, dynamic>;
+          result[entry.key] = files.map((k, v) =>
+              MapEntry(k, BlobRecord.fromJson(v as Map<String, dynamic>)));
+        }
+      }
+    } catch (e) {
+      // 清单坏了只意味着「不知道」，不能意味着「模型坏了」—— 退回 unknown 路径
+      AppLog.d('[BlobStore] 清单解析失败，忽略: $e');
+    }
+    return _manifest = result;
+  }
+
+  /// 落盘排成一条链：并发的 ingest / verify / forget 各自 _save 的话都写同一个
+  /// manifest.json.tmp，两个交错写会把写了一半的文件 rename 过去
+  Future<void> _saving = Future.value();
+
+  Future<void> _save() {
+    final next = _saving.then((_) => _writeManifest());
+    _saving = next.catchError((_) {});
+    return next;
+  }
+
+  Future<void> _writeManifest() async {
+    final manifest = await _load();
+    await blobDir.create(recursive: true);
+    final json = jsonEncode({
+      'version': 1,
+      'dirs': manifest.map((dir, files) =>
+          MapEntry(dir, files.map((k, v) => MapEntry(k, v.toJson())))),
+    });
+    // 先写临时文件再 rename：写到一半崩溃留下半个 JSON，下次启动就全成 unknown 了
+    final tmp = File('${_manifestFile.path}.tmp');
+    await tmp.writeAsString(json, flush: true);
+    await tmp.rename(_manifestFile.path);
+  }
+
+  /// 哈希 [modelDir] 下所有文件、大文件入库并硬链接回原处，记录清单。
+  ///
+  /// 在安装完成（正式目录已就位、校验已通过）之后调用；失败只打日志 ——
+  /// 入库是优化，不能让一次 `ln` 失败把已经装好的模型变成「安装失败」。
+  Future<void> ingest(Directory modelDir) async {
+    try {
+      final files = await modelDir
+          .list(recursive: true, followLinks: false)
+          .where((e) => e is File)
+          .cast<File>()
+          .toList();
+      final digests = await _hashAll(files.map((f) => f.path).toList());
+
+      final records = <String, BlobRecord>{};
+      int deduped = 0;
+      for (var i = 0; i < files.length; i++) {
+        final file = files[i];
+        final hash = digests[i];
+        final size = await file.length();
+        var linked = false;
+        if (size >= kMinBlobBytes) {
+          final (ok, reused) = await _linkIntoStore(file, hash, size);
+          linked = ok;
+          if (reused) deduped += size;
+        }
+        final stat = await file.stat();
+        final rel = file.path
+            .substring(modelDir.path.length + 1)
+            .replaceAll('\\', '/');
+        records[rel] = BlobRecord(
+          sha256: hash,
+          size: stat.size,
+          mtimeMs: stat.modified.millisecondsSinceEpoch,
+          linked: linked,
+        );
+      }
+
+      (await _load())[_dirKey(modelDir)] = records;
+      await _save();
+      AppLog.d('[BlobStore] 入库 ${_dirKey(modelDir)}: ${records.length} 个文件'
+          '${deduped > 0 ? '，复用已有 blob ${(deduped / 1048576).toStringAsFixed(1)}MB' : ''}');
+    } catch (e) {
+      AppLog.d('[BlobStore] 入库失败 ${modelDir.path}: $e');
+    }
+  }
+
+  /// 返回 (是否已链接, 是否复用了已有 blob)
+  Future<(bool, bool)> _linkIntoStore(File file, String hash, int size) async {
+    final blob = blobFile(hash);
+    try {
+      await blob.parent.create(recursive: true);
+      if (await blob.exists() && await blob.length() == size) {
+        // 已有同内容 blob：把本文件换成指向它的硬链接。
+        // 先链到临时名再 rename 覆盖，中途崩溃也不会留下一个缺文件的模型目录。
+        final tmp = '${file.path}.blobtmp';
+        if (!await _hardLink(blob.path, tmp)) return (false, false);
+        await File(tmp).rename(file.path);
+        return (true, true);
+      }
+      // 长度对不上的 blob 是残缺的（上次入库中途崩溃），用本文件取代
+      if (await blob.exists()) await blob.delete();
+      return (await _hardLink(file.path, blob.path), false);
+    } catch (e) {
+      AppLog.d('[BlobStore] 链接失败 ${file.path}: $e');
+      return (false, false);
+    }
+  }
+
+  /// Dart 没有硬链接 API（Link 只会建符号链接），借系统命令。
+  /// App Store 沙盒下 Process.run 会抛异常 —— 与 _extractModelTask 的 tar 同一处理：
+  /// 退化为不去重，文件留在原地。
+  static Future<bool> _hardLink(String existing, String newPath) async {
+    try {
+      final result = Platform.isWindows
+          ? await Process.run('cmd', ['/c', 'mklink', '/H', newPath, existing])
+          : await Process.run('ln', [existing, newPath]);
+      return result.exitCode == 0;
+    } catch (_) {
+      return false;
+    }
+  }
+
+  Future<List<String>> _hashAll(List<String> paths) async {
+    final results = List<String>.filled(paths.length, '');
+    if (paths.isEmpty) return results;
+    var next = 0;
+    Future<void> worker() async {
+      while (next < paths.length) {
+        final i = next++;
+        results[i] = await compute(_sha256OfFile, paths[i]);
+      }
+    }
+
+    final workers =
+        paths.length < _hashConcurrency ? paths.length : _hashConcurrency;
+    await Future.wait(List.generate(workers, (_) => worker()));
+    return results;
+  }
+
+  /// 按清单检查 [modelDir]。
+  ///
+  /// 先只比 size/mtime（不读文件）；对不上的文件才重新哈希 ——
+  /// mtime 被备份/同步工具碰过但内容没变时，刷新记录并视为完好。
+  Future<BlobCheck> verify(Directory modelDir) async {
+    final manifest = await _load();
+    final records = manifest[_dirKey(modelDir)];
+    if (records == null) return BlobCheck.unknown;
+
+    final suspects = <String>[];
+    for (final entry in records.entries) {
+      final file = File('${modelDir.path}/${entry.key}');
+      try {
+        final stat = await file.stat();
+        if (stat.type != FileSystemEntityType.file) return BlobCheck.damaged;
+        if (stat.size != entry.value.size) return BlobCheck.damaged;
+        if (stat.modified.millisecondsSinceEpoch != entry.value.mtimeMs) {
+          suspects.add(entry.key);
+        }
+      } catch (_) {
+        return BlobCheck.damaged;
+      }
+    }
+    if (suspects.isEmpty) return BlobCheck.intact;
+
+    // 这里是 getActiveModelPath 的路径：读盘 / 写清单偶尔出错（文件被占用、
+    // 盘满）只能说明「这次没确认」，按 unknown 交回调用方的原有规则，不能让查模型抛异常
+    try {
+      final digests =
+          await _hashAll(suspects.map((r) => '${modelDir.path}/$r').toList());
+      for (var i = 0; i < suspects.length; i++) {
+        if (digests[i] != records[suspects[i]]!.sha256) {
+          AppLog.d('[BlobStore] 内容校验失败: ${_dirKey(modelDir)}/${suspects[i]}');
+          return BlobCheck.damaged;
+        }
+      }
+      for (final rel in suspects) {
+        final old = records[rel]!;
+        final stat = await File('${modelDir.path}/$rel').stat();
+        records[rel] = BlobRecord(
+          sha256: old.sha256,
+          size: old.size,
+          mtimeMs: stat.modified.millisecondsSinceEpoch,
+          linked: old.linked,
+        );
+      }
+      await _save();
+    } catch (e) {
+      AppLog.d('[BlobStore] 校验出错，按未校验处理 ${_dirKey(modelDir)}: $e');
+      return BlobCheck.unknown;
+    }
+    return BlobCheck.intact;
+  }
+
+  /// 清单记录的目录总大小；没记录返回 null（调用方自行遍历）
+  Future<int?> recordedSize(Directory modelDir) async {
+    final records = (await _load())[_dirKey(modelDir)];
+    if (records == null) return null;
+    return records.values.fold<int>(0, (sum, r) => sum + r.size);
+  }
+
+  /// 删除 [modelDir] 能**真正**释放的字节数：未入库的文件 + 只被它引用的 blob。
+  /// 与别的模型共用的 blob 删了目录也不会释放，不能算进去。
+  Future<int?> exclusiveSize(Directory modelDir) async {
+    final manifest = await _load();
+    final key = _dirKey(modelDir);
+    final records = manifest[key];
+    if (records == null) return null;
+    final shared = <String>{
+      for (final e in manifest.entries)
+        if (e.key != key)
+          for (final r in e.value.values)
+            if (r.linked) r.sha256,
+    };
+    return records.values
+        .where((r) => !r.linked || !shared.contains(r.sha256))
+        .fold<int>(0, (sum, r) => sum + r.size);
+  }
+
+  /// 目录已删除/被替换：移除清单记录（不动 blob，交给 [collectGarbage]）。
+  /// 返回其中未入库文件的字节数 —— 这部分随目录删除即释放，入库的要等 GC。
+  Future<int> forget(Directory modelDir) async {
+    final manifest = await _load();
+    final removed = manifest.remove(_dirKey(modelDir));
+    if (removed == null) return 0;
+    await _save();
+    return removed.values
+        .where((r) => !r.linked)
+        .fold<int>(0, (sum, r) => sum + r.size);
+  }
+
+  /// 删除不再被任何清单记录引用的 blob，返回释放的字节数。
+  Future<int> collectGarbage() async {
+    if (!await blobDir.exists()) return 0;
+    final manifest = await _load();
+    final live = <String>{
+      for (final files in manifest.values)
+        for (final r in files.values)
+          if (r.linked) r.sha256,
+    };
+    int freed = 0;
+    await for (final e in blobDir.list(recursive: true, followLinks: false)) {
+      if (e is! File) continue;
+      final name = e.path.split(Platform.pathSeparator).last;
+      if (name == _manifestName || name.endsWith('.tmp')) continue;
+      if (live.contains(name)) continue;
+      try {
+        final size = await e.length();
+        await e.delete();
+        freed += size;
+      } catch (err) {
+        AppLog.d('[BlobStore] 清理 blob 失败 $name: $err');
+      }
+    }
+    return freed;
+  }
+}
+
+/// Top-level for compute：流式分块哈希，不把整个 .onnx 读进内存
+Future<String> _sha256OfFile(String path) async {
+  final digest = await sha256.bind(File(path).openRead()).first;
+  return digest.toString();
+}
@@ -6,6 +6,7 @@ import 'package:flutter/foundation.dart';
 import 'package:speakout/config/app_constants.dart';
 import 'package:speakout/services/config_service.dart';
 import 'package:speakout/config/app_log.dart';
+import 'model_blob_store.dart';
 
 /// 模型架构分类，用于确定 Phase 2 置信度支持能力
 enum ModelArch {
@@ -278,6 +279,15 @@ class ModelManager {
     return Directory('${appSupportDir.path}/Models');
   }
 
+  /// 按模型根目录缓存 —— 清单在内存里维护，同一根目录必须共用一个实例，
+  /// 否则两个实例各自落盘会互相覆盖对方的记录。
+  static final Map<String, ModelBlobStore> _blobStores = {};
+
+  Future<ModelBlobStore> _blobStore() async {
+    final root = await _getModelsRoot();
+    return _blobStores.putIfAbsent(root.path, () => ModelBlobStore(root));
+  }
+
   /// 随包内置模型的目录（打包脚本在 codesign 前注入到 app bundle 的 Resources 下）。
   ///
   /// 路径推算：`.../SpeakOut.app/Contents/MacOS/SpeakOut` → `.../Contents/Resources/models/<dir>`
@@ -326,46 +336,56 @@ class ModelManager {
   ///
   /// 老用户升级到内置版本后，之前下载的那份就纯属冗余（同一 URL、同一目录、同一内容），
   /// 但不会自动删 —— 删用户数据目录得由用户自己点。返回总字节数与目录列表。
+  ///
+  /// 已入库的目录直接用清单算「删了能释放多少」（与别的模型共用的 blob 不算），
+  /// 不再逐个遍历几百 MB 的目录；旧版本装的目录没有清单，仍走遍历。
   Future<(int, List<Directory>)> findRedundantBundledCopies() async {
     final dirs = <Directory>[];
     int total = 0;
     final modelsRoot = await _getModelsRoot();
     if (!await modelsRoot.exists()) return (0, dirs);
+    final store = await _blobStore();
     for (final m in allModels) {
       if (bundledModelDir(m.id) == null) continue; // 没内置就谈不上冗余
       final dup = Directory('${modelsRoot.path}/${_getDirNameFromUrl(m.url)}');
       if (!await dup.exists()) continue;
-      int size = 0;
-      try {
-        await for (final e in dup.list(recursive: true, followLinks: false)) {
-          if (e is File) size += await e.length();
-        }
-      } catch (_) {}
       dirs.add(dup);
-      total += size;
+      total += await store.exclusiveSize(dup) ?? await _walkSize(dup);
     }
     return (total, dirs);
   }
 
+  Future<int> _walkSize(Directory dir) async {
+    int size = 0;
+    try {
+      await for (final e in dir.list(recursive: true, followLinks: false)) {
+        if (e is File) size += await e.length();
+      }
+    } catch (_) {}
+    return size;
+  }
+
   /// 删除上面找出的冗余副本。内置那份在 app bundle 内，不受影响。
   /// 返回**实际释放**的字节数（不是检测到的总量）——
   /// 删除可能因权限/占用失败，返回 total 会让 UI 谎报「已释放 229MB」。
   Future<int> cleanupRedundantBundledCopies() async {
     final (_, dirs) = await findRedundantBundledCopies();
+    final store = await _blobStore();
     int freed = 0;
     for (final d in dirs) {
-      int size = 0;
       try {
-        await for (final e in d.list(recursive: true, followLinks: false)) {
-          if (e is File) size += await e.length();
-        }
+        // 有清单的目录：入库文件的空间要等 blob 没人引用、GC 掉才真正释放，
+        // 所以这里只计未入库的部分，其余由下面的 collectGarbage 如实返回。
+        final known = await store.recordedSize(d) != null;
+        final size = known ? 0 : await _walkSize(d);
         await d.delete(recursive: true);
-        freed += size; // 只在删除确实成功后计入
+        freed += size + await store.forget(d); // 只在删除确实成功后计入
         AppLog.d('[Model] 已清理冗余副本: ${d.path}');
       } catch (e) {
         AppLog.d('[Model] 清理失败 ${d.path}: $e');
       }
     }
+    freed += await store.collectGarbage();
     return freed;
   }
 
@@ -391,7 +411,13 @@ class ModelManager {
     );
 
     final local = _findValidModelDir(model, modelRoot.path);
-    if (local != null) return local;
+    // 文件齐全不代表内容完好：被截断/覆写的 .onnx 照样「非空」，
+    // 交给 sherpa 加载只会在 FFI 里崩。清单比对只看 stat，启动时几乎零成本。
+    if (local != null &&
+        await (await _blobStore()).verify(modelRoot) != BlobCheck.damaged) {
+      return local;
+    }
+    if (local != null) AppLog.d('[Model] 模型文件与清单不符，不再使用: ${modelRoot.path}');
 
     // 3. 兜底：随包内置的模型。
     //    放最后而非最前 —— 用户主动下载/导入的副本必须优先，
@@ -538,7 +564,11 @@ class ModelManager {
     final backupDir = Directory('${finalDir.path}.old');
     if (!await backupDir.exists()) return;
 
-    if (await finalDir.exists() && isValid(finalDir.path)) {
+    // 「文件齐全」不够：内容与清单对不上（文件被写坏）而备份可用时，回滚到备份。
+    final store = await _blobStore();
+    if (await finalDir.exists() &&
+        isValid(finalDir.path) &&
+        await store.verify(finalDir) != BlobCheck.damaged) {
       try {
         await backupDir.delete(recursive: true);
       } catch (e) {
@@ -554,6 +584,8 @@ class ModelManager {
 
     if (await finalDir.exists()) await finalDir.delete(recursive: true);
     await backupDir.rename(finalDir.path);
+    // 清单记录的是被丢弃的那份内容，留着会让恢复回来的目录被判为损坏
+    await store.forget(finalDir);
     AppLog.d('[Model] 已恢复中断安装留下的备份: ${finalDir.path}');
   }
 
@@ -570,6 +602,11 @@ class ModelManager {
       throw Exception('发现无法自动恢复的安装备份: ${backupDir.path}');
     }
 
+    // 先撤掉旧内容的清单记录：rename 之后、入库之前崩溃时，
+    // 新目录按 unknown 走原有规则，而不是拿旧记录比对新文件、误判损坏。
+    final store = await _blobStore();
+    await store.forget(finalDir);
+
     if (await finalDir.exists()) await finalDir.rename(backupDir.path);
 
     try {
@@ -588,6 +625,9 @@ class ModelManager {
         AppLog.d('[Model] 新模型已安装，但旧备份清理失败: $e');
       }
     }
+
+    await store.ingest(finalDir);
+    await store.collectGarbage();
   }
 
   String _getDirNameFromUrl(String url) {
@@ -897,6 +937,9 @@ class ModelManager {
      if (await backupDir.exists()) {
        await backupDir.delete(recursive: true);
      }
+     final store = await _blobStore();
+     await store.forget(modelDir);
+     await store.collectGarbage();
      // 若删除的是当前 active 模型，切到另一个已下载模型，避免 active_model_id 悬空
      // （否则下次启动 getActiveModelPath 返回 null，会静默重下默认模型，造成"为什么又下载"困惑）
      final activeId = ConfigService().activeModelId;
@@ -1016,6 +1059,9 @@ class ModelManager {
     if (await backupDir.exists()) {
       await backupDir.delete(recursive: true);
     }
+    final store = await _blobStore();
+    await store.forget(modelDir);
+    await store.collectGarbage();
   }
 }
 
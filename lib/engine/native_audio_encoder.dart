@@ -0,0 +1,76 @@
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import '../config/app_constants.dart';
+import '../ffi/native_input_base.dart';
+import 'asr_provider.dart';
+
+/// 一次录音的原生压缩编码（见 native_lib/linux/flac_encoder.c）。
+///
+/// CoreEngine 每轮轮询把 ring buffer 读出来的 int16 原地交给编码器（poll 缓冲
+/// 本来就在 native 堆上，不经 Dart 拷贝），取回的已编码字节交给 provider 的
+/// [ASRProvider.acceptEncoded]。FLAC 每 4096 样本（256ms）出一帧，所以
+/// 多数轮询拿不到字节；松手时 [finish] 把不满一帧的尾巴吐出来。
+class NativeAudioEncoder {
+  NativeAudioEncoder._(this._native, this._handle);
+
+  /// [format] 不是压缩格式、或平台没有对应的原生编码器时返回 null ——
+  /// 调用方照旧送 PCM。
+  static NativeAudioEncoder? open(NativeInputBase native, AudioSampleFormat format,
+      {int sampleRate = AppConstants.kSampleRate}) {
+    if (format != AudioSampleFormat.flac) return null;
+    final handle = native.audioEncoderCreate(kNativeAudioEncodingFlac, sampleRate);
+    if (handle == nullptr) return null;
+    return NativeAudioEncoder._(native, handle);
+  }
+
+  final NativeInputBase _native;
+  Pointer<Void> _handle;
+  Pointer<Uint8> _out = nullptr;
+  int _outCapacity = 0;
+
+  /// 统计：喂进去的样本数 / 吐出来的字节数
+  int inputSamples = 0;
+  int encodedBytes = 0;
+
+  /// 编码 [count] 个样本，返回这次新产出的字节（没有完整的帧时返回 null）
+  Uint8List? encode(Pointer<Int16> samples, int count) {
+    if (_handle == nullptr || count <= 0) return null;
+    inputSamples += count;
+    return _drain(_native.audioEncoderWrite(_handle, samples, count));
+  }
+
+  /// 编完剩余样本，返回最后的字节。之后只能 [dispose]
+  Uint8List? finish() {
+    if (_handle == nullptr) return null;
+    return _drain(_native.audioEncoderFinish(_handle));
+  }
+
+  Uint8List? _drain(int available) {
+    if (available <= 0) return null;
+    if (available > _outCapacity) {
+      if (_out != nullptr) calloc.free(_out);
+      _out = calloc<Uint8>(available);
+      _outCapacity = available;
+    }
+    final n = _native.audioEncoderRead(_handle, _out, available);
+    if (n <= 0) return null;
+    encodedBytes += n;
+    // 拷一份：所有权交给 provider，_out 下一轮还要复用
+    return Uint8List.fromList(_out.asTypedList(n));
+  }
+
+  void dispose() {
+    if (_handle != nullptr) {
+      _native.audioEncoderDestroy(_handle);
+      _handle = nullptr;
+    }
+    if (_out != nullptr) {
+      calloc.free(_out);
+      _out = nullptr;
+      _outCapacity = 0;
+    }
+  }
+}
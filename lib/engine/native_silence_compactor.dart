@@ -0,0 +1,140 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+
+import '../config/app_constants.dart';
+import '../ffi/native_input_base.dart';
+import 'asr_result.dart';
+
+/// 一次录音的停顿压缩（见 native_lib/dsp/silence_compact.h）。
+///
+/// CoreEngine 每轮轮询先把 ring 读出来的 int16 交给它，长停顿压成固定间隔之后
+/// 再去编码 / 交给 provider —— 离线模型少解几秒静音，云端少传几秒。
+/// 静音帧要等知道停顿多长才吐，所以停顿期间 [process] 可能一个样本都不给；
+/// 松手时 [finish] 把压着的交出来。压掉了哪些记在 [offsetMap] 里，
+/// 识别结果的时间戳靠它映射回原始录音。
+class NativeSilenceCompactor {
+  NativeSilenceCompactor._(this._native, this._handle);
+
+  /// 平台没导出停顿压缩时返回 null —— 调用方照旧送原始音频。
+  static NativeSilenceCompactor? open(NativeInputBase native,
+      {int minSilenceMs = AppConstants.kSilenceCompactMinMs,
+      int keepMs = AppConstants.kSilenceCompactKeepMs}) {
+    final handle = native.silenceCompactorCreate(minSilenceMs, keepMs);
+    if (handle == nullptr) return null;
+    return NativeSilenceCompactor._(native, handle);
+  }
+
+  final NativeInputBase _native;
+  Pointer<Void> _handle;
+  Pointer<Int16> _out = nullptr;
+  int _outCapacity = 0;
+
+  /// 最近一次 [process] / [finish] 的输出，下一次调用前有效
+  Pointer<Int16> get output => _out;
+
+  /// 压缩 [count] 个样本，返回写进 [output] 的个数（停顿中可能是 0）
+  int process(Pointer<Int16> samples, int count) {
+    if (_handle == nullptr || count <= 0) return 0;
+    _reserve(_native.silenceCompactorMaxOutput(_handle, count));
+    return _native.silenceCompactorProcess(_handle, samples, count, _out);
+  }
+
+  /// 录音结束：交出还压着的样本，返回写进 [output] 的个数。之后只读统计 / [offsetMap]
+  int finish() {
+    if (_handle == nullptr) return 0;
+    _reserve(_native.silenceCompactorMaxOutput(_handle, 0));
+    return _native.silenceCompactorFlush(_handle, _out);
+  }
+
+  void _reserve(int samples) {
+    if (samples <= _outCapacity) return;
+    if (_out != nullptr) calloc.free(_out);
+    _out = calloc<Int16>(samples);
+    _outCapacity = samples;
+  }
+
+  int _stat(int which) => _handle == nullptr ? 0 : _native.silenceCompactorStat(_handle, which);
+
+  int get inputSamples => _stat(kSilenceCompactStatInput);
+  int get outputSamples => _stat(kSilenceCompactStatOutput);
+  int get cuts => _stat(kSilenceCompactStatCuts);
+
+  /// 压掉的秒数
+  double get removedSeconds => (inputSamples - outputSamples) / AppConstants.kSampleRate;
+
+  /// 压缩后 → 原始录音的位置对照（[finish] 之后取才完整）
+  SilenceOffsetMap offsetMap() {
+    final n = cuts;
+    if (_handle == nullptr || n <= 0) return SilenceOffsetMap.identity;
+    final buf = calloc<Int64>(n * 2);
+    try {
+      final got = _native.silenceCompactorMapPoints(_handle, buf, n);
+      return SilenceOffsetMap([for (var i = 0; i < got; i++) buf[2 * i]],
+          [for (var i = 0; i < got; i++) buf[2 * i + 1]]);
+    } finally {
+      calloc.free(buf);
+    }
+  }
+
+  void dispose() {
+    if (_handle != nullptr) {
+      _native.silenceCompactorDestroy(_handle);
+      _handle = nullptr;
+    }
+    if (_out != nullptr) {
+      calloc.free(_out);
+      _out = nullptr;
+      _outCapacity = 0;
+    }
+  }
+}
+
+/// 停顿压缩的位置对照：第 i 个点之后，压缩后的位置 `p` 对应原始的 `orig[i] + (p - comp[i])`；
+/// 第一个点之前两边相同。点按 [comp] 递增。
+class SilenceOffsetMap {
+  SilenceOffsetMap(this.comp, this.orig, {this.sampleRate = AppConstants.kSampleRate})
+      : assert(comp.length == orig.length);
+
+  static final SilenceOffsetMap identity = SilenceOffsetMap(const [], const []);
+
+  final List<int> comp;
+  final List<int> orig;
+  final int sampleRate;
+
+  bool get isIdentity => comp.isEmpty;
+
+  /// 压缩后的第 [pos] 个样本在原始录音里的位置
+  int toOriginalSample(int pos) {
+    // 最后一个 comp <= pos 的点
+    var lo = 0, hi = comp.length;
+    while (lo < hi) {
+      final mid = (lo + hi) >> 1;
+      if (comp[mid] <= pos) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == 0) return pos;
+    return orig[lo - 1] + (pos - comp[lo - 1]);
+  }
+
+  double toOriginalSeconds(double seconds) {
+    final pos = (seconds * sampleRate).round();
+    // 只平移、不缩放：段内的小数部分原样保留
+    return (toOriginalSample(pos) - pos) / sampleRate + seconds;
+  }
+
+  /// 识别结果的时间戳映射回原始录音；tokens 与时间戳一一对应，不用动
+  ASRResult apply(ASRResult result) {
+    if (isIdentity || result.timestamps.isEmpty) return result;
+    return ASRResult(
+      text: result.text,
+      tokens: result.tokens,
+      timestamps: [for (final t in result.timestamps) toOriginalSeconds(t)],
+      tokenConfidence: result.tokenConfidence,
+      error: result.error,
+    );
+  }
+}
@@ -0,0 +1,113 @@
+import 'dart:async';
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+
+import '../ffi/native_input_base.dart';
+
+/// 一次录音的 native 流式解码（见 native_lib/linux/native_input.c 9. STREAMING DECODE）。
+///
+/// 本地流式模型原先在主 isolate 上每轮轮询 `while (isReady) decode`，一次几到几十毫秒，
+/// 和悬浮窗动画、按键回调抢同一个线程。这里解码线程直接从 ring 取样本，
+/// 只有变了的字幕经 [NativeCallable.listener] 投递回来 —— 样本不进 Dart 堆，
+/// 主 isolate 上只剩把字幕交给 textStream 这一步。
+///
+/// 识别器和流仍归 sherpa_onnx 的 Dart 对象所有，[destroy] 返回之前不能碰那个流。
+class NativeStreamDecoder {
+  NativeStreamDecoder._(this._native, this._onPartial);
+
+  /// 平台没导出、sherpa 库不是这个进程加载的、或已有一个在解码时返回 null ——
+  /// 调用方照旧在 Dart 里解码。
+  static NativeStreamDecoder? start(
+    NativeInputBase native, {
+    required Pointer<Void> recognizer,
+    required Pointer<Void> stream,
+    required void Function(String text) onPartial,
+    String sherpaLib = '',
+    int paddingMs = 0,
+  }) {
+    if (!native.canStreamDecode) return null;
+    final decoder = NativeStreamDecoder._(native, onPartial);
+    final callable = NativeCallable<DecoderTextCallbackC>.listener(decoder._onText);
+    final handle = native.streamDecoderStart(
+        recognizer, stream, sherpaLib, callable.nativeFunction, paddingMs);
+    if (handle == nullptr) {
+      callable.close();
+      return null;
+    }
+    decoder
+      .._handle = handle
+      .._callable = callable;
+    return decoder;
+  }
+
+  final NativeInputBase _native;
+  final void Function(String text) _onPartial;
+  Pointer<Void> _handle = nullptr;
+  NativeCallable<DecoderTextCallbackC>? _callable;
+  final Completer<String> _final = Completer<String>();
+
+  void _onText(Pointer<Utf8> text, int isFinal) {
+    final value = text.toDartString();
+    _native.nativeFree(text.cast());
+    if (isFinal != 0) {
+      if (!_final.isCompleted) _final.complete(value);
+    } else if (!_final.isCompleted) {
+      _onPartial(value);
+    }
+  }
+
+  /// 松键（ring 已 drain）后调用：等解码线程解完剩下的音频，返回最终文字。
+  /// tokens / timestamps 等 [destroy] 之后再从流上取。
+  Future<String> finish() {
+    if (_handle != nullptr) _native.streamDecoderFinish(_handle);
+    return _final.future;
+  }
+
+  /// 解码线程的统计（[destroy] 之前调用），写进延迟追踪和日志，
+  /// 和 Dart 解码的同名字段对比
+  Map<String, Object?> stats() {
+    if (_handle == nullptr) return const {};
+    int stat(int which) => _native.streamDecoderStat(_handle, which);
+    return {
+      'decode': 'native',
+      'decodeMs': stat(kStreamDecoderStatDecodeUs) / 1000,
+      'decodedSamples': stat(kStreamDecoderStatSamples),
+      'partials': stat(kStreamDecoderStatPartials),
+      'maxLagMs': stat(kStreamDecoderStatMaxLagUs) / 1000,
+      'overrunSamples': stat(kStreamDecoderStatOverrun),
+    };
+  }
+
+  /// 第一条字幕在 native 线程上产生的时刻（native 单调钟微秒），还没有时为 null
+  int? get firstPartialNativeUs {
+    if (_handle == nullptr) return null;
+    final us = _native.streamDecoderStat(_handle, kStreamDecoderStatFirstPartial);
+    return us > 0 ? us : null;
+  }
+
+  /// 收尾超时后用：让线程解完手上这次 decode 就走，等它报退出再 [destroy]。
+  /// 直接 destroy(abort) 会在 UI isolate 上 join 到线程退出 —— 用户已经等满了超时，
+  /// 不能再让界面卡一段
+  Future<void> abort() async {
+    if (_handle == nullptr) return;
+    _native.streamDecoderAbort(_handle);
+    while (_handle != nullptr &&
+        _native.streamDecoderStat(_handle, kStreamDecoderStatExited) == 0) {
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+    destroy(abort: true);
+  }
+
+  /// 等线程退出、释放句柄，之后才能再碰流。[abort] 时不收尾（取消 / dispose）。
+  /// abort 时还在投递途中的字幕随 callable 关闭丢掉 —— 那几条 native 字符串不再释放，
+  /// 只在取消时发生、每条几十字节，不值得为它多一轮握手。
+  void destroy({bool abort = false}) {
+    if (_handle == nullptr) return;
+    _native.streamDecoderDestroy(_handle, abort: abort);
+    _handle = nullptr;
+    _callable?.close();
+    _callable = null;
+    if (!_final.isCompleted) _final.complete('');
+  }
+}
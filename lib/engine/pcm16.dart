@@ -0,0 +1,47 @@
+import 'dart:typed_data';
+
+/// 16kHz mono int16 little-endian PCM 与 Float32 之间的转换。
+///
+/// 原先 Core 和六个云端 provider 各写一份，全用 `ByteData.getInt16/setInt16`
+/// 逐样本读写；这里统一成一份，并在对齐时走 `Int16List` 视图（整块拷贝，
+/// 没有逐样本的边界检查和字节序分支）。
+///
+/// Int16List 用宿主字节序：目前所有目标平台（x64 / arm64）都是小端。
+/// 大端宿主或奇数偏移的切片退回 ByteData 逐样本处理，结果一致。
+
+bool _canView(Uint8List bytes) =>
+    Endian.host == Endian.little && bytes.offsetInBytes % 2 == 0;
+
+/// int16 LE 字节 → Float32，范围 [-1, 1)
+Float32List pcm16ToFloat32(Uint8List pcm) {
+  final count = pcm.length ~/ 2;
+  final out = Float32List(count);
+  if (_canView(pcm)) {
+    final samples = Int16List.view(pcm.buffer, pcm.offsetInBytes, count);
+    for (var i = 0; i < count; i++) {
+      out[i] = samples[i] / 32768.0;
+    }
+  } else {
+    final data = ByteData.sublistView(pcm);
+    for (var i = 0; i < count; i++) {
+      out[i] = data.getInt16(i * 2, Endian.little) / 32768.0;
+    }
+  }
+  return out;
+}
+
+/// Float32 → int16 LE 字节。先夹到 [-1, 1] 再乘 32767，与各 provider 原实现一致
+Uint8List float32ToPcm16(Float32List samples) {
+  final out = Int16List(samples.length);
+  for (var i = 0; i < samples.length; i++) {
+    final s = samples[i];
+    out[i] = ((s > 1.0 ? 1.0 : (s < -1.0 ? -1.0 : s)) * 32767).toInt();
+  }
+  final bytes = out.buffer.asUint8List();
+  if (Endian.host == Endian.little) return bytes;
+  final data = ByteData(bytes.length);
+  for (var i = 0; i < out.length; i++) {
+    data.setInt16(i * 2, out[i], Endian.little);
+  }
+  return data.buffer.asUint8List();
+}
@@ -5,7 +5,9 @@ import 'package:uuid/uuid.dart';
 import 'package:web_socket_channel/web_socket_channel.dart';
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
 import 'aliyun_token_service.dart';
+import 'ws_audio_framer.dart';
 import 'package:speakout/config/app_log.dart';
 import '../../config/app_constants.dart';
 class AliyunProvider implements ASRProvider {
@@ -67,6 +69,10 @@ class AliyunProvider implements ASRProvider {
     if (_appKey.isEmpty || _accessKeyId.isEmpty || _accessKeySecret.isEmpty) {
        throw Exception("Aliyun Config Missing");
     }
+    _framer = WsAudioFramer(
+      frameMs: config['frameMs'] as int? ?? _defaultFrameMs,
+      emit: (frame, _, __) => _sendOrBuffer(frame),
+    );
     
     _isReady = true;
     
@@ -156,8 +162,12 @@ class AliyunProvider implements ASRProvider {
   }
 
   // Audio Buffering for Handshake Latency (capped to prevent OOM)
-  static const int _maxPendingBuffers = 200; // ~10s of audio at 50ms chunks
+  static const int _maxPendingBuffers = 200; // ~20s of audio at 100ms frames
   final List<Uint8List> _pendingBuffer = [];
+
+  /// 每包音频时长。实时识别文档建议每次发送 100ms（3200 字节）
+  static const _defaultFrameMs = 100;
+  late WsAudioFramer _framer;
   bool _isHandshakeComplete = false;
 
   @override
@@ -173,6 +183,7 @@ class AliyunProvider implements ASRProvider {
     
     // Reset state for new transcription task
     _pendingBuffer.clear();
+    _framer.reset();
     _isHandshakeComplete = false;
     _committedText = "";
     _currentSentence = "";
@@ -300,12 +311,22 @@ class AliyunProvider implements ASRProvider {
   }
 
   @override
-  void acceptWaveform(Float32List samples) {
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  /// 原生采集的字节原样上传，不经 Float32 往返；攒满一包才发
+  @override
+  void acceptPcm16(Uint8List pcmBytes) => _framer.add(pcmBytes);
+
+  void _sendOrBuffer(Uint8List pcmBytes) {
     if (_channel == null) return;
-    
-    // Aliyun expects Int16 PCM bytes. Input is Float32.
-    final pcmBytes = _float32ToInt16Bytes(samples);
-    
+
     if (!_isHandshakeComplete) {
        if (_pendingBuffer.length < _maxPendingBuffers) {
          _pendingBuffer.add(pcmBytes);
@@ -314,18 +335,6 @@ class AliyunProvider implements ASRProvider {
        _channel!.sink.add(pcmBytes);
     }
   }
-
-  Uint8List _float32ToInt16Bytes(Float32List samples) {
-    final buffer = ByteData(samples.length * 2);
-    for (int i = 0; i < samples.length; i++) {
-        var s = samples[i];
-        if (s > 1.0) s = 1.0;
-        if (s < -1.0) s = -1.0;
-        int v = (s * 32767).toInt();
-        buffer.setInt16(i * 2, v, Endian.little);
-    }
-    return buffer.buffer.asUint8List();
-  }
   // ...
 
   /// 流式识别：结果随说话陆续回来，stop 只等最后一帧，用全局默认即可。
@@ -359,6 +368,9 @@ class AliyunProvider implements ASRProvider {
       ]);
     }
 
+    // 没攒满的尾巴先发，再发 StopTranscription
+    _framer.flush();
+
     // Send Stop (but DON'T close the connection - keep it for reuse)
     final stopCmd = {
       "header": {
@@ -2,7 +2,10 @@ import '../../models/cloud_account.dart';
 import '../asr_provider.dart';
 import 'aliyun_provider.dart';
 import 'dashscope_asr_provider.dart';
+import 'offline_sherpa_provider.dart';
 import 'openai_asr_provider.dart';
+import 'racing_asr_provider.dart';
+import 'sherpa_provider.dart';
 import 'tencent_asr_provider.dart';
 import 'volcengine_asr_provider.dart';
 import 'xfyun_asr_provider.dart';
@@ -33,6 +36,19 @@ class ASRProviderFactory {
     }
   }
 
+  /// 云端 + 本地竞速（见 [RacingASRProvider]）。[cloudProviderId] 同 [create]，
+  /// 本地按模型是否流式选 Sherpa 实现
+  static RacingASRProvider createRacing(String cloudProviderId, {required bool localOffline}) =>
+      RacingASRProvider(
+        cloud: create(cloudProviderId),
+        local: localOffline ? OfflineSherpaProvider() : SherpaProvider(),
+      );
+
+  /// 竞速 provider 的 config：两路各自的 config 原样嵌进去
+  static Map<String, dynamic> buildRacingConfig(
+          Map<String, dynamic> cloudConfig, Map<String, dynamic> localConfig) =>
+      {'cloud': cloudConfig, 'local': localConfig};
+
   /// 构建 initialize() 的 config Map
   static Map<String, dynamic> buildConfig(CloudAccount account, CloudASRModel model) {
     switch (account.providerId) {
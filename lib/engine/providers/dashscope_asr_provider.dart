@@ -5,6 +5,8 @@ import 'package:uuid/uuid.dart';
 import 'package:web_socket_channel/io.dart';
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
+import 'ws_audio_framer.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 import '../../config/app_constants.dart';
@@ -35,6 +37,10 @@ class DashScopeASRProvider implements ASRProvider {
   static const int _maxPendingBuffers = 200;
   final List<Uint8List> _pendingBuffer = [];
 
+  /// 每包音频时长。文档建议每次发送 100ms 的音频
+  static const _defaultFrameMs = 100;
+  late WsAudioFramer _framer;
+
   // Text accumulation
   String _committedText = '';
   String _currentSentence = '';
@@ -55,6 +61,10 @@ class DashScopeASRProvider implements ASRProvider {
     _model = config['model'] as String? ?? 'paraformer-realtime-v2';
 
     if (_apiKey.isEmpty) throw Exception('DashScope API Key missing');
+    _framer = WsAudioFramer(
+      frameMs: config['frameMs'] as int? ?? _defaultFrameMs,
+      emit: (frame, _, __) => _sendOrBuffer(frame),
+    );
 
     _isReady = true;
     _log('Initialized (model=$_model)');
@@ -65,6 +75,7 @@ class DashScopeASRProvider implements ASRProvider {
     _generation++;
     final gen = _generation;
     _pendingBuffer.clear();
+    _framer.reset();
     _isHandshakeComplete = false;
     _isTaskFinished = false;
     _committedText = '';
@@ -191,10 +202,21 @@ class DashScopeASRProvider implements ASRProvider {
   }
 
   @override
-  void acceptWaveform(Float32List samples) {
-    if (_channel == null) return;
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
 
-    final pcmBytes = _float32ToInt16Bytes(samples);
+  /// 原生采集的字节原样上传，不经 Float32 往返；攒满一包才发
+  @override
+  void acceptPcm16(Uint8List pcmBytes) => _framer.add(pcmBytes);
+
+  void _sendOrBuffer(Uint8List pcmBytes) {
+    if (_channel == null) return;
 
     if (!_isHandshakeComplete) {
       if (_pendingBuffer.length < _maxPendingBuffers) {
@@ -221,15 +243,6 @@ class DashScopeASRProvider implements ASRProvider {
     return newText;
   }
 
-  Uint8List _float32ToInt16Bytes(Float32List samples) {
-    final buffer = ByteData(samples.length * 2);
-    for (int i = 0; i < samples.length; i++) {
-      var s = samples[i].clamp(-1.0, 1.0);
-      buffer.setInt16(i * 2, (s * 32767).toInt(), Endian.little);
-    }
-    return buffer.buffer.asUint8List();
-  }
-
   /// 流式识别：结果随说话陆续回来，stop 只等最后一帧，用全局默认即可。
   @override
   Duration get stopTimeout => AppConstants.kAsrStopTimeout;
@@ -254,6 +267,9 @@ class DashScopeASRProvider implements ASRProvider {
       ]);
     }
 
+    // 没攒满的尾巴先发，再发 finish-task
+    _framer.flush();
+
     // Send finish-task
     final finishTask = {
       'header': {
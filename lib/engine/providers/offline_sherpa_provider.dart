@@ -4,6 +4,8 @@ import 'package:flutter/foundation.dart';
 import 'package:sherpa_onnx/sherpa_onnx.dart' as sherpa;
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../decode_windows.dart';
+import '../pcm16.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 import '../../config/app_constants.dart';
@@ -26,10 +28,68 @@ class OfflineSherpaProvider implements ASRProvider {
   bool _isSegmentDecoding = false;
 
   StreamController<String> _textController = StreamController<String>.broadcast();
+  final StreamController<String> _segmentController = StreamController<String>.broadcast();
+
+  /// 上次 stop() 拼出全文所用的各段（预分段 + 最后一段），按顺序
+  List<String> _lastSegments = const [];
 
   @override
   Stream<String> get textStream => _textController.stream;
 
+  /// 每解出一段预分段就发一次（录音仍在进行），供边说边润色
+  Stream<String> get segmentStream => _segmentController.stream;
+
+  List<String> get lastSegments => _lastSegments;
+
+  // Whisper / Moonshine 这类只看 30 秒的模型：每次解码都切成不超过窗口的几段（其余模型为 null）
+  DecodeWindowPlanner? _windowPlanner;
+  // 各窗口的 tokens / 时间戳拼成整段录音的，重叠里重复的去掉
+  final DecodeWindowMerger _merger = DecodeWindowMerger();
+  int _chunksStartSample = 0; // _audioChunks 第一个样本在整段录音里的位置
+  int _decodedSamples = 0;
+  int _decodeMs = 0;
+
+  /// 上次录音各段解码加起来花的时间（ms）和解了多少秒音频 —— 停顿压缩据此估算省下的解码时间
+  int get lastDecodeMs => _decodeMs;
+  double get lastDecodedSec => _decodedSamples / 16000.0;
+
+  /// 解整段录音里从 [start] 开始的 [samples]；有窗口限制的模型先切窗。返回这一段的文本
+  String _decodeRange(Float32List samples, int start) {
+    final planner = _windowPlanner;
+    final windows = planner == null ? [DecodeWindow(0, samples.length)] : planner.plan(samples);
+    var text = '';
+    for (final w in windows) {
+      final result = _decodeWindow(Float32List.sublistView(samples, w.start, w.end));
+      final part = _merger.add(
+        start: start + w.start,
+        end: start + w.end,
+        text: result.text,
+        windowTokens: result.tokens,
+        windowTimestamps: result.timestamps.map((t) => t.toDouble()).toList(),
+      );
+      text = joinDecodedText(text, part);
+    }
+    if (windows.length > 1) {
+      AppLog.d("[OfflineSherpaProvider] ${(samples.length / 16000.0).toStringAsFixed(1)}s decoded in "
+          "${windows.length} windows: ${windows.map((w) => (w.length / 16000.0).toStringAsFixed(1)).join(' / ')}s");
+    }
+    return text;
+  }
+
+  sherpa.OfflineRecognizerResult _decodeWindow(Float32List samples) {
+    final sw = Stopwatch()..start();
+    final stream = _recognizer!.createStream();
+    try {
+      stream.acceptWaveform(samples: samples, sampleRate: 16000);
+      _recognizer!.decode(stream);
+      return _recognizer!.getResult(stream);
+    } finally {
+      stream.free();
+      _decodedSamples += samples.length;
+      _decodeMs += sw.elapsedMilliseconds;
+    }
+  }
+
   @override
   String get type => "local_sherpa_offline";
 
@@ -42,6 +102,7 @@ class OfflineSherpaProvider implements ASRProvider {
   Future<void> initialize(Map<String, dynamic> config) async {
     final modelPath = config['modelPath'] as String;
     final modelType = config['modelType'] as String? ?? 'sense_voice';
+    _windowPlanner = DecodeWindowPlanner.forModelType(modelType);
     _activeModelInfo = '$modelType (${modelPath.split('/').last})';
     AppLog.d("[OfflineSherpaProvider] Initializing: $_activeModelInfo");
 
@@ -210,8 +271,13 @@ class OfflineSherpaProvider implements ASRProvider {
     _audioChunks.clear();
 
     _segmentResults.clear();
+    _lastSegments = const [];
     _lastVoiceChunkIndex = -1;
     _isSegmentDecoding = false;
+    _merger.reset();
+    _chunksStartSample = 0;
+    _decodedSamples = 0;
+    _decodeMs = 0;
   }
 
   @override
@@ -222,13 +288,47 @@ class OfflineSherpaProvider implements ASRProvider {
 
   }
 
-  /// Accumulated audio duration in seconds (for pre-segment threshold check)
-  double get accumulatedDurationSec {
+  /// 整段攒到 stop 才解码：原始字节在这里转一次，转出来的缓冲本来就归自己，
+  /// 省掉 acceptWaveform 那次防御性拷贝
+  @override
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptPcm16(Uint8List pcm) {
+    if (_recognizer == null) return;
+    _audioChunks.add(pcm16ToFloat32(pcm));
+  }
+
+  int get _accumulatedSamples {
     int totalSamples = 0;
     for (final chunk in _audioChunks) {
       totalSamples += chunk.length;
     }
-    return totalSamples / 16000.0;
+    return totalSamples;
+  }
+
+  /// Accumulated audio duration in seconds (for pre-segment threshold check)
+  double get accumulatedDurationSec => _accumulatedSamples / 16000.0;
+
+  /// 当前模型有固定输入窗口（Whisper / Moonshine），长录音按窗口切着解
+  bool get isWindowed => _windowPlanner != null;
+
+  static Float32List _mergeChunks(List<Float32List> chunks) {
+    int totalSamples = 0;
+    for (final chunk in chunks) {
+      totalSamples += chunk.length;
+    }
+    final merged = Float32List(totalSamples);
+    int offset = 0;
+    for (final chunk in chunks) {
+      merged.setAll(offset, chunk);
+      offset += chunk.length;
+    }
+    return merged;
   }
 
   /// Mark current latest chunk as "has voice" (called by CoreEngine silence check)
@@ -259,35 +359,22 @@ class OfflineSherpaProvider implements ASRProvider {
       _audioChunks.addAll(remainingChunks);
       _lastVoiceChunkIndex = -1;
 
-      int totalSamples = 0;
-      for (final chunk in segmentChunks) {
-        totalSamples += chunk.length;
-      }
-
+      final merged = _mergeChunks(segmentChunks);
+      final totalSamples = merged.length;
       if (totalSamples == 0) return;
 
-      final merged = Float32List(totalSamples);
-      int offset = 0;
-      for (final chunk in segmentChunks) {
-        merged.setAll(offset, chunk);
-        offset += chunk.length;
-      }
-
       final durationSec = (totalSamples / 16000.0).toStringAsFixed(1);
       AppLog.d("[OfflineSherpaProvider] PreSegment #${_segmentResults.length + 1}: "
           "decoding $totalSamples samples (${durationSec}s)...");
 
-      final stream = _recognizer!.createStream();
-      stream.acceptWaveform(samples: merged, sampleRate: 16000);
-      _recognizer!.decode(stream);
-      final result = _recognizer!.getResult(stream);
-      final text = result.text.trim();
-      stream.free();
+      final text = _decodeRange(merged, _chunksStartSample);
+      _chunksStartSample += totalSamples;
 
       if (text.isNotEmpty) {
         _segmentResults.add(text);
         AppLog.d("[OfflineSherpaProvider] PreSegment #${_segmentResults.length}: "
             "(${text.length}字, ${durationSec}s): ${AppLog.redact(text)}");
+        _segmentController.add(text);
       }
     } catch (e) {
       AppLog.d("[OfflineSherpaProvider] PreSegment error: $e");
@@ -322,20 +409,10 @@ class OfflineSherpaProvider implements ASRProvider {
         AppLog.d("[OfflineSherpaProvider] Decoding final segment [$_activeModelInfo]: "
             "${_audioChunks.length} chunks, $totalSamples samples (${durationSec}s)");
 
-        final merged = Float32List(totalSamples);
-        int offset = 0;
-        for (final chunk in _audioChunks) {
-          merged.setAll(offset, chunk);
-          offset += chunk.length;
-        }
+        final merged = _mergeChunks(_audioChunks);
         _audioChunks.clear();
 
-        final stream = _recognizer!.createStream();
-        stream.acceptWaveform(samples: merged, sampleRate: 16000);
-        _recognizer!.decode(stream);
-        final result = _recognizer!.getResult(stream);
-        lastSegmentText = result.text.trim();
-        stream.free();
+        lastSegmentText = _decodeRange(merged, _chunksStartSample);
 
         final fullDurationSec = durationSec;
         AppLog.d("[OfflineSherpaProvider] Final segment (${lastSegmentText.length}字, ${fullDurationSec}s): ${AppLog.redact(lastSegmentText)}");
@@ -348,8 +425,10 @@ class OfflineSherpaProvider implements ASRProvider {
       if (lastSegmentText.isNotEmpty) {
         _segmentResults.add(lastSegmentText);
       }
-      final fullText = _segmentResults.join('');
+      // 预分段切在说话的停顿里，英文两段之间的空格要补回来（见 joinDecodedText）
+      final fullText = _segmentResults.fold('', joinDecodedText);
       final segmentCount = _segmentResults.length;
+      _lastSegments = List.unmodifiable(_segmentResults);
       _segmentResults.clear();
 
       if (hasPreSegments) {
@@ -367,14 +446,15 @@ class OfflineSherpaProvider implements ASRProvider {
 
       return ASRResult(
         text: fullText,
-        tokens: [],
-        timestamps: [],
+        tokens: List.of(_merger.tokens),
+        timestamps: List.of(_merger.timestamps),
         tokenConfidence: null,
       );
     } catch (e) {
       AppLog.d("[OfflineSherpaProvider] stop error: $e");
       _audioChunks.clear();
       _segmentResults.clear();
+      _lastSegments = const [];
       return ASRResult.textOnly("");
     }
   }
@@ -1,16 +1,22 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:math';
 import 'dart:typed_data';
 import 'package:http/http.dart' as http;
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 
 /// OpenAI / Groq Whisper ASR Provider (Non-streaming)
 ///
 /// 支持 OpenAI Whisper, GPT-4o Transcribe, Groq Whisper 等。
-/// 非流式：acceptWaveform() 累积音频，stop() 时 POST 到 REST API。
+/// 非流式识别，但**上传是边录边传**：start() 就发起 chunked multipart POST，
+/// 音频到一块写一块，松手时只剩收尾边界和服务端转写。
+/// 服务端不收 chunked 请求体时退回整段上传（松手后编码 WAV + 普通 POST）。
+/// 平台有原生编码器时（Linux）上传的是 FLAC：无损，字节数约为 WAV 的一半，
+/// 上行慢的网络下松手后要等的尾巴也跟着减半。
 /// 兼容所有 OpenAI audio/transcriptions API 格式的服务。
 class OpenAIASRProvider implements ASRProvider {
   StreamController<String> _textController = StreamController<String>.broadcast();
@@ -21,13 +27,28 @@ class OpenAIASRProvider implements ASRProvider {
 
   bool _isReady = false;
 
-  // Audio accumulation (16kHz mono Float32 PCM)
-  final List<Float32List> _audioChunks = [];
-  int _totalSamples = 0;
+  /// false = 始终整段上传（测试 / 排障用）
+  bool _streamingUpload = true;
+
+  /// 明确拒绝过 chunked 请求体的服务端（按 baseUrl）。进程内记住，
+  /// 之后直接整段上传，不再每次先失败一次。
+  static final Set<String> _chunkedRejected = {};
+
+  // Audio accumulation：16kHz mono int16 LE（原生采集的字节原样保存），
+  // 或原生编码器产出的 FLAC 流（[_encoded]）。同一次录音只会是其中一种。
+  // 边录边传时也要留一份：服务端拒收 chunked 时整段重传要用。
+  final List<Uint8List> _audioChunks = [];
+  int _audioBytes = 0;
+  bool _encoded = false;
+
+  /// 当前录音正在进行的边录边传请求
+  _StreamingUpload? _upload;
 
   /// 录音代次，用于丢弃被放弃请求的迟到结果（见 start()）
   int _generation = 0;
 
+  static const _httpTimeout = Duration(seconds: 30);
+
   @override
   Stream<String> get textStream => _textController.stream;
 
@@ -42,6 +63,7 @@ class OpenAIASRProvider implements ASRProvider {
     _apiKey = config['apiKey'] as String? ?? '';
     _baseUrl = config['baseUrl'] as String? ?? 'https://api.openai.com/v1';
     _model = config['model'] as String? ?? 'whisper-1';
+    _streamingUpload = config['streamingUpload'] as bool? ?? true;
 
     if (_apiKey.isEmpty) throw Exception('API Key missing');
 
@@ -52,73 +74,195 @@ class OpenAIASRProvider implements ASRProvider {
   @override
   Future<void> start() async {
     _audioChunks.clear();
-    _totalSamples = 0;
+    _audioBytes = 0;
+    _encoded = false;
     // 每次录音自增一代。批量识别的 stop() 可能被 Core 提前放弃
     // （取消路径只等 kAsrStopTimeout），但 Future.timeout 只是停止等待，
     // **不会取消底层 HTTP 请求** —— 它最长还能再跑 30 秒。
     // 若这期间用户已开始下一次录音，迟到的结果会经共享 textStream
     // 串进新录音的浮窗。用代次把过期结果丢掉。
     _generation++;
+
+    _upload?.abort();
+    _upload = null;
+    if (_streamingUpload && !_chunkedRejected.contains(_baseUrl)) {
+      _upload = _StreamingUpload.open(
+        uri: Uri.parse('$_baseUrl/audio/transcriptions'),
+        apiKey: _apiKey,
+        fields: _formFields(),
+      );
+    }
+  }
+
+  /// Whisper 接受 FLAC；没有原生编码器的平台 Core 会退回 [acceptPcm16]
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.flac;
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  /// 上传的 WAV 本来就是 16-bit：原始字节直接攒着，边录边传时同时写进请求体
+  @override
+  void acceptPcm16(Uint8List pcm) {
+    _audioChunks.add(pcm);
+    _audioBytes += pcm.length & ~1;
+    _upload?.addPcm(pcm);
   }
 
+  /// 原生编码器产出的 FLAC 流，原样攒着 / 写进请求体
   @override
-  void acceptWaveform(Float32List samples) {
-    _audioChunks.add(Float32List.fromList(samples));
-    _totalSamples += samples.length;
+  void acceptEncoded(Uint8List bytes) {
+    _encoded = true;
+    _audioChunks.add(bytes);
+    _audioBytes += bytes.length;
+    _upload?.addFlac(bytes);
   }
 
-  /// 批量识别：整段音频在松手后才上传+转写，耗时随录音长度增长。
-  /// 自身 HTTP 超时 30s（见 request.send().timeout），Core 必须等得比它久，
+  /// 批量识别：转写在松手后才开始，耗时随录音长度增长。
+  /// 自身 HTTP 超时 30s（见 _httpTimeout），Core 必须等得比它久，
   /// 否则 Core 先弃、provider 后返回，结果丢失。
   @override
   Duration get stopTimeout => const Duration(seconds: 35);
 
   @override
   Future<ASRResult> stop() async {
-    if (_totalSamples == 0) return ASRResult.textOnly('');
+    final upload = _upload;
+    _upload = null;
+    if (_audioBytes == 0) {
+      upload?.abort();
+      return ASRResult.textOnly('');
+    }
     final gen = _generation;
+    final keyUp = Stopwatch()..start();
 
-    _log('Encoding $_totalSamples samples to WAV...');
-    final wav = _encodeWav();
+    // 先把本次的音频拿走：Core 放弃等待后可能马上 start() 下一次，
+    // 清掉 _audioChunks —— 而退回整段上传还要用它
+    final chunks = List<Uint8List>.of(_audioChunks);
+    final audioBytes = _audioBytes;
+    final encoded = _encoded;
     _audioChunks.clear();
-    _totalSamples = 0;
+    _audioBytes = 0;
 
-    _log('Uploading ${wav.length} bytes to $_baseUrl/audio/transcriptions...');
+    ASRResult? result;
+    int? suspectStatus;
+    var path = 'whole-file';
+    if (upload != null) {
+      (result, suspectStatus) = await _finishStreaming(upload, gen);
+      if (result != null) path = 'streamed';
+    }
+    if (result == null) {
+      final remaining = _httpTimeout - keyUp.elapsed;
+      result = await _uploadWhole(chunks, audioBytes, encoded, gen,
+          remaining.isNegative ? Duration.zero : remaining);
+      // 同一段音频整段传就收了 → 刚才那个 4xx 冲的是 chunked 请求体，以后不再试。
+      // 整段也失败就是普通的 API 错误（太短、语言不对…），边录边传照旧
+      if (suspectStatus != null && result.error == null) {
+        _chunkedRejected.add(_baseUrl);
+        _log('Whole-file upload accepted after HTTP $suspectStatus on chunked, '
+            'using whole-file upload from now on');
+      }
+    }
+    _log('[PERF] key-up → text ${keyUp.elapsedMilliseconds}ms '
+        '($path, $audioBytes bytes ${encoded ? 'FLAC' : 'PCM'})');
+    return result;
+  }
+
+  /// 收尾边录边传的请求。结果为 null = 服务端不收 chunked（或连接中途断了），
+  /// 调用方退回整段上传；超时不退回 —— 再传一遍只会更久。
+  ///
+  /// 第二项是「说不准」的状态码：400 / 413 / 415 可能是网关不收 chunked
+  /// multipart，也可能是普通的 API 错误（音频太短、文件太大、语言不对）。
+  /// 这时候不能直接记黑名单，要看整段重传收不收。
+  Future<(ASRResult?, int?)> _finishStreaming(_StreamingUpload upload, int gen) async {
+    try {
+      upload.finish();
+      final response = await upload.response.timeout(_httpTimeout);
+      final body = await response.stream.bytesToString().timeout(_httpTimeout);
+      // 411 Length Required / 501 Not Implemented —— 明说了不收 chunked
+      if (const {411, 501}.contains(response.statusCode)) {
+        _chunkedRejected.add(_baseUrl);
+        _log('Server rejected chunked upload (HTTP ${response.statusCode}), '
+            'falling back to whole-file upload from now on');
+        return (null, null);
+      }
+      if (const {400, 413, 415}.contains(response.statusCode)) {
+        _log('Chunked upload got HTTP ${response.statusCode}: ${AppLog.redact(body)}; '
+            'retrying as whole-file upload');
+        return (null, response.statusCode);
+      }
+      return (_handleResponse(response.statusCode, body, gen), null);
+    } on TimeoutException catch (e) {
+      _log('Request failed: $e');
+      return (ASRResult.withError('云端识别请求失败: $e'), null);
+    } catch (e) {
+      _log('Streaming upload failed ($e), retrying as whole-file upload');
+      return (null, null);
+    } finally {
+      upload.close();
+    }
+  }
+
+  Future<ASRResult> _uploadWhole(List<Uint8List> chunks, int audioBytes,
+      bool encoded, int gen, Duration timeout) async {
+    final Uint8List file;
+    if (encoded) {
+      // FLAC 流自带文件头，按顺序拼起来就是完整文件
+      final builder = BytesBuilder(copy: false);
+      chunks.forEach(builder.add);
+      file = builder.takeBytes();
+    } else {
+      _log('Encoding ${audioBytes ~/ 2} samples to WAV...');
+      file = _encodeWav(chunks, audioBytes ~/ 2);
+    }
+
+    _log('Uploading ${file.length} bytes to $_baseUrl/audio/transcriptions...');
 
     try {
       final uri = Uri.parse('$_baseUrl/audio/transcriptions');
-      final inputLang = ConfigService().inputLanguage;
       final request = http.MultipartRequest('POST', uri)
         ..headers['Authorization'] = 'Bearer $_apiKey'
-        ..fields['model'] = _model
-        ..fields['response_format'] = 'json';
+        ..fields.addAll(_formFields());
+      request.files.add(http.MultipartFile.fromBytes(
+        'file',
+        file,
+        filename: encoded ? 'audio.flac' : 'audio.wav',
+      ));
+
+      final response = await request.send().timeout(timeout);
+      final body = await response.stream.bytesToString();
+      return _handleResponse(response.statusCode, body, gen);
+    } catch (e) {
+      _log('Request failed: $e');
+      return ASRResult.withError('云端识别请求失败: $e');
+    }
+  }
+
+  Map<String, String> _formFields() {
+    final inputLang = ConfigService().inputLanguage;
+    return {
+      'model': _model,
+      'response_format': 'json',
       // Only send language hint when explicitly set (auto = let Whisper detect)
-      if (inputLang != 'auto') {
+      if (inputLang != 'auto')
         // Map app lang codes to Whisper ISO-639-1 codes
-        request.fields['language'] = switch (inputLang) {
+        'language': switch (inputLang) {
           'zh' => 'zh',
           'en' => 'en',
           'ja' => 'ja',
           'ko' => 'ko',
           'yue' => 'zh', // Whisper doesn't have separate Cantonese code
           _ => inputLang,
-        };
-      }
-      request.files.add(http.MultipartFile.fromBytes(
-        'file',
-        wav,
-        filename: 'audio.wav',
-      ));
-
-      final response = await request.send().timeout(const Duration(seconds: 30));
-      final body = await response.stream.bytesToString();
-
-      if (response.statusCode != 200) {
-        _log('API error ${response.statusCode}: ${AppLog.redact(body)}');
-        // 错误通过 error 字段上报（鉴权/余额/模型名等），不要表现成"无语音"让用户反复重试
-        return ASRResult.withError('云端识别失败 (HTTP ${response.statusCode})');
-      }
+        },
+    };
+  }
 
+  ASRResult _handleResponse(int statusCode, String body, int gen) {
+    if (statusCode != 200) {
+      _log('API error $statusCode: ${AppLog.redact(body)}');
+      // 错误通过 error 字段上报（鉴权/余额/模型名等），不要表现成"无语音"让用户反复重试
+      return ASRResult.withError('云端识别失败 (HTTP $statusCode)');
+    }
+    try {
       final json = jsonDecode(body) as Map<String, dynamic>;
       final text = json['text'] as String? ?? '';
       _log('Result: ${text.length} chars');
@@ -136,15 +280,14 @@ class OpenAIASRProvider implements ASRProvider {
     }
   }
 
-  /// Encode accumulated Float32 PCM samples to WAV (16kHz mono 16-bit)
-  Uint8List _encodeWav() {
+  /// WAV 头 (16kHz mono 16-bit)。[dataSize] 为 null 表示长度未知（边录边传），
+  /// 两个长度字段按流式 WAV 的惯例填 0xFFFFFFFF，解码端读到 EOF 为止。
+  static Uint8List _wavHeader(int? dataSize) {
     const sampleRate = 16000;
     const bitsPerSample = 16;
     const numChannels = 1;
-    final dataSize = _totalSamples * 2; // 16-bit = 2 bytes per sample
-    final fileSize = 44 + dataSize;
 
-    final buffer = ByteData(fileSize);
+    final buffer = ByteData(44);
     int offset = 0;
 
     // RIFF header
@@ -154,7 +297,7 @@ class OpenAIASRProvider implements ASRProvider {
       }
     }
     writeStr('RIFF');
-    buffer.setUint32(offset, fileSize - 8, Endian.little); offset += 4;
+    buffer.setUint32(offset, dataSize == null ? 0xFFFFFFFF : 36 + dataSize, Endian.little); offset += 4;
     writeStr('WAVE');
 
     // fmt sub-chunk
@@ -169,28 +312,120 @@ class OpenAIASRProvider implements ASRProvider {
 
     // data sub-chunk
     writeStr('data');
-    buffer.setUint32(offset, dataSize, Endian.little); offset += 4;
-
-    // PCM data (Float32 → Int16)
-    for (final chunk in _audioChunks) {
-      for (int i = 0; i < chunk.length; i++) {
-        final s = chunk[i].clamp(-1.0, 1.0);
-        buffer.setInt16(offset, (s * 32767).toInt(), Endian.little);
-        offset += 2;
-      }
-    }
+    buffer.setUint32(offset, dataSize ?? 0xFFFFFFFF, Endian.little);
 
     return buffer.buffer.asUint8List();
   }
 
+  /// Encode accumulated int16 PCM chunks to WAV (16kHz mono 16-bit)
+  static Uint8List _encodeWav(List<Uint8List> chunks, int totalSamples) {
+    final dataSize = totalSamples * 2; // 16-bit = 2 bytes per sample
+    final out = Uint8List(44 + dataSize)..setRange(0, 44, _wavHeader(dataSize));
+    var offset = 44;
+    for (final chunk in chunks) {
+      final n = chunk.length & ~1; // 奇数字节的残片不成样本
+      out.setRange(offset, offset + n, chunk);
+      offset += n;
+    }
+    return out;
+  }
+
   @override
   Future<void> dispose() async {
     _isReady = false;
+    _upload?.abort();
+    _upload = null;
     _audioChunks.clear();
-    _totalSamples = 0;
+    _audioBytes = 0;
     _textController.close();
     _textController = StreamController<String>.broadcast();
   }
 
   void _log(String msg) => AppLog.d('[OpenAIASR] $msg');
 }
+
+/// 一次边录边传的 multipart 请求。
+///
+/// 不设 Content-Length → HTTP/1.1 chunked。请求体手工拼：表单字段 →
+/// 文件部分头 → 录音期间陆续写入的音频 → 结尾边界。文件部分头等第一块音频
+/// 到了才写：那时才知道这次是 PCM（补一个长度未知的 WAV 头）还是 FLAC 流。
+/// 每次录音独占一个 Client，放弃时 close 掉就等于中止请求。
+class _StreamingUpload {
+  _StreamingUpload._(this._client, this._request, this._boundary)
+      : response = _client.send(_request) {
+    // 录音中途服务端就回了错误 / 连接断了：先接住，stop() 时再看
+    response.ignore();
+  }
+
+  factory _StreamingUpload.open({
+    required Uri uri,
+    required String apiKey,
+    required Map<String, String> fields,
+  }) {
+    final rnd = Random();
+    final boundary = 'speakout-${List.generate(16, (_) => rnd.nextInt(16).toRadixString(16)).join()}';
+    final request = http.StreamedRequest('POST', uri)
+      ..headers['Authorization'] = 'Bearer $apiKey'
+      ..headers['Content-Type'] = 'multipart/form-data; boundary=$boundary';
+    final upload = _StreamingUpload._(http.Client(), request, boundary);
+
+    final head = StringBuffer();
+    fields.forEach((name, value) {
+      head.write('--$boundary\r\n'
+          'Content-Disposition: form-data; name="$name"\r\n\r\n'
+          '$value\r\n');
+    });
+    request.sink.add(utf8.encode(head.toString()));
+    return upload;
+  }
+
+  final http.Client _client;
+  final http.StreamedRequest _request;
+  final String _boundary;
+  final Future<http.StreamedResponse> response;
+  bool _finished = false;
+  bool _fileStarted = false;
+
+  void _startFile(String filename, String contentType) {
+    _fileStarted = true;
+    _request.sink.add(utf8.encode('--$_boundary\r\n'
+        'Content-Disposition: form-data; name="file"; filename="$filename"\r\n'
+        'Content-Type: $contentType\r\n\r\n'));
+  }
+
+  void addPcm(Uint8List pcm) {
+    if (_finished) return;
+    if (!_fileStarted) {
+      _startFile('audio.wav', 'audio/wav');
+      _request.sink.add(OpenAIASRProvider._wavHeader(null));
+    }
+    final n = pcm.length & ~1;
+    _request.sink.add(n == pcm.length ? pcm : Uint8List.sublistView(pcm, 0, n));
+  }
+
+  void addFlac(Uint8List bytes) {
+    if (_finished) return;
+    if (!_fileStarted) _startFile('audio.flac', 'audio/flac');
+    _request.sink.add(bytes);
+  }
+
+  /// 写结尾边界，请求体结束
+  void finish() {
+    if (_finished) return;
+    _finished = true;
+    _request.sink.add(utf8.encode('\r\n--$_boundary--\r\n'));
+    _request.sink.close();
+  }
+
+  void close() => _client.close();
+
+  /// 放弃本次请求（没录到音 / 录音取消 / provider 释放）
+  void abort() {
+    // 先断连接再关请求体：反过来的话服务端会收到一个「完整」的截断请求并照常转写
+    _client.close();
+    if (!_finished) {
+      _finished = true;
+      _request.sink.close();
+    }
+  }
+}
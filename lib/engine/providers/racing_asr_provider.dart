@@ -0,0 +1,247 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:speakout/config/app_log.dart';
+import '../../config/app_constants.dart';
+import '../asr_provider.dart';
+import '../asr_result.dart';
+import '../pcm16.dart';
+
+/// 云端 + 本地并行识别，挡云端的长尾延迟。
+///
+/// 同一份音频同时喂给云端 provider 和本地 Sherpa 模型。松键后云端在
+/// [cloudDeadline] 内给出结果就用云端（准确率高），过点还没回来就用本地的 ——
+/// 用户最多多等 [cloudDeadline]，而不是云端偶发的 3~5 秒。本地没认出字时
+/// 继续等云端，直到云端自己的超时；云端先报错则本地一出结果就用。
+///
+/// 任一路 start() 失败，本次会话由另一路单独撑着，两路都失败才抛。
+/// 实时字幕：云端出第一条中间结果之前显示本地的，之后只显示云端的
+/// （批量识别的云端不出中间结果，整段都是本地的）。
+///
+/// 输掉的那一路 stop() 不等它：云端 provider 的代次守卫会挡掉它迟到的消息，
+/// 下一次 start() 照常开新会话。迟到多久记日志，用来调 [cloudDeadline]。
+class RacingASRProvider implements ASRProvider {
+  RacingASRProvider({
+    required this.cloud,
+    required this.local,
+    Duration? cloudDeadline,
+  }) : cloudDeadline = cloudDeadline ?? AppConstants.kAsrRaceCloudDeadline;
+
+  final ASRProvider cloud;
+  final ASRProvider local;
+
+  /// 松键后云端结果的最长等待，initialize 的 `cloudDeadlineMs` 可覆盖
+  Duration cloudDeadline;
+
+  StreamController<String> _textController = StreamController<String>.broadcast();
+  final List<StreamSubscription<String>> _subs = [];
+
+  bool _cloudActive = false;
+  bool _localActive = false;
+
+  /// 本会话云端已出过非空中间结果 —— 之后字幕只跟云端
+  bool _cloudSpoke = false;
+
+  /// stop() 之后两路还可能冒出迟到的中间结果，不再转发
+  bool _listening = false;
+
+  /// 本会话本地一路在 native 线程上从 ring 自己的读位置解码（CoreEngine 在 start() 之后设）；
+  /// Dart 轮询到的样本只喂云端
+  bool localDecodesNatively = false;
+
+  /// 本会话本地一路起来了
+  bool get localActive => _localActive;
+
+  /// 上一次 stop() 用了哪一路（'cloud' / 'local'，都没结果时为 null）
+  String? lastWinner;
+
+  @override
+  Stream<String> get textStream => _textController.stream;
+
+  @override
+  String get type => 'racing';
+
+  @override
+  bool get isReady => cloud.isReady && local.isReady;
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  /// 取两路里长的那个：本地赢了的话 stop() 早早返回，用不满
+  @override
+  Duration get stopTimeout =>
+      cloud.stopTimeout > local.stopTimeout ? cloud.stopTimeout : local.stopTimeout;
+
+  @override
+  Future<void> initialize(Map<String, dynamic> config) async {
+    final ms = config['cloudDeadlineMs'];
+    if (ms is int) cloudDeadline = Duration(milliseconds: ms);
+
+    // 本地加载模型、云端握手/预热互不相干，并行
+    Object? error;
+    await Future.wait([
+      for (final (p, key) in [(cloud, 'cloud'), (local, 'local')])
+        p
+            .initialize(Map<String, dynamic>.from(config[key] as Map? ?? const {}))
+            .catchError((Object e) {
+          _log('$key init failed: $e');
+          error ??= e;
+        }),
+    ]);
+    if (error != null) {
+      // 一路起来了也不能留着：调用方只会 dispose 它拿到的 provider，也就是这个外壳
+      await dispose();
+      throw error!;
+    }
+
+    _subs.add(cloud.textStream.listen((text) {
+      if (!_listening) return;
+      if (text.isNotEmpty) _cloudSpoke = true;
+      if (_cloudSpoke) _textController.add(text);
+    }));
+    _subs.add(local.textStream.listen((text) {
+      if (!_listening || _cloudSpoke) return;
+      _textController.add(text);
+    }));
+    _log('Initialized (cloud=${cloud.type}, local=${local.type}, '
+        'deadline=${cloudDeadline.inMilliseconds}ms)');
+  }
+
+  @override
+  Future<void> start() async {
+    _cloudSpoke = false;
+    localDecodesNatively = false;
+    final errors = await Future.wait([_startChild(cloud), _startChild(local)]);
+    _cloudActive = errors[0] == null;
+    _localActive = errors[1] == null;
+    if (!_cloudActive && !_localActive) throw errors[0]!;
+    if (!_cloudActive) _log('cloud start failed, local only: ${errors[0]}');
+    if (!_localActive) _log('local start failed, cloud only: ${errors[1]}');
+    _listening = true;
+  }
+
+  static Future<Object?> _startChild(ASRProvider p) async {
+    try {
+      await p.start();
+      return null;
+    } catch (e) {
+      return e;
+    }
+  }
+
+  /// 两路都只读不写，同一块缓冲直接共用
+  @override
+  void acceptPcm16(Uint8List pcm) {
+    if (_cloudActive) cloud.acceptPcm16(pcm);
+    if (_localActive && !localDecodesNatively) local.acceptPcm16(pcm);
+  }
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  @override
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  Future<ASRResult> stop() async {
+    _listening = false;
+    final sw = Stopwatch()..start();
+    final decided = Completer<ASRResult>();
+    ASRResult? cloudResult;
+    ASRResult? localResult;
+    var cloudDone = !_cloudActive;
+    var localDone = !_localActive;
+    var deadlinePassed = false;
+    var decidedAtMs = 0;
+    lastWinner = null;
+
+    void decide(String? winner, ASRResult result) {
+      decidedAtMs = sw.elapsedMilliseconds;
+      lastWinner = winner;
+      _log('winner=${winner ?? 'none'} at ${decidedAtMs}ms '
+          '(cloud ${cloudDone ? 'done' : 'pending'}, local ${localDone ? 'done' : 'pending'})');
+      decided.complete(result);
+    }
+
+    void settle() {
+      if (decided.isCompleted) return;
+      if (_usable(cloudResult)) {
+        decide('cloud', cloudResult!);
+      } else if (_usable(localResult) && (deadlinePassed || cloudDone)) {
+        decide('local', localResult!);
+      } else if (cloudDone && localDone) {
+        // 两路都没字：带着云端的错误信息返回，用户才知道是鉴权/网络出了问题
+        decide(null, cloudResult ?? localResult ?? ASRResult.textOnly(''));
+      }
+    }
+
+    void arrived(String who) {
+      if (decided.isCompleted) {
+        _log('$who arrived ${sw.elapsedMilliseconds - decidedAtMs}ms after $lastWinner won');
+      }
+      settle();
+    }
+
+    // 期限从松键算起，先于两路 stop() 建好：离线的本地一路在 stop() 里同步解码整段，
+    // 期限要是等它返回才开始计，每句话都要付「本地解码 + cloudDeadline」
+    final deadline = Timer(cloudDeadline, () {
+      deadlinePassed = true;
+      settle();
+    });
+    final cloudActive = _cloudActive;
+    final localActive = _localActive;
+    _cloudActive = false;
+    _localActive = false;
+    try {
+      if (cloudActive) {
+        unawaited(_stopChild(cloud).then((r) {
+          cloudResult = r;
+          cloudDone = true;
+          arrived('cloud');
+        }));
+      }
+      if (localActive) {
+        // 让云端先把结束帧 / 请求体尾巴发出去，再让本地占住 UI isolate 解码
+        await Future<void>.delayed(Duration.zero);
+        unawaited(_stopChild(local).then((r) {
+          localResult = r;
+          localDone = true;
+          arrived('local');
+        }));
+      }
+      settle();
+      return await decided.future;
+    } finally {
+      deadline.cancel();
+    }
+  }
+
+  static bool _usable(ASRResult? r) => r != null && r.error == null && r.text.trim().isNotEmpty;
+
+  static Future<ASRResult> _stopChild(ASRProvider p) async {
+    try {
+      return await p.stop().timeout(p.stopTimeout);
+    } catch (e) {
+      return ASRResult.withError('${p.type}: $e');
+    }
+  }
+
+  @override
+  Future<void> dispose() async {
+    _listening = false;
+    for (final s in _subs) {
+      await s.cancel();
+    }
+    _subs.clear();
+    await Future.wait([
+      for (final p in [cloud, local])
+        p.dispose().catchError((Object e) => _log('${p.type} dispose failed: $e')),
+    ]);
+    await _textController.close();
+    // 与 SherpaProvider 一样重建，dispose 后可以再次 initialize
+    _textController = StreamController<String>.broadcast();
+  }
+
+  void _log(String msg) => AppLog.d('[RacingASR] $msg');
+}
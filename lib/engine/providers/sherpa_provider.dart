@@ -4,6 +4,9 @@ import 'package:flutter/foundation.dart';
 import 'package:sherpa_onnx/sherpa_onnx.dart' as sherpa;
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../native_stream_decoder.dart';
+import '../pcm16.dart';
+import '../../ffi/native_input_base.dart';
 import 'package:speakout/config/app_log.dart';
 import '../../config/app_constants.dart';
 
@@ -11,6 +14,25 @@ class SherpaProvider implements ASRProvider {
   sherpa.OnlineRecognizer? _recognizer;
   sherpa.OnlineStream? _stream;
   bool _isInit = false;
+  bool _hotwordsActive = false;
+
+  /// 收尾补的静音：sherpa 流式解码器尾部会吞字，补 0.8s 才解得全
+  static const int tailPaddingMs = 800;
+
+  /// 本次会话由 native 线程解码时非空（见 [startNativeDecode]）
+  NativeStreamDecoder? _nativeDecoder;
+  /// Dart 加载 sherpa C API 用的路径；空串 = 按 soname（Linux）
+  String _sherpaLibPath = '';
+
+  // Dart 路径的解码统计：主 isolate 上被 decode 占掉的总时长和最长一次
+  final Stopwatch _decodeWatch = Stopwatch();
+  int _maxBlockUs = 0;
+  int _partials = 0;
+  String _lastPartial = '';
+  Map<String, Object?> _lastDecodeStats = const {};
+
+  /// 上一次 [stop] 的解码统计（decode = native / dart），写进延迟追踪对比两条路径
+  Map<String, Object?> get lastDecodeStats => _lastDecodeStats;
   
   StreamController<String> _textController = StreamController<String>.broadcast();
   
@@ -23,68 +45,90 @@ class SherpaProvider implements ASRProvider {
   @override
   bool get isReady => _isInit && _recognizer != null;
 
+  /// 只有 transducer + modified_beam_search 支持热词偏置（sherpa 的上下文图
+  /// 挂在 beam search 上）；paraformer 走 greedy，传了热词也不生效。
+  static bool supportsHotwords(String modelType) => modelType == 'zipformer';
+
+  /// 当前识别器是否真的带着热词在解码（热词文件有问题时会退回无热词）
+  bool get hotwordsActive => _hotwordsActive;
+
   @override
   Future<void> initialize(Map<String, dynamic> config) async {
     final modelPath = config['modelPath'] as String;
     final modelType = config['modelType'] as String? ?? 'zipformer';
+    final hotwordsFile = supportsHotwords(modelType)
+        ? config['hotwordsFile'] as String? ?? ''
+        : '';
     
     // Ensure cleanup before re-init
     await dispose();
     
     _initSherpaBindings();
 
-    sherpa.OnlineRecognizerConfig recognizerConfig;
-
-    if (modelType == 'paraformer') {
-      // Paraformer uses CTC-based decoding, less prone to repetition
-      // Use default greedy_search and no blankPenalty
-      recognizerConfig = sherpa.OnlineRecognizerConfig(
-        model: sherpa.OnlineModelConfig(
-          paraformer: sherpa.OnlineParaformerModelConfig(
-            encoder: "$modelPath/encoder.int8.onnx",
-            decoder: "$modelPath/decoder.int8.onnx",
+    sherpa.OnlineRecognizerConfig recognizerConfig(String hotwords) {
+      if (modelType == 'paraformer') {
+        // Paraformer uses CTC-based decoding, less prone to repetition
+        // Use default greedy_search and no blankPenalty
+        return sherpa.OnlineRecognizerConfig(
+          model: sherpa.OnlineModelConfig(
+            paraformer: sherpa.OnlineParaformerModelConfig(
+              encoder: "$modelPath/encoder.int8.onnx",
+              decoder: "$modelPath/decoder.int8.onnx",
+            ),
+            tokens: "$modelPath/tokens.txt",
+            numThreads: 2,
+            provider: "cpu",
+            debug: false,
+            modelType: "paraformer",
           ),
-          tokens: "$modelPath/tokens.txt",
-          numThreads: 2,
-          provider: "cpu",
-          debug: false,
-          modelType: "paraformer",
-        ),
-        feat: const sherpa.FeatureConfig(sampleRate: 16000),
-        enableEndpoint: true,
-        rule1MinTrailingSilence: 2.4,
-        rule2MinTrailingSilence: 1.2,
-        rule3MinUtteranceLength: 20,
-      );
-    } else {
-      // Default: Zipformer
-      recognizerConfig = sherpa.OnlineRecognizerConfig(
-        model: sherpa.OnlineModelConfig(
-          transducer: sherpa.OnlineTransducerModelConfig(
-            encoder: _findFile(modelPath, "encoder"),
-            decoder: _findFile(modelPath, "decoder"),
-            joiner: _findFile(modelPath, "joiner"),
+          feat: const sherpa.FeatureConfig(sampleRate: 16000),
+          enableEndpoint: true,
+          rule1MinTrailingSilence: 2.4,
+          rule2MinTrailingSilence: 1.2,
+          rule3MinUtteranceLength: 20,
+        );
+      } else {
+        // Default: Zipformer
+        return sherpa.OnlineRecognizerConfig(
+          model: sherpa.OnlineModelConfig(
+            transducer: sherpa.OnlineTransducerModelConfig(
+              encoder: _findFile(modelPath, "encoder"),
+              decoder: _findFile(modelPath, "decoder"),
+              joiner: _findFile(modelPath, "joiner"),
+            ),
+            tokens: "$modelPath/tokens.txt",
+            numThreads: 2,
+            provider: "cpu",
+            debug: false,
+            modelType: "zipformer",
           ),
-          tokens: "$modelPath/tokens.txt",
-          numThreads: 2,
-          provider: "cpu",
-          debug: false,
-          modelType: "zipformer",
-        ),
-        feat: const sherpa.FeatureConfig(sampleRate: 16000),
-        enableEndpoint: true,
-        rule1MinTrailingSilence: 2.4,
-        rule2MinTrailingSilence: 1.2,
-        rule3MinUtteranceLength: 20,
-        // Anti-repetition tuning
-        decodingMethod: 'modified_beam_search',
-        maxActivePaths: 4,
-        blankPenalty: 5.0,
-      );
+          feat: const sherpa.FeatureConfig(sampleRate: 16000),
+          enableEndpoint: true,
+          rule1MinTrailingSilence: 2.4,
+          rule2MinTrailingSilence: 1.2,
+          rule3MinUtteranceLength: 20,
+          // Anti-repetition tuning
+          decodingMethod: 'modified_beam_search',
+          maxActivePaths: 4,
+          blankPenalty: 5.0,
+          hotwordsFile: hotwords,
+          hotwordsScore: AppConstants.kHotwordsScore,
+        );
+      }
     }
-    
+
     try {
-      _recognizer = sherpa.OnlineRecognizer(recognizerConfig);
+      if (hotwordsFile.isNotEmpty) {
+        try {
+          _recognizer = sherpa.OnlineRecognizer(recognizerConfig(hotwordsFile));
+          _hotwordsActive = true;
+        } catch (e) {
+          // 热词文件里混进模型不认识的 token 会让创建直接失败 —— 丢掉热词再来一次，
+          // 不能因为词库把整个本地识别搞挂
+          AppLog.d("[SherpaProvider] 带热词创建失败，退回无热词: $e");
+        }
+      }
+      _recognizer ??= sherpa.OnlineRecognizer(recognizerConfig(''));
       _isInit = true;
     } catch (e) {
       _isInit = false;
@@ -99,6 +143,7 @@ class SherpaProvider implements ASRProvider {
        
        if (libFile.existsSync()) {
           sherpa.initBindings(libFile.parent.path);
+          _sherpaLibPath = libFile.path;
        } else {
           sherpa.initBindings(); 
        }
@@ -111,13 +156,40 @@ class SherpaProvider implements ASRProvider {
   Future<void> start() async {
     if (!_isInit || _recognizer == null) throw Exception("Sherpa not initialized");
     _stream = _recognizer!.createStream();
+    _decodeWatch.reset();
+    _maxBlockUs = 0;
+    _partials = 0;
+    _lastPartial = '';
+  }
+
+  /// 本次会话改由 native 线程从 ring 直接取数解码，字幕经 port 回来
+  /// （见 [NativeStreamDecoder]）。[start] 之后、音频开始之后调用；成功后 CoreEngine
+  /// 不再轮询 ring，[acceptWaveform] 也不会再被调。平台或 sherpa 库不支持时返回 false，
+  /// 一切照旧。
+  bool startNativeDecode(NativeInputBase native) {
+    final recognizer = _recognizer;
+    final stream = _stream;
+    if (recognizer == null || stream == null || _nativeDecoder != null) return false;
+    _nativeDecoder = NativeStreamDecoder.start(
+      native,
+      recognizer: recognizer.ptr.cast(),
+      stream: stream.ptr.cast(),
+      sherpaLib: _sherpaLibPath,
+      paddingMs: tailPaddingMs,
+      onPartial: (text) {
+        if (!_textController.isClosed) _textController.add(text);
+      },
+    );
+    return _nativeDecoder != null;
   }
 
   @override
   void acceptWaveform(Float32List samples) {
-    if (_stream == null || _recognizer == null) return;
+    if (_stream == null || _recognizer == null || _nativeDecoder != null) return;
     
     try {
+      final before = _decodeWatch.elapsedMicroseconds;
+      _decodeWatch.start();
       _stream!.acceptWaveform(samples: samples, sampleRate: 16000);
       
       // Active Decoding Loop
@@ -126,7 +198,14 @@ class SherpaProvider implements ASRProvider {
       }
       
       final result = _recognizer!.getResult(_stream!);
+      _decodeWatch.stop();
+      final blocked = _decodeWatch.elapsedMicroseconds - before;
+      if (blocked > _maxBlockUs) _maxBlockUs = blocked;
       if (result.text.isNotEmpty) {
+        if (result.text != _lastPartial) {
+          _lastPartial = result.text;
+          _partials++;
+        }
         _textController.add(result.text); // Emit partial result
       }
     } catch (e) {
@@ -135,6 +214,17 @@ class SherpaProvider implements ASRProvider {
     }
   }
 
+  /// sherpa 的 acceptWaveform 只收 Float32（内部再拷进原生缓冲），这条路不变
+  @override
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.float32;
+
+  @override
+  void acceptPcm16(Uint8List pcm) => acceptWaveform(pcm16ToFloat32(pcm));
+
   /// 本地解码：stop 里同步跑完剩余音频，不走网络。
   @override
   Duration get stopTimeout => AppConstants.kAsrStopTimeout;
@@ -144,16 +234,47 @@ class SherpaProvider implements ASRProvider {
     if (_stream == null || _recognizer == null) return ASRResult.textOnly("");
 
     try {
-      // Inject silence padding for Sherpa's decoder quirks
-      // Padding (Increased to 0.8s to fix tail truncation)
-      final silence = Float32List(12800); // 0.8s @ 16k
-      acceptWaveform(silence);
+      final decoder = _nativeDecoder;
+      if (decoder != null) {
+        // 收尾（补静音、inputFinished、最后一轮 decode）在解码线程上做完
+        var finished = false;
+        try {
+          await decoder.finish().timeout(AppConstants.kAsrStopTimeout);
+          finished = true;
+        } on TimeoutException {
+          AppLog.d("[SherpaProvider] native decode did not finish in time");
+        }
+        _lastDecodeStats = {
+          ...decoder.stats(),
+          if (decoder.firstPartialNativeUs != null)
+            'firstPartialNativeUs': decoder.firstPartialNativeUs,
+        };
+        if (finished) {
+          decoder.destroy();
+        } else {
+          await decoder.abort();
+        }
+        _nativeDecoder = null;
+      } else {
+        // Inject silence padding for Sherpa's decoder quirks
+        // Padding (Increased to 0.8s to fix tail truncation)
+        final silence = Float32List(tailPaddingMs * 16); // 0.8s @ 16k
+        acceptWaveform(silence);
 
-      _stream!.inputFinished();
+        _stream!.inputFinished();
 
-      // Final Decode
-      while (_recognizer!.isReady(_stream!)) {
-        _recognizer!.decode(_stream!);
+        // Final Decode
+        _decodeWatch.start();
+        while (_recognizer!.isReady(_stream!)) {
+          _recognizer!.decode(_stream!);
+        }
+        _decodeWatch.stop();
+        _lastDecodeStats = {
+          'decode': 'dart',
+          'decodeMs': _decodeWatch.elapsedMicroseconds / 1000,
+          'partials': _partials,
+          'maxBlockMs': _maxBlockUs / 1000,
+        };
       }
 
       final result = _recognizer!.getResult(_stream!);
@@ -170,6 +291,8 @@ class SherpaProvider implements ASRProvider {
       );
     } catch (e) {
       AppLog.d("[SherpaProvider] stop error: $e");
+      _nativeDecoder?.destroy(abort: true);
+      _nativeDecoder = null;
       try { _stream?.free(); } catch (_) {}
       _stream = null;
       return ASRResult.textOnly("");
@@ -200,11 +323,15 @@ class SherpaProvider implements ASRProvider {
 
   @override
   Future<void> dispose() async {
+    // 解码线程手上拿着 stream / recognizer，必须先等它退出
+    _nativeDecoder?.destroy(abort: true);
+    _nativeDecoder = null;
     _stream?.free();
     _stream = null;
     _recognizer?.free();
     _recognizer = null;
     _isInit = false;
+    _hotwordsActive = false;
     _textController.close();
     // Recreate controller so provider can be re-initialized
     _textController = StreamController<String>.broadcast();
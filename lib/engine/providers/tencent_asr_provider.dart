@@ -1,12 +1,15 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:io';
 import 'dart:math';
 import 'dart:typed_data';
 import 'package:crypto/crypto.dart';
 import 'package:uuid/uuid.dart';
-import 'package:web_socket_channel/io.dart';
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
+import 'ws_audio_framer.dart';
+import 'ws_warm_pool.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 import '../../config/app_constants.dart';
@@ -23,7 +26,10 @@ class TencentASRProvider implements ASRProvider {
   /// 不只是发布过期文本，回调还会改写新会话的共享状态（_finalText/_stopCompleter）。
   /// 守卫因此包住整个 listener。与 OpenAI 那处同源。
   int _generation = 0;
-  IOWebSocketChannel? _channel;
+  WarmSocket? _socket;
+  WsWarmPool? _pool;
+  /// start() 里后台取连接的那个 future；stop() 要等它落定才能发结束信号
+  Future<void>? _attaching;
   StreamController<String> _textController = StreamController<String>.broadcast();
 
   late String _secretId;
@@ -36,8 +42,14 @@ class TencentASRProvider implements ASRProvider {
 
   // Audio buffering before connection is ready
   final List<Uint8List> _pendingBuffer = [];
+  bool _pendingOverflowLogged = false;
   static const int _maxPendingBuffers = 200;
 
+  /// 每包音频时长。文档要求的是 1:1 实时率（示例每 40ms 发 40ms）；
+  /// 每 200ms 发 200ms 仍是 1:1，消息数只有原先 50ms 一包的 1/4
+  static const _defaultFrameMs = 200;
+  late WsAudioFramer _framer;
+
   // Result tracking
   String _finalText = '';
   String? _errorMessage;
@@ -60,11 +72,26 @@ class TencentASRProvider implements ASRProvider {
     // 注册表 id（asr-streaming）只是 UI 标识，**不是** engine_model_type。
     // 真正下发的值由 _tencentEngineModelFor(语言) 决定，见 _buildSignedUrl。
     _engineModel = config['model'] as String? ?? '';
+    _framer = WsAudioFramer(
+      frameMs: config['frameMs'] as int? ?? _defaultFrameMs,
+      emit: (frame, _, __) => _sendOrBuffer(frame),
+    );
 
     if (_secretId.isEmpty || _secretKey.isEmpty || _appId.isEmpty) {
       throw Exception('Tencent ASR: secretId, secretKey, appId required');
     }
 
+    await _pool?.dispose();
+    _pool = WsWarmPool(
+      // 签名 URL 每条连接现签（voice_id / nonce 不能复用）
+      () => WebSocket.connect(_buildSignedUrl()),
+      tag: 'TencentASR',
+      // 语言写在 URL 的 engine_model_type 里，连上之后改不了：
+      // 备用连接建好后用户切了语言，这条就作废
+      fingerprint: () => _tencentEngineModelFor(ConfigService().inputLanguage),
+    );
+    _pool!.prewarm();
+
     _isReady = true;
     _log('Initialized (appId=$_appId, model=$_engineModel)');
   }
@@ -76,15 +103,27 @@ class TencentASRProvider implements ASRProvider {
     _finalText = '';
     _errorMessage = null;
     _pendingBuffer.clear();
+    _framer.reset();
     _isConnected = false;
+    _pendingOverflowLogged = false;
+    _socket = null;
     _stopCompleter = Completer<ASRResult>();
 
-    final url = _buildSignedUrl();
-    _log('Connecting to Tencent ASR...');
+    // 不在这里 await：CoreEngine 在 start() 返回后才开原生录音，
+    // 等握手就等于把握手时间加到了按键延迟上。连接没好之前音频进 _pendingBuffer。
+    // 预热池里的连接每条只发一次，代次守卫的前提（一次录音一条新连接）不变
+    _attaching = _attach(gen, _pool!.acquire());
+  }
 
+  Future<void> _attach(int gen, Future<WarmSocket> connecting) async {
     try {
-      _channel = IOWebSocketChannel.connect(Uri.parse(url));
-      _channel!.stream.listen(
+      final socket = await connecting;
+      if (gen != _generation) {
+        socket.close();
+        return;
+      }
+      _socket = socket;
+      socket.stream.listen(
         (msg) {
           if (gen != _generation) return; // 上一轮录音的迟到帧，丢弃
           _onMessage(msg);
@@ -102,27 +141,44 @@ class TencentASRProvider implements ASRProvider {
         },
       );
       _isConnected = true;
+      _log('[PERF] session attached: ${socket.warm ? 'warm' : 'cold'}, '
+          'handshake ${socket.handshake.inMilliseconds}ms, ${_pendingBuffer.length} buffered frames');
 
       // Flush pending audio
       for (final buf in _pendingBuffer) {
-        _channel!.sink.add(buf);
+        socket.sink.add(buf);
       }
       _pendingBuffer.clear();
     } catch (e) {
+      if (gen != _generation) return;
       _log('Connection failed: $e');
       _errorMessage = e.toString();
+      _finishStop();
     }
   }
 
   @override
-  void acceptWaveform(Float32List samples) {
-    // Convert Float32 → Int16 PCM bytes
-    final pcm = _float32ToInt16Bytes(samples);
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
 
-    if (_isConnected && _channel != null) {
-      _channel!.sink.add(pcm);
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  /// 原生采集的字节原样上传，不经 Float32 往返；攒满一包才发
+  @override
+  void acceptPcm16(Uint8List pcm) => _framer.add(pcm);
+
+  void _sendOrBuffer(Uint8List pcm) {
+    if (_isConnected && _socket != null) {
+      _socket!.sink.add(pcm);
     } else if (_pendingBuffer.length < _maxPendingBuffers) {
       _pendingBuffer.add(pcm);
+    } else if (!_pendingOverflowLogged) {
+      _pendingOverflowLogged = true;
+      _log('Pending buffer full while connecting, dropping audio');
     }
   }
 
@@ -132,11 +188,20 @@ class TencentASRProvider implements ASRProvider {
 
   @override
   Future<ASRResult> stop() async {
+    final deadline = DateTime.now().add(AppConstants.kAsrFinalFrameWait);
 
-    if (_channel != null && _isConnected) {
-      // Send end signal
+    // 松键时连接可能还在建：等它接上、把攒着的音频发出去再发结束信号。
+    // 与下面等最终结果共用同一个时间预算。
+    final attaching = _attaching;
+    if (attaching != null && _socket == null) {
+      await attaching.timeout(AppConstants.kAsrFinalFrameWait, onTimeout: () {});
+    }
+
+    if (_socket != null && _isConnected) {
+      // 没攒满的尾巴先发，再发结束信号
+      _framer.flush();
       try {
-        _channel!.sink.add(jsonEncode({'type': 'end'}));
+        _socket!.sink.add(jsonEncode({'type': 'end'}));
       } catch (_) {}
     }
 
@@ -144,13 +209,17 @@ class TencentASRProvider implements ASRProvider {
     // 内层等待走 kAsrFinalFrameWait，**不要**用 stopTimeout —— 后者是引擎给
     // 整个 stop() 的预算（kAsrStopTimeout），两者相等就成了竞速：
     // 引擎的超时回调返回空文本，会把这里攒下的部分文本一起丢掉。
-    return (_stopCompleter?.future ?? Future.value(_buildResult())).timeout(
-      AppConstants.kAsrFinalFrameWait,
+    final remaining = deadline.difference(DateTime.now());
+    final result = await (_stopCompleter?.future ?? Future.value(_buildResult())).timeout(
+      remaining.isNegative ? Duration.zero : remaining,
       onTimeout: () {
         _log('Stop timeout, returning current text');
         return _buildResult();
       },
     );
+    // 这条连接用完即弃，给下一句备一条
+    _pool?.prewarm();
+    return result;
   }
 
   @override
@@ -158,8 +227,11 @@ class TencentASRProvider implements ASRProvider {
     _isReady = false;
     _isConnected = false;
     _pendingBuffer.clear();
-    try { await _channel?.sink.close(); } catch (_) {}
-    _channel = null;
+    _generation++; // 还在建的连接落定后自己关掉
+    await _pool?.dispose();
+    _pool = null;
+    await _socket?.close();
+    _socket = null;
     _textController.close();
     _textController = StreamController<String>.broadcast();
   }
@@ -212,7 +284,7 @@ class TencentASRProvider implements ASRProvider {
       _stopCompleter!.complete(_buildResult());
     }
     _isConnected = false;
-    try { _channel?.sink.close(); } catch (_) {}
+    _socket?.close();
   }
 
   ASRResult _buildResult() {
@@ -222,15 +294,6 @@ class TencentASRProvider implements ASRProvider {
     return ASRResult.textOnly(_finalText);
   }
 
-  Uint8List _float32ToInt16Bytes(Float32List samples) {
-    final bytes = ByteData(samples.length * 2);
-    for (int i = 0; i < samples.length; i++) {
-      final s = samples[i].clamp(-1.0, 1.0);
-      bytes.setInt16(i * 2, (s * 32767).toInt(), Endian.little);
-    }
-    return bytes.buffer.asUint8List();
-  }
-
   /// 构建带签名的 WebSocket URL
   /// 语言 → 腾讯 engine_model_type。
   /// 取值来自腾讯实时语音识别文档；auto 归到中文大模型（对中英混说效果最好）。
@@ -2,9 +2,11 @@ import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
 import 'dart:typed_data';
-import 'package:web_socket_channel/io.dart';
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
+import 'ws_audio_framer.dart';
+import 'ws_warm_pool.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 import '../../config/app_constants.dart';
@@ -22,10 +24,22 @@ class VolcengineASRProvider implements ASRProvider {
   /// _finalText / _stopCompleter 等**新会话**的共享状态。
   /// 守卫因此包住整个 listener，而不只是发布点。与 OpenAI 那处同源。
   int _generation = 0;
-  IOWebSocketChannel? _channel;
+  WarmSocket? _socket;
+  WsWarmPool? _pool;
+  /// start() 里后台取连接的那个 future；stop() 要等它落定才能发最后一帧
+  Future<void>? _attaching;
   StreamController<String> _textController = StreamController<String>.broadcast();
 
   late String _apiKey;
+  late String _endpoint;
+
+  static const _defaultEndpoint = 'wss://openspeech.bytedance.com/api/v3/sauc/bigmodel';
+
+  /// 每包音频时长。文档建议 100~200ms 一包，「200ms 性能最优」
+  static const _defaultFrameMs = 200;
+
+  /// 音频攒成整包再发，协议头直接写在包缓冲开头（见 [WsAudioFramer]）
+  late WsAudioFramer _framer;
 
   bool _isReady = false;
   bool _isConnected = false;
@@ -34,6 +48,7 @@ class VolcengineASRProvider implements ASRProvider {
   // Audio buffering before handshake completes
   final List<Uint8List> _pendingBuffer = [];
   int _frameDebugCount = 0;
+  bool _pendingOverflowLogged = false;
   static const int _maxPendingBuffers = 200;
 
   // Result tracking
@@ -57,11 +72,34 @@ class VolcengineASRProvider implements ASRProvider {
     if (_apiKey.isEmpty) {
       throw Exception('Volcengine ASR: apiKey required');
     }
+    // endpoint 只给测试用（指向本地替身服务），正常配置里没有这一项
+    _endpoint = config['endpoint'] as String? ?? _defaultEndpoint;
+    _framer = WsAudioFramer(
+      frameMs: config['frameMs'] as int? ?? _defaultFrameMs,
+      headerBytes: 8,
+      emit: _onAudioFrame,
+    );
+
+    await _pool?.dispose();
+    _pool = WsWarmPool(
+      () => WebSocket.connect(_endpoint, headers: {
+        'X-Api-Key': _apiKey,
+        'X-Api-Resource-Id': 'volc.seedasr.sauc.duration',
+      }),
+      tag: 'VolcengineASR',
+    );
+    // 切到火山之后第一句话通常紧跟着来，先把连接建起来
+    _pool!.prewarm();
 
     _isReady = true;
     _log('Initialized');
   }
 
+  /// 最近一次取用连接的握手耗时（预热命中时是当初预热的耗时）
+  Duration? get lastHandshake => _pool?.lastHandshake;
+  int get warmHits => _pool?.warmHits ?? 0;
+  int get coldConnects => _pool?.coldConnects ?? 0;
+
   @override
   Future<void> start() async {
     _generation++;
@@ -70,21 +108,28 @@ class VolcengineASRProvider implements ASRProvider {
     _errorMessage = null;
     _handshakeDone = false;
     _pendingBuffer.clear();
+    _framer.reset();
     _isConnected = false;
+    _pendingOverflowLogged = false;
+    _socket = null;
     _stopCompleter = Completer<ASRResult>();
 
-    const url = 'wss://openspeech.bytedance.com/api/v3/sauc/bigmodel';
-    _log('Connecting to Volcengine ASR...');
+    // 不在这里 await：CoreEngine 在 start() 返回后才开原生录音，
+    // 等握手就等于把握手时间加到了按键延迟上。连接没好之前音频进 _pendingBuffer。
+    // 预热池里的连接每条只发一次，代次守卫的前提（一次录音一条新连接）不变
+    _attaching = _attach(gen, _pool!.acquire());
+  }
 
+  Future<void> _attach(int gen, Future<WarmSocket> connecting) async {
     try {
-      _channel = IOWebSocketChannel.connect(
-        Uri.parse(url),
-        headers: {
-          'X-Api-Key': _apiKey,
-          'X-Api-Resource-Id': 'volc.seedasr.sauc.duration',
-        },
-      );
-      _channel!.stream.listen(
+      final socket = await connecting;
+      if (gen != _generation) {
+        // 连接还没好这次录音就结束了（或者又开了下一次），这条不能再给别人用
+        socket.close();
+        return;
+      }
+      _socket = socket;
+      socket.stream.listen(
         (msg) {
           if (gen != _generation) return; // 上一轮录音的迟到帧，丢弃
           _onMessage(msg);
@@ -102,23 +147,47 @@ class VolcengineASRProvider implements ASRProvider {
         },
       );
       _isConnected = true;
+      _log('[PERF] session attached: ${socket.warm ? 'warm' : 'cold'}, '
+          'handshake ${socket.handshake.inMilliseconds}ms, ${_pendingBuffer.length} buffered frames');
 
       // Send FullClientRequest (handshake with config)
       _sendFullClientRequest();
     } catch (e) {
+      if (gen != _generation) return;
       _log('Connection failed: $e');
       _errorMessage = e.toString();
+      // 连不上就没有「最后一帧」可等了，stop() 直接带错误返回
+      _finishStop();
     }
   }
 
   @override
-  void acceptWaveform(Float32List samples) {
-    final pcm = _float32ToInt16Bytes(samples);
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
 
-    if (_isConnected && _handshakeDone && _channel != null) {
-      _sendAudioFrame(pcm, isLast: false);
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  /// 原生采集的字节原样上传，不经 Float32 往返；攒满一包才发
+  @override
+  void acceptPcm16(Uint8List pcm) => _framer.add(pcm);
+
+  /// 一包攒好了：原地补上协议头，发出或在握手前先存着（存的是成品帧）
+  void _onAudioFrame(Uint8List frame, int payloadLength, bool isLast) {
+    // AudioOnly: msgType=0x2, serialization=0 (raw audio), compression=0
+    _writeHeader(frame, _msgAudioOnly, isLast ? 0x2 : 0x0, payloadLength, serialization: 0x0);
+    if (_isConnected && _handshakeDone && _socket != null) {
+      try {
+        _socket!.sink.add(frame);
+      } catch (_) {}
     } else if (_pendingBuffer.length < _maxPendingBuffers) {
-      _pendingBuffer.add(pcm);
+      _pendingBuffer.add(frame);
+    } else if (!_pendingOverflowLogged) {
+      _pendingOverflowLogged = true;
+      _log('Pending buffer full while connecting, dropping audio');
     }
   }
 
@@ -128,24 +197,34 @@ class VolcengineASRProvider implements ASRProvider {
 
   @override
   Future<ASRResult> stop() async {
+    final deadline = DateTime.now().add(AppConstants.kAsrFinalFrameWait);
 
-    if (_channel != null && _isConnected) {
-      // Send last audio frame with finish flag
-      try {
-        _sendAudioFrame(Uint8List(0), isLast: true);
-      } catch (_) {}
+    // 松键时连接可能还在建（冷连接 + 很短的一句）：等它接上再发最后一帧，
+    // 否则攒着的音频一帧都发不出去。与下面等最后一帧共用同一个时间预算。
+    final attaching = _attaching;
+    if (attaching != null && _socket == null) {
+      await attaching.timeout(AppConstants.kAsrFinalFrameWait, onTimeout: () {});
+    }
+
+    if (_socket != null && _isConnected) {
+      // 没攒满的尾巴带着结束标记一起发（没有尾巴就是一个空的结束帧）
+      _framer.flush(isLast: true);
     }
 
     // 内层等待走 kAsrFinalFrameWait，**不要**用 stopTimeout —— 后者是引擎给
     // 整个 stop() 的预算（kAsrStopTimeout），两者相等就成了竞速：
     // 引擎的超时回调返回空文本，会把这里攒下的部分文本一起丢掉。
-    return (_stopCompleter?.future ?? Future.value(_buildResult())).timeout(
-      AppConstants.kAsrFinalFrameWait,
+    final remaining = deadline.difference(DateTime.now());
+    final result = await (_stopCompleter?.future ?? Future.value(_buildResult())).timeout(
+      remaining.isNegative ? Duration.zero : remaining,
       onTimeout: () {
         _log('Stop timeout');
         return _buildResult();
       },
     );
+    // 这条连接用完即弃，给下一句备一条
+    _pool?.prewarm();
+    return result;
   }
 
   @override
@@ -154,8 +233,11 @@ class VolcengineASRProvider implements ASRProvider {
     _isConnected = false;
     _handshakeDone = false;
     _pendingBuffer.clear();
-    try { await _channel?.sink.close(); } catch (_) {}
-    _channel = null;
+    _generation++; // 还在建的连接落定后自己关掉
+    await _pool?.dispose();
+    _pool = null;
+    await _socket?.close();
+    _socket = null;
     _textController.close();
     _textController = StreamController<String>.broadcast();
   }
@@ -177,26 +259,23 @@ class VolcengineASRProvider implements ASRProvider {
   // Serialization: 0x1 = JSON
   // Compression: 0x0 = none, 0x1 = gzip
 
-  Uint8List _buildFrame(int msgType, int flags, Uint8List payload, {int serialization = 0x1, int compression = 0x0}) {
-    final headerSize = 1; // 1 word = 4 bytes
-    final byte0 = (0x1 << 4) | (headerSize & 0xF);
-    final byte1 = ((msgType & 0xF) << 4) | (flags & 0xF);
-    final byte2 = ((serialization & 0xF) << 4) | (compression & 0xF);
-    final byte3 = 0x00;
-
-    final payloadSize = payload.length;
-    final frame = ByteData(4 + 4 + payloadSize);
-    frame.setUint8(0, byte0);
-    frame.setUint8(1, byte1);
-    frame.setUint8(2, byte2);
-    frame.setUint8(3, byte3);
-    frame.setUint32(4, payloadSize, Endian.big);
-
-    for (int i = 0; i < payloadSize; i++) {
-      frame.setUint8(8 + i, payload[i]);
-    }
+  /// 在 [frame] 开头 8 字节原地写 header + payload size
+  static void _writeHeader(Uint8List frame, int msgType, int flags, int payloadSize,
+      {int serialization = 0x1, int compression = 0x0}) {
+    const headerSize = 1; // 1 word = 4 bytes
+    frame[0] = (0x1 << 4) | (headerSize & 0xF);
+    frame[1] = ((msgType & 0xF) << 4) | (flags & 0xF);
+    frame[2] = ((serialization & 0xF) << 4) | (compression & 0xF);
+    frame[3] = 0x00;
+    ByteData.sublistView(frame, 4, 8).setUint32(0, payloadSize, Endian.big);
+  }
 
-    return frame.buffer.asUint8List();
+  static Uint8List _buildFrame(int msgType, int flags, Uint8List payload,
+      {int serialization = 0x1, int compression = 0x0}) {
+    final frame = Uint8List(8 + payload.length)..setRange(8, 8 + payload.length, payload);
+    _writeHeader(frame, msgType, flags, payload.length,
+        serialization: serialization, compression: compression);
+    return frame;
   }
 
   void _sendFullClientRequest() {
@@ -224,31 +303,22 @@ class VolcengineASRProvider implements ASRProvider {
       },
     };
 
-    final jsonPayload = Uint8List.fromList(utf8.encode(jsonEncode(config)));
+    final jsonPayload = utf8.encode(jsonEncode(config));
     // FullClientRequest: msgType=0x1, flags=0b0000 (not last)
     final frame = _buildFrame(_msgFullClient, 0x0, jsonPayload);
-    _channel!.sink.add(frame);
+    _socket!.sink.add(frame);
     _log('Sent FullClientRequest');
 
     // 假设握手成功（V3 协议在首帧响应中确认）
     _handshakeDone = true;
 
-    // Flush pending audio
-    for (final buf in _pendingBuffer) {
-      _sendAudioFrame(buf, isLast: false);
+    // Flush pending audio（已是带头的成品帧）
+    for (final frame in _pendingBuffer) {
+      _socket!.sink.add(frame);
     }
     _pendingBuffer.clear();
   }
 
-  void _sendAudioFrame(Uint8List pcm, {required bool isLast}) {
-    final flags = isLast ? 0x2 : 0x0; // 0b0010 = last frame
-    // AudioOnly: msgType=0x2, serialization=0 (raw audio), compression=0
-    final frame = _buildFrame(_msgAudioOnly, flags, pcm, serialization: 0x0);
-    try {
-      _channel!.sink.add(frame);
-    } catch (_) {}
-  }
-
   // ── 接收响应 ──
 
   void _onMessage(dynamic message) {
@@ -257,7 +327,8 @@ class VolcengineASRProvider implements ASRProvider {
       return;
     }
 
-    final data = Uint8List.fromList(message);
+    // dart:io 交来的本来就是 Uint8List，直接用，不再整帧拷贝
+    final data = message is Uint8List ? message : Uint8List.fromList(message);
     if (data.length < 8) return;
 
     final byte1 = data[1];
@@ -307,7 +378,7 @@ class VolcengineASRProvider implements ASRProvider {
       return;
     }
 
-    var payload = data.sublist(offset, offset + payloadSize);
+    var payload = Uint8List.sublistView(data, offset, offset + payloadSize);
 
     // Decompress if gzip
     if (compression == 0x1) {
@@ -398,7 +469,7 @@ class VolcengineASRProvider implements ASRProvider {
       _stopCompleter!.complete(_buildResult());
     }
     _isConnected = false;
-    try { _channel?.sink.close(); } catch (_) {}
+    _socket?.close();
   }
 
   ASRResult _buildResult() {
@@ -408,14 +479,5 @@ class VolcengineASRProvider implements ASRProvider {
     return ASRResult.textOnly(_finalText);
   }
 
-  Uint8List _float32ToInt16Bytes(Float32List samples) {
-    final bytes = ByteData(samples.length * 2);
-    for (int i = 0; i < samples.length; i++) {
-      final s = samples[i].clamp(-1.0, 1.0);
-      bytes.setInt16(i * 2, (s * 32767).toInt(), Endian.little);
-    }
-    return bytes.buffer.asUint8List();
-  }
-
   void _log(String msg) => AppLog.d('[VolcengineASR] $msg');
 }
@@ -0,0 +1,86 @@
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../../config/app_constants.dart';
+
+/// 云端流式 ASR 的上行聚帧（16kHz mono int16）。
+///
+/// Core 每 50ms 交来一块 PCM（约 1600 字节），原先每块各发一条 WebSocket 消息：
+/// 每条都要一次 socket 写、一次客户端掩码拷贝，火山还要为它另分配「头 + 载荷」
+/// 再逐字节拷一遍。各家文档建议的包长是 100~200ms —— 攒够再发，消息数降到
+/// 1/2~1/4，分配次数跟着降。
+///
+/// **不做缓冲池**：发出去的缓冲所有权交给 socket，dart:io 在对端拥塞时会把它
+/// 原样挂在发送队列里，回收复用就会改写还没发出去的帧。改为每条消息只分配一次：
+///   - 协议头（[headerBytes]）预留在帧缓冲开头，调用方在 [emit] 里原地写；
+///   - 没有协议头时，手上没攒着东西、交来的块又够一整帧，就直接切视图发出，不拷贝。
+class WsAudioFramer {
+  WsAudioFramer({
+    required int frameMs,
+    required this.emit,
+    this.headerBytes = 0,
+  }) : frameBytes = frameMs * AppConstants.kSampleRate ~/ 1000 * 2;
+
+  /// 每帧音频字节数（不含协议头）
+  final int frameBytes;
+
+  /// 每帧开头留给协议头的字节数
+  final int headerBytes;
+
+  /// 一帧攒好了。[frame] 前 [headerBytes] 字节由调用方写协议头，其后
+  /// [payloadLength] 字节是音频；[frame] 的所有权随之交出。
+  final void Function(Uint8List frame, int payloadLength, bool isLast) emit;
+
+  Uint8List? _buf;
+  int _fill = 0;
+
+  /// 统计：发出的帧数 / 为聚帧拷贝的音频字节数
+  int framesEmitted = 0;
+  int bytesCopied = 0;
+
+  /// [pcm] 的所有权交给聚帧器（同 [ASRProvider.acceptPcm16]），可能被切成视图直接发出
+  void add(Uint8List pcm) {
+    var offset = 0;
+    final len = pcm.length;
+    while (offset < len) {
+      if (headerBytes == 0 && _fill == 0 && len - offset >= frameBytes) {
+        _emit(Uint8List.sublistView(pcm, offset, offset + frameBytes), frameBytes, false);
+        offset += frameBytes;
+        continue;
+      }
+      final buf = _buf ??= Uint8List(headerBytes + frameBytes);
+      final n = min(frameBytes - _fill, len - offset);
+      buf.setRange(headerBytes + _fill, headerBytes + _fill + n, pcm, offset);
+      _fill += n;
+      offset += n;
+      bytesCopied += n;
+      if (_fill == frameBytes) {
+        _buf = null;
+        _fill = 0;
+        _emit(buf, frameBytes, false);
+      }
+    }
+  }
+
+  /// 把没攒满的尾巴发出去。[isLast] 时即使没有音频也发一帧（协议的结束帧）。
+  void flush({bool isLast = false}) {
+    if (_fill == 0 && !isLast) return;
+    final buf = _buf ?? Uint8List(headerBytes);
+    final n = _fill;
+    _buf = null;
+    _fill = 0;
+    _emit(buf.length == headerBytes + n ? buf : Uint8List.sublistView(buf, 0, headerBytes + n),
+        n, isLast);
+  }
+
+  /// 丢掉没发出的尾巴（新会话开始）
+  void reset() {
+    _buf = null;
+    _fill = 0;
+  }
+
+  void _emit(Uint8List frame, int payloadLength, bool isLast) {
+    framesEmitted++;
+    emit(frame, payloadLength, isLast);
+  }
+}
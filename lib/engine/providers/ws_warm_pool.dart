@@ -0,0 +1,176 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:speakout/config/app_log.dart';
+import '../../config/app_constants.dart';
+
+/// 一条已完成握手的 WebSocket 连接。
+///
+/// 入站数据在建连时就开始收（转进 [stream] 缓冲着），这样服务端在连接闲置期间
+/// 关掉它也能立刻发现 —— 不监听的话 close 帧没人处理，[isOpen] 会一直是 true，
+/// 下一次录音拿到一条死连接，音频全发进黑洞。
+class WarmSocket {
+  WarmSocket._(this._socket, this.handshake) {
+    _sub = _socket.listen(
+      _incoming.add,
+      onError: _incoming.addError,
+      onDone: () {
+        _closed = true;
+        _incoming.close();
+      },
+      cancelOnError: false,
+    );
+  }
+
+  final WebSocket _socket;
+  late final StreamSubscription<dynamic> _sub;
+  final StreamController<dynamic> _incoming = StreamController<dynamic>();
+  bool _closed = false;
+
+  /// DNS + TCP + TLS + HTTP Upgrade 的耗时
+  final Duration handshake;
+
+  /// 取用时连接是否已经预热好（true = start() 不用等握手）
+  bool warm = false;
+
+  /// 入站消息（单订阅；取用前收到的会缓冲在这里）
+  Stream<dynamic> get stream => _incoming.stream;
+
+  /// 出站，用法与 WebSocketChannel.sink 一致
+  StreamSink<dynamic> get sink => _socket;
+
+  bool get isOpen => !_closed && _socket.readyState == WebSocket.open;
+
+  Future<void> close() async {
+    _closed = true;
+    try {
+      await _socket.close();
+    } catch (_) {}
+    await _sub.cancel();
+    if (!_incoming.isClosed) await _incoming.close();
+  }
+}
+
+/// 流式云端 ASR 的预热连接。
+///
+/// 火山 / 腾讯都是「一条 WebSocket = 一次识别」，原先每次 start() 现连：
+/// DNS + TCP + TLS + Upgrade 全压在按键之后，音频只能先攒着。
+/// 这里在空闲时提前备好一条，start() 直接拿走；用完（stop）再备下一条。
+///
+/// 备用连接最多闲置 [idleTimeout]：服务端对「连上但不发音频」有超时
+/// （腾讯约 15 秒），闲置太久的连接会被对端关掉，与其拿到死连接再重连，
+/// 不如自己先关。关掉时离上次 [prewarm] 还不到 [keepAlive] 就换一条新的接着备，
+/// 过了才真正放手，下次 start() 退回现连，行为与原来一致。
+class WsWarmPool {
+  WsWarmPool(this._connect,
+      {required this.tag,
+      this.idleTimeout = AppConstants.kAsrWarmIdleTimeout,
+      this.keepAlive = AppConstants.kAsrWarmKeepAlive,
+      String Function()? fingerprint})
+      : _fingerprint = fingerprint;
+
+  /// 每次调用都建一条新连接（腾讯的签名 URL 每次都要重新生成）
+  final Future<WebSocket> Function() _connect;
+  final String tag;
+  final Duration idleTimeout;
+  final Duration keepAlive;
+
+  /// 建连时就定死、之后改不了的参数（如腾讯 URL 里的语言）。
+  /// 备用连接建好后用户改了设置，取用时指纹对不上就不用它。
+  final String Function()? _fingerprint;
+
+  Future<WarmSocket>? _spare;
+  String? _spareFingerprint;
+  Timer? _idleTimer;
+  bool _disposed = false;
+  /// 最近一次有人要连接的时刻（初始化 / 用完一条），续备的期限从这里算
+  final Stopwatch _sinceWanted = Stopwatch();
+
+  int warmHits = 0;
+  int coldConnects = 0;
+  Duration? lastHandshake;
+
+  /// 后台备一条连接；已有备用或正在建时什么都不做
+  void prewarm() {
+    _sinceWanted
+      ..reset()
+      ..start();
+    _prepare();
+  }
+
+  void _prepare() {
+    if (_disposed || _spare != null) return;
+    final spare = _open();
+    _spare = spare;
+    _spareFingerprint = _fingerprint?.call();
+    spare.then((socket) {
+      if (!identical(_spare, spare)) return;
+      _idleTimer?.cancel();
+      _idleTimer = Timer(idleTimeout, () {
+        if (!identical(_spare, spare)) return;
+        _spare = null;
+        socket.close();
+        if (_sinceWanted.elapsed < keepAlive) {
+          _log('spare idle ${idleTimeout.inSeconds}s, replacing');
+          _prepare();
+        } else {
+          _log('spare idle ${idleTimeout.inSeconds}s, closing');
+        }
+      });
+    }, onError: (Object e) {
+      if (identical(_spare, spare)) _spare = null;
+      _log('prewarm failed: $e');
+    });
+  }
+
+  /// 取一条可用连接：优先用备用的（正在建的就等它建完），否则现连
+  Future<WarmSocket> acquire() async {
+    final spare = _spare;
+    _spare = null;
+    _idleTimer?.cancel();
+    if (spare != null) {
+      try {
+        final socket = await spare;
+        if (_spareFingerprint != _fingerprint?.call()) {
+          _log('spare built with stale settings, reconnecting');
+          socket.close();
+        } else if (socket.isOpen) {
+          warmHits++;
+          lastHandshake = socket.handshake;
+          socket.warm = true;
+          _log('[PERF] warm connection (handshake was ${socket.handshake.inMilliseconds}ms)');
+          return socket;
+        } else {
+          _log('spare closed by peer, reconnecting');
+        }
+      } catch (_) {
+        // 备用那条没建起来，下面现连
+      }
+    }
+    coldConnects++;
+    final socket = await _open();
+    lastHandshake = socket.handshake;
+    _log('[PERF] cold connection, handshake ${socket.handshake.inMilliseconds}ms');
+    return socket;
+  }
+
+  Future<WarmSocket> _open() async {
+    final sw = Stopwatch()..start();
+    final ws = await _connect();
+    return WarmSocket._(ws, sw.elapsed);
+  }
+
+  Future<void> dispose() async {
+    _disposed = true;
+    _idleTimer?.cancel();
+    final spare = _spare;
+    _spare = null;
+    if (spare != null) {
+      try {
+        await (await spare).close();
+      } catch (_) {}
+    }
+  }
+
+  void _log(String msg) => AppLog.d('[$tag] $msg');
+}
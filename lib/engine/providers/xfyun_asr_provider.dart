@@ -5,6 +5,8 @@ import 'package:crypto/crypto.dart';
 import 'package:web_socket_channel/io.dart';
 import '../asr_provider.dart';
 import '../asr_result.dart';
+import '../pcm16.dart';
+import 'ws_audio_framer.dart';
 import 'package:speakout/config/app_log.dart';
 import 'package:speakout/services/config_service.dart';
 import '../../config/app_constants.dart';
@@ -37,6 +39,10 @@ class XfyunASRProvider implements ASRProvider {
   final List<Uint8List> _pendingBuffer = [];
   static const int _maxPendingBuffers = 200;
 
+  /// 每帧音频时长。文档建议「每 40ms 发送 1280 字节」
+  static const _defaultFrameMs = 40;
+  late WsAudioFramer _framer;
+
   // Result tracking: 讯飞用 wpgs 动态修正，维护一个有序 segment 列表
   final List<String> _segments = [];
   String? _errorMessage;
@@ -60,6 +66,10 @@ class XfyunASRProvider implements ASRProvider {
     if (_appId.isEmpty || _apiKey.isEmpty || _apiSecret.isEmpty) {
       throw Exception('Xfyun ASR: appId, apiKey, apiSecret required');
     }
+    _framer = WsAudioFramer(
+      frameMs: config['frameMs'] as int? ?? _defaultFrameMs,
+      emit: _onAudioFrame,
+    );
 
     _isReady = true;
     _log('Initialized (appId=$_appId)');
@@ -73,6 +83,7 @@ class XfyunASRProvider implements ASRProvider {
     _errorMessage = null;
     _firstFrameSent = false;
     _pendingBuffer.clear();
+    _framer.reset();
     _isConnected = false;
     _stopCompleter = Completer<ASRResult>();
 
@@ -109,11 +120,22 @@ class XfyunASRProvider implements ASRProvider {
   }
 
   @override
-  void acceptWaveform(Float32List samples) {
-    final pcm = _float32ToInt16Bytes(samples);
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
 
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptWaveform(Float32List samples) => acceptPcm16(float32ToPcm16(samples));
+
+  /// 原生采集的字节原样上传，不经 Float32 往返；按文档建议的帧长切好再发
+  @override
+  void acceptPcm16(Uint8List pcm) => _framer.add(pcm);
+
+  void _onAudioFrame(Uint8List pcm, int payloadLength, bool isLast) {
     if (_isConnected && _firstFrameSent && _channel != null) {
-      _sendAudioFrame(pcm, status: 1); // continue
+      _sendAudioFrame(pcm, status: isLast ? 2 : 1);
     } else if (_pendingBuffer.length < _maxPendingBuffers) {
       _pendingBuffer.add(pcm);
     }
@@ -127,10 +149,8 @@ class XfyunASRProvider implements ASRProvider {
   Future<ASRResult> stop() async {
 
     if (_channel != null && _isConnected) {
-      // Send last frame (status=2)
-      try {
-        _sendAudioFrame(Uint8List(0), status: 2);
-      } catch (_) {}
+      // 最后一帧 (status=2)，带上没凑满一帧的尾巴
+      _framer.flush(isLast: true);
     }
 
     // 内层等待走 kAsrFinalFrameWait，**不要**用 stopTimeout —— 后者是引擎给
@@ -197,17 +217,13 @@ class XfyunASRProvider implements ASRProvider {
     _pendingBuffer.clear();
   }
 
+  /// 音频帧直接拼 JSON 文本：base64 字符不需要转义，省掉每帧一次的
+  /// Map 构建和 jsonEncode 对整串 base64 的逐字符扫描
   void _sendAudioFrame(Uint8List pcm, {required int status}) {
-    final frame = {
-      'data': {
-        'status': status,
-        'format': 'audio/L16;rate=16000',
-        'encoding': 'raw',
-        'audio': base64Encode(pcm),
-      },
-    };
     try {
-      _channel!.sink.add(jsonEncode(frame));
+      _channel!.sink.add('{"data":{"status":$status,'
+          '"format":"audio/L16;rate=16000","encoding":"raw",'
+          '"audio":"${base64Encode(pcm)}"}}');
     } catch (_) {}
   }
 
@@ -309,15 +325,6 @@ class XfyunASRProvider implements ASRProvider {
     return ASRResult.textOnly(text);
   }
 
-  Uint8List _float32ToInt16Bytes(Float32List samples) {
-    final bytes = ByteData(samples.length * 2);
-    for (int i = 0; i < samples.length; i++) {
-      final s = samples[i].clamp(-1.0, 1.0);
-      bytes.setInt16(i * 2, (s * 32767).toInt(), Endian.little);
-    }
-    return bytes.buffer.asUint8List();
-  }
-
   /// 构建讯飞鉴权 URL (HMAC-SHA256 签名)
   String _buildAuthUrl() {
     final now = DateTime.now().toUtc();
@@ -0,0 +1,131 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+
+import 'package:sherpa_onnx/sherpa_onnx.dart' as sherpa;
+
+/// 标点模型（CT-Transformer）搬到常驻的 worker isolate 上跑。
+///
+/// 原先 [sherpa.OfflinePunctuation] 挂在 CoreEngine 上，松键后对整段文本
+/// 同步跑一遍 —— 跑在主 isolate、又在收尾的关键路径上，口述越长越慢。
+/// 放到 worker 之后录音期间可以逐段提前加（见 SpeculativePunctuator），
+/// 主 isolate 只在松键时等最后一段。
+///
+/// 请求按提交顺序一个个跑（worker 只有一个模型实例）。
+/// 模型只在 worker 里加载一份，主 isolate 不再持有。
+class PunctuationWorker {
+  PunctuationWorker._(this._commands, this._responses);
+
+  final SendPort _commands;
+  final ReceivePort _responses;
+  final Map<int, Completer<String>> _pending = {};
+  final Map<int, String> _texts = {};
+  int _nextId = 0;
+  bool _closed = false;
+
+  /// 起 worker 并加载 [modelPath] 的标点模型；加载失败抛异常
+  static Future<PunctuationWorker> spawn(String modelPath) async {
+    final responses = ReceivePort();
+    final isolate = await Isolate.spawn(_workerMain, [responses.sendPort, modelPath],
+        debugName: 'punctuation');
+    // 握手：先收 worker 的 SendPort，再收加载结果（true 或错误信息）；之后的消息都是结果
+    final events = StreamIterator(responses);
+    SendPort? commands;
+    Object? ready;
+    if (await events.moveNext()) {
+      final first = events.current;
+      if (first is SendPort) {
+        commands = first;
+        if (await events.moveNext()) ready = events.current;
+      } else {
+        ready = first;
+      }
+    }
+    if (commands == null || ready != true) {
+      await events.cancel();
+      isolate.kill(priority: Isolate.immediate);
+      throw StateError('punctuation worker failed: ${ready ?? 'exited'}');
+    }
+    return PunctuationWorker._(commands, responses).._listen(events);
+  }
+
+  void _listen(StreamIterator<dynamic> events) {
+    () async {
+      while (await events.moveNext()) {
+        final message = events.current;
+        if (message is List && message.length == 2) {
+          _pending.remove(message[0] as int)?.complete(message[1] as String);
+        }
+      }
+    }();
+  }
+
+  /// 给 [text] 加标点；worker 出错时原样返回
+  Future<String> punctuate(String text) {
+    if (_closed || text.isEmpty) return Future.value(text);
+    final id = _nextId++;
+    final completer = Completer<String>();
+    _pending[id] = completer;
+    _texts[id] = text;
+    _commands.send([id, text]);
+    return completer.future.whenComplete(() => _texts.remove(id));
+  }
+
+  /// 释放模型、结束 worker；还没返回的请求按原文返回
+  void dispose() {
+    if (_closed) return;
+    _closed = true;
+    _commands.send(null); // worker 收到后 free 模型、关掉端口，isolate 自己退出
+    for (final entry in _pending.entries) {
+      entry.value.complete(_texts[entry.key] ?? '');
+    }
+    _pending.clear();
+    _responses.close();
+  }
+}
+
+void _workerMain(List<Object?> args) {
+  final replies = args[0] as SendPort;
+  final modelPath = args[1] as String;
+  final commands = ReceivePort();
+  replies.send(commands.sendPort);
+
+  sherpa.OfflinePunctuation punctuation;
+  try {
+    // bindings 是每个 isolate 各自一份，worker 里要重新加载
+    final exeDir = File(Platform.resolvedExecutable).parent;
+    final libFile = File("${exeDir.parent.path}/Frameworks/libsherpa-onnx-c-api.dylib");
+    if (libFile.existsSync()) {
+      sherpa.initBindings(libFile.parent.path);
+    } else {
+      sherpa.initBindings();
+    }
+    punctuation = sherpa.OfflinePunctuation(
+      config: sherpa.OfflinePunctuationConfig(
+        model: sherpa.OfflinePunctuationModelConfig(ctTransformer: modelPath, numThreads: 2, debug: false),
+      ),
+    );
+  } catch (e) {
+    replies.send('$e');
+    commands.close();
+    return;
+  }
+  replies.send(true);
+
+  commands.listen((message) {
+    if (message == null) {
+      punctuation.free();
+      commands.close();
+      return;
+    }
+    final request = message as List;
+    final text = request[1] as String;
+    String out;
+    try {
+      out = punctuation.addPunct(text);
+    } catch (_) {
+      out = text;
+    }
+    replies.send([request[0], out]);
+  });
+}
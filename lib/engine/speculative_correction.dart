@@ -0,0 +1,101 @@
+import 'dart:async';
+
+import '../config/app_log.dart';
+import '../services/llm_service.dart';
+import 'decode_windows.dart';
+
+/// 润色一段文本；失败返回 null（调用方据此放弃整套投机结果）
+typedef SegmentCorrector = Future<String?> Function(String segment, String? context);
+
+/// 边说边润色：离线模型在停顿处预解码出的每一段，立刻送 LLM 润色。
+///
+/// 原流程要等松键、整段拼好后才调一次 LLM —— 口述越长，松键后等得越久。
+/// 这里每段在用户还在说话时就润色完（上一段的润色结果作为上下文），
+/// 松键后只剩最后一段要等，收尾延迟基本不随口述长度增长。
+///
+/// 各段**串行**：第 n 段要拿第 n-1 段的润色结果当上下文。预分段之间
+/// 至少隔几十秒，串行不会拖慢。任何一段失败 → [finish] 返回 null，
+/// 调用方退回整段润色；不拼半成品。
+class SpeculativeCorrector {
+  SpeculativeCorrector(this._correct);
+
+  /// 走 [LLMService.correctText]，词库提示与翻译目标在录音开始时定下
+  factory SpeculativeCorrector.llm({List<String>? vocabHints, String? translateTo}) {
+    return SpeculativeCorrector((segment, context) async {
+      // 成败按这一次调用算：共用的 lastCallSucceeded 可能已经被别的听写改掉
+      final status = LlmCallStatus();
+      final out = await LLMService().correctText(segment,
+          vocabHints: vocabHints, translateTo: translateTo, context: context, status: status);
+      // 失败时 correctText 返回原文 —— 不能当润色结果拼进去
+      return status.succeeded ? out : null;
+    });
+  }
+
+  final SegmentCorrector _correct;
+  final List<String> _raw = [];
+  final List<Future<String?>> _corrected = [];
+  bool _cancelled = false;
+
+  int get submittedCount => _raw.length;
+
+  /// 新解出一段预分段文本
+  void submit(String segment) {
+    if (_cancelled || segment.trim().isEmpty) return;
+    final previous = _corrected.isEmpty ? null : _corrected.last;
+    _raw.add(segment);
+    _corrected.add(_run(segment, previous));
+    AppLog.d('[Speculative] segment #${_raw.length} submitted (${segment.length}字)');
+  }
+
+  Future<String?> _run(String segment, Future<String?>? previous) async {
+    final context = previous == null ? null : await previous;
+    // 前一段失败了，结果反正用不上，别再多打一次 LLM
+    if (_cancelled || (previous != null && context == null)) return null;
+    try {
+      return await _correct(segment, context);
+    } catch (e) {
+      AppLog.d('[Speculative] segment correction failed: $e');
+      return null;
+    }
+  }
+
+  /// 松键后收尾。[segments] 是 provider 最终产出的全部分段（预分段 + 最后一段）。
+  ///
+  /// 返回拼好的润色全文；没有可用的投机结果（一段都没提前送、分段对不上、
+  /// 某段失败）时返回 null，由调用方走原来的整段润色。
+  Future<String?> finish(List<String> segments) async {
+    if (_cancelled || _raw.isEmpty) return null;
+    final pending = segments.where((s) => s.trim().isNotEmpty).toList();
+    if (pending.length < _raw.length) return null;
+    for (var i = 0; i < _raw.length; i++) {
+      if (pending[i] != _raw[i]) return null;
+    }
+
+    final pieces = <String>[];
+    for (final f in _corrected) {
+      final text = await f;
+      if (text == null) return null;
+      pieces.add(text.trim());
+    }
+
+    final tail = pending.sublist(_raw.length).fold('', joinDecodedText);
+    if (tail.isNotEmpty) {
+      final String? corrected;
+      try {
+        corrected = await _correct(tail, pieces.last);
+      } catch (e) {
+        AppLog.d('[Speculative] final segment correction failed: $e');
+        return null;
+      }
+      if (corrected == null) return null;
+      pieces.add(corrected.trim());
+    }
+    // 与 OfflineSherpaProvider 拼原文的方式一致：中文直接连，英文两段之间补空格
+    return pieces.fold('', joinDecodedText);
+  }
+
+  /// 录音取消 / 结束：尚未发出的段不再发
+  void cancel() {
+    _cancelled = true;
+  }
+}
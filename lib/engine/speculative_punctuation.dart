@@ -0,0 +1,126 @@
+import 'dart:async';
+
+import '../config/app_constants.dart';
+import '../config/app_log.dart';
+import 'decode_windows.dart';
+
+/// 给一段文本加标点（PunctuationWorker.punctuate）
+typedef Punctuate = Future<String> Function(String text);
+
+/// 边说边加标点：离线模型的每个预分段、流式模型每次长停顿之前的新字幕，
+/// 一出来就送去 worker 加标点。
+///
+/// 原流程松键后对整段文本跑一遍标点模型，口述越长越慢；这里说话期间
+/// 各段就加好了，松键后只剩最后一段。每段前面带上前文最后
+/// [contextChars] 个字一起送进去（标点要看上下文，段首不能当句首），
+/// 结果里再把前文去掉。和 SpeculativeCorrector 一样：提前加好的段
+/// 和最终文本对不上（被润色 / 词库改过）时 [finish] 返回 null，调用方走整段。
+class SpeculativePunctuator {
+  SpeculativePunctuator(this._punctuate, {this.contextChars = AppConstants.kPunctuationContextChars});
+
+  final Punctuate _punctuate;
+  final int contextChars;
+  final List<Future<String>> _punctuated = [];
+  /// 每段和前文之间的分隔：离线预分段是 [joinDecodedText] 补的词间空格，流式为空
+  final List<String> _separators = [];
+  /// 已提交各段拼起来的原文。拼法必须和最终文本一致，否则英文一多段就对不上前缀
+  String _prefix = '';
+  bool _cancelled = false;
+
+  int get submittedCount => _punctuated.length;
+
+  /// 新出来一段原文（离线预分段）。最终文本由 [joinDecodedText] 拼成，这里照同样的拼法
+  void submit(String segment) {
+    if (_cancelled || segment.trim().isEmpty) return;
+    final joined = joinDecodedText(_prefix, segment);
+    _add(segment, joined.substring(_prefix.length, joined.length - segment.length));
+  }
+
+  /// 流式：[fullText] 是当前整段字幕，上次提交之后新增的部分作为一段提交。
+  /// 前面已提交的部分变了（字幕改写）就不提交，松键时整段兜底
+  void submitUpTo(String fullText) {
+    if (_cancelled || !fullText.startsWith(_prefix)) return;
+    final segment = fullText.substring(_prefix.length);
+    if (segment.trim().isEmpty) return;
+    _add(segment, '');
+  }
+
+  void _add(String segment, String separator) {
+    final context = _contextBefore(_prefix + separator);
+    _prefix = '$_prefix$separator$segment';
+    _separators.add(separator);
+    _punctuated.add(_run(segment, context));
+    AppLog.d('[SpeculativePunct] segment #${_punctuated.length} submitted (${segment.length}字)');
+  }
+
+  String _contextBefore(String text) =>
+      text.length <= contextChars ? text : text.substring(text.length - contextChars);
+
+  Future<String> _run(String segment, String context) async {
+    try {
+      final leading = segment.substring(0, segment.length - segment.trimLeft().length);
+      final body = segment.trimLeft();
+      if (context.isNotEmpty) {
+        final stripped = stripContext(await _punctuate(context + segment), context);
+        if (stripped != null && stripped.trim().isNotEmpty) return leading + stripped;
+      }
+      final out = await _punctuate(body);
+      return leading + (out.trim().isEmpty ? body : out);
+    } catch (e) {
+      AppLog.d('[SpeculativePunct] segment punctuation failed: $e');
+      return segment;
+    }
+  }
+
+  /// 松键后收尾：[fullText] 是最终要加标点的原文。
+  ///
+  /// 返回拼好的带标点全文；一段都没提前送、或提前送的段不是 [fullText] 的开头时返回 null
+  Future<String?> finish(String fullText) async {
+    if (_cancelled || _punctuated.isEmpty) return null;
+    if (!fullText.startsWith(_prefix)) return null;
+
+    final out = StringBuffer();
+    for (var i = 0; i < _punctuated.length; i++) {
+      out
+        ..write(_separators[i])
+        ..write(await _punctuated[i]);
+    }
+    // 尾巴直接从最终文本里截，接缝处的空格本来就在它开头
+    final tail = fullText.substring(_prefix.length);
+    if (tail.trim().isNotEmpty) {
+      out.write(await _run(tail, _contextBefore(_prefix)));
+    }
+    return out.toString();
+  }
+
+  /// 录音取消 / 结束：尚未发出的段不再发
+  void cancel() {
+    _cancelled = true;
+  }
+
+  static const String _marks = '，。？！、；：,.?!;:';
+
+  /// 从带前文的标点结果里去掉前文：逐字对上前文（跳过模型插进去的标点、空格，
+  /// 英文不分大小写），前文之后紧跟的标点属于上一段的结尾，一并去掉。对不上返回 null
+  static String? stripContext(String output, String context) {
+    var i = 0, j = 0;
+    while (j < context.length) {
+      if (i >= output.length) return null;
+      final o = output[i], c = context[j];
+      if (o.toLowerCase() == c.toLowerCase()) {
+        i++;
+        j++;
+      } else if (_marks.contains(o) || o == ' ') {
+        i++;
+      } else if (c == ' ') {
+        j++;
+      } else {
+        return null;
+      }
+    }
+    while (i < output.length && (_marks.contains(output[i]) || output[i] == ' ')) {
+      i++;
+    }
+    return output.substring(i);
+  }
+}
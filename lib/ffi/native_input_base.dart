@@ -58,6 +58,92 @@ typedef GetAvailableAudioSamplesDart = int Function();
 typedef ReadAudioBufferC = Int32 Function(Pointer<Int16> outSamples, Int32 maxSamples);
 typedef ReadAudioBufferDart = int Function(Pointer<Int16> outSamples, int maxSamples);
 
+// ring 的额外读者（可选；旧版本的库里没有）
+typedef AudioReaderOpenC = Int32 Function(Int32 fromOldest);
+typedef AudioReaderOpenDart = int Function(int fromOldest);
+typedef AudioReaderCloseC = Void Function(Int32 reader);
+typedef AudioReaderCloseDart = void Function(int reader);
+typedef AudioReaderAvailableC = Int32 Function(Int32 reader);
+typedef AudioReaderAvailableDart = int Function(int reader);
+typedef AudioReaderReadC = Int32 Function(Int32 reader, Pointer<Int16> outSamples, Int32 maxSamples);
+typedef AudioReaderReadDart = int Function(int reader, Pointer<Int16> outSamples, int maxSamples);
+typedef AudioReaderOverrunC = Int64 Function(Int32 reader);
+typedef AudioReaderOverrunDart = int Function(int reader);
+
+// Audio encoding（录音时压缩；目前只有 Linux 导出）
+typedef AudioEncoderCreateC = Pointer<Void> Function(Int32 format, Int32 sampleRate);
+typedef AudioEncoderCreateDart = Pointer<Void> Function(int format, int sampleRate);
+typedef AudioEncoderWriteC = Int32 Function(Pointer<Void> encoder, Pointer<Int16> samples, Int32 count);
+typedef AudioEncoderWriteDart = int Function(Pointer<Void> encoder, Pointer<Int16> samples, int count);
+typedef AudioEncoderFinishC = Int32 Function(Pointer<Void> encoder);
+typedef AudioEncoderFinishDart = int Function(Pointer<Void> encoder);
+typedef AudioEncoderReadC = Int32 Function(Pointer<Void> encoder, Pointer<Uint8> out, Int32 maxBytes);
+typedef AudioEncoderReadDart = int Function(Pointer<Void> encoder, Pointer<Uint8> out, int maxBytes);
+typedef AudioEncoderDestroyC = Void Function(Pointer<Void> encoder);
+typedef AudioEncoderDestroyDart = void Function(Pointer<Void> encoder);
+
+// 停顿压缩（可选；目前只有 Linux 导出）
+typedef SilenceCompactorCreateC = Pointer<Void> Function(Int32 minSilenceMs, Int32 keepMs);
+typedef SilenceCompactorCreateDart = Pointer<Void> Function(int minSilenceMs, int keepMs);
+typedef SilenceCompactorProcessC = Int32 Function(
+    Pointer<Void> compactor, Pointer<Int16> samples, Int32 count, Pointer<Int16> out);
+typedef SilenceCompactorProcessDart = int Function(
+    Pointer<Void> compactor, Pointer<Int16> samples, int count, Pointer<Int16> out);
+typedef SilenceCompactorMaxOutputC = Int32 Function(Pointer<Void> compactor, Int32 count);
+typedef SilenceCompactorMaxOutputDart = int Function(Pointer<Void> compactor, int count);
+typedef SilenceCompactorFlushC = Int32 Function(Pointer<Void> compactor, Pointer<Int16> out);
+typedef SilenceCompactorFlushDart = int Function(Pointer<Void> compactor, Pointer<Int16> out);
+typedef SilenceCompactorStatC = Int64 Function(Pointer<Void> compactor, Int32 which);
+typedef SilenceCompactorStatDart = int Function(Pointer<Void> compactor, int which);
+typedef SilenceCompactorMapPointsC = Int32 Function(Pointer<Void> compactor, Pointer<Int64> out, Int32 maxPoints);
+typedef SilenceCompactorMapPointsDart = int Function(Pointer<Void> compactor, Pointer<Int64> out, int maxPoints);
+typedef SilenceCompactorDestroyC = Void Function(Pointer<Void> compactor);
+typedef SilenceCompactorDestroyDart = void Function(Pointer<Void> compactor);
+
+// 停止并收尽最后一块（可选；目前只有 Linux 导出）
+typedef StopAudioRecordingAndDrainC = Int64 Function(Int32 timeoutMs);
+typedef StopAudioRecordingAndDrainDart = int Function(int timeoutMs);
+
+// 常驻采集 + pre-roll（可选；目前只有 Linux 导出）
+typedef AudioWarmStartC = Int32 Function(Int32 prerollMs, Int32 idleReleaseMs);
+typedef AudioWarmStartDart = int Function(int prerollMs, int idleReleaseMs);
+typedef AudioWarmStopC = Void Function();
+typedef AudioWarmStopDart = void Function();
+typedef IsAudioWarmC = Int32 Function();
+typedef IsAudioWarmDart = int Function();
+
+// 延迟追踪的 native 时刻（可选；目前只有 Linux 导出）
+typedef NativeTraceStampUsC = Int64 Function(Int32 which);
+typedef NativeTraceStampUsDart = int Function(int which);
+
+// 流式识别跑在 native 线程上（可选；目前只有 Linux 导出）
+// 文字由 native malloc，回调里读完用 native_free 还回去
+typedef DecoderTextCallbackC = Void Function(Pointer<Utf8> text, Int32 isFinal);
+typedef StreamDecoderStartC = Pointer<Void> Function(Pointer<Void> recognizer, Pointer<Void> stream,
+    Pointer<Utf8> sherpaLib, Pointer<NativeFunction<DecoderTextCallbackC>> callback, Int32 paddingMs);
+typedef StreamDecoderStartDart = Pointer<Void> Function(Pointer<Void> recognizer, Pointer<Void> stream,
+    Pointer<Utf8> sherpaLib, Pointer<NativeFunction<DecoderTextCallbackC>> callback, int paddingMs);
+typedef StreamDecoderFinishC = Void Function(Pointer<Void> decoder);
+typedef StreamDecoderFinishDart = void Function(Pointer<Void> decoder);
+typedef StreamDecoderAbortC = Void Function(Pointer<Void> decoder);
+typedef StreamDecoderAbortDart = void Function(Pointer<Void> decoder);
+typedef StreamDecoderStatC = Int64 Function(Pointer<Void> decoder, Int32 which);
+typedef StreamDecoderStatDart = int Function(Pointer<Void> decoder, int which);
+typedef StreamDecoderDestroyC = Int32 Function(Pointer<Void> decoder, Int32 abort);
+typedef StreamDecoderDestroyDart = int Function(Pointer<Void> decoder, int abort);
+
+// 采集降噪（可选；目前只有 Linux 导出）
+typedef AudioNoiseSuppressionSetC = Int32 Function(Int32 enabled, Int32 budgetUs);
+typedef AudioNoiseSuppressionSetDart = int Function(int enabled, int budgetUs);
+typedef AudioNoiseSuppressionStatC = Int64 Function(Int32 which);
+typedef AudioNoiseSuppressionStatDart = int Function(int which);
+
+// 采集自动增益（可选；目前只有 Linux 导出）
+typedef AudioAgcSetC = Int32 Function(Int32 enabled, Int32 targetDbfs, Int32 maxGainDb);
+typedef AudioAgcSetDart = int Function(int enabled, int targetDbfs, int maxGainDb);
+typedef AudioAgcTraceC = Int32 Function(Pointer<Float> out, Int32 maxPoints);
+typedef AudioAgcTraceDart = int Function(Pointer<Float> out, int maxPoints);
+
 // Audio Device Management FFI Types
 typedef GetAudioInputDevicesC = Pointer<Utf8> Function();
 typedef GetAudioInputDevicesDart = Pointer<Utf8> Function();
@@ -153,6 +239,69 @@ typedef ActivateAppDart = int Function(Pointer<Utf8> bundleId);
 typedef GetFrontmostAppInfoC = Pointer<Utf8> Function();
 typedef GetFrontmostAppInfoDart = Pointer<Utf8> Function();
 
+/// `audio_encoder_create` 的格式参数，和 native 侧 SPEAKOUT_AUDIO_ENCODING_* 对齐
+const int kNativeAudioEncodingFlac = 1;
+
+/// [NativeInputBase.silenceCompactorStat] 的参数，和 native 侧 SC_STAT_* 对齐
+/// 喂进去的样本数
+const int kSilenceCompactStatInput = 0;
+/// 压缩后吐出来的样本数
+const int kSilenceCompactStatOutput = 1;
+/// 压了几段停顿
+const int kSilenceCompactStatCuts = 2;
+
+/// [NativeInputBase.nativeTraceStampUs] 的参数，和 native 侧 TRACE_* 对齐
+const int kNativeTraceNow = 0;
+/// 最近一次按键事件（内核时间戳）
+const int kNativeTraceKeyEvent = 1;
+/// 本次 start_audio_recording 被调用
+const int kNativeTraceCaptureStart = 2;
+/// 采集设备可读（常驻模式下等于开始）
+const int kNativeTraceDeviceOpen = 3;
+/// 本次第一块实时音频进 ring（不含 pre-roll）
+const int kNativeTraceFirstChunk = 4;
+
+/// [NativeInputBase.streamDecoderStat] 的参数，和 native 侧 DECODER_STAT_* 对齐
+/// 累计花在 decode 上的微秒
+const int kStreamDecoderStatDecodeUs = 0;
+/// 从 ring 取走的样本数（不含收尾补的静音）
+const int kStreamDecoderStatSamples = 1;
+/// 回调出去的中间结果条数（只在文字变了时回调）
+const int kStreamDecoderStatPartials = 2;
+/// 第一条中间结果回调的 native 单调钟时刻，可与 [kNativeTraceNow] 对钟
+const int kStreamDecoderStatFirstPartial = 3;
+/// 一块样本从取出 ring 到解完的最长微秒
+const int kStreamDecoderStatMaxLagUs = 4;
+/// 解码线程读得太慢、被采集追上丢掉的样本数（它有自己的 ring 读者，丢了不影响别人）
+const int kStreamDecoderStatOverrun = 5;
+/// 解码线程已经退出（1）：这之后 [NativeInputBase.streamDecoderDestroy] 的 join 立即返回
+const int kStreamDecoderStatExited = 6;
+
+/// [NativeInputBase.noiseSuppressionStat] 的参数，和 native 侧 NS_STAT_* 对齐（都是本次录音的）
+/// 降噪花的采集线程 CPU 微秒
+const int kNoiseSuppressionStatCpuUs = 0;
+/// 降噪处理过、进了 ring 的样本数
+const int kNoiseSuppressionStatSamples = 1;
+/// 超过 CPU 预算的块数
+const int kNoiseSuppressionStatOverBudget = 2;
+/// 1 = 连续超预算，后半段转了旁路
+const int kNoiseSuppressionStatBypassed = 3;
+/// 最慢的一块（微秒）
+const int kNoiseSuppressionStatMaxChunkUs = 4;
+
+/// [NativeInputBase.autoGainTrace] 的一帧（10ms）
+class AutoGainFrame {
+  const AutoGainFrame(this.levelDbfs, this.gainDb, this.limiterDb, this.gateOpen);
+
+  /// 输入（降噪之后、增益之前）的帧 RMS
+  final double levelDbfs;
+  /// 电平跟踪给的增益，含噪声门收回的部分，不含限幅
+  final double gainDb;
+  /// 限幅器额外压掉的，<= 0
+  final double limiterDb;
+  final bool gateOpen;
+}
+
 abstract class NativeInputBase {
   bool startListener(Pointer<NativeFunction<KeyCallbackC>> callback);
   void stopListener();
@@ -171,6 +320,13 @@ abstract class NativeInputBase {
   bool startAudioRecording();
   bool stopAudioRecording();
   bool isAudioRecording();
+
+  /// 平台能否 [stopAudioRecordingAndDrain]。不能的话调用方照旧松键后等一会儿再 [stopAudioRecording]
+  bool get canDrainAudio;
+
+  /// 停源并等在途的最后一块进 ring（最多 [timeoutMs]），返回本次录音写进 ring 的
+  /// 样本总数 —— 读到这里就是全部音频。平台不支持时返回 -1。
+  int stopAudioRecordingAndDrain(int timeoutMs);
   bool checkMicrophonePermission();
 
   /// 当前麦克风授权状态，取值对齐 `AVAuthorizationStatus`：
@@ -187,6 +343,83 @@ abstract class NativeInputBase {
   int readAudioBuffer(Pointer<Int16> outSamples, int maxSamples);
   bool saveRecordingWav(String path);
 
+  // ring 的额外读者：[readAudioBuffer] 是默认读者，再要一路样本（VAD、落盘、第二路识别）
+  // 就开一个自己的，游标各走各的，互不抢样本。读得太慢被追上只丢自己的，记在 overrun 里。
+  /// [fromOldest] 从 ring 里还留着的最早样本开始，否则从现在开始。
+  /// 返回读者编号；槽满、平台没导出时返回 -1
+  int audioReaderOpen({bool fromOldest = false});
+  void audioReaderClose(int reader);
+  int audioReaderAvailable(int reader);
+  int audioReaderRead(int reader, Pointer<Int16> outSamples, int maxSamples);
+  /// 这个读者本次录音被追上丢掉的样本数；编号无效、平台没导出时返回 -1
+  int audioReaderOverrun(int reader);
+
+  // Audio Encoding（录音时压缩，格式常量见 [kNativeAudioEncodingFlac]）
+  /// 平台没导出编码器、或格式不支持时返回 `nullptr` —— 调用方退回送 PCM。
+  Pointer<Void> audioEncoderCreate(int format, int sampleRate);
+  /// 喂 int16 样本，返回当前可读的已编码字节数
+  int audioEncoderWrite(Pointer<Void> encoder, Pointer<Int16> samples, int count);
+  /// 把不满一块的尾巴编完，返回当前可读的已编码字节数
+  int audioEncoderFinish(Pointer<Void> encoder);
+  int audioEncoderRead(Pointer<Void> encoder, Pointer<Uint8> out, int maxBytes);
+  void audioEncoderDestroy(Pointer<Void> encoder);
+
+  // 停顿压缩（见 NativeSilenceCompactor）：长停顿压成固定间隔，只给整段解码 / 上传的 provider。
+  /// 平台没导出时返回 `nullptr` —— 调用方照旧送原始音频。
+  Pointer<Void> silenceCompactorCreate(int minSilenceMs, int keepMs);
+  /// [out] 至少 [silenceCompactorMaxOutput] 个样本，返回写出的个数
+  int silenceCompactorProcess(Pointer<Void> compactor, Pointer<Int16> samples, int count, Pointer<Int16> out);
+  int silenceCompactorMaxOutput(Pointer<Void> compactor, int count);
+  int silenceCompactorFlush(Pointer<Void> compactor, Pointer<Int16> out);
+  /// 统计项见 [kSilenceCompactStatInput] 等
+  int silenceCompactorStat(Pointer<Void> compactor, int which);
+  /// 对照点按 [压缩后位置, 原始位置]（样本）成对写进 [out]，返回对数
+  int silenceCompactorMapPoints(Pointer<Void> compactor, Pointer<Int64> out, int maxPoints);
+  void silenceCompactorDestroy(Pointer<Void> compactor);
+
+  // 常驻采集：热键就绪期间麦克风一直开着，按键时把之前 [prerollMs] 的声音
+  // 直接拼进录音开头。平台没导出时 start 返回 false，录音照旧冷启动。
+  /// 挂上（已挂着时只更新参数）。不录音累计 [idleReleaseMs] 后 native 自己释放，0 = 不自动释放
+  bool audioWarmStart(int prerollMs, int idleReleaseMs);
+  /// 立即释放设备；正在录的那次照常录完再关
+  void audioWarmStop();
+  bool isAudioWarm();
+
+  /// native 线程上打的时刻（单调钟微秒，与 Dart 的 Stopwatch 不是同一个零点，
+  /// 用 [kNativeTraceNow] 对钟）。本次还没发生、或平台没导出时返回 -1。
+  int nativeTraceStampUs(int which);
+
+  // 流式识别解码线程：直接从 ring 取样本喂 sherpa 在线识别器，只把字幕回调给 Dart。
+  // 解码线程有自己的 ring 读者，和 [readAudioBuffer] 互不抢样本。
+  /// 平台能否 [streamDecoderStart]
+  bool get canStreamDecode;
+  /// [recognizer] / [stream] 借用 sherpa_onnx 的原生指针，[streamDecoderDestroy] 返回前
+  /// 调用方不能碰这个流。sherpa 库没加载、已有一个在解码、平台没导出时返回 `nullptr`。
+  Pointer<Void> streamDecoderStart(Pointer<Void> recognizer, Pointer<Void> stream, String sherpaLib,
+      Pointer<NativeFunction<DecoderTextCallbackC>> callback, int paddingMs);
+  /// 松键（drain 之后）：解完剩下的就回调 isFinal=1，立即返回
+  void streamDecoderFinish(Pointer<Void> decoder);
+  /// 只让线程停下、不等它：解完手上这次 decode 就退出，不回调 final。
+  /// 等 [kStreamDecoderStatExited] 变成 1 再 [streamDecoderDestroy]，UI isolate 上不用干等 join
+  void streamDecoderAbort(Pointer<Void> decoder);
+  /// 统计项见 [kStreamDecoderStatDecodeUs] 等
+  int streamDecoderStat(Pointer<Void> decoder, int which);
+  /// 等线程退出并释放句柄；[abort] 时不收尾、不回调 final。返回是否正常收完尾
+  bool streamDecoderDestroy(Pointer<Void> decoder, {bool abort = false});
+
+  // 采集降噪：采集线程上、样本进 ring 之前处理，所有下游拿到的都是降过噪的。
+  /// 下一块生效；[budgetUs] 是每 20ms 一块的 CPU 预算，连续超了就转旁路。
+  /// 平台没导出时返回 false
+  bool setNoiseSuppression(bool enabled, int budgetUs);
+  /// 本次录音的统计项，见 [kNoiseSuppressionStatCpuUs] 等；平台没导出时返回 -1
+  int noiseSuppressionStat(int which);
+
+  // 采集自动增益：接在降噪后面，说话段拉到目标电平，噪声门 + 前瞻限幅，输出再晚 10ms。
+  /// 下一块生效；[targetDbfs]、[maxGainDb] 在下次打开时生效。平台没导出时返回 false
+  bool setAutoGain(bool enabled, int targetDbfs, int maxGainDb);
+  /// 本次录音最近 [maxFrames] 帧的增益轨迹，旧的在前；平台没导出时为空
+  List<AutoGainFrame> autoGainTrace(int maxFrames);
+
   // Audio Device Management
   String getAudioInputDevices();
   String getCurrentInputDevice();
@@ -12,7 +12,7 @@ import 'package:speakout/config/app_log.dart';
 /// 手动递增靠自觉，而我漏过一次（改了 inject_clipboard_begin 的签名却没升，
 /// 正好是这个握手要防的情形）。现在版本是签名的函数，只改一半不可能。
 /// 数值由 test/engine/native_batch5_invariants_test.dart 的指纹锁给出。
-const int kExpectedNativeAbiVersion = 0x3e3abe;
+const int kExpectedNativeAbiVersion = 0x160ccb;
 
 class NativeInputFFI implements NativeInputBase {
   late final DynamicLibrary _dylib;
@@ -45,6 +45,44 @@ class NativeInputFFI implements NativeInputBase {
   late GetAvailableAudioSamplesDart _getAvailableAudioSamples;
   late ReadAudioBufferDart _readAudioBuffer;
   SaveRecordingWavDart? _saveRecordingWav; // 可选：调试落盘，Win/Linux 未导出
+  // 可选：录音时压缩，目前只有 Linux 导出。五个要么全有要么全无
+  AudioEncoderCreateDart? _audioEncoderCreate;
+  AudioEncoderWriteDart? _audioEncoderWrite;
+  AudioEncoderFinishDart? _audioEncoderFinish;
+  AudioEncoderReadDart? _audioEncoderRead;
+  AudioEncoderDestroyDart? _audioEncoderDestroy;
+  StopAudioRecordingAndDrainDart? _stopAudioRecordingAndDrain; // 可选：目前只有 Linux 导出
+  // 可选：常驻采集，目前只有 Linux 导出。三个要么全有要么全无
+  AudioWarmStartDart? _audioWarmStart;
+  AudioWarmStopDart? _audioWarmStop;
+  IsAudioWarmDart? _isAudioWarm;
+  NativeTraceStampUsDart? _nativeTraceStampUs; // 可选：目前只有 Linux 导出
+  // 可选：停顿压缩，目前只有 Linux 导出。七个要么全有要么全无
+  SilenceCompactorCreateDart? _silenceCompactorCreate;
+  SilenceCompactorProcessDart? _silenceCompactorProcess;
+  SilenceCompactorMaxOutputDart? _silenceCompactorMaxOutput;
+  SilenceCompactorFlushDart? _silenceCompactorFlush;
+  SilenceCompactorStatDart? _silenceCompactorStat;
+  SilenceCompactorMapPointsDart? _silenceCompactorMapPoints;
+  SilenceCompactorDestroyDart? _silenceCompactorDestroy;
+  // 可选：ring 的额外读者，旧版本的库里没有。五个要么全有要么全无
+  AudioReaderOpenDart? _audioReaderOpen;
+  AudioReaderCloseDart? _audioReaderClose;
+  AudioReaderAvailableDart? _audioReaderAvailable;
+  AudioReaderReadDart? _audioReaderRead;
+  AudioReaderOverrunDart? _audioReaderOverrun;
+  // 可选：native 流式解码，目前只有 Linux 导出。五个要么全有要么全无
+  StreamDecoderStartDart? _streamDecoderStart;
+  StreamDecoderFinishDart? _streamDecoderFinish;
+  StreamDecoderAbortDart? _streamDecoderAbort;
+  StreamDecoderStatDart? _streamDecoderStat;
+  StreamDecoderDestroyDart? _streamDecoderDestroy;
+  // 可选：采集降噪，目前只有 Linux 导出。两个要么全有要么全无
+  AudioNoiseSuppressionSetDart? _audioNoiseSuppressionSet;
+  AudioNoiseSuppressionStatDart? _audioNoiseSuppressionStat;
+  // 可选：采集自动增益，目前只有 Linux 导出。两个要么全有要么全无
+  AudioAgcSetDart? _audioAgcSet;
+  AudioAgcTraceDart? _audioAgcTrace;
 
   bool _deviceBound = false;
   late GetAudioInputDevicesDart _getAudioInputDevices;
@@ -91,9 +129,9 @@ class NativeInputFFI implements NativeInputBase {
           .lookup<NativeFunction<CheckPermissionC>>('check_permission_silent')
           .asFunction();
 
-      // **日志符号是可选的。** Windows/Linux 的实现里压根没导出它们
-      // （两边 grep 都是 0），而这段在急切绑定的 try 里、失败会 rethrow ——
-      // 等于整个 FFI 初始化在那两个平台上直接抛异常，应用起不来。
+      // **日志符号是可选的。** Windows 的实现里压根没导出它们
+      // （Linux 后来补上了），而这段在急切绑定的 try 里、失败会 rethrow ——
+      // 等于整个 FFI 初始化在没导出的平台上直接抛异常，应用起不来。
       // 日志开关本来就是「有则用、无则算了」的能力，不该拖垮核心绑定。
       try {
         _setDebugLogging = _dylib
@@ -252,6 +290,136 @@ class NativeInputFFI implements NativeInputBase {
       } catch (_) {
         _saveRecordingWav = null;
       }
+      // 编码器同理：缺了只是退回送 PCM，不能拖垮录音
+      try {
+        _audioEncoderCreate = _dylib
+            .lookup<NativeFunction<AudioEncoderCreateC>>('audio_encoder_create')
+            .asFunction();
+        _audioEncoderWrite = _dylib
+            .lookup<NativeFunction<AudioEncoderWriteC>>('audio_encoder_write')
+            .asFunction();
+        _audioEncoderFinish = _dylib
+            .lookup<NativeFunction<AudioEncoderFinishC>>('audio_encoder_finish')
+            .asFunction();
+        _audioEncoderRead = _dylib
+            .lookup<NativeFunction<AudioEncoderReadC>>('audio_encoder_read')
+            .asFunction();
+        _audioEncoderDestroy = _dylib
+            .lookup<NativeFunction<AudioEncoderDestroyC>>('audio_encoder_destroy')
+            .asFunction();
+      } catch (_) {
+        _audioEncoderCreate = null;
+      }
+      try {
+        _silenceCompactorCreate = _dylib
+            .lookup<NativeFunction<SilenceCompactorCreateC>>('silence_compactor_create')
+            .asFunction();
+        _silenceCompactorProcess = _dylib
+            .lookup<NativeFunction<SilenceCompactorProcessC>>('silence_compactor_process')
+            .asFunction();
+        _silenceCompactorMaxOutput = _dylib
+            .lookup<NativeFunction<SilenceCompactorMaxOutputC>>('silence_compactor_max_output')
+            .asFunction();
+        _silenceCompactorFlush = _dylib
+            .lookup<NativeFunction<SilenceCompactorFlushC>>('silence_compactor_flush')
+            .asFunction();
+        _silenceCompactorStat = _dylib
+            .lookup<NativeFunction<SilenceCompactorStatC>>('silence_compactor_stat')
+            .asFunction();
+        _silenceCompactorMapPoints = _dylib
+            .lookup<NativeFunction<SilenceCompactorMapPointsC>>('silence_compactor_map_points')
+            .asFunction();
+        _silenceCompactorDestroy = _dylib
+            .lookup<NativeFunction<SilenceCompactorDestroyC>>('silence_compactor_destroy')
+            .asFunction();
+      } catch (_) {
+        _silenceCompactorCreate = null;
+      }
+      try {
+        _stopAudioRecordingAndDrain = _dylib
+            .lookup<NativeFunction<StopAudioRecordingAndDrainC>>('stop_audio_recording_and_drain')
+            .asFunction();
+      } catch (_) {
+        _stopAudioRecordingAndDrain = null;
+      }
+      try {
+        _audioWarmStart = _dylib
+            .lookup<NativeFunction<AudioWarmStartC>>('audio_warm_start')
+            .asFunction();
+        _audioWarmStop = _dylib
+            .lookup<NativeFunction<AudioWarmStopC>>('audio_warm_stop')
+            .asFunction();
+        _isAudioWarm = _dylib
+            .lookup<NativeFunction<IsAudioWarmC>>('is_audio_warm')
+            .asFunction();
+      } catch (_) {
+        _audioWarmStart = null;
+      }
+      try {
+        _nativeTraceStampUs = _dylib
+            .lookup<NativeFunction<NativeTraceStampUsC>>('native_trace_stamp_us')
+            .asFunction();
+      } catch (_) {
+        _nativeTraceStampUs = null;
+      }
+      try {
+        _streamDecoderStart = _dylib
+            .lookup<NativeFunction<StreamDecoderStartC>>('stream_decoder_start')
+            .asFunction();
+        _streamDecoderFinish = _dylib
+            .lookup<NativeFunction<StreamDecoderFinishC>>('stream_decoder_finish')
+            .asFunction();
+        _streamDecoderAbort = _dylib
+            .lookup<NativeFunction<StreamDecoderAbortC>>('stream_decoder_abort')
+            .asFunction();
+        _streamDecoderStat = _dylib
+            .lookup<NativeFunction<StreamDecoderStatC>>('stream_decoder_stat')
+            .asFunction();
+        _streamDecoderDestroy = _dylib
+            .lookup<NativeFunction<StreamDecoderDestroyC>>('stream_decoder_destroy')
+            .asFunction();
+      } catch (_) {
+        _streamDecoderStart = null;
+      }
+      try {
+        _audioReaderOpen = _dylib
+            .lookup<NativeFunction<AudioReaderOpenC>>('audio_reader_open')
+            .asFunction();
+        _audioReaderClose = _dylib
+            .lookup<NativeFunction<AudioReaderCloseC>>('audio_reader_close')
+            .asFunction();
+        _audioReaderAvailable = _dylib
+            .lookup<NativeFunction<AudioReaderAvailableC>>('audio_reader_available')
+            .asFunction();
+        _audioReaderRead = _dylib
+            .lookup<NativeFunction<AudioReaderReadC>>('audio_reader_read')
+            .asFunction();
+        _audioReaderOverrun = _dylib
+            .lookup<NativeFunction<AudioReaderOverrunC>>('audio_reader_overrun')
+            .asFunction();
+      } catch (_) {
+        _audioReaderOpen = null;
+      }
+      try {
+        _audioNoiseSuppressionSet = _dylib
+            .lookup<NativeFunction<AudioNoiseSuppressionSetC>>('audio_noise_suppression_set')
+            .asFunction();
+        _audioNoiseSuppressionStat = _dylib
+            .lookup<NativeFunction<AudioNoiseSuppressionStatC>>('audio_noise_suppression_stat')
+            .asFunction();
+      } catch (_) {
+        _audioNoiseSuppressionSet = null;
+      }
+      try {
+        _audioAgcSet = _dylib
+            .lookup<NativeFunction<AudioAgcSetC>>('audio_agc_set')
+            .asFunction();
+        _audioAgcTrace = _dylib
+            .lookup<NativeFunction<AudioAgcTraceC>>('audio_agc_trace')
+            .asFunction();
+      } catch (_) {
+        _audioAgcSet = null;
+      }
       _audioBound = true;
       _log("Audio FFI bindings SUCCESS");
 
@@ -296,6 +464,20 @@ class NativeInputFFI implements NativeInputBase {
     return _stopAudioRecording() == 1;
   }
 
+  @override
+  bool get canDrainAudio {
+    _bindAudioFunctions();
+    return _audioBound && _stopAudioRecordingAndDrain != null;
+  }
+
+  @override
+  int stopAudioRecordingAndDrain(int timeoutMs) {
+    _bindAudioFunctions();
+    final fn = _stopAudioRecordingAndDrain;
+    if (!_audioBound || fn == null) return -1;
+    return fn(timeoutMs);
+  }
+
   @override
   bool isAudioRecording() {
     _bindAudioFunctions();
@@ -372,6 +554,203 @@ class NativeInputFFI implements NativeInputBase {
     }
   }
 
+  // ============ AUDIO ENCODING ============
+
+  @override
+  Pointer<Void> audioEncoderCreate(int format, int sampleRate) {
+    _bindAudioFunctions();
+    final fn = _audioEncoderCreate;
+    if (!_audioBound || fn == null) return nullptr;
+    return fn(format, sampleRate);
+  }
+
+  // 下面几个只会拿着 create 成功返回的句柄调用，create 成功即意味着已绑定
+  @override
+  int audioEncoderWrite(Pointer<Void> encoder, Pointer<Int16> samples, int count) =>
+      _audioEncoderWrite!(encoder, samples, count);
+
+  @override
+  int audioEncoderFinish(Pointer<Void> encoder) => _audioEncoderFinish!(encoder);
+
+  @override
+  int audioEncoderRead(Pointer<Void> encoder, Pointer<Uint8> out, int maxBytes) =>
+      _audioEncoderRead!(encoder, out, maxBytes);
+
+  @override
+  void audioEncoderDestroy(Pointer<Void> encoder) => _audioEncoderDestroy!(encoder);
+
+  // ============ SILENCE COMPACTION ============
+
+  @override
+  Pointer<Void> silenceCompactorCreate(int minSilenceMs, int keepMs) {
+    _bindAudioFunctions();
+    final fn = _silenceCompactorCreate;
+    if (!_audioBound || fn == null) return nullptr;
+    return fn(minSilenceMs, keepMs);
+  }
+
+  // 同编码器：只会拿着 create 成功返回的句柄调用
+  @override
+  int silenceCompactorProcess(Pointer<Void> compactor, Pointer<Int16> samples, int count, Pointer<Int16> out) =>
+      _silenceCompactorProcess!(compactor, samples, count, out);
+
+  @override
+  int silenceCompactorMaxOutput(Pointer<Void> compactor, int count) =>
+      _silenceCompactorMaxOutput!(compactor, count);
+
+  @override
+  int silenceCompactorFlush(Pointer<Void> compactor, Pointer<Int16> out) =>
+      _silenceCompactorFlush!(compactor, out);
+
+  @override
+  int silenceCompactorStat(Pointer<Void> compactor, int which) => _silenceCompactorStat!(compactor, which);
+
+  @override
+  int silenceCompactorMapPoints(Pointer<Void> compactor, Pointer<Int64> out, int maxPoints) =>
+      _silenceCompactorMapPoints!(compactor, out, maxPoints);
+
+  @override
+  void silenceCompactorDestroy(Pointer<Void> compactor) => _silenceCompactorDestroy!(compactor);
+
+  @override
+  bool audioWarmStart(int prerollMs, int idleReleaseMs) {
+    _bindAudioFunctions();
+    final fn = _audioWarmStart;
+    if (!_audioBound || fn == null) return false;
+    return fn(prerollMs, idleReleaseMs) == 1;
+  }
+
+  @override
+  void audioWarmStop() {
+    _bindAudioFunctions();
+    if (_audioWarmStart == null) return;
+    _audioWarmStop!();
+  }
+
+  @override
+  bool isAudioWarm() {
+    _bindAudioFunctions();
+    if (_audioWarmStart == null) return false;
+    return _isAudioWarm!() == 1;
+  }
+
+  @override
+  int nativeTraceStampUs(int which) {
+    _bindAudioFunctions();
+    final fn = _nativeTraceStampUs;
+    if (!_audioBound || fn == null) return -1;
+    return fn(which);
+  }
+
+  @override
+  bool get canStreamDecode {
+    _bindAudioFunctions();
+    return _audioBound && _streamDecoderStart != null;
+  }
+
+  @override
+  Pointer<Void> streamDecoderStart(Pointer<Void> recognizer, Pointer<Void> stream, String sherpaLib,
+      Pointer<NativeFunction<DecoderTextCallbackC>> callback, int paddingMs) {
+    _bindAudioFunctions();
+    final fn = _streamDecoderStart;
+    if (!_audioBound || fn == null) return nullptr;
+    final libPtr = sherpaLib.toNativeUtf8();
+    try {
+      return fn(recognizer, stream, libPtr, callback, paddingMs);
+    } finally {
+      calloc.free(libPtr);
+    }
+  }
+
+  // 下面几个只会拿着 start 成功返回的句柄调用，start 成功即意味着已绑定
+  @override
+  void streamDecoderFinish(Pointer<Void> decoder) => _streamDecoderFinish!(decoder);
+
+  @override
+  void streamDecoderAbort(Pointer<Void> decoder) => _streamDecoderAbort!(decoder);
+
+  @override
+  int streamDecoderStat(Pointer<Void> decoder, int which) => _streamDecoderStat!(decoder, which);
+
+  @override
+  bool streamDecoderDestroy(Pointer<Void> decoder, {bool abort = false}) =>
+      _streamDecoderDestroy!(decoder, abort ? 1 : 0) == 1;
+
+  @override
+  bool setNoiseSuppression(bool enabled, int budgetUs) {
+    _bindAudioFunctions();
+    final fn = _audioNoiseSuppressionSet;
+    if (!_audioBound || fn == null) return false;
+    return fn(enabled ? 1 : 0, budgetUs) == 1;
+  }
+
+  @override
+  int audioReaderOpen({bool fromOldest = false}) {
+    _bindAudioFunctions();
+    final fn = _audioReaderOpen;
+    if (!_audioBound || fn == null) return -1;
+    return fn(fromOldest ? 1 : 0);
+  }
+
+  @override
+  void audioReaderClose(int reader) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioReaderOpen == null) return;
+    _audioReaderClose!(reader);
+  }
+
+  @override
+  int audioReaderAvailable(int reader) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioReaderOpen == null) return 0;
+    return _audioReaderAvailable!(reader);
+  }
+
+  @override
+  int audioReaderRead(int reader, Pointer<Int16> outSamples, int maxSamples) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioReaderOpen == null) return 0;
+    return _audioReaderRead!(reader, outSamples, maxSamples);
+  }
+
+  @override
+  int audioReaderOverrun(int reader) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioReaderOpen == null) return -1;
+    return _audioReaderOverrun!(reader);
+  }
+
+  @override
+  int noiseSuppressionStat(int which) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioNoiseSuppressionSet == null) return -1;
+    return _audioNoiseSuppressionStat!(which);
+  }
+
+  @override
+  bool setAutoGain(bool enabled, int targetDbfs, int maxGainDb) {
+    _bindAudioFunctions();
+    final fn = _audioAgcSet;
+    if (!_audioBound || fn == null) return false;
+    return fn(enabled ? 1 : 0, targetDbfs, maxGainDb) == 1;
+  }
+
+  @override
+  List<AutoGainFrame> autoGainTrace(int maxFrames) {
+    _bindAudioFunctions();
+    if (!_audioBound || _audioAgcSet == null || maxFrames <= 0) return const [];
+    final buf = calloc<Float>(maxFrames * 4);
+    try {
+      final n = _audioAgcTrace!(buf, maxFrames);
+      return [
+        for (var i = 0; i < n; i++)
+          AutoGainFrame(buf[i * 4], buf[i * 4 + 1], buf[i * 4 + 2], buf[i * 4 + 3] != 0),
+      ];
+    } finally {
+      calloc.free(buf);
+    }
+  }
+
   // ============ AUDIO DEVICE MANAGEMENT ============
 
   void _bindDeviceFunctions() {
@@ -2372,6 +2372,78 @@ abstract class AppLocalizations {
   /// **'Remind you to switch to the built-in mic when a Bluetooth mic is detected (one tap; never switches silently)'**
   String get autoOptimizeAudioDesc;
 
+  /// No description provided for @warmMic.
+  ///
+  /// In en, this message translates to:
+  /// **'Low-latency microphone'**
+  String get warmMic;
+
+  /// No description provided for @warmMicDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Keep the microphone open while the hotkey is ready, so the first syllable is never clipped. Released automatically after 10 minutes idle'**
+  String get warmMicDesc;
+
+  /// No description provided for @nativeStreamDecode.
+  ///
+  /// In en, this message translates to:
+  /// **'Decode off the UI thread'**
+  String get nativeStreamDecode;
+
+  /// No description provided for @nativeStreamDecodeDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Run local streaming models on a native thread that reads the microphone buffer directly, so decoding never stalls the overlay. Falls back automatically when unsupported'**
+  String get nativeStreamDecodeDesc;
+
+  /// No description provided for @asrLocalRace.
+  ///
+  /// In en, this message translates to:
+  /// **'Cloud + local race'**
+  String get asrLocalRace;
+
+  /// No description provided for @asrLocalRaceDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Also run the current offline model while using cloud recognition. If the cloud has not answered shortly after you release the key, the local result is used. Needs a downloaded offline model'**
+  String get asrLocalRaceDesc;
+
+  /// No description provided for @noiseSuppression.
+  ///
+  /// In en, this message translates to:
+  /// **'Noise suppression (current engine)'**
+  String get noiseSuppression;
+
+  /// No description provided for @noiseSuppressionDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Suppress steady background noise such as fans and air conditioning before audio reaches the recognizer. Remembered separately for each engine; adds 16 ms of latency'**
+  String get noiseSuppressionDesc;
+
+  /// No description provided for @autoGain.
+  ///
+  /// In en, this message translates to:
+  /// **'Automatic gain'**
+  String get autoGain;
+
+  /// No description provided for @autoGainDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Bring quiet or far-away speech up to a steady level without clipping; pauses are not amplified. Adds 10 ms of latency'**
+  String get autoGainDesc;
+
+  /// No description provided for @silenceCompaction.
+  ///
+  /// In en, this message translates to:
+  /// **'Compact long pauses'**
+  String get silenceCompaction;
+
+  /// No description provided for @silenceCompactionDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Offline models and batch uploads: pauses over 1 s are shortened before decoding, so less silence is decoded or uploaded (Linux only)'**
+  String get silenceCompactionDesc;
+
   /// No description provided for @hotkeyConflictTaken.
   ///
   /// In en, this message translates to:
@@ -2726,6 +2798,24 @@ abstract class AppLocalizations {
   /// **'Reset — please restart the app'**
   String get devResetOnboardingDone;
 
+  /// No description provided for @devLatencyTrace.
+  ///
+  /// In en, this message translates to:
+  /// **'Latency trace'**
+  String get devLatencyTrace;
+
+  /// No description provided for @devLatencyTraceDesc.
+  ///
+  /// In en, this message translates to:
+  /// **'Per-phase timings of the last 20 dictations, from hotkey to injected text. Open the exported JSON in chrome://tracing or ui.perfetto.dev'**
+  String get devLatencyTraceDesc;
+
+  /// No description provided for @devLatencyTraceEmpty.
+  ///
+  /// In en, this message translates to:
+  /// **'No dictation recorded yet'**
+  String get devLatencyTraceEmpty;
+
   /// No description provided for @cloudAccountDelete.
   ///
   /// In en, this message translates to:
@@ -3050,6 +3140,18 @@ abstract class AppLocalizations {
   /// **'AI Polish ✓ + Dictionary ✓ → terms injected into LLM\nAI Polish ✓ + Dictionary ✗ → plain LLM polish\nAI Polish ✗ + Dictionary ✓ → exact replace (offline)\nAI Polish ✗ + Dictionary ✗ → raw ASR output'**
   String get vocabMatrixInfo;
 
+  /// No description provided for @vocabHotwordsSkipLlm.
+  ///
+  /// In en, this message translates to:
+  /// **'Skip AI Polish on term hits'**
+  String get vocabHotwordsSkipLlm;
+
+  /// No description provided for @vocabHotwordsSkipLlmNote.
+  ///
+  /// In en, this message translates to:
+  /// **'Local streaming models only: vocab is compiled into decoder hotwords; utterances containing terms are output directly'**
+  String get vocabHotwordsSkipLlmNote;
+
   /// No description provided for @modeExtracting.
   ///
   /// In en, this message translates to:
@@ -1289,6 +1289,48 @@ class AppLocalizationsEn extends AppLocalizations {
   String get autoOptimizeAudioDesc =>
       'Remind you to switch to the built-in mic when a Bluetooth mic is detected (one tap; never switches silently)';
 
+  @override
+  String get warmMic => 'Low-latency microphone';
+
+  @override
+  String get warmMicDesc =>
+      'Keep the microphone open while the hotkey is ready, so the first syllable is never clipped. Released automatically after 10 minutes idle';
+
+  @override
+  String get nativeStreamDecode => 'Decode off the UI thread';
+
+  @override
+  String get nativeStreamDecodeDesc =>
+      'Run local streaming models on a native thread that reads the microphone buffer directly, so decoding never stalls the overlay. Falls back automatically when unsupported';
+
+  @override
+  String get asrLocalRace => 'Cloud + local race';
+
+  @override
+  String get asrLocalRaceDesc =>
+      'Also run the current offline model while using cloud recognition. If the cloud has not answered shortly after you release the key, the local result is used. Needs a downloaded offline model';
+
+  @override
+  String get noiseSuppression => 'Noise suppression (current engine)';
+
+  @override
+  String get noiseSuppressionDesc =>
+      'Suppress steady background noise such as fans and air conditioning before audio reaches the recognizer. Remembered separately for each engine; adds 16 ms of latency';
+
+  @override
+  String get autoGain => 'Automatic gain';
+
+  @override
+  String get autoGainDesc =>
+      'Bring quiet or far-away speech up to a steady level without clipping; pauses are not amplified. Adds 10 ms of latency';
+
+  @override
+  String get silenceCompaction => 'Compact long pauses';
+
+  @override
+  String get silenceCompactionDesc =>
+      'Offline models and batch uploads: pauses over 1 s are shortened before decoding, so less silence is decoded or uploaded (Linux only)';
+
   @override
   String get hotkeyConflictTaken => 'That key is taken. Please choose another.';
 
@@ -1494,6 +1536,16 @@ class AppLocalizationsEn extends AppLocalizations {
   @override
   String get devResetOnboardingDone => 'Reset — please restart the app';
 
+  @override
+  String get devLatencyTrace => 'Latency trace';
+
+  @override
+  String get devLatencyTraceDesc =>
+      'Per-phase timings of the last 20 dictations, from hotkey to injected text. Open the exported JSON in chrome://tracing or ui.perfetto.dev';
+
+  @override
+  String get devLatencyTraceEmpty => 'No dictation recorded yet';
+
   @override
   String get cloudAccountDelete => 'Delete account';
 
@@ -1678,6 +1730,13 @@ class AppLocalizationsEn extends AppLocalizations {
   String get vocabMatrixInfo =>
       'AI Polish ✓ + Dictionary ✓ → terms injected into LLM\nAI Polish ✓ + Dictionary ✗ → plain LLM polish\nAI Polish ✗ + Dictionary ✓ → exact replace (offline)\nAI Polish ✗ + Dictionary ✗ → raw ASR output';
 
+  @override
+  String get vocabHotwordsSkipLlm => 'Skip AI Polish on term hits';
+
+  @override
+  String get vocabHotwordsSkipLlmNote =>
+      'Local streaming models only: vocab is compiled into decoder hotwords; utterances containing terms are output directly';
+
   @override
   String get modeExtracting => 'Extracting...';
 
@@ -1220,6 +1220,46 @@ class AppLocalizationsZh extends AppLocalizations {
   @override
   String get autoOptimizeAudioDesc => '检测到蓝牙麦克风时提醒你切换到内置麦克风（一键切换，不会自动改动设备）';
 
+  @override
+  String get warmMic => '低延迟麦克风';
+
+  @override
+  String get warmMicDesc => '快捷键就绪期间麦克风保持打开，按下即录、开头不丢字。闲置 10 分钟自动释放';
+
+  @override
+  String get nativeStreamDecode => '后台线程解码';
+
+  @override
+  String get nativeStreamDecodeDesc =>
+      '本地流式模型改在原生线程上直接读麦克风缓冲解码，不再和悬浮窗抢主线程。不支持时自动退回';
+
+  @override
+  String get asrLocalRace => '云端 + 本地竞速';
+
+  @override
+  String get asrLocalRaceDesc =>
+      '用云端识别时同时跑当前的离线模型，松键后云端迟迟不回就用本地结果。需要已下载离线模型';
+
+  @override
+  String get noiseSuppression => '降噪（当前引擎）';
+
+  @override
+  String get noiseSuppressionDesc =>
+      '在音频送进识别之前压掉风扇、空调这类稳定的背景噪声。每个引擎分别记住；多 16 毫秒延迟';
+
+  @override
+  String get autoGain => '自动增益';
+
+  @override
+  String get autoGainDesc => '把说话轻、离麦克风远的声音拉到稳定的音量，不削波；停顿里的底噪不跟着放大。多 10 毫秒延迟';
+
+  @override
+  String get silenceCompaction => '压缩长停顿';
+
+  @override
+  String get silenceCompactionDesc =>
+      '离线模型和整段上传的引擎：超过 1 秒的停顿先压短再识别，少解码、少上传静音（目前仅 Linux）';
+
   @override
   String get hotkeyConflictTaken => '该按键已被占用，请选择其他按键。';
 
@@ -1414,6 +1454,16 @@ class AppLocalizationsZh extends AppLocalizations {
   @override
   String get devResetOnboardingDone => '已重置，请重启应用';
 
+  @override
+  String get devLatencyTrace => '延迟追踪';
+
+  @override
+  String get devLatencyTraceDesc =>
+      '最近 20 次听写从按键到出字的分阶段耗时。导出的 JSON 用 chrome://tracing 或 ui.perfetto.dev 打开';
+
+  @override
+  String get devLatencyTraceEmpty => '还没有听写记录';
+
   @override
   String get cloudAccountDelete => '删除账户';
 
@@ -1595,6 +1645,12 @@ class AppLocalizationsZh extends AppLocalizations {
   String get vocabMatrixInfo =>
       'AI 润色 ✓ + 词典 ✓ → 术语注入 LLM\nAI 润色 ✓ + 词典 ✗ → 纯 LLM 润色\nAI 润色 ✗ + 词典 ✓ → 精确替换（离线）\nAI 润色 ✗ + 词典 ✗ → 原始 ASR 输出';
 
+  @override
+  String get vocabHotwordsSkipLlm => '术语命中时跳过 AI 润色';
+
+  @override
+  String get vocabHotwordsSkipLlmNote => '仅本地流式模型：词库编译为解码热词，识别结果含术语时直接输出';
+
   @override
   String get modeExtracting => '解压中...';
 
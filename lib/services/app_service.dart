@@ -303,6 +303,22 @@ class AppService {
     await engine.initASR(modelPath, modelType: type ?? 'zipformer', modelName: modelName ?? 'Local Model', hasPunctuation: hasPunctuation);
   }
 
+  /// 云端模式重建 ASR。开了本地兜底竞速时把当前离线模型一并带上 ——
+  /// 引擎的云端分支靠 modelPath 判断要不要起本地那一路。
+  Future<void> initCloudASR() async {
+    if (!ConfigService().asrLocalRaceEnabled) {
+      await initASR(modelPath: '', type: 'aliyun');
+      return;
+    }
+    final path = await getActiveModelPath();
+    final info = await getActiveModelInfo();
+    await initASR(
+        modelPath: path ?? '',
+        type: info?.type,
+        modelName: info?.name,
+        hasPunctuation: info?.hasPunctuation ?? false);
+  }
+
   Future<void> _initPunctuation() async {
     if (_isPunctuationInitialized) return;
     
@@ -303,6 +303,42 @@ class ConfigService {
 
   Future<void> setBluetoothMicReminderEnabled(bool enabled) async =>
       await _prefs?.setBool('bluetooth_mic_reminder_enabled', enabled);
+
+  /// 常驻麦克风（低延迟模式，目前仅 Linux）：热键就绪期间采集流不关，按键零打开延迟
+  bool get warmMicEnabled => _prefs?.getBool('warm_mic_enabled') ?? false;
+  Future<void> setWarmMicEnabled(bool enabled) async =>
+      await _prefs?.setBool('warm_mic_enabled', enabled);
+
+  /// 本地流式模型在 native 线程上解码（目前仅 Linux）：样本不进 Dart，主 isolate 只收字幕
+  bool get nativeStreamDecodeEnabled => _prefs?.getBool('native_stream_decode_enabled') ?? false;
+  Future<void> setNativeStreamDecodeEnabled(bool enabled) async =>
+      await _prefs?.setBool('native_stream_decode_enabled', enabled);
+
+  /// 采集降噪按 provider 分别开关（key 是 ASRProvider.type，目前仅 Linux 生效）：
+  /// 本地模型在风扇、键盘声里掉字明显；有的云端自带前端降噪，再降一遍反而伤音色
+  Set<String> get noiseSuppressionProviders =>
+      (_prefs?.getStringList('noise_suppression_providers') ?? const <String>[]).toSet();
+  bool noiseSuppressionEnabledFor(String providerType) =>
+      noiseSuppressionProviders.contains(providerType);
+  Future<void> setNoiseSuppressionFor(String providerType, bool enabled) async {
+    final types = noiseSuppressionProviders;
+    if (enabled) {
+      types.add(providerType);
+    } else {
+      types.remove(providerType);
+    }
+    await _prefs?.setStringList('noise_suppression_providers', types.toList()..sort());
+  }
+
+  /// 采集自动增益（目前仅 Linux 生效）：说话轻、离笔记本麦克风远时把电平拉上来
+  bool get autoGainEnabled => _prefs?.getBool('auto_gain_enabled') ?? false;
+  Future<void> setAutoGainEnabled(bool enabled) async =>
+      await _prefs?.setBool('auto_gain_enabled', enabled);
+
+  /// 停顿压缩（目前仅 Linux 生效）：离线模型 / 整段上传前把长停顿压短
+  bool get silenceCompactionEnabled => _prefs?.getBool('silence_compaction_enabled') ?? false;
+  Future<void> setSilenceCompactionEnabled(bool enabled) async =>
+      await _prefs?.setBool('silence_compaction_enabled', enabled);
   
   // --- Aliyun Config ---
   String get aliyunAccessKeyId => _cachedAliyunAkId ?? AppConstants.kDefaultAliyunAkId;
@@ -410,6 +446,10 @@ class ConfigService {
     await _prefs?.setString('asr_engine_type', type);
   }
 
+  /// 云端模式下同时跑当前离线模型，云端超过竞速期限就用本地结果（见 RacingASRProvider）
+  bool get asrLocalRaceEnabled => _prefs?.getBool('asr_local_race_enabled') ?? false;
+  Future<void> setAsrLocalRaceEnabled(bool v) async => await _prefs?.setBool('asr_local_race_enabled', v);
+
   // --- AI Correction Config ---
   bool get aiCorrectionEnabled => _prefs?.getBool('ai_correct_enabled') ?? AppConstants.kDefaultAiCorrectionEnabled;
   String get aiCorrectionPrompt => _getStringWithDefault('ai_correct_prompt', AppConstants.kDefaultAiCorrectionPrompt);
@@ -467,6 +507,14 @@ class ConfigService {
   String get llmProviderType => _prefs?.getString('llm_provider_type') ?? AppConstants.kDefaultLlmProviderType;
   Future<void> setLlmProviderType(String type) async => await _prefs?.setString('llm_provider_type', type);
 
+  /// 离线模型边说边润色：预分段一解出就送 LLM，松键后只等最后一段
+  bool get aiSpeculativeSegments => _prefs?.getBool('ai_speculative_segments') ?? true;
+  Future<void> setAiSpeculativeSegments(bool v) async => await _prefs?.setBool('ai_speculative_segments', v);
+
+  /// 短句润色结果缓存（相同输入 + 词库 + 模型直接复用上次结果，不发请求）
+  bool get llmCacheEnabled => _prefs?.getBool('llm_cache_enabled') ?? true;
+  Future<void> setLlmCacheEnabled(bool v) async => await _prefs?.setBool('llm_cache_enabled', v);
+
   // --- LLM Preset ---
   String get llmPresetId => _prefs?.getString('llm_preset_id') ?? 'dashscope';
   Future<void> setLlmPresetId(String id) async => await _prefs?.setString('llm_preset_id', id);
@@ -613,6 +661,10 @@ class ConfigService {
   String get vocabUserEntriesJson => _prefs?.getString('vocab_user_entries') ?? '[]';
   Future<void> setVocabUserEntriesJson(String json) async => await _prefs?.setString('vocab_user_entries', json);
 
+  /// 本地流式模型已把词库编成热词时，命中术语的句子跳过 AI 润色
+  bool get vocabHotwordsSkipLlm => _prefs?.getBool('vocab_hotwords_skip_llm') ?? false;
+  Future<void> setVocabHotwordsSkipLlm(bool v) async => await _prefs?.setBool('vocab_hotwords_skip_llm', v);
+
   // --- Typewriter Effect (Alpha) ---
   bool get typewriterEnabled => _prefs?.getBool('typewriter_enabled') ?? false;
   Future<void> setTypewriterEnabled(bool v) async => await _prefs?.setBool('typewriter_enabled', v);
@@ -0,0 +1,167 @@
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:crypto/crypto.dart';
+import 'package:path_provider/path_provider.dart';
+
+import '../config/app_constants.dart';
+import '../config/app_log.dart';
+
+/// 润色结果的磁盘 LRU 缓存。
+///
+/// 口述里很大一部分是重复的短句（「好的」「收到」、固定的结束语），
+/// 每句都打一次 LLM 是白等一个网络往返。命中时直接返回上次的结果，零网络延迟。
+///
+/// key 覆盖所有会改变输出的东西：规整后的原文、词库提示、翻译目标、
+/// 服务端点 + 模型、完整 system prompt —— 任何一项变了都是新 key，
+/// 所以不需要「配置变了清缓存」这种容易漏的逻辑。
+///
+/// 存储：`<appSupport>/llm_cache.json`，整表一个 JSON（条目少、都是短句）。
+/// Map 的插入顺序即 LRU 顺序，命中时挪到末尾；写盘合并成一次，先写临时文件再 rename。
+class LlmCorrectionCache {
+  LlmCorrectionCache({
+    File? file,
+    this.maxEntries = AppConstants.kLlmCacheMaxEntries,
+    this.ttl = AppConstants.kLlmCacheTtl,
+    DateTime Function()? clock,
+    this.persist = true,
+  })  : _file = file,
+        _clock = clock ?? DateTime.now;
+
+  File? _file;
+  final int maxEntries;
+  final Duration ttl;
+  final DateTime Function() _clock;
+
+  /// false = 只在内存里，不读写磁盘
+  final bool persist;
+
+  /// key → (结果, 写入时间 ms)
+  final LinkedHashMap<String, (String, int)> _entries = LinkedHashMap();
+  Future<void>? _loading;
+  Future<void> _writing = Future.value();
+  bool _dirty = false;
+
+  int hits = 0;
+  int misses = 0;
+  int evictions = 0;
+
+  double get hitRate => hits + misses == 0 ? 0 : hits / (hits + misses);
+  int get length => _entries.length;
+
+  /// 空白规整：ASR 偶尔多出首尾空格或连续空格，不该因此错过命中。
+  /// 标点不动 ——「好的？」和「好的。」润色结果本来就不同。
+  static String normalize(String input) =>
+      input.trim().replaceAll(RegExp(r'\s+'), ' ');
+
+  /// 这句值不值得缓存：只收短句
+  static bool isCacheable(String input) {
+    final n = normalize(input);
+    return n.isNotEmpty && n.length <= AppConstants.kLlmCacheMaxInputChars;
+  }
+
+  static String keyFor({
+    required String input,
+    required List<String>? vocabHints,
+    required String? translateTo,
+    required String model,
+    required String systemPrompt,
+    String? context,
+  }) {
+    final raw = jsonEncode([
+      normalize(input),
+      vocabHints ?? const <String>[],
+      translateTo ?? '',
+      model,
+      systemPrompt,
+      if (context != null && context.isNotEmpty) context,
+    ]);
+    return sha256.convert(utf8.encode(raw)).toString();
+  }
+
+  /// 命中返回结果并计 hit；未命中 / 过期返回 null 并计 miss
+  Future<String?> get(String key) async {
+    await _ensureLoaded();
+    final entry = _entries.remove(key);
+    if (entry == null) {
+      misses++;
+      return null;
+    }
+    if (_clock().millisecondsSinceEpoch - entry.$2 > ttl.inMilliseconds) {
+      misses++;
+      _markDirty();
+      return null;
+    }
+    _entries[key] = entry; // 挪到末尾 = 最近使用
+    hits++;
+    _markDirty();
+    return entry.$1;
+  }
+
+  Future<void> put(String key, String value) async {
+    await _ensureLoaded();
+    _entries.remove(key);
+    _entries[key] = (value, _clock().millisecondsSinceEpoch);
+    while (_entries.length > maxEntries) {
+      _entries.remove(_entries.keys.first);
+      evictions++;
+    }
+    _markDirty();
+  }
+
+  Future<void> clear() async {
+    await _ensureLoaded();
+    _entries.clear();
+    _markDirty();
+    await flush();
+  }
+
+  /// 等待排队中的写盘完成
+  Future<void> flush() => _writing;
+
+  Future<void> _ensureLoaded() => _loading ??= _load();
+
+  Future<File> _resolveFile() async =>
+      _file ??= File('${(await getApplicationSupportDirectory()).path}/llm_cache.json');
+
+  Future<void> _load() async {
+    if (!persist) return;
+    try {
+      final file = await _resolveFile();
+      if (!await file.exists()) return;
+      final json = jsonDecode(await file.readAsString()) as Map<String, dynamic>;
+      final now = _clock().millisecondsSinceEpoch;
+      for (final e in json.entries) {
+        final v = e.value as List<dynamic>;
+        final at = v[1] as int;
+        if (now - at > ttl.inMilliseconds) continue;
+        _entries[e.key] = (v[0] as String, at);
+      }
+    } catch (e) {
+      // 文件坏了就当空缓存：缓存丢了只是慢一次，不能影响润色
+      AppLog.d('[LLM] 缓存文件读取失败，按空缓存处理: $e');
+      _entries.clear();
+    }
+  }
+
+  /// 连续多次修改只排一次写盘
+  void _markDirty() {
+    if (!persist || _dirty) return;
+    _dirty = true;
+    _writing = _writing.then((_) async {
+      _dirty = false;
+      try {
+        final file = await _resolveFile();
+        await file.parent.create(recursive: true);
+        final tmp = File('${file.path}.tmp');
+        await tmp.writeAsString(jsonEncode({
+          for (final e in _entries.entries) e.key: [e.value.$1, e.value.$2],
+        }));
+        await tmp.rename(file.path);
+      } catch (e) {
+        AppLog.d('[LLM] 缓存写盘失败: $e');
+      }
+    });
+  }
+}
@@ -3,11 +3,22 @@ import 'dart:convert';
 import 'package:http/http.dart' as http;
 import 'config_service.dart';
 import 'cloud_account_service.dart';
+import 'llm_correction_cache.dart';
 import '../models/cloud_account.dart';
 import '../config/app_constants.dart';
 import '../config/app_log.dart';
 import '../config/cloud_providers.dart';
 
+/// 一次 [LLMService.correctText] / [LLMService.correctTextStream] 调用是否成功，
+/// 由调用方传进去、调用结束后读。
+///
+/// [LLMService.lastCallSucceeded] 是整个进程共用的一个标志：上一句的收尾还在等 LLM 时
+/// 下一句的调用（听写流水线、边说边润色）会把它改掉，读到的就是别人那次的结果。
+class LlmCallStatus {
+  /// true = LLM 成功返回（无论是否有修改，含缓存命中）；失败时调用返回的是原文
+  bool succeeded = false;
+}
+
 class LLMService {
   static final LLMService _instance = LLMService._internal();
   factory LLMService() => _instance;
@@ -18,8 +29,12 @@ class LLMService {
   http.Client? _client;
   http.Client? _defaultClient;
 
+  /// 注入 client 时顺带换一份空的纯内存缓存：每个注入的 client 代表一套
+  /// 独立的服务端行为，沿用上一个 client 的缓存会让「同一句话换个响应」的用例
+  /// 直接命中旧结果，也不该往真实的应用目录里写。
   void setClient(http.Client client) {
     _client = client;
+    _cache = LlmCorrectionCache(persist: false);
   }
 
   http.Client get _effectiveClient {
@@ -28,6 +43,14 @@ class LLMService {
     return _defaultClient!;
   }
 
+  /// 短句润色结果缓存。测试里换成指向临时文件的实例。
+  LlmCorrectionCache _cache = LlmCorrectionCache();
+  LlmCorrectionCache get correctionCache => _cache;
+
+  void setCorrectionCache(LlmCorrectionCache cache) {
+    _cache = cache;
+  }
+
   /// 释放默认 client（应用退出时调用）。注入的 _client 由注入方负责。
   void dispose() {
     _defaultClient?.close();
@@ -37,6 +60,8 @@ class LLMService {
   /// 最近一次 correctText / correctTextStream 调用是否成功
   /// true = LLM 成功返回（无论是否有修改）
   /// false = 调用失败（API 错误、超时、空响应、Key 缺失等）
+  ///
+  /// 调用可能并发时不要读它，传 [LlmCallStatus] 拿这一次自己的结果
   bool lastCallSucceeded = false;
 
   void log(String msg) => _log(msg);
@@ -105,8 +130,51 @@ class LLMService {
     return cleaned.trim();
   }
 
-  Future<String> correctText(String input, {List<String>? vocabHints, String? translateTo}) async {
+  /// 缓存 key；不该走缓存（关闭、长句、没配 Key）时返回 null
+  String? _correctionCacheKey(String input, {List<String>? vocabHints, String? translateTo,
+      ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? context}) {
+    if (!ConfigService().llmCacheEnabled || !LlmCorrectionCache.isCacheable(input)) return null;
+    final String model;
+    if (resolved == null) {
+      model = 'ollama|${ConfigService().ollamaBaseUrl}|${ConfigService().ollamaModel}';
+    } else {
+      if (resolved.apiKey.isEmpty) return null;
+      model = '${resolved.baseUrl}|${resolved.model}';
+    }
+    return LlmCorrectionCache.keyFor(
+      input: input,
+      vocabHints: vocabHints,
+      translateTo: translateTo,
+      model: model,
+      systemPrompt: _buildSystemPrompt(translateTo: translateTo),
+      context: context,
+    );
+  }
+
+  /// 查缓存；命中时视同一次成功调用
+  Future<String?> _cachedCorrection(String? key, LlmCallStatus call) async {
+    if (key == null) return null;
+    final cached = await _cache.get(key);
+    if (cached != null) {
+      call.succeeded = true;
+      _log("CACHE HIT (hits=${_cache.hits}, misses=${_cache.misses}): ${AppLog.redact(cached)}");
+    }
+    return cached;
+  }
+
+  /// [bypassCache] 为 true 时既不读也不写缓存（例如用户要求重新润色）。
+  /// [context] 为已润色的上文，只用来理解语境，不会出现在输出里。
+  /// [status] 记下这一次是否成功（见 [LlmCallStatus]）。
+  Future<String> correctText(String input, {List<String>? vocabHints, String? translateTo, bool bypassCache = false, String? context, LlmCallStatus? status}) async {
+    final call = status ?? LlmCallStatus();
     lastCallSucceeded = false;
+    final out = await _correctText(input,
+        vocabHints: vocabHints, translateTo: translateTo, bypassCache: bypassCache, context: context, call: call);
+    lastCallSucceeded = call.succeeded;
+    return out;
+  }
+
+  Future<String> _correctText(String input, {List<String>? vocabHints, String? translateTo, required bool bypassCache, String? context, required LlmCallStatus call}) async {
     if (input.trim().isEmpty) return input;
     // translateTo 强制启用 LLM（即使 AI 润色关闭）
     if (!ConfigService().aiCorrectionEnabled && translateTo == null) {
@@ -115,25 +183,42 @@ class LLMService {
     }
 
     final providerType = ConfigService().llmProviderType;
+    final resolved = providerType == 'ollama' ? null : _resolveLlmConfig();
+    final cacheKey = bypassCache
+        ? null
+        : _correctionCacheKey(input, vocabHints: vocabHints, translateTo: translateTo, resolved: resolved, context: context);
+    final cached = await _cachedCorrection(cacheKey, call);
+    if (cached != null) return cached;
+
     String result;
-    if (providerType == 'ollama') {
-      result = await _correctTextOllama(input, vocabHints: vocabHints, translateTo: translateTo);
+    if (resolved == null) {
+      result = await _correctTextOllama(input, vocabHints: vocabHints, translateTo: translateTo, context: context, call: call);
+    } else if (resolved.isAnthropic) {
+      result = await _correctTextAnthropic(input, vocabHints: vocabHints, resolved: resolved, translateTo: translateTo, context: context, call: call);
     } else {
-      final resolved = _resolveLlmConfig();
-      if (resolved.isAnthropic) {
-        result = await _correctTextAnthropic(input, vocabHints: vocabHints, resolved: resolved, translateTo: translateTo);
-      } else {
-        result = await _correctTextCloud(input, vocabHints: vocabHints, resolved: resolved, translateTo: translateTo);
-      }
+      result = await _correctTextCloud(input, vocabHints: vocabHints, resolved: resolved, translateTo: translateTo, context: context, call: call);
     }
-    // lastCallSucceeded 由各 _correctText* 方法在成功时设为 true
-    return _cleanLlmOutput(result);
+    // call.succeeded 由各 _correctText* 方法在成功时设为 true
+    final cleaned = _cleanLlmOutput(result);
+    // 失败时返回的是原文，不能当成「润色结果」缓存下来
+    if (cacheKey != null && call.succeeded && cleaned.isNotEmpty) {
+      unawaited(_cache.put(cacheKey, cleaned));
+    }
+    return cleaned;
   }
 
   /// Streaming version: yields incremental text chunks as they arrive from LLM.
   /// Falls back to non-streaming for Anthropic/Ollama.
-  Stream<String> correctTextStream(String input, {List<String>? vocabHints, String? translateTo}) async* {
+  /// [status] 记下这一次是否成功（流结束后读，见 [LlmCallStatus]）。
+  Stream<String> correctTextStream(String input, {List<String>? vocabHints, String? translateTo, bool bypassCache = false, LlmCallStatus? status}) async* {
+    final call = status ?? LlmCallStatus();
     lastCallSucceeded = false;
+    yield* _correctTextStream(input,
+        vocabHints: vocabHints, translateTo: translateTo, bypassCache: bypassCache, call: call);
+    lastCallSucceeded = call.succeeded;
+  }
+
+  Stream<String> _correctTextStream(String input, {List<String>? vocabHints, String? translateTo, required bool bypassCache, required LlmCallStatus call}) async* {
     if (input.trim().isEmpty) {
       yield input;
       return;
@@ -149,22 +234,42 @@ class LLMService {
     // thinking 模型的 `<think>…</think>` 会被打字机原样粘进用户文档
     // （引擎收完后确实也清一遍，但清的是留档用的 finalText，粘出去的撤不回来）。
     final providerType = ConfigService().llmProviderType;
-    if (providerType == 'ollama') {
-      yield _cleanLlmOutput(
-          await _correctTextOllama(input, vocabHints: vocabHints, translateTo: translateTo));
+    final resolved = providerType == 'ollama' ? null : _resolveLlmConfig();
+    final cacheKey = bypassCache
+        ? null
+        : _correctionCacheKey(input, vocabHints: vocabHints, translateTo: translateTo, resolved: resolved);
+    final cached = await _cachedCorrection(cacheKey, call);
+    if (cached != null) {
+      yield cached; // 命中：整段一次吐出，打字机直接粘
       return;
     }
-    final resolved = _resolveLlmConfig();
-    if (resolved.isAnthropic) {
-      yield _cleanLlmOutput(await _correctTextAnthropic(input,
-          vocabHints: vocabHints, resolved: resolved, translateTo: translateTo));
-      return;
+
+    final out = StringBuffer();
+    if (resolved == null) {
+      final text = _cleanLlmOutput(
+          await _correctTextOllama(input, vocabHints: vocabHints, translateTo: translateTo, call: call));
+      out.write(text);
+      yield text;
+    } else if (resolved.isAnthropic) {
+      final text = _cleanLlmOutput(await _correctTextAnthropic(input,
+          vocabHints: vocabHints, resolved: resolved, translateTo: translateTo, call: call));
+      out.write(text);
+      yield text;
+    } else {
+      await for (final chunk in _correctTextCloudStream(input,
+          vocabHints: vocabHints, resolved: resolved, translateTo: translateTo, call: call)) {
+        out.write(chunk);
+        yield chunk;
+      }
+    }
+    final result = out.toString().trim();
+    if (cacheKey != null && call.succeeded && result.isNotEmpty) {
+      unawaited(_cache.put(cacheKey, result));
     }
-    yield* _correctTextCloudStream(input, vocabHints: vocabHints, resolved: resolved, translateTo: translateTo);
   }
 
   /// SSE streaming for OpenAI-compatible APIs
-  Stream<String> _correctTextCloudStream(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo}) async* {
+  Stream<String> _correctTextCloudStream(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo, required LlmCallStatus call}) async* {
     final r = resolved ?? _resolveLlmConfig();
     final apiKey = r.apiKey;
     final baseUrl = r.baseUrl;
@@ -267,7 +372,7 @@ class LLMService {
 
       final result = fullBuffer.toString().trim();
       if (result.isNotEmpty) {
-        lastCallSucceeded = true;
+        call.succeeded = true;
       }
       _log("LLM STREAM SUCCESS (${result.length}字, differs=${result != input}): ${AppLog.redact(result)}");
     } catch (e) {
@@ -316,11 +421,17 @@ class LLMService {
     return parts.join('\n');
   }
 
-  String _buildUserMessage(String input, {List<String>? vocabHints}) {
+  /// [context]：紧接在前、已经润色过的上文（分段润色时用）。
+  /// 说明写在用户消息里而不是 system prompt —— 后者用户可以自定义，不能指望它认识这个标签。
+  String _buildUserMessage(String input, {List<String>? vocabHints, String? context}) {
     final vocabSection = (vocabHints != null && vocabHints.isNotEmpty)
         ? '\n\n<vocab_hints>\n${vocabHints.join(', ')}\n</vocab_hints>'
         : '';
-    return '<speech_text>\n$input\n</speech_text>$vocabSection';
+    final contextSection = (context != null && context.isNotEmpty)
+        ? '<preceding_text>\n$context\n</preceding_text>\n'
+            '（以上是紧接在前、已润色过的上文，仅供理解语境，不要输出；只润色 speech_text。）\n\n'
+        : '';
+    return '$contextSection<speech_text>\n$input\n</speech_text>$vocabSection';
   }
 
   /// 模型特定参数注入。DeepSeek V4 默认开 thinking mode，会让总耗时翻 2x+
@@ -341,7 +452,7 @@ class LLMService {
     }
   }
 
-  Future<String> _correctTextCloud(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo}) async {
+  Future<String> _correctTextCloud(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo, String? context, required LlmCallStatus call}) async {
     final r = resolved ?? _resolveLlmConfig();
     final apiKey = r.apiKey;
     final baseUrl = r.baseUrl;
@@ -364,7 +475,7 @@ class LLMService {
         "model": model,
         "messages": [
           {"role": "system", "content": systemPrompt},
-          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints)}
+          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints, context: context)}
         ],
         "temperature": AppConstants.kLlmDefaultTemperature,
       };
@@ -384,7 +495,7 @@ class LLMService {
         final content = json['choices']?[0]?['message']?['content']?.toString();
         if (content != null && content.isNotEmpty) {
           _log("LLM SUCCESS (${content.trim().length}字, differs=${content.trim() != input}): ${AppLog.redact(content.trim())}");
-          lastCallSucceeded = true;
+          call.succeeded = true;
           return content.trim();
         }
         _log("LLM returned empty content.");
@@ -398,7 +509,7 @@ class LLMService {
     return input;
   }
 
-  Future<String> _correctTextAnthropic(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo}) async {
+  Future<String> _correctTextAnthropic(String input, {List<String>? vocabHints, ({String apiKey, String baseUrl, String model, bool isAnthropic})? resolved, String? translateTo, String? context, required LlmCallStatus call}) async {
     final r = resolved ?? _resolveLlmConfig();
     final apiKey = r.apiKey;
     final baseUrl = r.baseUrl;
@@ -422,7 +533,7 @@ class LLMService {
         "max_tokens": AppConstants.kAnthropicMaxTokens,
         "system": systemPrompt,
         "messages": [
-          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints)}
+          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints, context: context)}
         ],
         "temperature": AppConstants.kLlmDefaultTemperature,
       };
@@ -444,7 +555,7 @@ class LLMService {
             ?['text']?.toString();
         if (content != null && content.isNotEmpty) {
           _log("Anthropic SUCCESS (${content.trim().length}字, differs=${content.trim() != input}): ${AppLog.redact(content.trim())}");
-          lastCallSucceeded = true;
+          call.succeeded = true;
           return content.trim();
         }
         _log("Anthropic returned empty content.");
@@ -458,7 +569,7 @@ class LLMService {
     return input;
   }
 
-  Future<String> _correctTextOllama(String input, {List<String>? vocabHints, String? translateTo}) async {
+  Future<String> _correctTextOllama(String input, {List<String>? vocabHints, String? translateTo, String? context, required LlmCallStatus call}) async {
     final baseUrl = ConfigService().ollamaBaseUrl;
     final model = ConfigService().ollamaModel;
     final systemPrompt = _buildSystemPrompt(translateTo: translateTo);
@@ -474,7 +585,7 @@ class LLMService {
         "model": model,
         "messages": [
           {"role": "system", "content": systemPrompt},
-          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints)}
+          {"role": "user", "content": _buildUserMessage(input, vocabHints: vocabHints, context: context)}
         ],
         "stream": false,
         "think": false,
@@ -494,7 +605,7 @@ class LLMService {
         final content = json['message']?['content']?.toString();
         if (content != null && content.isNotEmpty) {
           _log("Ollama SUCCESS (${content.trim().length}字, differs=${content.trim() != input}): ${AppLog.redact(content.trim())}");
-          lastCallSucceeded = true;
+          call.succeeded = true;
           return content.trim();
         }
         _log("Ollama returned empty content.");
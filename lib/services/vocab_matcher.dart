@@ -0,0 +1,169 @@
+import 'dart:typed_data';
+
+/// 多模式替换自动机（Aho–Corasick），**最左最长**、不重叠、单遍扫描。
+///
+/// 取代原先「每个词条一次 replaceAll」：那是 O(词条数 × 文本长)，五个行业包
+/// 全开时每句话要扫几千遍；而且后面的词条会在前面替换**产出的文本**上再匹配
+/// （A→B、B→C 会把 A 链成 C，TC-044 记录过这个问题）。
+/// 这里只在原文上匹配一次，替换结果不再参与匹配。
+///
+/// 冲突规则：
+/// - 同一位置起有多个词条命中 → 取最长的（「机器学系统」优先于「机器学系」）
+/// - 多个命中相互重叠 → 取起点最靠左的，其余让位
+/// - 同一个 wrong 出现多次 → 后加入的覆盖先加入的（调用方把用户词条放在行业包之后）
+class VocabMatcher {
+  VocabMatcher._(this._children, this._fail, this._dict, this._depth,
+      this._replacement, this.patternCount);
+
+  /// node → {UTF-16 code unit → child}
+  final List<Map<int, int>> _children;
+  final Int32List _fail;
+
+  /// 沿失败链最近的「词条终点」节点，-1 表示没有。扫描时不用逐级爬失败链找输出。
+  final Int32List _dict;
+  final Int32List _depth;
+
+  /// 终点节点 → 替换文本；非终点为 null
+  final List<String?> _replacement;
+
+  final int patternCount;
+
+  static final VocabMatcher empty = VocabMatcher.build(const []);
+
+  /// [pairs] 为 (wrong, correct)。wrong 或 correct 为空的条目跳过 ——
+  /// 与原 applyReplacements 的约定一致（correct 为空不是「删除」，是无效词条）。
+  factory VocabMatcher.build(Iterable<(String, String)> pairs) {
+    final children = <Map<int, int>>[{}];
+    final replacement = <String?>[null];
+    final depth = <int>[0];
+    var count = 0;
+
+    for (final (wrong, correct) in pairs) {
+      if (wrong.isEmpty || correct.isEmpty) continue;
+      var node = 0;
+      for (var i = 0; i < wrong.length; i++) {
+        final c = wrong.codeUnitAt(i);
+        var next = children[node][c];
+        if (next == null) {
+          next = children.length;
+          children[node][c] = next;
+          children.add({});
+          replacement.add(null);
+          depth.add(depth[node] + 1);
+        }
+        node = next;
+      }
+      if (replacement[node] == null) count++;
+      replacement[node] = correct;
+    }
+
+    // BFS 补失败链与输出链
+    final n = children.length;
+    final fail = Int32List(n);
+    final dict = Int32List(n)..fillRange(0, n, -1);
+    final queue = <int>[];
+    for (final child in children[0].values) {
+      queue.add(child); // 深度 1 的失败链指向根（Int32List 默认 0）
+    }
+    for (var qi = 0; qi < queue.length; qi++) {
+      final node = queue[qi];
+      for (final entry in children[node].entries) {
+        final c = entry.key;
+        final child = entry.value;
+        var f = fail[node];
+        while (f != 0 && !children[f].containsKey(c)) {
+          f = fail[f];
+        }
+        final target = children[f][c];
+        fail[child] = (target != null && target != child) ? target : 0;
+        final fc = fail[child];
+        dict[child] = replacement[fc] != null ? fc : dict[fc];
+        queue.add(child);
+      }
+    }
+
+    return VocabMatcher._(children, fail, dict, Int32List.fromList(depth),
+        replacement, count);
+  }
+
+  bool get isEmpty => patternCount == 0;
+
+  int _step(int state, int c) {
+    while (true) {
+      final next = _children[state][c];
+      if (next != null) return next;
+      if (state == 0) return 0;
+      state = _fail[state];
+    }
+  }
+
+  /// [text] 是否命中任一词条（只判存在，找到第一个就返回）
+  bool matchesAny(String text) {
+    if (isEmpty) return false;
+    var state = 0;
+    for (var i = 0; i < text.length; i++) {
+      state = _step(state, text.codeUnitAt(i));
+      if (_replacement[state] != null || _dict[state] >= 0) return true;
+    }
+    return false;
+  }
+
+  /// 对 [text] 做一次最左最长替换
+  String apply(String text) {
+    if (isEmpty || text.isEmpty) return text;
+
+    StringBuffer? out; // 没有命中时原样返回，不分配
+    var emitted = 0; // text[0, emitted) 已写入 out
+    var state = 0;
+    var i = 0;
+    // 当前最优候选：[bestStart, bestEnd)
+    var bestStart = -1, bestEnd = -1, bestNode = -1;
+
+    void commit() {
+      (out ??= StringBuffer())
+        ..write(text.substring(emitted, bestStart))
+        ..write(_replacement[bestNode]);
+      emitted = bestEnd;
+      // 从命中结尾重新起步：之后的候选必须不与它重叠。
+      // 回退量不超过最长词条长度，整体仍是线性的。
+      i = bestEnd;
+      state = 0;
+      bestStart = bestEnd = bestNode = -1;
+    }
+
+    while (true) {
+      while (i < text.length) {
+        state = _step(state, text.codeUnitAt(i));
+        i++;
+
+        // 候选已定：当前状态覆盖的后缀已经够不到 bestStart，
+        // 之后不可能再出现起点 ≤ bestStart 的更长命中。
+        if (bestNode >= 0 && i - _depth[state] > bestStart) {
+          commit();
+          continue;
+        }
+
+        // 收集以 i 结尾的所有命中，只保留起点最左、同起点最长的
+        for (var node = _replacement[state] != null ? state : _dict[state];
+            node >= 0;
+            node = _dict[node]) {
+          final start = i - _depth[node];
+          if (bestNode < 0 ||
+              start < bestStart ||
+              (start == bestStart && i > bestEnd)) {
+            bestStart = start;
+            bestEnd = i;
+            bestNode = node;
+          }
+        }
+      }
+      if (bestNode < 0) break;
+      commit(); // 扫到结尾时手里还有候选：落定后从它的结尾继续
+    }
+
+    final result = out;
+    if (result == null) return text;
+    result.write(text.substring(emitted));
+    return result.toString();
+  }
+}
@@ -1,7 +1,12 @@
 import 'dart:convert';
+import 'dart:io';
+import 'package:crypto/crypto.dart';
+import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
+import 'package:path_provider/path_provider.dart';
 import 'config_service.dart';
 import 'package:speakout/config/app_log.dart';
+import 'vocab_matcher.dart';
 
 /// Vocab entry: wrong form -> correct form
 class VocabEntry {
@@ -56,6 +61,15 @@ class VocabService {
   /// 而词库其实还没读完，调用方拿到空列表。
   Future<void>? _packsLoading;
 
+  /// 编译好的替换自动机，及编译它时的词库签名（启用的包 + 用户词条原文）。
+  /// 词条与开关都在 ConfigService 里，别处（设置页、导入配置）也会改 ——
+  /// 只靠 add/delete 时重建会漏掉那些路径，所以每次使用前比一下签名。
+  VocabMatcher? _matcher;
+  String? _matcherKey;
+
+  /// 最近一次编进热词文件的术语（correct 形式），判断「本句是否命中了已偏置的词」用
+  VocabMatcher _hotwordTerms = VocabMatcher.empty;
+
   static List<({String id, String nameZh, String nameEn})> get availablePacks =>
       _packDefs.map((d) => (id: d.id, nameZh: d.nameZh, nameEn: d.nameEn)).toList();
 
@@ -119,6 +133,7 @@ class VocabService {
       current.add(entry);
     }
     await _saveUserEntries(current);
+    _currentMatcher(); // 提前编好，别让下一句话的替换来付这笔开销
   }
 
   Future<void> deleteUserEntry(int index) async {
@@ -126,6 +141,7 @@ class VocabService {
     if (index < 0 || index >= current.length) return;
     current.removeAt(index);
     await _saveUserEntries(current);
+    _currentMatcher();
   }
 
   Future<void> _saveUserEntries(List<VocabEntry> entries) async {
@@ -134,17 +150,196 @@ class VocabService {
   }
 
   /// Fallback: direct string replacement (used when AI is disabled)
+  ///
+  /// 单遍最左最长匹配（见 [VocabMatcher]）：替换产出的文本不会被再次匹配，
+  /// 同一处命中多个词条时取最长的，用户词条与行业包同 wrong 时用户词条优先。
   String applyReplacements(String text) {
     if (text.isEmpty) return text;
+    return _currentMatcher().apply(text);
+  }
+
+  VocabMatcher _currentMatcher() {
+    final config = ConfigService();
+    final key = [
+      for (final def in _packDefs)
+        if (_isPackEnabled(def.id, config) && _loadedPacks.containsKey(def.id))
+          def.id,
+      config.vocabUserEnabled ? config.vocabUserEntriesJson : '',
+    ].join('\u0000');
+    if (_matcher != null && key == _matcherKey) return _matcher!;
+
     final entries = getActiveEntries();
-    if (entries.isEmpty) return text;
+    final matcher = entries.isEmpty
+        ? VocabMatcher.empty
+        : VocabMatcher.build(entries.map((e) => (e.wrong, e.correct)));
+    _matcher = matcher;
+    _matcherKey = key;
+    return matcher;
+  }
+
+  /// 本句是否含有已编进解码器热词的术语
+  bool containsHotword(String text) => _hotwordTerms.matchesAny(text);
+
+  /// 把启用的词库编译成 sherpa-onnx 热词文件（按模型的 tokens.txt 切分），返回路径。
+  ///
+  /// 写进去的是 correct 形式：目的是让解码器直接认出正确写法，而不是识别错了再替换。
+  /// 切不出来的词（含 tokens.txt 里没有的字/子词）整条丢弃 ——
+  /// 热词里出现未知 token，sherpa 会让整个识别器创建失败。
+  /// 按「术语集合 + tokens.txt 身份」缓存在 `<appSupport>/hotwords/`，
+  /// 词库没变时切换模型、重启都不重新编译。
+  Future<String?> compileHotwords(String modelPath) async {
+    try {
+      await ensurePacksLoaded();
+      final tokensFile = File('$modelPath/tokens.txt');
+      final terms = getActiveEntries()
+          .map((e) => e.correct.trim())
+          .where((t) => t.isNotEmpty)
+          .toSet()
+          .toList()
+        ..sort();
+      if (terms.isEmpty || !await tokensFile.exists()) {
+        _hotwordTerms = VocabMatcher.empty;
+        return null;
+      }
+
+      final stat = await tokensFile.stat();
+      final key = sha256
+          .convert(utf8.encode([
+            tokensFile.path,
+            stat.size,
+            stat.modified.millisecondsSinceEpoch,
+            ...terms,
+          ].join('\n')))
+          .toString()
+          .substring(0, 16);
+      final dir = Directory('${(await getApplicationSupportDirectory()).path}/hotwords');
+      final hotwordsFile = File('${dir.path}/$key.txt');
+      final termsFile = File('${dir.path}/$key.terms.json');
+
+      List<String> included;
+      if (await hotwordsFile.exists() && await termsFile.exists()) {
+        included = (jsonDecode(await termsFile.readAsString()) as List).cast<String>();
+      } else {
+        final vocab = parseTokens(await tokensFile.readAsString());
+        final lines = <String>[];
+        included = [];
+        for (final term in terms) {
+          final tokenized = tokenizeHotword(term, vocab);
+          if (tokenized == null) continue;
+          lines.add(tokenized);
+          included.add(term);
+        }
+        await dir.create(recursive: true);
+        // 先写术语表再写热词文件：两者都在才算缓存命中，中途崩溃只会重编一次
+        await termsFile.writeAsString(jsonEncode(included));
+        final tmp = File('${hotwordsFile.path}.tmp');
+        await tmp.writeAsString(lines.join('\n'), flush: true);
+        await tmp.rename(hotwordsFile.path);
+        AppLog.d('VocabService: 热词编译 ${included.length}/${terms.length} 条 → ${hotwordsFile.path}');
+      }
+
+      _hotwordTerms = VocabMatcher.build(included.map((t) => (t, t)));
+      return included.isEmpty ? null : hotwordsFile.path;
+    } catch (e) {
+      // 热词是锦上添花：编不出来就按无热词初始化，不能连累模型加载
+      AppLog.d('VocabService: 热词编译失败，本次不启用: $e');
+      _hotwordTerms = VocabMatcher.empty;
+      return null;
+    }
+  }
+
+  /// tokens.txt 每行「token id」，token 本身可能含空格以外的任何字符
+  @visibleForTesting
+  static Set<String> parseTokens(String raw) {
+    final tokens = <String>{};
+    for (final line in const LineSplitter().convert(raw)) {
+      final sp = line.lastIndexOf(' ');
+      if (sp > 0) tokens.add(line.substring(0, sp));
+    }
+    return tokens;
+  }
+
+  /// 把一个术语切成模型词表里的 token，空格分隔；切不出来返回 null。
+  ///
+  /// 中文按字（cjkchar 模型的 token 就是单字）；连续的字母数字按 BPE 习惯
+  /// 贪心最长匹配，词首带 `▁`。双语模型的英文 token 多为大写，大小写都试。
+  @visibleForTesting
+  static String? tokenizeHotword(String term, Set<String> tokens) {
+    final pieces = <String>[];
+    final word = StringBuffer();
+
+    bool flushWord() {
+      if (word.isEmpty) return true;
+      final w = word.toString();
+      word.clear();
+      final p = _bpePieces(w, tokens) ??
+          _bpePieces(w.toUpperCase(), tokens) ??
+          _bpePieces(w.toLowerCase(), tokens);
+      if (p == null) return false;
+      pieces.addAll(p);
+      return true;
+    }
+
+    for (final rune in term.runes) {
+      final isWordChar = (rune >= 0x30 && rune <= 0x39) ||
+          (rune >= 0x41 && rune <= 0x5A) ||
+          (rune >= 0x61 && rune <= 0x7A) ||
+          rune == 0x27; // '
+      if (isWordChar) {
+        word.writeCharCode(rune);
+        continue;
+      }
+      if (!flushWord()) return null;
+      final ch = String.fromCharCode(rune);
+      if (ch.trim().isEmpty) continue;
+      if (!tokens.contains(ch)) return null;
+      pieces.add(ch);
+    }
+    if (!flushWord()) return null;
+    return pieces.isEmpty ? null : pieces.join(' ');
+  }
+
+  static List<String>? _bpePieces(String word, Set<String> tokens) {
+    final pieces = <String>[];
+    var i = 0;
+    while (i < word.length) {
+      String? hit;
+      for (var end = word.length; end > i; end--) {
+        final piece = (i == 0 ? '▁' : '') + word.substring(i, end);
+        if (tokens.contains(piece)) {
+          hit = piece;
+          i = end;
+          break;
+        }
+      }
+      if (hit == null) {
+        // 词首也可能被切成单独的「▁」+ 子词
+        if (i == 0 && pieces.isEmpty && tokens.contains('▁')) {
+          pieces.add('▁');
+          final rest = _bpeTail(word, tokens);
+          if (rest == null) return null;
+          return pieces..addAll(rest);
+        }
+        return null;
+      }
+      pieces.add(hit);
+    }
+    return pieces;
+  }
 
-    String result = text;
-    for (final entry in entries) {
-      if (entry.wrong.isEmpty || entry.correct.isEmpty) continue;
-      result = result.replaceAll(entry.wrong, entry.correct);
+  static List<String>? _bpeTail(String word, Set<String> tokens) {
+    final pieces = <String>[];
+    var i = 0;
+    while (i < word.length) {
+      var end = word.length;
+      while (end > i && !tokens.contains(word.substring(i, end))) {
+        end--;
+      }
+      if (end == i) return null;
+      pieces.add(word.substring(i, end));
+      i = end;
     }
-    return result;
+    return pieces;
   }
 
   /// Load all industry packs (lazy, called once)
@@ -162,6 +357,7 @@ class VocabService {
     for (final def in _packDefs) {
       await _loadPack(def.id, def.asset, def.nameZh, def.nameEn);
     }
+    _currentMatcher();
   }
 
   /// 按 RFC4180 切一行 CSV：引号内的逗号属于字段本身。
@@ -198,6 +198,27 @@ class _DeveloperPageState extends State<DeveloperPage> {
     }
   }
 
+  Future<void> _exportLatencyTrace(AppLocalizations loc) async {
+    final tracer = AppService().engine.latencyTrace;
+    if (tracer.sessions.isEmpty) {
+      showSettingsInfo(loc.devLatencyTraceEmpty);
+      return;
+    }
+    final path = await FilePicker.platform.saveFile(
+      dialogTitle: loc.devLatencyTrace,
+      fileName: 'speakout_latency_trace.json',
+      allowedExtensions: ['json'],
+      type: FileType.custom,
+    );
+    if (path == null) return;
+    try {
+      await File(path).writeAsString(tracer.toChromeTraceJson());
+      NotificationService().notifySuccess(loc.aboutSystemLogSuccess(path));
+    } catch (e) {
+      NotificationService().notifyError(loc.aboutSystemLogFailed('$e'));
+    }
+  }
+
   Future<String> _buildDiagnostics() async {
     final info = await PackageInfo.fromPlatform();
     final buf = StringBuffer();
@@ -333,6 +354,18 @@ class _DeveloperPageState extends State<DeveloperPage> {
           ),
         ),
         const SettingsDivider(),
+        SettingsTile(
+          label: loc.devLatencyTrace,
+          subtitle: loc.devLatencyTraceDesc,
+          icon: CupertinoIcons.timer,
+          child: PushButton(
+            controlSize: ControlSize.regular,
+            secondary: true,
+            onPressed: () => _exportLatencyTrace(loc),
+            child: Text(loc.aboutExportAction),
+          ),
+        ),
+        const SettingsDivider(),
         SettingsTile(
           label: loc.aboutDiagnostics,
           subtitle: loc.aboutDiagnosticsDesc,
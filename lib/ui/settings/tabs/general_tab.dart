@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:io';
 import 'package:flutter/material.dart';
 import 'package:flutter/cupertino.dart';
 import 'package:macos_ui/macos_ui.dart';
@@ -30,6 +31,13 @@ class _GeneralTabState extends State<GeneralTab> with WidgetsBindingObserver {
   List<AudioDevice> _audioDevices = [];
   AudioDevice? _currentAudioDevice;
   bool _autoManageAudio = true;
+  bool _warmMic = ConfigService().warmMicEnabled;
+  bool _nativeDecode = ConfigService().nativeStreamDecodeEnabled;
+  final String? _asrType = AppService().engine.asrProviderType;
+  late bool _noiseSuppression =
+      _asrType != null && ConfigService().noiseSuppressionEnabledFor(_asrType);
+  bool _autoGain = ConfigService().autoGainEnabled;
+  bool _silenceCompaction = ConfigService().silenceCompactionEnabled;
   bool _useSystemDefaultAudio = true;
 
   // Hotkeys
@@ -554,6 +562,81 @@ class _GeneralTabState extends State<GeneralTab> with WidgetsBindingObserver {
             },
           ),
         ),
+        // 常驻采集目前只有 Linux 库导出
+        if (Platform.isLinux) ...[
+          const SizedBox(height: 12),
+          _settingsRow(
+            label: loc.warmMic,
+            subtitle: loc.warmMicDesc,
+            trailing: MacosSwitch(
+              value: _warmMic,
+              onChanged: (v) async {
+                setState(() => _warmMic = v);
+                await ConfigService().setWarmMicEnabled(v);
+                if (v) {
+                  engine.engine.armWarmMic();
+                } else {
+                  engine.engine.releaseWarmMic();
+                }
+              },
+            ),
+          ),
+          const SizedBox(height: 12),
+          // 下一次录音生效；不支持时（模型不是流式、sherpa 库加载方式不对）自动退回
+          _settingsRow(
+            label: loc.nativeStreamDecode,
+            subtitle: loc.nativeStreamDecodeDesc,
+            trailing: MacosSwitch(
+              value: _nativeDecode,
+              onChanged: (v) async {
+                setState(() => _nativeDecode = v);
+                await ConfigService().setNativeStreamDecodeEnabled(v);
+              },
+            ),
+          ),
+          // 按当前引擎分别记；换了引擎，开关跟着那个引擎自己的设置走
+          if (_asrType != null) ...[
+            const SizedBox(height: 12),
+            _settingsRow(
+              label: loc.noiseSuppression,
+              subtitle: loc.noiseSuppressionDesc,
+              trailing: MacosSwitch(
+                value: _noiseSuppression,
+                onChanged: (v) async {
+                  setState(() => _noiseSuppression = v);
+                  await ConfigService().setNoiseSuppressionFor(_asrType, v);
+                  engine.engine.applyNoiseSuppression();
+                },
+              ),
+            ),
+          ],
+          const SizedBox(height: 12),
+          _settingsRow(
+            label: loc.autoGain,
+            subtitle: loc.autoGainDesc,
+            trailing: MacosSwitch(
+              value: _autoGain,
+              onChanged: (v) async {
+                setState(() => _autoGain = v);
+                await ConfigService().setAutoGainEnabled(v);
+                engine.engine.applyAutoGain();
+              },
+            ),
+          ),
+          const SizedBox(height: 12),
+          _settingsRow(
+            label: loc.silenceCompaction,
+            subtitle: loc.silenceCompactionDesc,
+            trailing: MacosSwitch(
+              value: _silenceCompaction,
+              onChanged: (v) async {
+                setState(() => _silenceCompaction = v);
+                // 下一次录音开始时生效
+                await ConfigService().setSilenceCompactionEnabled(v);
+              },
+            ),
+          ),
+        ],
       ],
     );
   }
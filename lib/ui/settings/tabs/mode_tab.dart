@@ -573,7 +573,7 @@ class ModeTabState extends State<ModeTab> {
   /// 这里只负责把离线模型的路径/类型喂对。
   Future<void> _initAsrForCurrentConfig() async {
     if (ConfigService().workMode == 'cloud') {
-      await _app.initASR(modelPath: '', type: 'aliyun');
+      await _app.initCloudASR();
       return;
     }
     final path = await _app.getActiveModelPath();
@@ -612,7 +612,7 @@ class ModeTabState extends State<ModeTab> {
   /// 否则下拉框显示新账户、引擎还连着旧的，跟 v1.10.0 那批「显示 A 跑 B」同源。
   Future<void> _reinitCloudAsr(String? prevAccountId, String? prevModelId) async {
     try {
-      await _app.initASR(modelPath: '', type: 'aliyun');
+      await _app.initCloudASR();
     } catch (e) {
       // 选择已经落盘了，新账户又起不来 —— 不回滚的话下拉框显示新账户、
       // 引擎却是空的，跟 v1.10.0 那批「显示 A 跑 B」同源。
@@ -635,6 +635,29 @@ class ModeTabState extends State<ModeTab> {
     if (mounted) setState(() {});
   }
 
+  /// 云端 + 本地竞速开关：本地那一路要在 initCloudASR 里一并建，所以切完立刻重建 ASR。
+  /// 起不来（离线模型加载失败）就把开关拨回去，别留一个「开着但引擎是空的」状态
+  Future<void> _switchLocalRace(bool enabled, AppLocalizations loc) async {
+    await ConfigService().setAsrLocalRaceEnabled(enabled);
+    try {
+      await _app.initCloudASR();
+    } catch (e) {
+      await ConfigService().setAsrLocalRaceEnabled(!enabled);
+      await _restoreEngineAfterRollback();
+      if (!mounted) return;
+      setState(() {});
+      if (context.mounted) {
+        showSettingsError(
+            context,
+            _app.isASRReady
+                ? loc.asrSwitchFailed('$e')
+                : loc.asrSwitchFailedNoEngine('$e'));
+      }
+      return;
+    }
+    if (mounted) setState(() {});
+  }
+
   Future<void> _switchWorkMode(String? mode) async {
     if (mode == null) return;
     final oldMode = ConfigService().workMode;
@@ -1526,6 +1549,12 @@ class ModeTabState extends State<ModeTab> {
           )),
         ],
         const SizedBox(height: 6),
+        _compactRow(loc.asrLocalRace, MacosSwitch(
+          value: ConfigService().asrLocalRaceEnabled,
+          onChanged: (v) => _switchLocalRace(v, loc),
+        )),
+        Text(loc.asrLocalRaceDesc, style: AppTheme.caption(context).copyWith(fontSize: 10)),
+        const SizedBox(height: 6),
         GestureDetector(
           onTap: () => SidebarNavigation.of(context)?.goto('cloud_accounts'),
           child: Text('${loc.manageCloudAccounts} ▸', style: TextStyle(fontSize: 11, color: AppTheme.getAccent(context))),
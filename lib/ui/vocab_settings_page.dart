@@ -22,6 +22,7 @@ class _VocabSettingsViewState extends State<VocabSettingsView> {
   late bool _vocabEnabled;
   late Map<String, bool> _packEnabled;
   late bool _userEnabled;
+  late bool _hotwordsSkipLlm;
   List<VocabEntry> _userEntries = [];
 
   @override
@@ -30,6 +31,7 @@ class _VocabSettingsViewState extends State<VocabSettingsView> {
     final config = ConfigService();
     _vocabEnabled = config.vocabEnabled;
     _userEnabled = config.vocabUserEnabled;
+    _hotwordsSkipLlm = config.vocabHotwordsSkipLlm;
     _packEnabled = {
       'tech': config.vocabTechEnabled,
       'medical': config.vocabMedicalEnabled,
@@ -277,6 +279,25 @@ class _VocabSettingsViewState extends State<VocabSettingsView> {
                   _buildCompactPackRow('legal', loc.vocabLegal, CupertinoIcons.book),
                   _buildCompactPackRow('finance', loc.vocabFinance, CupertinoIcons.chart_bar),
                   _buildCompactPackRow('education', loc.vocabEducation, CupertinoIcons.book_circle),
+                  Divider(height: 16, color: AppTheme.getBorder(context)),
+                  Row(
+                    children: [
+                      Expanded(child: Text(loc.vocabHotwordsSkipLlm, style: AppTheme.body(context).copyWith(fontSize: 12))),
+                      MacosSwitch(
+                        value: _hotwordsSkipLlm,
+                        onChanged: (v) async {
+                          await ConfigService().setVocabHotwordsSkipLlm(v);
+                          if (!mounted) return;
+                          setState(() => _hotwordsSkipLlm = v);
+                        },
+                      ),
+                    ],
+                  ),
+                  const SizedBox(height: 4),
+                  Text(
+                    loc.vocabHotwordsSkipLlmNote,
+                    style: AppTheme.caption(context).copyWith(fontSize: 10, color: MacosColors.systemGrayColor),
+                  ),
                 ],
               ),
 
@@ -0,0 +1,241 @@
+/**
+ * 自动增益实现，接口说明见 agc.h。
+ *
+ * 每收满一帧（第 k+1 帧）做三件事：用它的电平更新噪底、噪声门和说话电平，
+ * 算出它该用的增益；再结合第 k、k+1 两帧的峰值定下第 k 帧末尾的增益；
+ * 最后第 k 帧从上一帧末尾的增益线性滑到这个值输出。线性插值的每一点都不超过两端的
+ * 较大者，两端又都按各自相邻帧的峰值限过，所以输出不会超过 ceiling。
+ * 逐样本乘增益包络、统计峰值都走 dsp_kernels 的 SIMD 内核。
+ */
+#include "agc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp_kernels.h"
+
+#define AGC_SILENCE_DB -120.0f
+#define AGC_FLOOR_FALL 0.3f       /* 噪底往下跟得快（每帧走差值的 30%） */
+#define AGC_FLOOR_RISE_DB 0.02f   /* 往上每帧最多 0.02dB（2dB/s）：说话不会把噪底顶上去 */
+#define AGC_GATE_OPEN_DB 9.0f     /* 高出噪底这么多才算有人说话 */
+#define AGC_GATE_CLOSE_DB 5.0f    /* 低于噪底 + 这么多才开始算 hold：两道线之间不来回跳 */
+#define AGC_GATE_FLOOR_DBFS -60.0f /* 数字静音、极安静的环境里门也不会被一丝底噪打开 */
+#define AGC_GATE_HOLD_FRAMES 20   /* 字与字之间的停顿（200ms 以内）不关门 */
+#define AGC_GATE_RELEASE_DB 0.3f  /* 关门后放大部分每帧收回 0.3dB：1 秒左右收完，听不出喘 */
+#define AGC_LEVEL_ATTACK 0.25f    /* 说话电平往上跟得快，往下慢：跟的是包络不是平均 */
+#define AGC_LEVEL_DECAY 0.03f
+#define AGC_GAIN_UP_DB 0.4f       /* 增益每帧最多升 0.4dB（40dB/s） */
+#define AGC_GAIN_DOWN_DB 1.0f     /* 降得更快：宁可一时偏小，不要持续偏大 */
+#define AGC_LIMIT_RELEASE_DB 0.5f /* 限幅器压下去之后每帧回升 0.5dB */
+
+struct Agc {
+    const DspKernels* k;
+    AgcConfig cfg;
+    float ceiling; /* 峰值上限，int16 刻度 */
+
+    int16_t cur[AGC_FRAME_SAMPLES];  /* 正在收的帧 */
+    int fill;
+    int16_t prev[AGC_FRAME_SAMPLES]; /* 收满了、等下一帧峰值才能输出的帧 */
+    int32_t prevPeak;
+    float ramp[AGC_FRAME_SAMPLES];
+    float gStart; /* 上一帧输出末尾的总增益（线性）；< 0 表示还没输出过 */
+
+    float noiseDb;
+    float speechDb;
+    int speechKnown;
+    int gateOpen;
+    int hold;
+    float gainDb;  /* 跟踪器的增益 */
+    float gateDb;  /* 噪声门收回的部分，<= 0 */
+    float limDb;   /* 限幅器当前压掉的，<= 0 */
+    int frozen;    /* agc_flush 补零期间不更新估计 */
+
+    AgcTracePoint trace[AGC_TRACE_FRAMES];
+    long long frames;
+};
+
+static float db_to_lin(float db) { return powf(10.0f, db / 20.0f); }
+
+static float clampf(float v, float lo, float hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+void agc_default_config(AgcConfig* cfg) {
+    cfg->targetDbfs = -20.0f;
+    cfg->maxGainDb = 30.0f;
+    cfg->minGainDb = -10.0f;
+    cfg->ceilingDbfs = -1.0f;
+}
+
+Agc* agc_create(const AgcConfig* cfg) {
+    Agc* agc = calloc(1, sizeof(Agc));
+    if (!agc) return NULL;
+    agc->k = dsp_kernels();
+    if (cfg) agc->cfg = *cfg;
+    else agc_default_config(&agc->cfg);
+    if (agc->cfg.minGainDb > 0) agc->cfg.minGainDb = 0;
+    if (agc->cfg.maxGainDb < agc->cfg.minGainDb) agc->cfg.maxGainDb = agc->cfg.minGainDb;
+    agc->ceiling = 32768.0f * db_to_lin(clampf(agc->cfg.ceilingDbfs, -30.0f, 0.0f));
+    if (agc->ceiling > 32767.0f) agc->ceiling = 32767.0f;
+    agc_reset(agc);
+    return agc;
+}
+
+void agc_free(Agc* agc) { free(agc); }
+
+void agc_reset(Agc* agc) {
+    if (!agc) return;
+    /* 开头垫一帧静音当「上一帧」：整帧喂进来时输出个数就和输入一样，延迟固定一帧 */
+    memset(agc->prev, 0, sizeof(agc->prev));
+    agc->prevPeak = 0;
+    agc->fill = 0;
+    agc->gStart = -1.0f;
+    agc->noiseDb = AGC_SILENCE_DB;
+    agc->gateOpen = 0;
+    agc->hold = 0;
+    agc->limDb = 0;
+    agc->frozen = 0;
+    agc->frames = 0;
+    agc_seed(agc, 0.0f);
+    agc->speechKnown = 0; /* 第一帧有声音时直接当作说话电平 */
+}
+
+void agc_seed(Agc* agc, float gainDb) {
+    if (!agc) return;
+    agc->gainDb = clampf(gainDb, agc->cfg.minGainDb, agc->cfg.maxGainDb);
+    agc->speechDb = agc->cfg.targetDbfs - agc->gainDb;
+    agc->speechKnown = 1;
+    /* 门按关着算：开录到开口之间的底噪不先被放大 */
+    agc->gateDb = agc->gateOpen || agc->gainDb < 0 ? 0.0f : -agc->gainDb;
+}
+
+float agc_gain_db(const Agc* agc) { return agc ? agc->gainDb : 0.0f; }
+
+long long agc_frame_count(const Agc* agc) { return agc ? agc->frames : 0; }
+
+/* 用第 k+1 帧（cur）更新估计，返回它的增益（dB，含噪声门） */
+static float agc_track(Agc* agc, float levelDb) {
+    if (agc->frozen) return agc->gainDb + agc->gateDb;
+
+    if (agc->frames == 0) {
+        agc->noiseDb = levelDb; /* 第一帧直接落成噪底：按键到开口之间总有一点空 */
+    } else if (levelDb < agc->noiseDb) {
+        agc->noiseDb += AGC_FLOOR_FALL * (levelDb - agc->noiseDb);
+        if (agc->noiseDb - levelDb < 0.01f) agc->noiseDb = levelDb;
+    } else {
+        agc->noiseDb += fminf(levelDb - agc->noiseDb, AGC_FLOOR_RISE_DB);
+    }
+
+    float openAt = fmaxf(agc->noiseDb + AGC_GATE_OPEN_DB, AGC_GATE_FLOOR_DBFS);
+    float closeAt = fmaxf(agc->noiseDb + AGC_GATE_CLOSE_DB, AGC_GATE_FLOOR_DBFS - 4.0f);
+    int voiced = levelDb >= openAt;
+    if (voiced) {
+        agc->gateOpen = 1;
+        agc->hold = AGC_GATE_HOLD_FRAMES;
+    } else if (agc->gateOpen && levelDb < closeAt) {
+        if (agc->hold > 0) agc->hold--;
+        else agc->gateOpen = 0;
+    }
+
+    if (voiced) {
+        if (!agc->speechKnown) {
+            agc->speechDb = levelDb;
+            agc->speechKnown = 1;
+        } else {
+            float c = levelDb > agc->speechDb ? AGC_LEVEL_ATTACK : AGC_LEVEL_DECAY;
+            agc->speechDb += c * (levelDb - agc->speechDb);
+        }
+    }
+    if (agc->gateOpen) {
+        float want = clampf(agc->cfg.targetDbfs - agc->speechDb, agc->cfg.minGainDb, agc->cfg.maxGainDb);
+        agc->gainDb += clampf(want - agc->gainDb, -AGC_GAIN_DOWN_DB, AGC_GAIN_UP_DB);
+        /* 开门不用爬：前瞻一帧，这一跳摊在前面那帧停顿里 */
+        agc->gateDb = 0;
+    } else {
+        float want = agc->gainDb > 0 ? -agc->gainDb : 0.0f;
+        agc->gateDb += clampf(want - agc->gateDb, -AGC_GATE_RELEASE_DB, AGC_GATE_RELEASE_DB);
+    }
+    return agc->gainDb + agc->gateDb;
+}
+
+/* cur 收满：定下 prev 末尾的增益，把 prev 输出到 out，cur 变成新的 prev */
+static void agc_frame(Agc* agc, int16_t* out) {
+    const int n = AGC_FRAME_SAMPLES;
+    DspStats st;
+    agc->k->stats_i16(agc->cur, n, &st);
+    double rms = dsp_stats_rms(&st, n);
+    float levelDb = rms > 1e-6 ? (float)(20.0 * log10(rms)) : AGC_SILENCE_DB;
+    float gainDb = agc_track(agc, levelDb);
+    float g = db_to_lin(gainDb);
+
+    /* 第 k 帧末尾 = 第 k+1 帧开头，两帧的峰值都不能被这个增益推过上限 */
+    int32_t peak = st.peak > agc->prevPeak ? st.peak : agc->prevPeak;
+    float needDb = 0;
+    if (peak > 0 && peak * g > agc->ceiling) needDb = 20.0f * log10f(agc->ceiling / (peak * g));
+    agc->limDb = fminf(needDb, fminf(agc->limDb + AGC_LIMIT_RELEASE_DB, 0.0f));
+    float gEnd = g * db_to_lin(agc->limDb);
+    /* 乘回去的舍入可能让它比真正的上限高一丝：照峰值再夹一次 */
+    if (peak > 0 && peak * gEnd > agc->ceiling) gEnd = agc->ceiling / peak;
+
+    float g0 = agc->gStart < 0 ? gEnd : agc->gStart;
+    float step = (gEnd - g0) / n;
+    for (int i = 0; i < n; i++) agc->ramp[i] = g0 + step * (float)(i + 1);
+    memcpy(out, agc->prev, sizeof(agc->prev));
+    agc->k->mul_i16(out, agc->ramp, n);
+    agc->gStart = gEnd;
+
+    memcpy(agc->prev, agc->cur, sizeof(agc->cur));
+    agc->prevPeak = st.peak;
+    if (!agc->frozen) {
+        AgcTracePoint* p = &agc->trace[agc->frames % AGC_TRACE_FRAMES];
+        p->levelDbfs = levelDb;
+        p->gainDb = gainDb;
+        p->limiterDb = agc->limDb;
+        p->gateOpen = agc->gateOpen;
+        agc->frames++;
+    }
+}
+
+int agc_process(Agc* agc, const int16_t* in, int16_t* out, int n) {
+    int done = 0, written = 0;
+    while (done < n) {
+        int take = AGC_FRAME_SAMPLES - agc->fill;
+        if (take > n - done) take = n - done;
+        memcpy(agc->cur + agc->fill, in + done, sizeof(int16_t) * take);
+        agc->fill += take;
+        done += take;
+        if (agc->fill == AGC_FRAME_SAMPLES) {
+            agc_frame(agc, out + written);
+            written += AGC_FRAME_SAMPLES;
+            agc->fill = 0;
+        }
+    }
+    return written;
+}
+
+int agc_flush(Agc* agc, int16_t* out) {
+    if (!agc) return 0;
+    int partial = agc->fill;
+    /* 半帧补零凑成整帧，吐出 prev；估计冻结，补的零不算进噪底和轨迹 */
+    memset(agc->cur + partial, 0, sizeof(int16_t) * (AGC_FRAME_SAMPLES - partial));
+    agc->frozen = 1;
+    agc_frame(agc, out);
+    agc->frozen = 0;
+    agc->fill = 0;
+    /* 半帧用 prev 末尾的增益：那个值已经按它的峰值限过 */
+    memcpy(out + AGC_FRAME_SAMPLES, agc->prev, sizeof(int16_t) * partial);
+    agc->k->gain_i16(out + AGC_FRAME_SAMPLES, partial, agc->gStart);
+    memset(agc->prev, 0, sizeof(agc->prev));
+    agc->prevPeak = 0;
+    return AGC_FRAME_SAMPLES + partial;
+}
+
+int agc_trace(const Agc* agc, long long since, AgcTracePoint* out, int max) {
+    if (!agc || max <= 0) return 0;
+    long long from = since > 0 ? since : 0;
+    if (from < agc->frames - AGC_TRACE_FRAMES) from = agc->frames - AGC_TRACE_FRAMES;
+    int count = 0;
+    for (long long i = from; i < agc->frames && count < max; i++) {
+        out[count++] = agc->trace[i % AGC_TRACE_FRAMES];
+    }
+    return count;
+}
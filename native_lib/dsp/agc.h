@@ -0,0 +1,80 @@
+/**
+ * 自动增益：说话电平跟踪 + 噪声门 + 前瞻限幅。
+ *
+ * 16kHz 单声道 int16，按 10ms（AGC_FRAME_SAMPLES）一帧处理。远场笔记本麦克风、
+ * 说话轻的人进来的电平常在 -45dBFS 上下，识别模型和 Dart 侧的静音判断都吃不准；
+ * 这一级把说话段拉到 targetDbfs 附近。
+ *
+ * - 电平跟踪只在噪声门开着时更新，增益按速率上限慢慢挪，不会一个字一个字地跳。
+ * - 噪声门：帧电平比噪底高出一截才算开，关要低于更低的一道线并且熬过 hold；
+ *   门关着增益冻结，只把「放大」这部分慢慢收回来 —— 停顿里的底噪不跟着增益一起抬，
+ *   也不会一停就忽上忽下地「喘」。
+ * - 限幅器前瞻一帧：输出第 k 帧时已经看到了第 k+1 帧的峰值，增益在这一帧里线性
+ *   滑下去，不削波、也没有硬切的咔哒声。代价是输出比输入晚一帧。
+ *
+ * 所有状态都在 Agc 里，create 之后不再分配内存；不是线程安全的，一个实例只给一个采集线程用。
+ */
+#ifndef SPEAKOUT_AGC_H
+#define SPEAKOUT_AGC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGC_FRAME_SAMPLES 160 /* 10ms */
+#define AGC_TRACE_FRAMES 512  /* 增益轨迹保留最近 5 秒多 */
+
+typedef struct {
+    float targetDbfs;   /* 说话段帧 RMS 的目标，默认 -20 */
+    float maxGainDb;    /* 最多放大，默认 30 */
+    float minGainDb;    /* 最多衰减（负数），默认 -10 */
+    float ceilingDbfs;  /* 限幅上限（峰值），默认 -1 */
+} AgcConfig;
+
+/* 每帧一个点，调试用 */
+typedef struct {
+    float levelDbfs;  /* 输入帧 RMS */
+    float gainDb;     /* 跟踪器给的增益（含噪声门收回的部分），不含限幅 */
+    float limiterDb;  /* 限幅器额外压掉的，<= 0 */
+    int gateOpen;
+} AgcTracePoint;
+
+typedef struct Agc Agc;
+
+void agc_default_config(AgcConfig* cfg);
+
+/* cfg 为 NULL 时用默认值 */
+Agc* agc_create(const AgcConfig* cfg);
+void agc_free(Agc* agc);
+
+/* 清空延迟、噪底和电平估计，增益回到 0dB */
+void agc_reset(Agc* agc);
+
+/* 预置增益（比如上一次录音结束时的值），省掉开头那段爬坡 */
+void agc_seed(Agc* agc, float gainDb);
+
+/* 当前增益（不含限幅），dB */
+float agc_gain_db(const Agc* agc);
+
+/* in → out，返回写出的样本数。整帧整帧地出：每收满一帧，吐出上一帧，
+ * 所以 out 的容量至少 n + AGC_FRAME_SAMPLES；输入按整帧喂时写出的正好是 n。
+ * in 与 out 不能是同一块内存。 */
+int agc_process(Agc* agc, const int16_t* in, int16_t* out, int n);
+
+/* 录音结束：吐出还压着的上一帧和没收满的半帧（最多 2 × AGC_FRAME_SAMPLES），返回个数 */
+int agc_flush(Agc* agc, int16_t* out);
+
+/* 累计处理过的帧数（轨迹点的序号从 0 开始） */
+long long agc_frame_count(const Agc* agc);
+
+/* 序号 >= since 的轨迹点按时间顺序写进 out，最多 max 个，返回个数。
+ * 只保留最近 AGC_TRACE_FRAMES 个，更早的已经被覆盖，直接跳过。 */
+int agc_trace(const Agc* agc, long long since, AgcTracePoint* out, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_AGC_H */
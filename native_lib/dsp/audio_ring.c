@@ -0,0 +1,169 @@
+/**
+ * 多读者采集 ring 实现，接口说明见 audio_ring.h。
+ *
+ * 写者：reserved = w + n（release 栅栏）→ 拷数据 → written = w + n（release）。
+ * 读者：acquire 读 written → 拷数据 → acquire 栅栏 → 读 reserved。
+ * 序号 < reserved - capacity 的槽位在拷的时候可能已经被写者改了，丢掉算 overrun；
+ * 其余的一定是完整的旧值。游标用 CAS 推进：audio_ring_reset 在中途把它归零的话 CAS 失败，
+ * 这次读的东西属于上一次录音，整批作废。
+ */
+#include "audio_ring.h"
+
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+/* Interlocked 系列在 x64 / ARM64 上都是全屏障，acquire / release 一并满足 */
+static uint64_t ar_load(const volatile uint64_t* p) {
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+}
+static void ar_store(volatile uint64_t* p, uint64_t v) { _InterlockedExchange64((volatile __int64*)p, (__int64)v); }
+static int ar_cas(volatile uint64_t* p, uint64_t expect, uint64_t v) {
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, (__int64)v, (__int64)expect) == expect;
+}
+static void ar_add(volatile uint64_t* p, uint64_t v) { _InterlockedExchangeAdd64((volatile __int64*)p, (__int64)v); }
+static int ar_claim(volatile int32_t* p) { return _InterlockedCompareExchange((volatile long*)p, 1, 0) == 0; }
+static void ar_release_slot(volatile int32_t* p) { _InterlockedExchange((volatile long*)p, 0); }
+static int ar_active(const volatile int32_t* p) { return _InterlockedCompareExchange((volatile long*)p, 0, 0) != 0; }
+static void ar_fence_release(void) { _ReadWriteBarrier(); }
+static void ar_fence_acquire(void) { _ReadWriteBarrier(); }
+#else
+static uint64_t ar_load(const volatile uint64_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static void ar_store(volatile uint64_t* p, uint64_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static int ar_cas(volatile uint64_t* p, uint64_t expect, uint64_t v) {
+    return __atomic_compare_exchange_n(p, &expect, v, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static void ar_add(volatile uint64_t* p, uint64_t v) { __atomic_fetch_add(p, v, __ATOMIC_RELAXED); }
+static int ar_claim(volatile int32_t* p) {
+    int32_t expect = 0;
+    return __atomic_compare_exchange_n(p, &expect, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static void ar_release_slot(volatile int32_t* p) { __atomic_store_n(p, 0, __ATOMIC_RELEASE); }
+static int ar_active(const volatile int32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE) != 0; }
+static void ar_fence_release(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+static void ar_fence_acquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+#endif
+
+void audio_ring_init(AudioRing* r, int16_t* storage, int capacity) {
+    memset(r, 0, sizeof(*r));
+    r->buf = storage;
+    r->capacity = (uint64_t)capacity;
+    r->readers[AUDIO_RING_DEFAULT_READER].active = 1;
+}
+
+void audio_ring_reset(AudioRing* r) {
+    ar_store(&r->reserved, 0);
+    ar_store(&r->written, 0);
+    for (int i = 0; i < AUDIO_RING_MAX_READERS; i++) {
+        ar_store(&r->readers[i].cursor, 0);
+        ar_store(&r->readers[i].overrun, 0);
+    }
+}
+
+/* 序号 [pos, pos + n) 拷进 out，按容量回绕，n <= capacity */
+static void ar_copy_out(const AudioRing* r, uint64_t pos, int16_t* out, int n) {
+    uint64_t head = pos % r->capacity;
+    uint64_t first = r->capacity - head < (uint64_t)n ? r->capacity - head : (uint64_t)n;
+    memcpy(out, r->buf + head, sizeof(int16_t) * first);
+    if (first < (uint64_t)n) memcpy(out + first, r->buf, sizeof(int16_t) * (n - first));
+}
+
+void audio_ring_write(AudioRing* r, const int16_t* samples, int count) {
+    if (count <= 0) return;
+    uint64_t w = r->written; /* 只有写者改它 */
+    uint64_t end = w + (uint64_t)count;
+    /* 一次写超过容量：前面的反正会被后面的覆盖，只拷最后 capacity 个 */
+    if ((uint64_t)count > r->capacity) {
+        samples += (uint64_t)count - r->capacity;
+        w = end - r->capacity;
+        count = (int)r->capacity;
+    }
+    ar_store(&r->reserved, end);
+    ar_fence_release();
+    uint64_t head = w % r->capacity;
+    uint64_t first = r->capacity - head < (uint64_t)count ? r->capacity - head : (uint64_t)count;
+    memcpy(r->buf + head, samples, sizeof(int16_t) * first);
+    if (first < (uint64_t)count) memcpy(r->buf, samples + first, sizeof(int16_t) * (count - first));
+    ar_store(&r->written, end);
+}
+
+uint64_t audio_ring_written(const AudioRing* r) { return ar_load(&r->written); }
+
+static int ar_valid(const AudioRing* r, int reader) {
+    return reader >= 0 && reader < AUDIO_RING_MAX_READERS && ar_active(&r->readers[reader].active);
+}
+
+int audio_ring_register(AudioRing* r, int from) {
+    for (int i = 1; i < AUDIO_RING_MAX_READERS; i++) {
+        AudioRingReader* rd = &r->readers[i];
+        if (!ar_claim(&rd->active)) continue;
+        uint64_t w = ar_load(&r->written);
+        uint64_t start = w;
+        if (from == AUDIO_RING_FROM_OLDEST) start = w > r->capacity ? w - r->capacity : 0;
+        ar_store(&rd->overrun, 0);
+        ar_store(&rd->cursor, start);
+        return i;
+    }
+    return -1;
+}
+
+void audio_ring_unregister(AudioRing* r, int reader) {
+    if (reader <= AUDIO_RING_DEFAULT_READER || reader >= AUDIO_RING_MAX_READERS) return;
+    ar_release_slot(&r->readers[reader].active);
+}
+
+int audio_ring_available(AudioRing* r, int reader) {
+    if (!ar_valid(r, reader)) return 0;
+    uint64_t w = ar_load(&r->written);
+    uint64_t rp = ar_load(&r->readers[reader].cursor);
+    if (w <= rp) return 0;
+    return w - rp > r->capacity ? (int)r->capacity : (int)(w - rp);
+}
+
+int audio_ring_read(AudioRing* r, int reader, int16_t* out, int max) {
+    if (!out || max <= 0 || !ar_valid(r, reader)) return 0;
+    AudioRingReader* rd = &r->readers[reader];
+    uint64_t w = ar_load(&r->written);
+    uint64_t rp = ar_load(&rd->cursor);
+    if (w <= rp) return 0; /* 没有新的，或者刚 reset 过 */
+
+    uint64_t start = rp, lost = 0;
+    if (w - rp > r->capacity) {
+        start = w - r->capacity;
+        lost = start - rp;
+    }
+    int n = w - start < (uint64_t)max ? (int)(w - start) : max;
+    ar_copy_out(r, start, out, n);
+    ar_fence_acquire();
+
+    /* 拷的时候写者可能已经绕回来改了开头那一截 */
+    uint64_t res = ar_load(&r->reserved);
+    if (res > r->capacity && start < res - r->capacity) {
+        uint64_t bad = res - r->capacity - start;
+        if (bad > (uint64_t)n) bad = (uint64_t)n;
+        memmove(out, out + bad, sizeof(int16_t) * (size_t)(n - bad));
+        n -= (int)bad;
+        start += bad;
+        lost += bad;
+    }
+    if (!ar_cas(&rd->cursor, rp, start + (uint64_t)n)) return 0;
+    if (lost) ar_add(&rd->overrun, lost);
+    return n;
+}
+
+long long audio_ring_overrun(const AudioRing* r, int reader) {
+    if (reader < 0 || reader >= AUDIO_RING_MAX_READERS || !ar_active(&r->readers[reader].active)) return -1;
+    return (long long)ar_load(&r->readers[reader].overrun);
+}
+
+int audio_ring_latest(AudioRing* r, int16_t* out, int count) {
+    if (!out || count <= 0 || (uint64_t)count > r->capacity) return 0;
+    uint64_t w = ar_load(&r->written);
+    if (w < (uint64_t)count) return 0;
+    uint64_t start = w - (uint64_t)count;
+    ar_copy_out(r, start, out, count);
+    ar_fence_acquire();
+    uint64_t res = ar_load(&r->reserved);
+    if (res > r->capacity && start < res - r->capacity) return 0;
+    return count;
+}
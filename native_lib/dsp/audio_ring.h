@@ -0,0 +1,86 @@
+/**
+ * 采集 ring：一个写者（采集线程），多个读者，每个读者一个自己的读位置。
+ *
+ * 以前 ring 只有一个读位置，谁读谁推进：native 解码线程活着时 Dart 就不能再轮询，
+ * macOS 存调试 WAV 得另记一个 recordingStartPos 绕开被 ASR 读走的那段。
+ * 再加一个读者（VAD、落盘、质量分析、第二路识别）就得互相抢样本。
+ * 现在每个读者 audio_ring_register 一个游标，各读各的；慢的读者被写者追上只丢它自己的，
+ * 丢了多少记在它自己的 overrun 里，别的读者不受影响。
+ *
+ * 写者不等任何读者：写之前先公布「要写到哪」（reserved），写完再公布 written。
+ * 读者拷完之后再看一眼 reserved，拷的过程中被覆盖掉的那一截当作丢了，不交给调用方 ——
+ * 不用锁，读者也就卡不住采集线程。
+ *
+ * 位置都是从 audio_ring_reset 起算的样本序号（单调递增，不回绕）。
+ * 0 号读者是「默认读者」，一直在：read_audio_buffer / get_available_audio_samples 用它。
+ *
+ * 三个平台共用这一份（macOS .m、Linux C、Windows MSVC），原子操作在 .c 里按编译器分开写。
+ */
+#ifndef SPEAKOUT_AUDIO_RING_H
+#define SPEAKOUT_AUDIO_RING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_RING_MAX_READERS 8
+#define AUDIO_RING_DEFAULT_READER 0
+
+enum {
+    AUDIO_RING_FROM_NOW = 0,    /* 从当前写位置开始，只看之后写进来的 */
+    AUDIO_RING_FROM_OLDEST = 1, /* 从 ring 里还留着的最早一个样本开始（录音不超过容量时就是开头） */
+};
+
+/* 读者槽，字段只给 audio_ring.c 用 */
+typedef struct {
+    volatile uint64_t cursor;  /* 下一个要读的样本序号 */
+    volatile uint64_t overrun; /* 被写者追上丢掉的样本数 */
+    volatile int32_t active;
+} AudioRingReader;
+
+/* 状态放在调用方的静态变量里（不分配内存），字段只给 audio_ring.c 用 */
+typedef struct {
+    int16_t* buf;
+    uint64_t capacity;
+    volatile uint64_t written;  /* [0, written) 已经写完 */
+    volatile uint64_t reserved; /* 写者正在写 [written, reserved) */
+    AudioRingReader readers[AUDIO_RING_MAX_READERS];
+} AudioRing;
+
+/* storage 至少 capacity 个样本。0 号读者就此注册好 */
+void audio_ring_init(AudioRing* r, int16_t* storage, int capacity);
+
+/* 新一次录音：写位置和所有读者的游标归零、overrun 清零。
+ * 不能和写者并发（采集线程还没起来 / 持有写者那边的锁时调用）；
+ * 和读者并发没关系，正在读的那一次会返回 0。 */
+void audio_ring_reset(AudioRing* r);
+
+/* 只能一个线程写 */
+void audio_ring_write(AudioRing* r, const int16_t* samples, int count);
+
+/* 已写完的样本总数（自 reset 起） */
+uint64_t audio_ring_written(const AudioRing* r);
+
+/* 注册一个读者，返回编号（1..AUDIO_RING_MAX_READERS-1），槽满返回 -1。from 见 AUDIO_RING_FROM_* */
+int audio_ring_register(AudioRing* r, int from);
+void audio_ring_unregister(AudioRing* r, int reader);
+
+/* 这个读者还没读的样本数（最多 capacity） */
+int audio_ring_available(AudioRing* r, int reader);
+
+/* 读最多 max 个，返回个数。同一个读者同一时刻只能有一个线程在读 */
+int audio_ring_read(AudioRing* r, int reader, int16_t* out, int max);
+
+/* 这个读者累计丢掉的样本数；读者编号无效返回 -1 */
+long long audio_ring_overrun(const AudioRing* r, int reader);
+
+/* 不占游标，拷最新的 count 个（电平表用），返回拷到的个数：不够 count 或者拷的时候被覆盖了返回 0 */
+int audio_ring_latest(AudioRing* r, int16_t* out, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_AUDIO_RING_H */
@@ -0,0 +1,598 @@
+/**
+ * DSP 内核的各个变体和运行时分派，接口说明见 dsp_kernels.h。
+ *
+ * 不用 -mavx2 之类的全局编译选项：那样整个库都可能被编成 AVX2 指令，
+ * 在老 CPU 上一加载就 SIGILL。AVX2 变体逐个函数标 target("avx2")，
+ * 只有 CPUID 报告支持时才会被调到；SSE2 是 x86-64 基线，NEON 是 arm64 基线。
+ * MSVC 不需要标注，内建函数随时可用。
+ */
+#include "dsp_kernels.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DSP_HAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DSP_TARGET_AVX2
+#else
+#define DSP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define DSP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+static int popcount32(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return (int)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// ============================================================
+// 标量参考实现
+// ============================================================
+
+static void scalar_i16_to_f32(const int16_t* in, float* out, int n) {
+    for (int i = 0; i < n; i++) out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+static void scalar_f32_to_i16(const float* in, int16_t* out, int n) {
+    for (int i = 0; i < n; i++) {
+        float s = in[i];
+        /* 写成 !(s >= -1) 让 NaN 也落到 -1，和 SIMD 的 max/min 行为一致 */
+        if (!(s >= -1.0f)) s = -1.0f;
+        if (s > 1.0f) s = 1.0f;
+        out[i] = (int16_t)(s * 32767.0f);
+    }
+}
+
+static void scalar_gain_f32(float* x, int n, float gain) {
+    for (int i = 0; i < n; i++) x[i] *= gain;
+}
+
+static void scalar_gain_i16(int16_t* x, int n, float gain) {
+    for (int i = 0; i < n; i++) {
+        float v = x[i] * gain;
+        if (!(v >= -32768.0f)) v = -32768.0f;
+        if (v > 32767.0f) v = 32767.0f;
+        x[i] = (int16_t)lrintf(v);
+    }
+}
+
+/* 累加进已有的统计（SIMD 变体处理尾巴时复用） */
+static void stats_accumulate(const int16_t* x, int n, DspStats* s) {
+    for (int i = 0; i < n; i++) {
+        int32_t v = x[i];
+        s->sumSquares += (uint64_t)(v * v);
+        int32_t a = v < 0 ? -v : v;
+        if (a > s->peak) s->peak = a;
+        if (a >= DSP_CLIP_LEVEL) s->clipped++;
+    }
+}
+
+static void scalar_stats_i16(const int16_t* x, int n, DspStats* out) {
+    memset(out, 0, sizeof(*out));
+    stats_accumulate(x, n, out);
+}
+
+static float scalar_dot_f32(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+static void scalar_mul_f32(float* x, const float* w, int n) {
+    for (int i = 0; i < n; i++) x[i] *= w[i];
+}
+
+static void scalar_mul_i16(int16_t* x, const float* g, int n) {
+    for (int i = 0; i < n; i++) {
+        float v = x[i] * g[i];
+        if (!(v >= -32768.0f)) v = -32768.0f;
+        if (v > 32767.0f) v = 32767.0f;
+        x[i] = (int16_t)lrintf(v);
+    }
+}
+
+static const DspKernels kScalar = {
+    "scalar",
+    scalar_i16_to_f32,
+    scalar_f32_to_i16,
+    scalar_gain_f32,
+    scalar_gain_i16,
+    scalar_stats_i16,
+    scalar_dot_f32,
+    scalar_mul_f32,
+    scalar_mul_i16,
+};
+
+// ============================================================
+// SSE2（x86-64 基线）
+// ============================================================
+#ifdef DSP_HAVE_X86
+
+/* int16 × 8 → 两组 int32 × 4（符号扩展；SSE2 没有 cvtepi16_epi32） */
+#define SSE2_WIDEN_LO(v) _mm_srai_epi32(_mm_unpacklo_epi16((v), (v)), 16)
+#define SSE2_WIDEN_HI(v) _mm_srai_epi32(_mm_unpackhi_epi16((v), (v)), 16)
+
+static void sse2_i16_to_f32(const int16_t* in, float* out, int n) {
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_LO(v)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_HI(v)), scale));
+    }
+    scalar_i16_to_f32(in + i, out + i, n - i);
+}
+
+static void sse2_f32_to_i16(const float* in, int16_t* out, int n) {
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), k = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        /* max 的 NaN 返回第二个操作数：NaN → -1 */
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi);
+        __m128i ia = _mm_cvttps_epi32(_mm_mul_ps(a, k));
+        __m128i ib = _mm_cvttps_epi32(_mm_mul_ps(b, k));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(ia, ib));
+    }
+    scalar_f32_to_i16(in + i, out + i, n - i);
+}
+
+static void sse2_gain_f32(float* x, int n, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), g));
+    scalar_gain_f32(x + i, n - i, gain);
+}
+
+static void sse2_gain_i16(int16_t* x, int n, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(x + i));
+        __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_LO(v)), g);
+        __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_HI(v)), g);
+        /* 先在浮点里夹住：超出 int32 的值 cvtps 会变成 0x80000000，pack 后符号就反了 */
+        a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+        b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+        _mm_storeu_si128((__m128i*)(x + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    scalar_gain_i16(x + i, n - i, gain);
+}
+
+static void sse2_stats_i16(const int16_t* x, int n, DspStats* out) {
+    memset(out, 0, sizeof(*out));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i clipHi = _mm_set1_epi16(DSP_CLIP_LEVEL - 1);
+    const __m128i clipLo = _mm_set1_epi16(-(DSP_CLIP_LEVEL - 1));
+    __m128i sum = zero;
+    __m128i vmax = _mm_set1_epi16(INT16_MIN);
+    __m128i vmin = _mm_set1_epi16(INT16_MAX);
+    int clipped = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(x + i));
+        /* 相邻两个平方之和最大 2^31，按无符号零扩展到 64 位再累加 */
+        __m128i sq = _mm_madd_epi16(v, v);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(sq, zero));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(sq, zero));
+        vmax = _mm_max_epi16(vmax, v);
+        vmin = _mm_min_epi16(vmin, v);
+        __m128i clip = _mm_or_si128(_mm_cmpgt_epi16(v, clipHi), _mm_cmplt_epi16(v, clipLo));
+        clipped += popcount32((uint32_t)_mm_movemask_epi8(clip)) / 2;
+    }
+    if (i > 0) {
+        uint64_t lanes[2];
+        int16_t maxs[8], mins[8];
+        _mm_storeu_si128((__m128i*)lanes, sum);
+        _mm_storeu_si128((__m128i*)maxs, vmax);
+        _mm_storeu_si128((__m128i*)mins, vmin);
+        out->sumSquares = lanes[0] + lanes[1];
+        for (int k = 0; k < 8; k++) {
+            if (maxs[k] > out->peak) out->peak = maxs[k];
+            if (-(int32_t)mins[k] > out->peak) out->peak = -(int32_t)mins[k];
+        }
+        out->clipped = clipped;
+    }
+    stats_accumulate(x + i, n - i, out);
+}
+
+static float sse2_dot_f32(const float* a, const float* b, int n) {
+    __m128 acc = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_dot_f32(a + i, b + i, n - i);
+}
+
+static void sse2_mul_f32(float* x, const float* w, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(w + i)));
+    }
+    scalar_mul_f32(x + i, w + i, n - i);
+}
+
+static void sse2_mul_i16(int16_t* x, const float* g, int n) {
+    const __m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(x + i));
+        __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_LO(v)), _mm_loadu_ps(g + i));
+        __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_HI(v)), _mm_loadu_ps(g + i + 4));
+        a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+        b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+        _mm_storeu_si128((__m128i*)(x + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    scalar_mul_i16(x + i, g + i, n - i);
+}
+
+static const DspKernels kSse2 = {
+    "sse2",
+    sse2_i16_to_f32,
+    sse2_f32_to_i16,
+    sse2_gain_f32,
+    sse2_gain_i16,
+    sse2_stats_i16,
+    sse2_dot_f32,
+    sse2_mul_f32,
+    sse2_mul_i16,
+};
+
+// ============================================================
+// AVX2（运行时探测）
+// ============================================================
+
+DSP_TARGET_AVX2 static void avx2_i16_to_f32(const int16_t* in, float* out, int n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i + 8)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    scalar_i16_to_f32(in + i, out + i, n - i);
+}
+
+DSP_TARGET_AVX2 static void avx2_f32_to_i16(const float* in, int16_t* out, int n) {
+    const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f);
+    const __m256 k = _mm256_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), lo), hi);
+        __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), lo), hi);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(a, k)),
+                                            _mm256_cvttps_epi32(_mm256_mul_ps(b, k)));
+        /* packs 在两个 128 位半边里各自交错，换回顺序 */
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    scalar_f32_to_i16(in + i, out + i, n - i);
+}
+
+DSP_TARGET_AVX2 static void avx2_gain_f32(float* x, int n, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), g));
+    }
+    scalar_gain_f32(x + i, n - i, gain);
+}
+
+DSP_TARGET_AVX2 static void avx2_gain_i16(int16_t* x, int n, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    const __m256 lo = _mm256_set1_ps(-32768.0f), hi = _mm256_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(x + i))));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(x + i + 8))));
+        a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, g), lo), hi);
+        b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, g), lo), hi);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i*)(x + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    scalar_gain_i16(x + i, n - i, gain);
+}
+
+DSP_TARGET_AVX2 static void avx2_stats_i16(const int16_t* x, int n, DspStats* out) {
+    memset(out, 0, sizeof(*out));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i clipHi = _mm256_set1_epi16(DSP_CLIP_LEVEL - 1);
+    const __m256i clipLo = _mm256_set1_epi16(-(DSP_CLIP_LEVEL - 1));
+    __m256i sum = zero;
+    __m256i vmax = _mm256_set1_epi16(INT16_MIN);
+    __m256i vmin = _mm256_set1_epi16(INT16_MAX);
+    int clipped = 0;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(x + i));
+        __m256i sq = _mm256_madd_epi16(v, v);
+        sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(sq, zero));
+        sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(sq, zero));
+        vmax = _mm256_max_epi16(vmax, v);
+        vmin = _mm256_min_epi16(vmin, v);
+        __m256i clip = _mm256_or_si256(_mm256_cmpgt_epi16(v, clipHi),
+                                       _mm256_cmpgt_epi16(clipLo, v));
+        clipped += popcount32((uint32_t)_mm256_movemask_epi8(clip)) / 2;
+    }
+    if (i > 0) {
+        uint64_t lanes[4];
+        int16_t maxs[16], mins[16];
+        _mm256_storeu_si256((__m256i*)lanes, sum);
+        _mm256_storeu_si256((__m256i*)maxs, vmax);
+        _mm256_storeu_si256((__m256i*)mins, vmin);
+        out->sumSquares = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (int k = 0; k < 16; k++) {
+            if (maxs[k] > out->peak) out->peak = maxs[k];
+            if (-(int32_t)mins[k] > out->peak) out->peak = -(int32_t)mins[k];
+        }
+        out->clipped = clipped;
+    }
+    stats_accumulate(x + i, n - i, out);
+}
+
+DSP_TARGET_AVX2 static float avx2_dot_f32(const float* a, const float* b, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    float sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+                ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    return sum + scalar_dot_f32(a + i, b + i, n - i);
+}
+
+DSP_TARGET_AVX2 static void avx2_mul_f32(float* x, const float* w, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(w + i)));
+    }
+    scalar_mul_f32(x + i, w + i, n - i);
+}
+
+DSP_TARGET_AVX2 static void avx2_mul_i16(int16_t* x, const float* g, int n) {
+    const __m256 lo = _mm256_set1_ps(-32768.0f), hi = _mm256_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(x + i))));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(x + i + 8))));
+        a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, _mm256_loadu_ps(g + i)), lo), hi);
+        b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, _mm256_loadu_ps(g + i + 8)), lo), hi);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i*)(x + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    scalar_mul_i16(x + i, g + i, n - i);
+}
+
+static const DspKernels kAvx2 = {
+    "avx2",
+    avx2_i16_to_f32,
+    avx2_f32_to_i16,
+    avx2_gain_f32,
+    avx2_gain_i16,
+    avx2_stats_i16,
+    avx2_dot_f32,
+    avx2_mul_f32,
+    avx2_mul_i16,
+};
+
+/* CPU 支持 AVX2，且操作系统会保存 YMM 寄存器（XCR0 的 bit 1、2） */
+static int cpu_has_avx2(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27))) return 0; /* OSXSAVE */
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    /* libgcc / compiler-rt 的探测已经核对过 XGETBV */
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif /* DSP_HAVE_X86 */
+
+// ============================================================
+// NEON（arm64 基线）
+// ============================================================
+#ifdef DSP_HAVE_NEON
+
+static void neon_i16_to_f32(const int16_t* in, float* out, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), 1.0f / 32768.0f));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), 1.0f / 32768.0f));
+    }
+    scalar_i16_to_f32(in + i, out + i, n - i);
+}
+
+static void neon_f32_to_i16(const float* in, int16_t* out, int n) {
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        /* maxnm：NaN 取另一个操作数，和标量、SSE 一样落到 -1 */
+        float32x4_t a = vminnmq_f32(vmaxnmq_f32(vld1q_f32(in + i), lo), hi);
+        float32x4_t b = vminnmq_f32(vmaxnmq_f32(vld1q_f32(in + i + 4), lo), hi);
+        int32x4_t ia = vcvtq_s32_f32(vmulq_n_f32(a, 32767.0f));
+        int32x4_t ib = vcvtq_s32_f32(vmulq_n_f32(b, 32767.0f));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+    }
+    scalar_f32_to_i16(in + i, out + i, n - i);
+}
+
+static void neon_gain_f32(float* x, int n, float gain) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(x + i, vmulq_n_f32(vld1q_f32(x + i), gain));
+    scalar_gain_f32(x + i, n - i, gain);
+}
+
+static void neon_gain_i16(int16_t* x, int n, float gain) {
+    const float32x4_t lo = vdupq_n_f32(-32768.0f), hi = vdupq_n_f32(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(x + i);
+        float32x4_t a = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), gain);
+        float32x4_t b = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), gain);
+        a = vminnmq_f32(vmaxnmq_f32(a, lo), hi);
+        b = vminnmq_f32(vmaxnmq_f32(b, lo), hi);
+        vst1q_s16(x + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+    scalar_gain_i16(x + i, n - i, gain);
+}
+
+static void neon_stats_i16(const int16_t* x, int n, DspStats* out) {
+    memset(out, 0, sizeof(*out));
+    const int16x8_t clipHi = vdupq_n_s16(DSP_CLIP_LEVEL - 1);
+    const int16x8_t clipLo = vdupq_n_s16(-(DSP_CLIP_LEVEL - 1));
+    uint64x2_t sum = vdupq_n_u64(0);
+    int16x8_t vmax = vdupq_n_s16(INT16_MIN);
+    int16x8_t vmin = vdupq_n_s16(INT16_MAX);
+    int clipped = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(x + i);
+        /* 单个平方最大 2^30，int32 放得下，按无符号两两累加进 64 位 */
+        int32x4_t lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+        int32x4_t hi = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+        sum = vpadalq_u32(sum, vreinterpretq_u32_s32(lo));
+        sum = vpadalq_u32(sum, vreinterpretq_u32_s32(hi));
+        vmax = vmaxq_s16(vmax, v);
+        vmin = vminq_s16(vmin, v);
+        uint16x8_t clip = vorrq_u16(vcgtq_s16(v, clipHi), vcltq_s16(v, clipLo));
+        clipped += vaddvq_u16(vshrq_n_u16(clip, 15));
+    }
+    if (i > 0) {
+        out->sumSquares = vaddvq_u64(sum);
+        int32_t peak = vmaxvq_s16(vmax);
+        int32_t neg = -(int32_t)vminvq_s16(vmin);
+        out->peak = peak > neg ? peak : neg;
+        if (out->peak < 0) out->peak = 0;
+        out->clipped = clipped;
+    }
+    stats_accumulate(x + i, n - i, out);
+}
+
+static float neon_dot_f32(const float* a, const float* b, int n) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    return vaddvq_f32(acc) + scalar_dot_f32(a + i, b + i, n - i);
+}
+
+static void neon_mul_f32(float* x, const float* w, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(x + i, vmulq_f32(vld1q_f32(x + i), vld1q_f32(w + i)));
+    scalar_mul_f32(x + i, w + i, n - i);
+}
+
+static void neon_mul_i16(int16_t* x, const float* g, int n) {
+    const float32x4_t lo = vdupq_n_f32(-32768.0f), hi = vdupq_n_f32(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(x + i);
+        float32x4_t a = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), vld1q_f32(g + i));
+        float32x4_t b = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), vld1q_f32(g + i + 4));
+        a = vminnmq_f32(vmaxnmq_f32(a, lo), hi);
+        b = vminnmq_f32(vmaxnmq_f32(b, lo), hi);
+        vst1q_s16(x + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+    scalar_mul_i16(x + i, g + i, n - i);
+}
+
+static const DspKernels kNeon = {
+    "neon",
+    neon_i16_to_f32,
+    neon_f32_to_i16,
+    neon_gain_f32,
+    neon_gain_i16,
+    neon_stats_i16,
+    neon_dot_f32,
+    neon_mul_f32,
+    neon_mul_i16,
+};
+
+#endif /* DSP_HAVE_NEON */
+
+// ============================================================
+// 分派
+// ============================================================
+
+int dsp_kernels_all(const DspKernels** out, int max) {
+    int n = 0;
+    if (n < max) out[n++] = &kScalar;
+#ifdef DSP_HAVE_X86
+    if (n < max) out[n++] = &kSse2;
+    if (n < max && cpu_has_avx2()) out[n++] = &kAvx2;
+#endif
+#ifdef DSP_HAVE_NEON
+    if (n < max) out[n++] = &kNeon;
+#endif
+    return n;
+}
+
+static const DspKernels* dsp_select(void) {
+    const DspKernels* all[4];
+    int n = dsp_kernels_all(all, 4);
+    const char* forced = getenv("SPEAKOUT_DSP");
+    if (forced && forced[0]) {
+        for (int i = 0; i < n; i++) {
+            if (strcmp(all[i]->name, forced) == 0) return all[i];
+        }
+    }
+    return all[n - 1]; /* 按由慢到快排的，最后一个最快 */
+}
+
+/* 选择结果与线程无关，两个线程同时首次调用各自算一遍、写进同一个值，无害；
+ * 只需保证指针读写本身不撕裂 */
+static const DspKernels* g_selected = NULL;
+
+const DspKernels* dsp_kernels(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    const DspKernels* k = *(const DspKernels* volatile*)&g_selected;
+    if (!k) {
+        k = dsp_select();
+        *(const DspKernels* volatile*)&g_selected = k;
+    }
+#else
+    const DspKernels* k = __atomic_load_n(&g_selected, __ATOMIC_ACQUIRE);
+    if (!k) {
+        k = dsp_select();
+        __atomic_store_n(&g_selected, k, __ATOMIC_RELEASE);
+    }
+#endif
+    return k;
+}
+
+const DspKernels* dsp_kernels_scalar(void) { return &kScalar; }
+
+void dsp_hann_window(float* w, int n) {
+    const double twoPi = 6.283185307179586;
+    for (int i = 0; i < n; i++) w[i] = (float)(0.5 - 0.5 * cos(twoPi * i / n));
+}
+
+double dsp_stats_rms(const DspStats* stats, int n) {
+    if (!stats || n <= 0) return 0.0;
+    return sqrt((double)stats->sumSquares / n) / 32768.0;
+}
@@ -0,0 +1,67 @@
+/**
+ * SpeakOut DSP 内核：int16↔float 转换、增益（常数或逐样本包络）、RMS/峰值/削波计数、点积、加窗。
+ *
+ * 每个内核都有标量参考实现，外加 SSE2 / AVX2（x86-64）、NEON（arm64）变体。
+ * 第一次调用 dsp_kernels() 时按 CPU 选一套，之后就是一次函数指针调用。
+ * 纯 C11，不依赖平台头文件：Linux / Windows 库都直接编译 dsp_kernels.c。
+ *
+ * 整数内核（转换、增益、统计）各变体与标量结果逐位一致，测试就是这么比的；
+ * 浮点累加（点积）求和顺序不同，只保证相对误差在 1e-5 量级。
+ */
+#ifndef SPEAKOUT_DSP_KERNELS_H
+#define SPEAKOUT_DSP_KERNELS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* |x| 到这个值就算削波（int16 满幅） */
+#define DSP_CLIP_LEVEL 32767
+
+/* int16 样本的统计。全部整数累加：顺序无关，各变体结果相同 */
+typedef struct {
+    uint64_t sumSquares; /* Σ x²，x 为 int16 原值 */
+    int32_t peak;        /* max |x|，-32768 记作 32768 */
+    int32_t clipped;     /* |x| >= DSP_CLIP_LEVEL 的样本数 */
+} DspStats;
+
+typedef struct {
+    const char* name; /* "scalar" / "sse2" / "avx2" / "neon" */
+    /* x / 32768，范围 [-1, 1) */
+    void (*i16_to_f32)(const int16_t* in, float* out, int n);
+    /* 先夹到 [-1, 1] 再 × 32767，向零取整（与 Dart 侧 float32ToPcm16 一致） */
+    void (*f32_to_i16)(const float* in, int16_t* out, int n);
+    void (*gain_f32)(float* x, int n, float gain);
+    /* 就地 × gain，四舍六入五成双，饱和到 int16 */
+    void (*gain_i16)(int16_t* x, int n, float gain);
+    void (*stats_i16)(const int16_t* x, int n, DspStats* out);
+    float (*dot_f32)(const float* a, const float* b, int n);
+    /* x[i] *= w[i]（加窗） */
+    void (*mul_f32)(float* x, const float* w, int n);
+    /* x[i] *= g[i]（逐样本增益包络），舍入、饱和同 gain_i16 */
+    void (*mul_i16)(int16_t* x, const float* g, int n);
+} DspKernels;
+
+/* 本机最快的一套。环境变量 SPEAKOUT_DSP=scalar|sse2|avx2|neon 可强制指定
+ * （本机不支持的名字忽略），A/B 对比和排查用 */
+const DspKernels* dsp_kernels(void);
+
+/* 标量参考实现 */
+const DspKernels* dsp_kernels_scalar(void);
+
+/* 本机能跑的全部变体（标量在第一个），返回个数。测试和基准逐个比对用 */
+int dsp_kernels_all(const DspKernels** out, int max);
+
+/* 周期 Hann 窗，n 点 */
+void dsp_hann_window(float* w, int n);
+
+/* 由统计算 RMS，归一化到满幅 = 1.0；n <= 0 时为 0 */
+double dsp_stats_rms(const DspStats* stats, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_DSP_KERNELS_H */
@@ -0,0 +1,49 @@
+/**
+ * 流式降噪：谱减（判决引导 Wiener 增益）+ 最小值统计跟踪噪声谱。
+ *
+ * 16kHz 单声道 int16 进、int16 出，逐块喂多少吐多少，输出比输入固定晚
+ * NS_DELAY_SAMPLES（16ms）。不需要先「学」一段纯噪声：噪声谱取过去约 1.5 秒
+ * 平滑功率谱的最小值，说话中间的停顿就够它跟上风扇、空调这类稳态噪声。
+ * 键盘声这种瞬态压不干净，能压掉的是它和语音频段不重叠的那部分。
+ *
+ * 所有状态都在 NoiseSuppressor 里，create 之后不再分配内存；不是线程安全的，
+ * 一个实例只给一个采集线程用。
+ */
+#ifndef SPEAKOUT_NOISE_SUPPRESS_H
+#define SPEAKOUT_NOISE_SUPPRESS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NS_FRAME_SAMPLES 256 /* 分析窗 16ms，50% 重叠 */
+#define NS_HOP_SAMPLES 128
+#define NS_DELAY_SAMPLES NS_FRAME_SAMPLES
+
+typedef struct NoiseSuppressor NoiseSuppressor;
+
+NoiseSuppressor* ns_create(void);
+void ns_free(NoiseSuppressor* ns);
+
+/* 清空延迟线和噪声估计，回到刚 create 的状态 */
+void ns_reset(NoiseSuppressor* ns);
+
+/* in → out，n 个样本；in 与 out 可以是同一块内存 */
+void ns_process(NoiseSuppressor* ns, const int16_t* in, int16_t* out, int n);
+
+/* 旁路：照样走延迟线（输出时间轴不跳），只是不做频域处理，
+ * 输出 = 输入晚 NS_DELAY_SAMPLES（±1 LSB 的舍入）。开关可以在任意块之间切换，
+ * 重叠相加保证切换处没有断点。CPU 超预算时采集线程用它兜底。 */
+void ns_set_bypass(NoiseSuppressor* ns, int bypass);
+
+/* 把延迟线里还没吐出来的 NS_DELAY_SAMPLES 个样本写进 out（录音结束时调用），
+ * 返回写出的个数。冲刷期间冻结噪声跟踪，补进去的静音不会被当成噪底。 */
+int ns_flush(NoiseSuppressor* ns, int16_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_NOISE_SUPPRESS_H */
@@ -0,0 +1,239 @@
+/**
+ * 流式重采样实现，接口说明见 resampler.h。
+ *
+ * 原型低通有 L × taps 个系数（按上采样后的 inRate × L 设计），拆成 L 个相位，
+ * 每个相位倒序存好，和历史缓冲做一次连续的点积就是一个输出样本。
+ * 时间用整数累加器 t（单位是 1/L 个输入样本）推进：每个输出 t += M，
+ * t / L 是最新用到的输入下标，t % L 是相位 —— 不用浮点相位，跑几个小时也不会漂。
+ *
+ * 历史缓冲开头垫半个滤波器长度的零，把群延迟抵掉：第 k 个输出对应的正好是
+ * 输入时刻 k × M / L，冲刷后总数也就能对得上 ceil(输入帧数 × L / M)。
+ */
+#include "resampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp_kernels.h"
+
+#define RS_PASS 0.4375f      /* 通带边缘 / 较低采样率 */
+#define RS_STOP 0.5f         /* 阻带起点 / 较低采样率 */
+#define RS_ATTEN_DB 90.0     /* 阻带衰减：int16 量化噪声在 -98dB 左右，再往下没意义 */
+#define RS_BLOCK 1024        /* 一次搬进历史缓冲的输入帧数 */
+#define RS_MAX_BANK (1 << 18)
+/* MSVC 不定义 M_PI（除非先定义 _USE_MATH_DEFINES），自己带一个 */
+#define RS_PI 3.14159265358979323846
+
+struct Resampler {
+    const DspKernels* k;
+    int inRate;
+    int outRate;
+    int channels;
+    int up;      /* L */
+    int down;    /* M */
+    int taps;    /* 每相位系数个数，8 的倍数 */
+    float* bank; /* up × taps，每个相位倒序 */
+
+    float* hist; /* 单声道、[-1, 1) 的输入历史 */
+    int histCap;
+    int have;
+    long long t; /* 下一个输出的时刻，单位 1/L 个输入样本，相对 hist[0] */
+    long long inFrames;
+    long long outSamples;
+};
+
+static int rs_gcd(int a, int b) {
+    while (b) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/* 第一类零阶修正贝塞尔函数，Kaiser 窗用 */
+static double rs_bessel_i0(double x) {
+    double sum = 1.0, term = 1.0, q = x * x / 4.0;
+    for (int k = 1; k < 64; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static int rs_build_bank(Resampler* rs) {
+    const int L = rs->up;
+    const double protoRate = (double)rs->inRate * L;
+    const double minRate = rs->inRate < rs->outRate ? rs->inRate : rs->outRate;
+    const double transition = (RS_STOP - RS_PASS) * minRate;
+    const double cutoff = (RS_PASS + RS_STOP) / 2.0 * minRate / protoRate; /* 相对 protoRate */
+    const double beta = 0.1102 * (RS_ATTEN_DB - 8.7);
+
+    /* Kaiser 的长度估计，按相位数向上取整到 8 的倍数，SIMD 点积没有尾巴 */
+    double n = (RS_ATTEN_DB - 7.95) / (2.285 * 2.0 * RS_PI * transition / protoRate) + 1.0;
+    int taps = (int)ceil(n / L);
+    taps = (taps + 7) & ~7;
+    if ((long long)taps * L > RS_MAX_BANK) return 0;
+    rs->taps = taps;
+
+    const int total = taps * L;
+    rs->bank = malloc(sizeof(float) * total);
+    if (!rs->bank) return 0;
+    const double center = (total - 1) / 2.0;
+    const double i0beta = rs_bessel_i0(beta);
+    for (int p = 0; p < L; p++) {
+        double sum = 0.0;
+        float* phase = rs->bank + (size_t)p * taps;
+        for (int j = 0; j < taps; j++) {
+            int idx = j * L + p;
+            double x = idx - center;
+            double s = x == 0.0 ? 1.0 : sin(2.0 * RS_PI * cutoff * x) / (2.0 * RS_PI * cutoff * x);
+            double r = x / center;
+            double w = rs_bessel_i0(beta * sqrt(fmax(0.0, 1.0 - r * r))) / i0beta;
+            double h = s * w;
+            phase[taps - 1 - j] = (float)h;
+            sum += h;
+        }
+        /* 每个相位单独归一：直流增益在每个相位上都是 1，不会出现以 L 为周期的纹波 */
+        for (int j = 0; j < taps; j++) phase[j] = (float)(phase[j] / sum);
+    }
+    return 1;
+}
+
+Resampler* rs_create(int inRate, int inChannels, int outRate) {
+    if (inRate <= 0 || outRate <= 0 || inChannels < 1 || inChannels > RS_MAX_CHANNELS) return NULL;
+    Resampler* rs = calloc(1, sizeof(Resampler));
+    if (!rs) return NULL;
+    int g = rs_gcd(inRate, outRate);
+    rs->k = dsp_kernels();
+    rs->inRate = inRate;
+    rs->outRate = outRate;
+    rs->channels = inChannels;
+    rs->up = outRate / g;
+    rs->down = inRate / g;
+    if (!rs_build_bank(rs)) {
+        free(rs);
+        return NULL;
+    }
+    rs->histCap = rs->taps + RS_BLOCK;
+    rs->hist = malloc(sizeof(float) * rs->histCap);
+    if (!rs->hist) {
+        rs_free(rs);
+        return NULL;
+    }
+    rs_reset(rs);
+    return rs;
+}
+
+void rs_free(Resampler* rs) {
+    if (!rs) return;
+    free(rs->bank);
+    free(rs->hist);
+    free(rs);
+}
+
+void rs_reset(Resampler* rs) {
+    const int pad = rs->taps / 2;
+    memset(rs->hist, 0, sizeof(float) * pad);
+    rs->have = pad;
+    /* 第 0 个输出的滤波器中心落在 hist[pad]，也就是第一个真实输入样本上 */
+    rs->t = (long long)pad * rs->up + ((long long)rs->taps * rs->up - 1) / 2;
+    rs->inFrames = 0;
+    rs->outSamples = 0;
+}
+
+int rs_max_output(const Resampler* rs, int frames) {
+    return (int)(((long long)frames + rs->taps) * rs->up / rs->down) + 2;
+}
+
+int rs_taps(const Resampler* rs) { return rs->taps; }
+
+/* 历史缓冲里能算的都算出来（最多 limit 个），再把用不到的旧样本挪掉 */
+static int rs_drain(Resampler* rs, int16_t* out, long long limit) {
+    const int L = rs->up, M = rs->down, T = rs->taps;
+    int n = 0;
+    while (n < limit) {
+        long long b = rs->t / L;
+        if (b >= rs->have) break;
+        const float* phase = rs->bank + (size_t)(rs->t % L) * T;
+        float y = rs->k->dot_f32(phase, rs->hist + b - (T - 1), T) * 32768.0f;
+        out[n++] = y >= 32767.0f ? 32767 : y <= -32768.0f ? -32768 : (int16_t)lrintf(y);
+        rs->t += M;
+    }
+    long long shift = rs->t / L - (T - 1);
+    if (shift > rs->have) shift = rs->have;
+    if (shift > 0) {
+        memmove(rs->hist, rs->hist + shift, sizeof(float) * (size_t)(rs->have - shift));
+        rs->have -= (int)shift;
+        rs->t -= shift * L;
+    }
+    rs->outSamples += n;
+    return n;
+}
+
+int rs_process_i16(Resampler* rs, const int16_t* in, int frames, int16_t* out) {
+    const int ch = rs->channels;
+    int written = 0;
+    while (frames > 0) {
+        int take = frames < RS_BLOCK ? frames : RS_BLOCK;
+        float* dst = rs->hist + rs->have;
+        if (ch == 1) {
+            rs->k->i16_to_f32(in, dst, take);
+        } else {
+            const float scale = 1.0f / (32768.0f * ch);
+            for (int i = 0; i < take; i++) {
+                int sum = 0;
+                for (int c = 0; c < ch; c++) sum += in[i * ch + c];
+                dst[i] = sum * scale;
+            }
+        }
+        rs->have += take;
+        rs->inFrames += take;
+        in += (size_t)take * ch;
+        frames -= take;
+        written += rs_drain(rs, out + written, 1LL << 62);
+    }
+    return written;
+}
+
+int rs_process_f32(Resampler* rs, const float* in, int frames, int16_t* out) {
+    const int ch = rs->channels;
+    int written = 0;
+    while (frames > 0) {
+        int take = frames < RS_BLOCK ? frames : RS_BLOCK;
+        float* dst = rs->hist + rs->have;
+        if (ch == 1) {
+            memcpy(dst, in, sizeof(float) * take);
+        } else {
+            const float scale = 1.0f / ch;
+            for (int i = 0; i < take; i++) {
+                float sum = 0.0f;
+                for (int c = 0; c < ch; c++) sum += in[i * ch + c];
+                dst[i] = sum * scale;
+            }
+        }
+        rs->have += take;
+        rs->inFrames += take;
+        in += (size_t)take * ch;
+        frames -= take;
+        written += rs_drain(rs, out + written, 1LL << 62);
+    }
+    return written;
+}
+
+int rs_flush(Resampler* rs, int16_t* out) {
+    const long long target = (rs->inFrames * rs->up + rs->down - 1) / rs->down;
+    int written = 0;
+    /* 补零直到最后一个输出的滤波器窗口整个落在已有数据上；最多补 taps/2 + M 个左右 */
+    while (rs->outSamples < target) {
+        int room = rs->histCap - rs->have;
+        int zeros = room < RS_BLOCK ? room : RS_BLOCK;
+        memset(rs->hist + rs->have, 0, sizeof(float) * zeros);
+        rs->have += zeros;
+        written += rs_drain(rs, out + written, target - rs->outSamples);
+    }
+    rs_reset(rs);
+    return written;
+}
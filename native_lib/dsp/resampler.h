@@ -0,0 +1,55 @@
+/**
+ * 流式重采样 + 声道混合：设备原生格式（48k / 44.1k / 32k / 8k …，多声道）→ 16kHz 单声道。
+ *
+ * 以前两边都向声音服务器要 16kHz 单声道：PulseAudio 用它默认的低质量重采样，
+ * 高频折叠回语音频段；Windows 上不支持 16kHz 的设备 Initialize 直接失败，录不了音。
+ * 现在按设备的原生格式打开，在进程里转。
+ *
+ * 多相 Kaiser 窗 sinc：通带到 0.4375 × 较低采样率（输出 16k 时是 7kHz），
+ * 阻带从较低采样率的一半开始、衰减 90dB。L/M 由两个采样率的最大公约数定，
+ * 滤波器组（L 个相位 × 每相位 taps 个系数）在 rs_create 时算好，每个输出样本就是
+ * 一次 dot_f32（dsp_kernels 的 SIMD 内核）。
+ *
+ * 所有状态都在 Resampler 里，create 之后不再分配内存；不是线程安全的，一个实例只给一个采集线程用。
+ */
+#ifndef SPEAKOUT_RESAMPLER_H
+#define SPEAKOUT_RESAMPLER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RS_MAX_CHANNELS 8
+
+typedef struct Resampler Resampler;
+
+/* 不支持的参数（采样率 <= 0、声道数不在 1..RS_MAX_CHANNELS、滤波器组大得离谱）返回 NULL */
+Resampler* rs_create(int inRate, int inChannels, int outRate);
+void rs_free(Resampler* rs);
+
+/* 清空历史，回到刚 create 的状态 */
+void rs_reset(Resampler* rs);
+
+/* 喂 frames 帧交织的输入，转换结果写进 out，返回写出的样本数。
+ * 输入总是全部吃掉；out 的容量至少 rs_max_output(rs, frames)。 */
+int rs_process_i16(Resampler* rs, const int16_t* in, int frames, int16_t* out);
+/* 同上，输入是 [-1, 1] 的 float（WASAPI 的混音格式通常是这个） */
+int rs_process_f32(Resampler* rs, const float* in, int frames, int16_t* out);
+
+/* 录音结束：补零把滤波器里压着的尾巴推出来。结束后输出总数 = ceil(输入总帧数 × 输出率 / 输入率)，
+ * 返回这次写出的个数（最多 rs_max_output(rs, 0)）。之后回到刚 create 的状态，可以接着录下一段 */
+int rs_flush(Resampler* rs, int16_t* out);
+
+/* 喂 frames 帧时最多写出多少个样本 */
+int rs_max_output(const Resampler* rs, int frames);
+
+/* 每个输出样本的乘加次数（每相位系数个数），基准和日志用 */
+int rs_taps(const Resampler* rs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_RESAMPLER_H */
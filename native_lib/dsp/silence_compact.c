@@ -0,0 +1,249 @@
+/**
+ * 停顿压缩实现，接口说明见 silence_compact.h。
+ *
+ * 每收满一帧判一次：说话帧（含说话之后 hold 的那几帧）先把压着的静音交出去再输出自己；
+ * 静音帧进 pending。pending 超过 minFrames 的那一刻这段停顿就确定要压了：
+ * 吐出开头 headFrames，之后 pending 只滚动保留最近 tailFrames，其余丢掉；
+ * 等下一帧说话来了再把这 tailFrames 吐出去，同时记下对照点。
+ * 电平统计走 dsp_kernels 的 SIMD 内核。
+ */
+#include "silence_compact.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp_kernels.h"
+
+#define SC_SILENCE_DB -120.0f
+#define SC_FLOOR_FALL 0.3f     /* 噪底往下跟得快、往上慢，同 agc */
+#define SC_FLOOR_RISE_DB 0.02f
+#define SC_VOICE_DB 9.0f       /* 高出噪底这么多算有人说话 */
+#define SC_VOICE_FLOOR_DBFS -60.0f
+#define SC_HOLD_FRAMES 20      /* 说话之后 200ms 仍按说话算：轻声的字尾不当停顿 */
+
+typedef struct {
+    long long comp;
+    long long orig;
+} ScPoint;
+
+struct SilenceCompactor {
+    const DspKernels* k;
+    int minFrames;  /* 连续静音超过这么多帧才压 */
+    int headFrames; /* 压完留在停顿开头的 */
+    int tailFrames; /* 留在下一句之前的 */
+
+    int16_t cur[SC_FRAME_SAMPLES];
+    int fill;
+    int pendingFrames; /* pending 里压着的静音帧 */
+    int cutting;       /* 这段停顿已经确定要压：开头吐过了，pending 只滚动保留尾巴 */
+
+    float noiseDb;
+    int hold;
+    long long frames;
+    long long inSamples, outSamples;
+    int cuts;
+    int npoints;
+    ScPoint points[SC_MAX_CUTS];
+    int16_t pending[]; /* (minFrames + 1) 帧 */
+};
+
+static int clampi(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+SilenceCompactor* sc_create(int minSilenceMs, int keepMs) {
+    int minFrames = clampi(minSilenceMs / 10, 2, 60000);
+    int keepFrames = clampi(keepMs / 10, 0, minFrames - 1);
+    SilenceCompactor* sc =
+        calloc(1, sizeof(SilenceCompactor) + sizeof(int16_t) * (size_t)(minFrames + 1) * SC_FRAME_SAMPLES);
+    if (!sc) return NULL;
+    sc->k = dsp_kernels();
+    sc->minFrames = minFrames;
+    sc->headFrames = keepFrames / 2;
+    sc->tailFrames = keepFrames - sc->headFrames;
+    sc_reset(sc);
+    return sc;
+}
+
+void sc_free(SilenceCompactor* sc) { free(sc); }
+
+void sc_reset(SilenceCompactor* sc) {
+    if (!sc) return;
+    sc->fill = 0;
+    sc->pendingFrames = 0;
+    sc->cutting = 0;
+    sc->noiseDb = SC_SILENCE_DB;
+    sc->hold = 0;
+    sc->frames = 0;
+    sc->inSamples = 0;
+    sc->outSamples = 0;
+    sc->cuts = 0;
+    sc->npoints = 0;
+}
+
+int sc_max_output(const SilenceCompactor* sc, int n) {
+    /* 最坏：一段没到阈值的停顿（minFrames 帧）整段吐出，再加上一个半帧凑成的整帧 */
+    return (n > 0 ? n : 0) + (sc->minFrames + 1) * SC_FRAME_SAMPLES;
+}
+
+/* 这一帧算不算说话（噪底跟踪和判定同 agc 的噪声门，hold 之内都算） */
+static int sc_voiced(SilenceCompactor* sc, const int16_t* x, int n) {
+    DspStats st;
+    sc->k->stats_i16(x, n, &st);
+    double rms = dsp_stats_rms(&st, n);
+    float levelDb = rms > 1e-6 ? (float)(20.0 * log10(rms)) : SC_SILENCE_DB;
+
+    if (sc->frames == 0) {
+        sc->noiseDb = levelDb;
+    } else if (levelDb < sc->noiseDb) {
+        sc->noiseDb += SC_FLOOR_FALL * (levelDb - sc->noiseDb);
+        if (sc->noiseDb - levelDb < 0.01f) sc->noiseDb = levelDb;
+    } else {
+        sc->noiseDb += fminf(levelDb - sc->noiseDb, SC_FLOOR_RISE_DB);
+    }
+    sc->frames++;
+
+    if (levelDb >= fmaxf(sc->noiseDb + SC_VOICE_DB, SC_VOICE_FLOOR_DBFS)) {
+        sc->hold = SC_HOLD_FRAMES;
+        return 1;
+    }
+    if (sc->hold > 0) {
+        sc->hold--;
+        return 1;
+    }
+    return 0;
+}
+
+static int sc_emit(SilenceCompactor* sc, int16_t* out, const int16_t* x, int n) {
+    memcpy(out, x, sizeof(int16_t) * (size_t)n);
+    sc->outSamples += n;
+    return n;
+}
+
+/* 一帧（或 flush 时的半帧，n < SC_FRAME_SAMPLES）。frameStart 是它在原始录音里的位置 */
+static int sc_frame(SilenceCompactor* sc, const int16_t* x, int n, long long frameStart, int16_t* out) {
+    const int F = SC_FRAME_SAMPLES;
+    int written = 0;
+    if (sc_voiced(sc, x, n)) {
+        if (sc->pendingFrames > 0 || sc->cutting) {
+            if (sc->cutting) {
+                /* 留下的尾巴从这里开始接回原始时间线 */
+                ScPoint* p = &sc->points[sc->npoints++];
+                p->comp = sc->outSamples;
+                p->orig = frameStart - (long long)sc->pendingFrames * F;
+            }
+            written += sc_emit(sc, out, sc->pending, sc->pendingFrames * F);
+            sc->pendingFrames = 0;
+            sc->cutting = 0;
+        }
+        return written + sc_emit(sc, out + written, x, n);
+    }
+
+    if (sc->cutting) {
+        /* 只滚动保留最近 tailFrames 帧 */
+        if (sc->tailFrames == 0) return 0;
+        if (sc->pendingFrames == sc->tailFrames) {
+            memmove(sc->pending, sc->pending + F, sizeof(int16_t) * (size_t)(sc->tailFrames - 1) * F);
+            sc->pendingFrames--;
+        }
+        memcpy(sc->pending + sc->pendingFrames * F, x, sizeof(int16_t) * (size_t)n);
+        sc->pendingFrames++;
+        return 0;
+    }
+
+    /* 半帧只会在 flush 时出现，之后不再有帧，放进去按整帧算不影响结果 */
+    memcpy(sc->pending + sc->pendingFrames * F, x, sizeof(int16_t) * (size_t)n);
+    if (n < F) memset(sc->pending + sc->pendingFrames * F + n, 0, sizeof(int16_t) * (size_t)(F - n));
+    sc->pendingFrames++;
+    if (sc->pendingFrames <= sc->minFrames) return 0;
+    if (sc->npoints >= SC_MAX_CUTS) {
+        /* 对照点用完了：不再压，攒够的原样交出去 */
+        written = sc_emit(sc, out, sc->pending, sc->pendingFrames * F);
+        sc->pendingFrames = 0;
+        return written;
+    }
+
+    /* 超过阈值：这段停顿确定要压 */
+    written = sc_emit(sc, out, sc->pending, sc->headFrames * F);
+    memmove(sc->pending, sc->pending + (sc->pendingFrames - sc->tailFrames) * F,
+            sizeof(int16_t) * (size_t)sc->tailFrames * F);
+    sc->pendingFrames = sc->tailFrames;
+    sc->cutting = 1;
+    sc->cuts++;
+    return written;
+}
+
+int sc_process(SilenceCompactor* sc, const int16_t* in, int16_t* out, int n) {
+    if (!sc || !in || n <= 0) return 0;
+    int done = 0, written = 0;
+    while (done < n) {
+        int take = SC_FRAME_SAMPLES - sc->fill;
+        if (take > n - done) take = n - done;
+        memcpy(sc->cur + sc->fill, in + done, sizeof(int16_t) * (size_t)take);
+        sc->fill += take;
+        done += take;
+        if (sc->fill == SC_FRAME_SAMPLES) {
+            written += sc_frame(sc, sc->cur, SC_FRAME_SAMPLES, sc->inSamples, out + written);
+            sc->inSamples += SC_FRAME_SAMPLES;
+            sc->fill = 0;
+        }
+    }
+    return written;
+}
+
+int sc_flush(SilenceCompactor* sc, int16_t* out) {
+    if (!sc) return 0;
+    int written = 0;
+    int partial = sc->fill;
+    int lastPartial = 0; /* 半帧最后落在 pending 末尾、补了零 */
+    if (partial > 0) {
+        int pendingBefore = sc->pendingFrames, cuttingBefore = sc->cutting;
+        written = sc_frame(sc, sc->cur, partial, sc->inSamples, out);
+        sc->inSamples += partial;
+        sc->fill = 0;
+        lastPartial = !cuttingBefore && sc->pendingFrames == pendingBefore + 1;
+    }
+    if (!sc->cutting && sc->pendingFrames > 0) {
+        /* 没到阈值的结尾停顿原样交出；补的零不算 */
+        int n = sc->pendingFrames * SC_FRAME_SAMPLES;
+        if (lastPartial) n -= SC_FRAME_SAMPLES - partial;
+        written += sc_emit(sc, out + written, sc->pending, n);
+    }
+    /* 在压的那段：开头已经吐过，尾巴后面没有下一句了，丢掉 */
+    sc->pendingFrames = 0;
+    sc->cutting = 0;
+    return written;
+}
+
+long long sc_stat(const SilenceCompactor* sc, int which) {
+    if (!sc) return -1;
+    switch (which) {
+    case SC_STAT_INPUT: return sc->inSamples + sc->fill;
+    case SC_STAT_OUTPUT: return sc->outSamples;
+    case SC_STAT_CUTS: return sc->cuts;
+    default: return -1;
+    }
+}
+
+long long sc_map(const SilenceCompactor* sc, long long pos) {
+    if (!sc) return pos;
+    /* 最后一个 comp <= pos 的对照点 */
+    int lo = 0, hi = sc->npoints;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (sc->points[mid].comp <= pos) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return pos;
+    const ScPoint* p = &sc->points[lo - 1];
+    return p->orig + (pos - p->comp);
+}
+
+int sc_map_points(const SilenceCompactor* sc, long long* out, int maxPoints) {
+    if (!sc || !out || maxPoints <= 0) return 0;
+    int n = sc->npoints < maxPoints ? sc->npoints : maxPoints;
+    for (int i = 0; i < n; i++) {
+        out[2 * i] = sc->points[i].comp;
+        out[2 * i + 1] = sc->points[i].orig;
+    }
+    return n;
+}
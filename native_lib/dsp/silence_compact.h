@@ -0,0 +1,67 @@
+/**
+ * 停顿压缩：整段解码 / 整段上传之前，把录音里长的停顿压成一小段固定长度的间隔。
+ *
+ * 边想边说的一段口述，停顿往往比说话还长。离线模型（Whisper 一类尤其明显）的编码器
+ * 按音频时长算钱，云端按上传的字节算时间 —— 停顿全是白花的。
+ * 这一级按 10ms 一帧判断有没有人说话（噪底跟踪 + 高出噪底一截才算，和 agc 的噪声门同一套），
+ * 连续静音超过 minSilenceMs 的那段只留 keepMs：一半留在停顿开头、一半留在下一句之前，
+ * 字的收尾和起音不会被切掉，模型也还能看出这里断了句。短于 minSilenceMs 的停顿原样保留。
+ *
+ * 边录边压：说话帧立刻吐出，静音帧先压着，等知道这段停顿有多长再决定吐多少，
+ * 所以输出最多比输入晚 minSilenceMs。每切掉一段记一个对照点（压缩后的样本位置 ↔ 原始位置），
+ * 识别结果里的时间戳按它映射回原始录音（sc_map / sc_map_points）。
+ *
+ * 16kHz 单声道 int16。create 之后不再分配内存；不是线程安全的，一个实例只给一次录音用。
+ */
+#ifndef SPEAKOUT_SILENCE_COMPACT_H
+#define SPEAKOUT_SILENCE_COMPACT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SC_FRAME_SAMPLES 160 /* 10ms */
+#define SC_MAX_CUTS 4096     /* 对照点上限；用满之后不再压缩，原样输出 */
+
+/* sc_stat 的参数 */
+enum {
+    SC_STAT_INPUT = 0,  /* 喂进来的样本数 */
+    SC_STAT_OUTPUT = 1, /* 吐出去的样本数（压缩后） */
+    SC_STAT_CUTS = 2,   /* 压了几段停顿 */
+};
+
+typedef struct SilenceCompactor SilenceCompactor;
+
+/* minSilenceMs：停顿超过这么长才压；keepMs：压完留下的间隔，会被夹到小于 minSilenceMs */
+SilenceCompactor* sc_create(int minSilenceMs, int keepMs);
+void sc_free(SilenceCompactor* sc);
+
+/* 新一次录音：噪底、压着的静音、统计和对照点全部清空 */
+void sc_reset(SilenceCompactor* sc);
+
+/* 一次 sc_process 最多吐出的样本数（out 至少要这么大） */
+int sc_max_output(const SilenceCompactor* sc, int n);
+
+/* in → out，返回写出的样本数。in 与 out 不能是同一块内存 */
+int sc_process(SilenceCompactor* sc, const int16_t* in, int16_t* out, int n);
+
+/* 录音结束：没收满的半帧照常判断；还压着的静音短于阈值的原样吐出，
+ * 已经在压的那段（结尾的长停顿）只留开头那一半。out 至少 sc_max_output(sc, 0) */
+int sc_flush(SilenceCompactor* sc, int16_t* out);
+
+long long sc_stat(const SilenceCompactor* sc, int which);
+
+/* 压缩后第 pos 个样本在原始录音里的位置 */
+long long sc_map(const SilenceCompactor* sc, long long pos);
+
+/* 对照点按顺序写成 [压缩后位置, 原始位置] 对，最多 maxPoints 对，返回个数。
+ * 两个对照点之间原始和压缩后一一对应；第一个对照点之前两边位置相同 */
+int sc_map_points(const SilenceCompactor* sc, long long* out, int maxPoints);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEAKOUT_SILENCE_COMPACT_H */
@@ -0,0 +1,350 @@
+/**
+ * 流式 FLAC 编码器，见 flac_encoder.h。
+ *
+ * 每帧对 0~4 阶固定预测器分别算残差，按 Rice 编码的估算码长挑最短的
+ * （连同分区阶数一起挑），都不划算时退回 VERBATIM。语音的相邻样本高度
+ * 相关，2~3 阶残差通常只有原值的几十分之一，一般能压到 PCM 的 40%~60%。
+ */
+#include "flac_encoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FLAC_BLOCK_SIZE 4096
+#define FLAC_MAX_FIXED_ORDER 4
+#define FLAC_MAX_PARTITION_ORDER 8
+#define FLAC_MAX_RICE_PARAM 14 /* 4-bit Rice 参数，15 是 escape，不用 */
+
+// ============================================================
+// Bit writer
+// ============================================================
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+    uint64_t acc;
+    int bits; /* acc 里还没落成字节的位数，始终 < 8 */
+} BitWriter;
+
+static int bw_reserve(BitWriter* bw, size_t extra) {
+    if (bw->len + extra <= bw->cap) return 1;
+    size_t cap = bw->cap ? bw->cap : 4096;
+    while (cap < bw->len + extra) cap *= 2;
+    uint8_t* p = realloc(bw->data, cap);
+    if (!p) return 0;
+    bw->data = p;
+    bw->cap = cap;
+    return 1;
+}
+
+/* n ≤ 32 */
+static void bw_put(BitWriter* bw, uint32_t value, int n) {
+    if (n <= 0) return;
+    if (!bw_reserve(bw, 8)) return;
+    bw->acc = (bw->acc << n) | (n == 32 ? value : (value & ((1u << n) - 1)));
+    bw->bits += n;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        bw->data[bw->len++] = (uint8_t)(bw->acc >> bw->bits);
+    }
+}
+
+static void bw_put_unary(BitWriter* bw, uint32_t zeros) {
+    while (zeros >= 32) {
+        bw_put(bw, 0, 32);
+        zeros -= 32;
+    }
+    bw_put(bw, 1, (int)zeros + 1);
+}
+
+static void bw_align(BitWriter* bw) {
+    if (bw->bits > 0) bw_put(bw, 0, 8 - bw->bits);
+}
+
+// ============================================================
+// CRC (FLAC: CRC-8 poly 0x07, CRC-16 poly 0x8005, 初值 0)
+// ============================================================
+
+static uint8_t crc8(const uint8_t* p, size_t n) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+static uint16_t crc16(const uint8_t* p, size_t n) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint16_t)p[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+// ============================================================
+// Encoder
+// ============================================================
+
+struct FlacEncoder {
+    int sampleRate;
+    int srCode;
+    int32_t block[FLAC_BLOCK_SIZE];
+    int blockFill;
+    uint64_t frameNumber;
+    int headerWritten;
+    int finished;
+    BitWriter frame;           /* 当前帧，编完整体搬进 out */
+    uint8_t* out;              /* 已编码、待取走的字节 */
+    size_t outLen, outRead, outCap;
+    uint32_t resid[FLAC_MAX_FIXED_ORDER + 1][FLAC_BLOCK_SIZE]; /* zigzag 后的残差 */
+};
+
+static int sample_rate_code(int rate) {
+    switch (rate) {
+        case 8000: return 4;
+        case 16000: return 5;
+        case 22050: return 6;
+        case 24000: return 7;
+        case 32000: return 8;
+        case 44100: return 9;
+        case 48000: return 10;
+        default: return 0; /* 取 STREAMINFO */
+    }
+}
+
+FlacEncoder* flac_encoder_new(int sampleRate) {
+    if (sampleRate <= 0 || sampleRate >= (1 << 20)) return NULL;
+    FlacEncoder* enc = calloc(1, sizeof(FlacEncoder));
+    if (!enc) return NULL;
+    enc->sampleRate = sampleRate;
+    enc->srCode = sample_rate_code(sampleRate);
+    return enc;
+}
+
+void flac_encoder_free(FlacEncoder* enc) {
+    if (!enc) return;
+    free(enc->frame.data);
+    free(enc->out);
+    free(enc);
+}
+
+static void out_append(FlacEncoder* enc, const uint8_t* p, size_t n) {
+    if (enc->outLen + n > enc->outCap) {
+        size_t cap = enc->outCap ? enc->outCap : 16384;
+        while (cap < enc->outLen + n) cap *= 2;
+        uint8_t* q = realloc(enc->out, cap);
+        if (!q) return;
+        enc->out = q;
+        enc->outCap = cap;
+    }
+    memcpy(enc->out + enc->outLen, p, n);
+    enc->outLen += n;
+}
+
+static void write_stream_header(FlacEncoder* enc) {
+    uint8_t h[4 + 4 + 34];
+    memset(h, 0, sizeof(h));
+    memcpy(h, "fLaC", 4);
+    h[4] = 0x80;           /* last metadata block, type 0 = STREAMINFO */
+    h[7] = 34;             /* length (24 bit) */
+    uint8_t* si = h + 8;
+    si[0] = FLAC_BLOCK_SIZE >> 8; si[1] = FLAC_BLOCK_SIZE & 0xFF; /* min block size */
+    si[2] = FLAC_BLOCK_SIZE >> 8; si[3] = FLAC_BLOCK_SIZE & 0xFF; /* max block size */
+    /* si[4..9]: min/max frame size = 0（未知） */
+    /* 20 bit 采样率 | 3 bit (声道-1)=0 | 5 bit (位深-1)=15 | 36 bit 总样本数=0（未知） */
+    uint32_t sr = (uint32_t)enc->sampleRate;
+    si[10] = (uint8_t)(sr >> 12);
+    si[11] = (uint8_t)(sr >> 4);
+    si[12] = (uint8_t)(((sr & 0xF) << 4) | (0 << 1) | (15 >> 4));
+    si[13] = (uint8_t)((15 & 0xF) << 4);
+    /* si[18..33]: MD5 = 0（未知，解码端跳过校验） */
+    out_append(enc, h, sizeof(h));
+}
+
+static void put_utf8_number(BitWriter* bw, uint64_t v) {
+    if (v < 0x80) { bw_put(bw, (uint32_t)v, 8); return; }
+    int bytes = v < 0x800 ? 2 : v < 0x10000 ? 3 : v < 0x200000 ? 4
+              : v < 0x4000000 ? 5 : v < 0x80000000ULL ? 6 : 7;
+    int lead = bytes == 7 ? 0xFE : (0xFF00 >> bytes) & 0xFF;
+    int shift = 6 * (bytes - 1);
+    bw_put(bw, (uint32_t)(lead | (bytes == 7 ? 0 : (int)(v >> shift))), 8);
+    for (shift -= 6; shift >= 0; shift -= 6) {
+        bw_put(bw, (uint32_t)(0x80 | ((v >> shift) & 0x3F)), 8);
+    }
+}
+
+static uint32_t zigzag(int32_t r) { return r >= 0 ? (uint32_t)r << 1 : ((uint32_t)(-(r + 1)) << 1) | 1; }
+
+static int rice_param(uint64_t sum, uint32_t count) {
+    int k = 0;
+    while (k < FLAC_MAX_RICE_PARAM && ((uint64_t)count << (k + 1)) < sum) k++;
+    return k;
+}
+
+/* 对给定阶数挑分区阶数；返回估算位数，*bestPartOrder 给出选中的分区阶数 */
+static uint64_t choose_partitions(const uint32_t* u, int n, int order, int* bestPartOrder) {
+    int maxP = 0;
+    while (maxP < FLAC_MAX_PARTITION_ORDER && (n % (1 << (maxP + 1))) == 0 &&
+           (n >> (maxP + 1)) > order) {
+        maxP++;
+    }
+    uint64_t sums[1 << FLAC_MAX_PARTITION_ORDER];
+    int parts = 1 << maxP;
+    int psize = n >> maxP;
+    for (int j = 0; j < parts; j++) {
+        uint64_t s = 0;
+        for (int i = (j == 0 ? order : j * psize); i < (j + 1) * psize; i++) s += u[i];
+        sums[j] = s;
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (int p = maxP; p >= 0; p--) {
+        int np = 1 << p;
+        int size = n >> p;
+        uint64_t bits = 0;
+        for (int j = 0; j < np; j++) {
+            uint32_t cnt = (uint32_t)(j == 0 ? size - order : size);
+            int k = rice_param(sums[j], cnt);
+            bits += 4 + (uint64_t)cnt * (k + 1) + (sums[j] >> k);
+        }
+        if (bits < best) {
+            best = bits;
+            *bestPartOrder = p;
+        }
+        /* 合并相邻分区，进入下一层（更粗） */
+        for (int j = 0; j < np / 2; j++) sums[j] = sums[2 * j] + sums[2 * j + 1];
+    }
+    return best + 6; /* 2 bit 编码方式 + 4 bit 分区阶数 */
+}
+
+static void write_residual(BitWriter* bw, const uint32_t* u, int n, int order, int partOrder) {
+    bw_put(bw, 0, 2);          /* RICE (4-bit 参数) */
+    bw_put(bw, (uint32_t)partOrder, 4);
+    int np = 1 << partOrder;
+    int size = n >> partOrder;
+    for (int j = 0; j < np; j++) {
+        int start = j == 0 ? order : j * size;
+        int end = (j + 1) * size;
+        uint64_t sum = 0;
+        for (int i = start; i < end; i++) sum += u[i];
+        int k = rice_param(sum, (uint32_t)(end - start));
+        bw_put(bw, (uint32_t)k, 4);
+        for (int i = start; i < end; i++) {
+            bw_put_unary(bw, u[i] >> k);
+            bw_put(bw, u[i], k);
+        }
+    }
+}
+
+static void encode_frame(FlacEncoder* enc) {
+    const int n = enc->blockFill;
+    const int32_t* x = enc->block;
+    BitWriter* bw = &enc->frame;
+    bw->len = 0;
+    bw->acc = 0;
+    bw->bits = 0;
+
+    // ── 帧头 ──
+    int bsCode = n == FLAC_BLOCK_SIZE ? 12 : (n <= 256 ? 6 : 7);
+    bw_put(bw, 0xFFF8, 16); /* sync + reserved + 固定块长 */
+    bw_put(bw, (uint32_t)bsCode, 4);
+    bw_put(bw, (uint32_t)enc->srCode, 4);
+    bw_put(bw, 0, 4);       /* mono */
+    bw_put(bw, 4, 3);       /* 16 bit */
+    bw_put(bw, 0, 1);
+    put_utf8_number(bw, enc->frameNumber);
+    if (bsCode == 6) bw_put(bw, (uint32_t)(n - 1), 8);
+    if (bsCode == 7) bw_put(bw, (uint32_t)(n - 1), 16);
+    bw_put(bw, crc8(bw->data, bw->len), 8);
+
+    // ── 子帧 ──
+    int constant = 1;
+    for (int i = 1; i < n && constant; i++) constant = x[i] == x[0];
+
+    if (constant) {
+        bw_put(bw, 0x00, 8);                 /* pad + CONSTANT + no wasted bits */
+        bw_put(bw, (uint32_t)x[0] & 0xFFFF, 16);
+    } else {
+        uint64_t bestBits = (uint64_t)n * 16; /* VERBATIM */
+        int bestOrder = -1, bestPart = 0;
+        int maxOrder = n - 1 < FLAC_MAX_FIXED_ORDER ? n - 1 : FLAC_MAX_FIXED_ORDER;
+        for (int order = 0; order <= maxOrder; order++) {
+            uint32_t* u = enc->resid[order];
+            for (int i = order; i < n; i++) {
+                int32_t r;
+                switch (order) {
+                    case 0: r = x[i]; break;
+                    case 1: r = x[i] - x[i - 1]; break;
+                    case 2: r = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+                    case 3: r = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+                    default: r = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+                }
+                u[i] = zigzag(r);
+            }
+            int part = 0;
+            uint64_t bits = (uint64_t)order * 16 + choose_partitions(u, n, order, &part);
+            if (bits < bestBits) {
+                bestBits = bits;
+                bestOrder = order;
+                bestPart = part;
+            }
+        }
+
+        if (bestOrder < 0) {
+            bw_put(bw, 0x02, 8);             /* pad + VERBATIM(000001) + no wasted bits */
+            for (int i = 0; i < n; i++) bw_put(bw, (uint32_t)x[i] & 0xFFFF, 16);
+        } else {
+            bw_put(bw, (uint32_t)((0x08 | bestOrder) << 1), 8); /* pad + FIXED(001ooo) + 0 */
+            for (int i = 0; i < bestOrder; i++) bw_put(bw, (uint32_t)x[i] & 0xFFFF, 16);
+            write_residual(bw, enc->resid[bestOrder], n, bestOrder, bestPart);
+        }
+    }
+
+    // ── 帧尾 ──
+    bw_align(bw);
+    uint16_t crc = crc16(bw->data, bw->len);
+    bw_put(bw, crc, 16);
+
+    if (!enc->headerWritten) {
+        write_stream_header(enc);
+        enc->headerWritten = 1;
+    }
+    out_append(enc, bw->data, bw->len);
+    enc->frameNumber++;
+    enc->blockFill = 0;
+}
+
+int flac_encoder_write(FlacEncoder* enc, const int16_t* samples, int count) {
+    if (!enc) return 0;
+    if (enc->finished || !samples) return (int)(enc->outLen - enc->outRead);
+    for (int i = 0; i < count; i++) {
+        enc->block[enc->blockFill++] = samples[i];
+        if (enc->blockFill == FLAC_BLOCK_SIZE) encode_frame(enc);
+    }
+    return (int)(enc->outLen - enc->outRead);
+}
+
+int flac_encoder_finish(FlacEncoder* enc) {
+    if (!enc) return 0;
+    if (!enc->finished) {
+        enc->finished = 1;
+        if (enc->blockFill > 0) encode_frame(enc);
+    }
+    return (int)(enc->outLen - enc->outRead);
+}
+
+int flac_encoder_read(FlacEncoder* enc, uint8_t* out, int maxBytes) {
+    if (!enc || !out || maxBytes <= 0) return 0;
+    size_t avail = enc->outLen - enc->outRead;
+    size_t n = avail < (size_t)maxBytes ? avail : (size_t)maxBytes;
+    memcpy(out, enc->out + enc->outRead, n);
+    enc->outRead += n;
+    if (enc->outRead == enc->outLen) {
+        enc->outRead = 0;
+        enc->outLen = 0;
+    }
+    return (int)n;
+}
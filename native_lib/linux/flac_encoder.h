@@ -0,0 +1,34 @@
+/**
+ * 流式 FLAC 编码器（无损，16-bit mono）
+ *
+ * 录音期间逐块喂 PCM，随时取走已编码好的字节：上传可以和录音同时进行，
+ * 不用等松键后再整段压缩。实现只用 FLAC 的子集 —— CONSTANT / VERBATIM /
+ * FIXED(0~4 阶) 子帧 + Rice 残差编码，足够让 ffmpeg/libFLAC 正常解码，
+ * 也不引入 libFLAC 依赖。
+ *
+ * 输出是标准 FLAC 流："fLaC" + STREAMINFO + 帧。STREAMINFO 在第一帧
+ * 产出时才写（没录到音就一个字节都不产出），总样本数和 MD5 填 0
+ * （规范允许：「未知」），所以不需要回头改文件头。
+ */
+#ifndef SPEAKOUT_FLAC_ENCODER_H
+#define SPEAKOUT_FLAC_ENCODER_H
+
+#include <stdint.h>
+
+typedef struct FlacEncoder FlacEncoder;
+
+/* sampleRate 任意；常见采样率直接写进帧头，其余走 STREAMINFO */
+FlacEncoder* flac_encoder_new(int sampleRate);
+
+/* 喂 count 个样本；满一块（4096）就编码一帧。返回当前可读的字节数 */
+int flac_encoder_write(FlacEncoder* enc, const int16_t* samples, int count);
+
+/* 把不满一块的尾巴编成最后一帧。之后不能再 write。返回当前可读的字节数 */
+int flac_encoder_finish(FlacEncoder* enc);
+
+/* 取走最多 maxBytes 个已编码字节，返回实际取到的字节数 */
+int flac_encoder_read(FlacEncoder* enc, uint8_t* out, int maxBytes);
+
+void flac_encoder_free(FlacEncoder* enc);
+
+#endif
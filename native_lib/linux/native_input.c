@@ -7,10 +7,17 @@
  *   - 文本注入: xdotool / xte (X11) 或 ydotool (Wayland)
  *   - 音频采集: PulseAudio (pa_simple)
  *   - 设备管理: PulseAudio context API
+ *   - 日志: 无锁环 + 后台写线程（speakout_native.log，见 0. LOGGING）
+ *   - 流式解码: sherpa-onnx 在线识别直接从 ring 取数（可选，见 9. STREAMING DECODE）
+ *   - 降噪: 采集线程上进 ring 之前就地处理（可选，见 5. AUDIO RECORDING）
+ *   - 自动增益: 接在降噪后面，噪声门 + 前瞻限幅（可选，见 5. AUDIO RECORDING）
+ *   - ring: 多读者，各读各的游标（../dsp/audio_ring.h）；Dart 轮询和 native 解码互不抢样本
+ *   - 重采样: 按默认 source 的原生采样率 / 声道打开，进程内转 16k 单声道（见 5. AUDIO RECORDING）
  *
  * 编译: 参见同目录 CMakeLists.txt
- *   gcc -shared -fPIC -o libnative_input.so native_input.c \
- *       -lpulse-simple -lpulse -lX11 -lXtst -lpthread
+ *   gcc -shared -fPIC -o libnative_input.so native_input.c flac_encoder.c ../dsp/dsp_kernels.c ../dsp/noise_suppress.c ../dsp/agc.c \
+ *       ../dsp/resampler.c ../dsp/audio_ring.c ../dsp/silence_compact.c \
+ *       -lpulse-simple -lpulse -lX11 -lXtst -lpthread -ldl
  */
 
 #define _GNU_SOURCE
@@ -25,6 +32,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <linux/input.h>
 
 /* PulseAudio simple API */
@@ -34,6 +44,14 @@
 /* X11 for text injection (optional, dlopened) */
 #include <dlfcn.h>
 
+#include "flac_encoder.h"
+#include "../dsp/dsp_kernels.h"
+#include "../dsp/noise_suppress.h"
+#include "../dsp/agc.h"
+#include "../dsp/resampler.h"
+#include "../dsp/audio_ring.h"
+#include "../dsp/silence_compact.h"
+
 // ============================================================
 // DLL Export macro
 // ============================================================
@@ -50,49 +68,262 @@
 typedef void (*KeyCallback)(int keyCode, int isDown, unsigned int modifierFlags);
 typedef void (*DeviceChangeCallback)(const char* deviceId, const char* deviceName, int isBluetooth);
 
+// ============================================================
+// 0. LOGGING (MPSC ring + writer thread)
+// ============================================================
+// 原来一律 fprintf(stderr)：打包后的应用 stderr 没人接，日志等于没写；
+// 更糟的是 stderr 接在管道上、对端不读时 write 会阻塞 —— 阻塞的是采集线程，
+// 丢的是用户的音频。
+//
+// 生产者（键盘、采集、PulseAudio 回调线程都可能是）只做一次 CAS 占槽 +
+// 栈外 vsnprintf + 一个 release store：无锁、无堆分配、不进内核
+// （clock_gettime 走 vDSO）。写满时丢新的并计数，绝不等。
+// 后台写线程每 LOG_FLUSH_MS 排空一次，同时镜像到 stderr（开发时在终端里看）
+// 和日志文件（set_debug_logging(1) 时，与 macOS 的 speakout_native.log 对齐）。
+//
+// 每个槽带一个序号，第 lap 圈：2*lap = 空闲，2*lap+1 = 已发布；
+// 读者取走后写 2*(lap+1) 还给下一圈。全零初始化正好是「第 0 圈空闲」，
+// 不需要生产者可能撞上的惰性初始化。
+#define LOG_SLOTS 512
+#define LOG_LINE 240
+#define LOG_FLUSH_MS 200
+#ifndef LOG_ROTATE_BYTES
+#define LOG_ROTATE_BYTES (4L * 1024 * 1024) /* 超过就滚成 .1，只留一份旧的 */
+#endif
+
+typedef struct {
+    atomic_ulong seq;
+    struct timespec ts;
+    char line[LOG_LINE];
+} LogSlot;
+
+static LogSlot g_logRing[LOG_SLOTS];
+static atomic_ulong g_logEnqueue = 0;
+static atomic_ulong g_logDropped = 0;
+/* 读者一侧只在 g_logDrainLock 下动：写线程和 set_debug_logging 的同步排空会抢着读 */
+static pthread_mutex_t g_logDrainLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long g_logDequeue = 0;
+static FILE* g_logFile = NULL;
+static long g_logFileBytes = 0;
+static unsigned g_logFileGen = 0;
+
+static atomic_int g_debugLogging = 0;
+static char g_logDir[1024] = {0};
+static pthread_mutex_t g_logDirLock = PTHREAD_MUTEX_INITIALIZER;
+/* 目录或开关变了就 +1，写线程据此重开文件 */
+static atomic_uint g_logPathGen = 1;
+
+__attribute__((format(printf, 1, 2)))
+static void native_log(const char* fmt, ...) {
+    unsigned long pos = atomic_load_explicit(&g_logEnqueue, memory_order_relaxed);
+    LogSlot* slot;
+    for (;;) {
+        slot = &g_logRing[pos % LOG_SLOTS];
+        unsigned long seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        unsigned long freeSeq = (pos / LOG_SLOTS) * 2;
+        if (seq == freeSeq) {
+            /* 失败时 pos 被改成最新值，重来 */
+            if (atomic_compare_exchange_weak_explicit(&g_logEnqueue, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (seq < freeSeq) {
+            /* 上一圈的这条读者还没取走：环满了，丢这一条 */
+            atomic_fetch_add_explicit(&g_logDropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            /* 别的生产者先占了这个位置 */
+            pos = atomic_load_explicit(&g_logEnqueue, memory_order_relaxed);
+        }
+    }
+    clock_gettime(CLOCK_REALTIME, &slot->ts);
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(slot->line, LOG_LINE, fmt, ap);
+    va_end(ap);
+    atomic_store_explicit(&slot->seq, (pos / LOG_SLOTS) * 2 + 1, memory_order_release);
+}
+
+/* 与 Dart 侧 getApplicationSupportDirectory() 同一目录（AppLog 的 speakout.log 也在那）：
+ * path_provider 在 Linux 上取 $XDG_DATA_HOME/<APPLICATION_ID>，见 linux/CMakeLists.txt */
+static void log_file_path(char* buffer, size_t size) {
+    pthread_mutex_lock(&g_logDirLock);
+    if (g_logDir[0] != 0) {
+        snprintf(buffer, size, "%s/speakout_native.log", g_logDir);
+        pthread_mutex_unlock(&g_logDirLock);
+        return;
+    }
+    pthread_mutex_unlock(&g_logDirLock);
+    const char* xdg = getenv("XDG_DATA_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && xdg[0] == '/') {
+        snprintf(buffer, size, "%s/com.example.speakout/speakout_native.log", xdg);
+    } else {
+        snprintf(buffer, size, "%s/.local/share/com.example.speakout/speakout_native.log",
+                 home ? home : "/tmp");
+    }
+}
+
+/* 调用方持有 g_logDrainLock。返回当前该写的文件，落盘关着时为 NULL */
+static FILE* log_sink_locked(void) {
+    unsigned gen = atomic_load(&g_logPathGen);
+    if (!atomic_load(&g_debugLogging)) {
+        if (g_logFile) {
+            fclose(g_logFile);
+            g_logFile = NULL;
+        }
+        return NULL;
+    }
+    if (gen == g_logFileGen && (!g_logFile || g_logFileBytes < LOG_ROTATE_BYTES)) {
+        return g_logFile; /* 打不开的话同一个目录不反复重试，换目录或重开开关再来 */
+    }
+
+    char path[1100];
+    log_file_path(path, sizeof(path));
+    if (g_logFile) {
+        fclose(g_logFile);
+        g_logFile = NULL;
+        if (gen == g_logFileGen) {
+            char rotated[1110];
+            snprintf(rotated, sizeof(rotated), "%s.1", path);
+            rename(path, rotated);
+        }
+    }
+    g_logFileGen = gen;
+    g_logFile = fopen(path, "a");
+    if (!g_logFile) {
+        /* 默认目录在首次运行时可能还没建（Dart 侧建目录是异步的） */
+        char* slash = strrchr(path, '/');
+        if (slash) {
+            *slash = 0;
+            mkdir(path, 0700);
+            *slash = '/';
+            g_logFile = fopen(path, "a");
+        }
+    }
+    if (!g_logFile) return NULL;
+    fseek(g_logFile, 0, SEEK_END);
+    g_logFileBytes = ftell(g_logFile);
+    return g_logFile;
+}
+
+static void log_emit_locked(const struct timespec* ts, const char* line) {
+    struct tm tm;
+    time_t secs = ts->tv_sec;
+    localtime_r(&secs, &tm);
+    char stamp[32];
+    snprintf(stamp, sizeof(stamp), "[%02d:%02d:%02d.%03ld] ",
+             tm.tm_hour, tm.tm_min, tm.tm_sec, ts->tv_nsec / 1000000);
+    fprintf(stderr, "%s%s\n", stamp, line);
+    FILE* f = log_sink_locked();
+    if (f) {
+        int n = fprintf(f, "%s%s\n", stamp, line);
+        if (n > 0) g_logFileBytes += n;
+    }
+}
+
+/* 把已发布的全部写出去。遇到占了槽还没写完的就停在那，下一轮再来 */
+static void log_drain(void) {
+    pthread_mutex_lock(&g_logDrainLock);
+    for (;;) {
+        LogSlot* slot = &g_logRing[g_logDequeue % LOG_SLOTS];
+        unsigned long lap = g_logDequeue / LOG_SLOTS;
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != lap * 2 + 1) break;
+        log_emit_locked(&slot->ts, slot->line);
+        atomic_store_explicit(&slot->seq, (lap + 1) * 2, memory_order_release);
+        g_logDequeue++;
+    }
+    unsigned long dropped = atomic_exchange_explicit(&g_logDropped, 0, memory_order_relaxed);
+    if (dropped > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        char msg[64];
+        snprintf(msg, sizeof(msg), "[log] dropped %lu lines (ring full)", dropped);
+        log_emit_locked(&now, msg);
+    }
+    if (g_logFile) fflush(g_logFile);
+    pthread_mutex_unlock(&g_logDrainLock);
+}
+
+static void* log_writer_thread(void* param) {
+    (void)param;
+    for (;;) {
+        log_drain();
+        struct timespec interval = { 0, LOG_FLUSH_MS * 1000000L };
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+static pthread_once_t g_logWriterOnce = PTHREAD_ONCE_INIT;
+
+static void log_writer_start(void) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, log_writer_thread, NULL) == 0) {
+        pthread_detach(thread);
+    }
+}
+
+/* 只在 Dart 调进来的导出函数里拉起写线程：生产者线程上不能有 pthread_create。
+ * 拉起之前写的日志留在环里，起来后一并写出 */
+static void log_writer_ensure(void) {
+    pthread_once(&g_logWriterOnce, log_writer_start);
+}
+
+EXPORT void set_debug_logging(int enabled) {
+    log_writer_ensure();
+    if (enabled) {
+        if (!atomic_exchange(&g_debugLogging, 1)) atomic_fetch_add(&g_logPathGen, 1);
+        return;
+    }
+    /* 关落盘前先排空：最后一批（往往正是用户关开关前想看的几行）要落进文件 */
+    log_drain();
+    atomic_store(&g_debugLogging, 0);
+    pthread_mutex_lock(&g_logDrainLock);
+    log_sink_locked();
+    pthread_mutex_unlock(&g_logDrainLock);
+}
+
+/* 空字符串或 NULL 回到默认目录。切换前已经记下的日志落在旧目录 */
+EXPORT void set_log_directory(const char* dir) {
+    log_writer_ensure();
+    log_drain();
+    pthread_mutex_lock(&g_logDirLock);
+    if (dir == NULL || dir[0] == 0) {
+        g_logDir[0] = 0;
+    } else {
+        snprintf(g_logDir, sizeof(g_logDir), "%s", dir);
+    }
+    pthread_mutex_unlock(&g_logDirLock);
+    atomic_fetch_add(&g_logPathGen, 1);
+}
+
 // ============================================================
 // Ring Buffer for audio samples (16-bit PCM, 16kHz)
 // ============================================================
 #define RING_BUFFER_SAMPLES (16000 * 30)  // 30 seconds max
 
 static int16_t g_ringBuffer[RING_BUFFER_SAMPLES];
-static volatile long g_ringWritePos = 0;
-static volatile long g_ringReadPos = 0;
+/* 0 号读者（read_audio_buffer）静态初始化就在，不依赖谁先调 init */
+static AudioRing g_ring = {
+    .buf = g_ringBuffer,
+    .capacity = RING_BUFFER_SAMPLES,
+    .readers = {[AUDIO_RING_DEFAULT_READER] = {.active = 1}},
+};
+/* 读写都不走这把锁；它只用来叫醒在 ring 空时等数据的读者
+ * （native 解码线程，见 9. STREAMING DECODE），不空转 */
 static pthread_mutex_t g_ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ringCond = PTHREAD_COND_INITIALIZER;
 
 static void ring_init(void) {
-    g_ringWritePos = 0;
-    g_ringReadPos = 0;
+    audio_ring_reset(&g_ring);
 }
 
 static void ring_write(const int16_t* samples, int count) {
+    audio_ring_write(&g_ring, samples, count);
     pthread_mutex_lock(&g_ringLock);
-    for (int i = 0; i < count; i++) {
-        g_ringBuffer[g_ringWritePos % RING_BUFFER_SAMPLES] = samples[i];
-        g_ringWritePos++;
-    }
-    if (g_ringWritePos - g_ringReadPos > RING_BUFFER_SAMPLES) {
-        g_ringReadPos = g_ringWritePos - RING_BUFFER_SAMPLES;
-    }
-    pthread_mutex_unlock(&g_ringLock);
-}
-
-static int ring_read(int16_t* out, int maxSamples) {
-    pthread_mutex_lock(&g_ringLock);
-    long available = (long)(g_ringWritePos - g_ringReadPos);
-    if (available < 0) available = 0;
-    int toRead = (available < maxSamples) ? (int)available : maxSamples;
-    for (int i = 0; i < toRead; i++) {
-        out[i] = g_ringBuffer[g_ringReadPos % RING_BUFFER_SAMPLES];
-        g_ringReadPos++;
-    }
+    pthread_cond_broadcast(&g_ringCond);
     pthread_mutex_unlock(&g_ringLock);
-    return toRead;
-}
-
-static int ring_available(void) {
-    long available = (long)(g_ringWritePos - g_ringReadPos);
-    return (available < 0) ? 0 : (int)available;
 }
 
 // ============================================================
@@ -108,10 +339,37 @@ static int g_evdevFd = -1;
 // Audio
 static atomic_int g_isRecording = 0;
 static pthread_t g_audioThread;
+static int g_audioThreadJoinable = 0; /* 冷启动线程还没 join/detach */
 
 // Device change listener
 static DeviceChangeCallback g_deviceChangeCallback = NULL;
 
+// ============================================================
+// Latency trace stamps (CLOCK_MONOTONIC, 微秒)
+// ============================================================
+// Dart 侧的延迟追踪要知道按键和采集在 native 线程上**实际**发生的时刻：
+// 按键回调经 NativeCallable 队列投递到 Dart 时已经晚了一截，那一截正是要量的。
+// 下标与 Dart 侧的 kNativeTrace* 常量一一对应，0 = 本次还没发生。
+enum {
+    TRACE_NOW = 0,
+    TRACE_KEY_EVENT = 1,     /* 最近一次按键事件（内核打的时间戳） */
+    TRACE_CAPTURE_START = 2, /* start_audio_recording 被调用 */
+    TRACE_DEVICE_OPEN = 3,   /* 采集设备可读（常驻模式下就是按键那一刻） */
+    TRACE_FIRST_CHUNK = 4,   /* 本次录音第一块实时音频进 ring（不算 pre-roll） */
+    TRACE_STAMP_COUNT
+};
+static atomic_llong g_traceStamps[TRACE_STAMP_COUNT];
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void trace_stamp(int which, long long us) {
+    atomic_store(&g_traceStamps[which], us);
+}
+
 // ============================================================
 // 1. KEYBOARD LISTENER (evdev /dev/input)
 // ============================================================
@@ -160,8 +418,8 @@ static void* keyboard_thread_proc(void* param) {
 
     g_evdevFd = find_keyboard_device();
     if (g_evdevFd < 0) {
-        fprintf(stderr, "[NativeInput] No keyboard device found. "
-                "Try: sudo usermod -aG input $USER\n");
+        native_log("[NativeInput] No keyboard device found. "
+                   "Try: sudo usermod -aG input $USER");
         atomic_store(&g_keyListening, 0);
         return NULL;
     }
@@ -170,6 +428,11 @@ static void* keyboard_thread_proc(void* param) {
     int flags = fcntl(g_evdevFd, F_GETFL, 0);
     fcntl(g_evdevFd, F_SETFL, flags & ~O_NONBLOCK);
 
+    /* 让内核按 CLOCK_MONOTONIC 给事件打时间戳（默认是 REALTIME），
+     * 和 trace 用同一个钟；老内核不支持就退回读到事件的时刻 */
+    int clk = CLOCK_MONOTONIC;
+    int kernelStamps = ioctl(g_evdevFd, EVIOCSCLOCKID, &clk) == 0;
+
     struct input_event ev;
     while (atomic_load(&g_keyListening)) {
         fd_set fds;
@@ -186,6 +449,9 @@ static void* keyboard_thread_proc(void* param) {
         if (ev.type == EV_KEY && g_keyCallback) {
             /* ev.value: 0=up, 1=down, 2=repeat */
             if (ev.value == 0 || ev.value == 1) {
+                trace_stamp(TRACE_KEY_EVENT, kernelStamps
+                    ? (long long)ev.input_event_sec * 1000000LL + ev.input_event_usec
+                    : monotonic_us());
                 // Linux 侧暂未采集修饰键状态，显式传 0 而不是不传 ——
                 // 不传的话 Dart 读到的是残值。
                 g_keyCallback((int)ev.code, ev.value, 0u);
@@ -201,17 +467,18 @@ static void* keyboard_thread_proc(void* param) {
 // ABI 版本握手，必须与 macOS 侧的 SPEAKOUT_NATIVE_ABI_VERSION 保持一致。
 // Dart 初始化时校验：旧 dylib 没有这个 symbol 就明确报错，
 // 而不是按新签名去调旧函数、读到返回寄存器里的垃圾。
-#define SPEAKOUT_NATIVE_ABI_VERSION 0x3e3abe
+#define SPEAKOUT_NATIVE_ABI_VERSION 0x160ccb
 EXPORT int native_input_abi_version(void) { return SPEAKOUT_NATIVE_ABI_VERSION; }
 
 EXPORT int start_keyboard_listener(KeyCallback callback) {
+    log_writer_ensure();
     if (atomic_load(&g_keyListening)) return 1;
 
     g_keyCallback = callback;
     atomic_store(&g_keyListening, 1);
 
     if (pthread_create(&g_keyThread, NULL, keyboard_thread_proc, NULL) != 0) {
-        fprintf(stderr, "[NativeInput] Failed to create keyboard thread\n");
+        native_log("[NativeInput] Failed to create keyboard thread");
         atomic_store(&g_keyListening, 0);
         return 0;
     }
@@ -263,8 +530,8 @@ EXPORT int inject_text(const char* text) {
 
     int ret = system(cmd);
     if (ret != 0) {
-        fprintf(stderr, "[NativeInput] Text injection failed (ret=%d). "
-                "Install xdotool (X11) or wtype (Wayland).\n", ret);
+        native_log("[NativeInput] Text injection failed (ret=%d). "
+                   "Install xdotool (X11) or wtype (Wayland).", ret);
         return 0;
     }
     return 1;
@@ -313,73 +580,817 @@ EXPORT int check_microphone_permission(void) {
 // 5. AUDIO RECORDING (PulseAudio + Ring Buffer)
 // ============================================================
 
-static void* audio_capture_thread(void* param) {
-    (void)param;
+/*
+ * 两种采集方式：
+ *   - 冷启动（默认）：每次 start_audio_recording 新开线程 + pa_simple 连接，
+ *     设备打开之前说的字进不了 ring buffer
+ *     （docs/debug-log/2026-06-02-asr-startup-audio-gap.md）。
+ *   - 常驻（audio_warm_start，可选）：连接一直开着，不录音时写进一段环形
+ *     pre-roll；start_audio_recording 把 pre-roll 原样拼进 ring 开头 ——
+ *     没有设备打开的空窗，按键前那半秒也在。代价是麦克风一直占着：
+ *     不录音累计超过 idleReleaseMs 自己释放，audio_warm_stop 随时释放。
+ */
+#define AUDIO_CHUNK_SAMPLES 320             /* 20ms @ 16kHz */
+/* 一块转成 16k 之后最多这么多（重采样器的输出按相位走，不总是正好 320） */
+#define CAPTURE_CHUNK_MAX (AUDIO_CHUNK_SAMPLES * 2)
+#define PREROLL_MAX_SAMPLES (16000 * 2)     /* pre-roll 上限 2 秒 */
+
+static int16_t g_preroll[PREROLL_MAX_SAMPLES];
+static int g_prerollCapacity = 0;   /* 本次常驻的 pre-roll 长度（样本），0 = 不留 */
+static long g_prerollWritten = 0;   /* 上次清空以来写进 pre-roll 的样本数 */
+static long g_warmIdleSamples = 0;  /* 不录音期间累计读了多少样本 */
+static long g_warmIdleLimit = 0;    /* 超过就释放设备，0 = 不自动释放 */
+static atomic_int g_warmActive = 0; /* 调用方要求常驻（audio_warm_stop 清零） */
+static int g_warmThreadAlive = 0;   /* 常驻线程存在（含正在打开设备） */
+static int g_warmServing = 0;       /* 当前这次录音由常驻线程供数 */
+/* 常驻线程「这一块写给谁」和 start/stop 切换录音状态必须互斥：
+ * 不然按键那一刻的一块可能在拼接之后又写进 pre-roll（丢 20ms），
+ * 或者松键之后还写进 ring（下一次录音开头多出上一次的尾巴）。
+ * 锁序：g_warmLock → g_ringLock。 */
+static pthread_mutex_t g_warmLock = PTHREAD_MUTEX_INITIALIZER;
+/* stop_audio_recording_and_drain 在等常驻线程把在途的最后一块收进 ring */
+static int g_warmDrainPending = 0;
+static pthread_cond_t g_warmDrainCond = PTHREAD_COND_INITIALIZER;
+
+static struct timespec deadline_after_ms(int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+/* 调用方持有 g_warmLock。常驻线程不再给这次录音供数，唤醒在等 drain 的一方 */
+static void warm_end_recording_locked(void) {
+    g_warmServing = 0;
+    g_warmIdleSamples = 0;
+    atomic_store(&g_isRecording, 0);
+    if (g_warmDrainPending) {
+        g_warmDrainPending = 0;
+        pthread_cond_broadcast(&g_warmDrainCond);
+    }
+}
+
+/*
+ * 降噪（可选，audio_noise_suppression_set 打开）：采集线程读到一块先就地降噪再进 ring，
+ * 下游 —— Dart 轮询、native 解码、编码器 —— 拿到的都是处理过的样本。输出比输入晚
+ * NS_DELAY_SAMPLES（16ms），录音结束时把延迟线冲刷进 ring，尾巴不丢。
+ * 每块计线程 CPU 时间：连续 NS_OVERRUN_LIMIT 块超预算就转旁路（延迟线照走，不出断点），
+ * 这次录音剩下的原样通过 —— 采集线程跟不上丢的是整块音频，比噪声要命。
+ */
+#define NS_OVERRUN_LIMIT 3
+enum {
+    NS_STAT_CPU_US = 0,       /* 本次录音降噪花的线程 CPU 时间 */
+    NS_STAT_SAMPLES = 1,      /* 本次录音降噪处理过的样本数 */
+    NS_STAT_OVER_BUDGET = 2,  /* 超预算的块数 */
+    NS_STAT_BYPASSED = 3,     /* 1 = 因为超预算转了旁路 */
+    NS_STAT_MAX_CHUNK_US = 4, /* 最慢的一块 */
+    NS_STAT_COUNT
+};
+static atomic_int g_nsEnabled = 0;
+static atomic_int g_nsBudgetUs = 0; /* 每块（20ms）的 CPU 预算，<= 0 不限 */
+static atomic_int g_nsRearm = 0;    /* 新一次录音：清掉旁路，重新计超预算 */
+static atomic_llong g_nsStats[NS_STAT_COUNT];
+
+/* 一个采集线程的降噪级，只有这个线程碰 */
+typedef struct {
+    NoiseSuppressor* ns;
+    int on;
+    int overruns;      /* 连续超预算的块数 */
+    long long spentUs; /* 上一块的耗时，进 ring 时才记进统计 */
+    int over;
+} NsStage;
+
+static long long thread_cpu_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* 对读到的每一块调用，结果写进 out（容量至少 n + NS_DELAY_SAMPLES），返回写出的样本数：
+ * 通常就是 n；刚被关掉时先吐出延迟线里的尾巴，再接原样 */
+static int ns_stage_run(NsStage* st, const int16_t* in, int16_t* out, int n) {
+    int want = atomic_load(&g_nsEnabled);
+    int k = 0;
+    st->spentUs = 0;
+    st->over = 0;
+    if (want && !st->on) {
+        if (st->ns) ns_reset(st->ns);
+        else st->ns = ns_create();
+        st->on = st->ns != NULL;
+        st->overruns = 0;
+    } else if (!want && st->on) {
+        k = ns_flush(st->ns, out);
+        st->on = 0;
+    }
+    if (!st->on) {
+        memcpy(out + k, in, sizeof(int16_t) * n);
+        return k + n;
+    }
+    if (atomic_exchange(&g_nsRearm, 0)) {
+        ns_set_bypass(st->ns, 0);
+        st->overruns = 0;
+    }
+
+    long long t0 = thread_cpu_us();
+    ns_process(st->ns, in, out, n);
+    st->spentUs = thread_cpu_us() - t0;
+    int budget = atomic_load(&g_nsBudgetUs);
+    st->over = budget > 0 && st->spentUs > budget;
+    st->overruns = st->over ? st->overruns + 1 : 0;
+    if (st->overruns == NS_OVERRUN_LIMIT) {
+        ns_set_bypass(st->ns, 1);
+        atomic_store(&g_nsStats[NS_STAT_BYPASSED], 1);
+        native_log("[Audio] noise suppression over budget (%lldus > %dus), bypassing",
+                   st->spentUs, budget);
+    }
+    return n;
+}
+
+/* 这一块进了 ring：记进本次录音的统计 */
+static void ns_stage_account(const NsStage* st, int n) {
+    if (!st->on) return;
+    atomic_fetch_add(&g_nsStats[NS_STAT_CPU_US], st->spentUs);
+    atomic_fetch_add(&g_nsStats[NS_STAT_SAMPLES], n);
+    if (st->over) atomic_fetch_add(&g_nsStats[NS_STAT_OVER_BUDGET], 1);
+    if (st->spentUs > atomic_load(&g_nsStats[NS_STAT_MAX_CHUNK_US])) {
+        atomic_store(&g_nsStats[NS_STAT_MAX_CHUNK_US], st->spentUs);
+    }
+}
+
+/*
+ * 自动增益（可选，audio_agc_set 打开）：接在降噪后面 —— 先把底噪压下去，
+ * 噪声门看到的噪底才干净，也不会把没压掉的噪声一起放大。
+ * 输出比输入再晚一帧（10ms），录音结束时和降噪的延迟线一起冲刷。
+ * 录音结束时的增益记下来，下一次录音从它开始，不用每次从 0dB 爬。
+ * 每帧的电平 / 增益 / 限幅 / 门状态抄进一个全局轨迹，audio_agc_trace 读，调试用。
+ */
+static atomic_int g_agcEnabled = 0;
+static atomic_int g_agcTargetDbfs = -20; /* 下次打开时生效 */
+static atomic_int g_agcMaxGainDb = 30;
+static atomic_int g_agcSeedMilliDb = 0;  /* 最近的增益，新实例从它开始 */
+/* 本次录音的轨迹，环形；和 ring 一样长，整段录音都看得到 */
+#define AGC_SESSION_TRACE_FRAMES (RING_BUFFER_SAMPLES / AGC_FRAME_SAMPLES)
+static pthread_mutex_t g_agcTraceLock = PTHREAD_MUTEX_INITIALIZER;
+static AgcTracePoint g_agcTrace[AGC_SESSION_TRACE_FRAMES];
+static long long g_agcTraceCount = 0;
+
+/* 一个采集线程的自动增益级，只有这个线程碰 */
+typedef struct {
+    Agc* agc;
+    int on;
+    long long published; /* 已经抄进全局轨迹的帧数 */
+} AgcStage;
+
+/* 降噪之后调用，结果写进 out（容量至少 n + 2 × AGC_FRAME_SAMPLES），返回写出的样本数 */
+static int agc_stage_run(AgcStage* st, const int16_t* in, int16_t* out, int n) {
+    int want = atomic_load(&g_agcEnabled);
+    int k = 0;
+    if (want && !st->on) {
+        AgcConfig cfg;
+        agc_default_config(&cfg);
+        cfg.targetDbfs = (float)atomic_load(&g_agcTargetDbfs);
+        cfg.maxGainDb = (float)atomic_load(&g_agcMaxGainDb);
+        agc_free(st->agc);
+        st->agc = agc_create(&cfg);
+        st->on = st->agc != NULL;
+        if (st->on) agc_seed(st->agc, atomic_load(&g_agcSeedMilliDb) / 1000.0f);
+        st->published = 0;
+    } else if (!want && st->on) {
+        k = agc_flush(st->agc, out);
+        st->on = 0;
+    }
+    if (!st->on) {
+        memcpy(out + k, in, sizeof(int16_t) * n);
+        return k + n;
+    }
+    return agc_process(st->agc, in, out, n);
+}
+
+/* 这一块处理完：录音中（publish）就把新帧抄进全局轨迹，不录音时跳过 */
+static void agc_stage_account(AgcStage* st, int publish) {
+    if (!st->on) return;
+    atomic_store(&g_agcSeedMilliDb, (int)lrintf(agc_gain_db(st->agc) * 1000.0f));
+    long long frames = agc_frame_count(st->agc);
+    if (st->published < frames - AGC_TRACE_FRAMES) st->published = frames - AGC_TRACE_FRAMES;
+    if (publish) {
+        AgcTracePoint pts[8];
+        int got;
+        pthread_mutex_lock(&g_agcTraceLock);
+        while ((got = agc_trace(st->agc, st->published, pts, 8)) > 0) {
+            for (int i = 0; i < got; i++) {
+                g_agcTrace[(g_agcTraceCount + i) % AGC_SESSION_TRACE_FRAMES] = pts[i];
+            }
+            g_agcTraceCount += got;
+            st->published += got;
+        }
+        pthread_mutex_unlock(&g_agcTraceLock);
+    }
+    st->published = frames;
+}
+
+/* 一块 16k 样本过降噪、自动增益，写进 ring */
+static void capture_stages_to_ring(NsStage* ns, AgcStage* agc, const int16_t* in, int n) {
+    int16_t mid[CAPTURE_CHUNK_MAX + NS_DELAY_SAMPLES];
+    int16_t out[CAPTURE_CHUNK_MAX + NS_DELAY_SAMPLES + 2 * AGC_FRAME_SAMPLES];
+    int k = ns_stage_run(ns, in, mid, n);
+    int m = agc_stage_run(agc, mid, out, k);
+    ring_write(out, m);
+    ns_stage_account(ns, k);
+    agc_stage_account(agc, 1);
+}
+
+/* 录音结束：重采样器压着的尾巴照常走一遍两级；再把降噪延迟线里的最后 16ms
+ * 过一遍自动增益，连同它自己压着的那一帧写进 ring */
+static void capture_stages_flush_to_ring(Resampler* rs, NsStage* ns, AgcStage* agc) {
+    if (rs) {
+        int16_t rest[CAPTURE_CHUNK_MAX];
+        int r = rs_flush(rs, rest);
+        if (r > 0) capture_stages_to_ring(ns, agc, rest, r);
+    }
+    int16_t tail[NS_DELAY_SAMPLES];
+    int16_t out[NS_DELAY_SAMPLES + 2 * AGC_FRAME_SAMPLES];
+    int k = ns->on ? ns_flush(ns->ns, tail) : 0;
+    if (!agc->on) {
+        ring_write(tail, k);
+        return;
+    }
+    int m = agc_process(agc->agc, tail, out, k);
+    m += agc_flush(agc->agc, out + m);
+    ring_write(out, m);
+    agc_stage_account(agc, 1);
+}
+
+/*
+ * 电平表：Dart 每 ~80ms 轮询一次，驱动波形和「没声音」提示。
+ * 以前 Linux 库不导出 get_audio_level，Dart 侧绑定失败按 0 算 —— 静音提示一开录就亮。
+ * 取 ring 里最新 10ms（过了降噪和自动增益，和识别看到的是同一份），映射和平滑与 macOS 一致：
+ * -54dBFS 以下记 0，-40dBFS 以上记 1，立刻升、约 500ms 衰减。
+ */
+static pthread_mutex_t g_levelLock = PTHREAD_MUTEX_INITIALIZER;
+static float g_level = 0.0f;
+static long long g_levelStampUs = 0;
+
+/* 新录音开始时复位：不然接着上一段结尾的高电平往下衰减，静音判定跟着延后 */
+static void level_reset(void) {
+    pthread_mutex_lock(&g_levelLock);
+    g_level = 0.0f;
+    g_levelStampUs = monotonic_us();
+    pthread_mutex_unlock(&g_levelLock);
+}
+
+EXPORT float get_audio_level(void) {
+    if (!atomic_load(&g_isRecording)) return 0.0f;
+    enum { WINDOW = 160 };
+    int16_t window[WINDOW];
+    if (audio_ring_latest(&g_ring, window, WINDOW) < WINDOW) return 0.0f;
+
+    DspStats st;
+    dsp_kernels()->stats_i16(window, WINDOW, &st);
+    double rms = dsp_stats_rms(&st, WINDOW);
+    float level = rms < 0.002 ? 0.0f : (float)((20.0 * log10(rms) + 54.0) / 14.0);
+    if (level > 1.0f) level = 1.0f;
+
+    long long now = monotonic_us();
+    pthread_mutex_lock(&g_levelLock);
+    if (level >= g_level) {
+        g_level = level;
+    } else {
+        long long delta = now > g_levelStampUs ? now - g_levelStampUs : 0;
+        double keep = pow(0.88, delta / 80000.0); /* 每 80ms 保留 88% */
+        g_level = (float)(g_level * keep + level * (1.0 - keep));
+    }
+    g_levelStampUs = now;
+    float result = g_level;
+    pthread_mutex_unlock(&g_levelLock);
+    return result;
+}
+
+/*
+ * 采集格式：以前直接向 PulseAudio 要 16k 单声道，它用默认的 speex-float-1 之类的
+ * 低档重采样，7~8kHz 往上的能量折回语音频段。现在按默认 source 的原生采样率和声道数
+ * 打开（pactl list sources short 的 sample_spec），采集线程上用 Resampler 转成
+ * 16k 单声道再进降噪 / 自动增益。原生就是 16k、或者采样率不认识时照旧让 PulseAudio 转。
+ *
+ * 探测要 popen pactl（几十毫秒），结果缓存：第一次录音 / 挂常驻时探一次，
+ * set_input_device 之后重探。外面换了默认设备而缓存没跟上也不要紧 —— 按旧格式打开，
+ * PulseAudio 自己转过来，录音不受影响，只是又回到它的重采样。
+ * SPEAKOUT_CAPTURE_RATE=采样率[/声道] 强制格式（16000 = 老路子），排查和测试用。
+ */
+#define CAPTURE_MAX_RATE 96000
+#define CAPTURE_RAW_MAX (CAPTURE_MAX_RATE / 50 * RS_MAX_CHANNELS)
+
+static pthread_mutex_t g_captureFormatLock = PTHREAD_MUTEX_INITIALIZER;
+static int g_captureRate = 0;      /* 0 = 还没探测 */
+static int g_captureChannels = 1;
+
+/* "s16le 2ch 48000Hz" → 48000 / 2；认不出返回 0 */
+static int parse_sample_spec(const char* spec, int* rate, int* channels) {
+    const char* ch = spec ? strstr(spec, "ch ") : NULL;
+    if (!ch) return 0;
+    const char* p = ch;
+    while (p > spec && p[-1] >= '0' && p[-1] <= '9') p--;
+    int c = atoi(p);
+    int r = atoi(ch + 3);
+    if (c <= 0 || r <= 0) return 0;
+    *rate = r;
+    *channels = c;
+    return 1;
+}
+
+/* 默认 source 的原生格式；拿不到就当 16k 单声道 */
+static void capture_format_probe(int* rate, int* channels) {
+    *rate = 16000;
+    *channels = 1;
+    char def[512] = {0};
+    FILE* fp = popen("pactl get-default-source 2>/dev/null", "r");
+    if (!fp) return;
+    if (!fgets(def, sizeof(def), fp)) def[0] = '\0';
+    pclose(fp);
+    def[strcspn(def, "\n")] = '\0';
+    if (!def[0]) return;
+
+    fp = popen("pactl list sources short 2>/dev/null", "r");
+    if (!fp) return;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        /* index\tname\tmodule\tsample_spec\tstate */
+        strtok(line, "\t");
+        char* name = strtok(NULL, "\t");
+        strtok(NULL, "\t");
+        char* spec = strtok(NULL, "\t");
+        if (name && strcmp(name, def) == 0) {
+            parse_sample_spec(spec, rate, channels);
+            break;
+        }
+    }
+    pclose(fp);
+}
+
+static void capture_format(int* rate, int* channels) {
+    const char* forced = getenv("SPEAKOUT_CAPTURE_RATE");
+    if (forced && atoi(forced) > 0) {
+        const char* slash = strchr(forced, '/');
+        *rate = atoi(forced);
+        *channels = slash && atoi(slash + 1) > 0 ? atoi(slash + 1) : 1;
+        return;
+    }
+    pthread_mutex_lock(&g_captureFormatLock);
+    if (g_captureRate == 0) {
+        capture_format_probe(&g_captureRate, &g_captureChannels);
+        native_log("[Audio] default source native format %dHz x%d", g_captureRate, g_captureChannels);
+    }
+    *rate = g_captureRate;
+    *channels = g_captureChannels;
+    pthread_mutex_unlock(&g_captureFormatLock);
+}
+
+/* 一个采集线程的输入端：设备连接 + 重采样器，只有这个线程碰 */
+typedef struct {
+    pa_simple* s;
+    Resampler* rs; /* NULL = 设备直接给 16k 单声道 */
+    int frames;    /* 每次读 20ms 的帧数 */
+    int channels;
+    int16_t raw[CAPTURE_RAW_MAX];
+} CaptureSource;
+
+static int audio_open_capture(CaptureSource* src) {
+    int rate, channels;
+    capture_format(&rate, &channels);
+    if (channels > RS_MAX_CHANNELS) channels = RS_MAX_CHANNELS;
+    src->rs = NULL;
+    if (rate != 16000 && rate <= CAPTURE_MAX_RATE) {
+        src->rs = rs_create(rate, channels, 16000);
+        /* 输出上限超过块缓冲的怪采样率不接，照旧让 PulseAudio 转 */
+        if (src->rs && rs_max_output(src->rs, rate / 50) > CAPTURE_CHUNK_MAX) {
+            rs_free(src->rs);
+            src->rs = NULL;
+        }
+    }
+    if (!src->rs) {
+        rate = 16000;
+        channels = 1;
+    }
+    src->frames = rate / 50;
+    src->channels = channels;
 
     pa_sample_spec ss = {
         .format = PA_SAMPLE_S16LE,
-        .rate = 16000,
-        .channels = 1
+        .rate = (uint32_t)rate,
+        .channels = (uint8_t)channels
     };
 
     int error;
-    pa_simple* s = pa_simple_new(NULL, "SpeakOut", PA_STREAM_RECORD,
-                                  NULL, "audio_capture", &ss, NULL, NULL, &error);
-    if (!s) {
-        fprintf(stderr, "[Audio] PulseAudio open failed: %s\n", pa_strerror(error));
+    src->s = pa_simple_new(NULL, "SpeakOut", PA_STREAM_RECORD,
+                           NULL, "audio_capture", &ss, NULL, NULL, &error);
+    if (!src->s) {
+        /* 只记错误码：pa_strerror 首次调用要初始化 gettext（读 .mo 文件），
+         * 这里是采集线程 */
+        native_log("[Audio] PulseAudio open failed: %d", error);
+        rs_free(src->rs);
+        src->rs = NULL;
+        return 0;
+    }
+    if (src->rs) {
+        native_log("[Audio] capturing %dHz x%d, resampling to 16k in-process (%d taps)",
+                   rate, channels, rs_taps(src->rs));
+    }
+    return 1;
+}
+
+/* 读 20ms，转成 16k 单声道写进 out（容量 CAPTURE_CHUNK_MAX），返回样本数；读失败返回 -1 */
+static int audio_read_capture(CaptureSource* src, int16_t* out, int* error) {
+    if (!src->rs) {
+        if (pa_simple_read(src->s, out, sizeof(int16_t) * AUDIO_CHUNK_SAMPLES, error) < 0) return -1;
+        return AUDIO_CHUNK_SAMPLES;
+    }
+    size_t bytes = sizeof(int16_t) * (size_t)src->frames * src->channels;
+    if (pa_simple_read(src->s, src->raw, bytes, error) < 0) return -1;
+    return rs_process_i16(src->rs, src->raw, src->frames, out);
+}
+
+static void audio_close_capture(CaptureSource* src) {
+    pa_simple_free(src->s);
+    rs_free(src->rs);
+    src->s = NULL;
+    src->rs = NULL;
+}
+
+static void* audio_capture_thread(void* param) {
+    (void)param;
+
+    CaptureSource src; /* raw 缓冲 30KB，放线程栈上（默认 8MB） */
+    if (!audio_open_capture(&src)) {
         atomic_store(&g_isRecording, 0);
         return NULL;
     }
+    trace_stamp(TRACE_DEVICE_OPEN, monotonic_us());
 
-    /* Read in 20ms chunks: 16000 * 0.02 = 320 samples */
-    int16_t buf[320];
+    int16_t buf[CAPTURE_CHUNK_MAX];
+    NsStage ns = {0};
+    AgcStage agc = {0};
+    int error;
+    int first = 1;
 
     while (atomic_load(&g_isRecording)) {
-        if (pa_simple_read(s, buf, sizeof(buf), &error) < 0) {
-            fprintf(stderr, "[Audio] PulseAudio read error: %s\n", pa_strerror(error));
+        int got = audio_read_capture(&src, buf, &error);
+        if (got < 0) {
+            native_log("[Audio] PulseAudio read error: %d", error);
+            atomic_store(&g_isRecording, 0);
             break;
         }
-        ring_write(buf, 320);
+        capture_stages_to_ring(&ns, &agc, buf, got);
+        if (first) {
+            trace_stamp(TRACE_FIRST_CHUNK, monotonic_us());
+            first = 0;
+        }
     }
+    /* 在 join 返回之前写进去：drain 报的结束位置要包含它 */
+    capture_stages_flush_to_ring(src.rs, &ns, &agc);
+    ns_free(ns.ns);
+    agc_free(agc.agc);
+
+    /* 正常退出时不再清录音标志：它已经是 0；松键后紧接着又按下时，
+     * 这里再清一次会把新开的那次录音掐掉 */
+    audio_close_capture(&src);
+    return NULL;
+}
 
-    pa_simple_free(s);
-    atomic_store(&g_isRecording, 0);
+/* 等冷启动采集线程退出（它会先把在途的那一块写进 ring），最多 timeoutMs；
+ * 超时就 detach，让它读完自己结束 */
+static int audio_join_capture_thread(int timeoutMs) {
+    if (!g_audioThreadJoinable) return 1;
+    g_audioThreadJoinable = 0;
+    struct timespec deadline = deadline_after_ms(timeoutMs);
+    if (pthread_timedjoin_np(g_audioThread, NULL, &deadline) != 0) {
+        native_log("[Audio] capture thread did not exit within %dms", timeoutMs);
+        pthread_detach(g_audioThread);
+        return 0;
+    }
+    return 1;
+}
+
+/* 调用方持有 g_warmLock */
+static void preroll_write_locked(const int16_t* samples, int count) {
+    if (g_prerollCapacity <= 0) return;
+    for (int i = 0; i < count; i++) {
+        g_preroll[g_prerollWritten % g_prerollCapacity] = samples[i];
+        g_prerollWritten++;
+    }
+}
+
+/* 调用方持有 g_warmLock。按时间顺序把 pre-roll 拼进 ring，然后清空 */
+static void preroll_splice_locked(void) {
+    long n = g_prerollWritten < g_prerollCapacity ? g_prerollWritten : g_prerollCapacity;
+    if (n > 0) {
+        int head = (int)((g_prerollWritten - n) % g_prerollCapacity);
+        int first = (int)n < g_prerollCapacity - head ? (int)n : g_prerollCapacity - head;
+        ring_write(&g_preroll[head], first);
+        if (first < n) ring_write(g_preroll, (int)n - first);
+    }
+    g_prerollWritten = 0;
+}
+
+static void* audio_warm_thread(void* param) {
+    (void)param;
+
+    CaptureSource src;
+    if (!audio_open_capture(&src)) {
+        pthread_mutex_lock(&g_warmLock);
+        g_warmThreadAlive = 0;
+        atomic_store(&g_warmActive, 0);
+        /* 设备还没打开就按了键：那次录音已经置了标志，却没人给它写 */
+        if (g_warmServing) warm_end_recording_locked();
+        pthread_mutex_unlock(&g_warmLock);
+        return NULL;
+    }
+    native_log("[Audio] warm capture open (pre-roll %d samples)", g_prerollCapacity);
+
+    int16_t buf[CAPTURE_CHUNK_MAX];
+    int16_t mid[CAPTURE_CHUNK_MAX + NS_DELAY_SAMPLES];
+    int16_t out[CAPTURE_CHUNK_MAX + NS_DELAY_SAMPLES + 2 * AGC_FRAME_SAMPLES];
+    /* 不录音时也降噪、也过自动增益（写进 pre-roll 的也是处理过的）：
+     * 流不断，噪声估计和噪底一直是热的 */
+    NsStage ns = {0};
+    AgcStage agc = {0};
+    int error;
+
+    for (;;) {
+        int got = audio_read_capture(&src, buf, &error);
+        int ok = got >= 0;
+        int k = ok ? ns_stage_run(&ns, buf, mid, got) : 0;
+        int n = ok ? agc_stage_run(&agc, mid, out, k) : 0;
+        pthread_mutex_lock(&g_warmLock);
+        if (!ok) {
+            native_log("[Audio] PulseAudio read error: %d", error);
+            atomic_store(&g_warmActive, 0);
+            if (g_warmServing) {
+                capture_stages_flush_to_ring(src.rs, &ns, &agc);
+                warm_end_recording_locked();
+            }
+        } else if (g_warmServing) {
+            /* 录音中途 audio_warm_stop：这次照常录完，松键后再释放 */
+            ring_write(out, n);
+            ns_stage_account(&ns, k);
+            agc_stage_account(&agc, 1);
+            if (atomic_load(&g_traceStamps[TRACE_FIRST_CHUNK]) == 0) {
+                trace_stamp(TRACE_FIRST_CHUNK, monotonic_us());
+            }
+            /* 松键时在途的这一块已经收进 ring，录音到此为止 */
+            if (g_warmDrainPending) {
+                capture_stages_flush_to_ring(src.rs, &ns, &agc);
+                warm_end_recording_locked();
+            }
+        } else if (atomic_load(&g_warmActive)) {
+            agc_stage_account(&agc, 0);
+            preroll_write_locked(out, n);
+            g_warmIdleSamples += got;
+            if (g_warmIdleLimit > 0 && g_warmIdleSamples >= g_warmIdleLimit) {
+                native_log("[Audio] warm capture idle, releasing device");
+                atomic_store(&g_warmActive, 0);
+            }
+        }
+        if (!atomic_load(&g_warmActive) && !g_warmServing) {
+            g_warmThreadAlive = 0;
+            g_prerollWritten = 0;
+            pthread_mutex_unlock(&g_warmLock);
+            break;
+        }
+        pthread_mutex_unlock(&g_warmLock);
+    }
+
+    ns_free(ns.ns);
+    agc_free(agc.agc);
+    audio_close_capture(&src);
     return NULL;
 }
 
 EXPORT int start_audio_recording(void) {
+    log_writer_ensure();
     if (atomic_load(&g_isRecording)) return 1;
 
+    long long now = monotonic_us();
+    pthread_mutex_lock(&g_warmLock);
+    trace_stamp(TRACE_CAPTURE_START, now);
+    trace_stamp(TRACE_DEVICE_OPEN, 0);
+    trace_stamp(TRACE_FIRST_CHUNK, 0);
+    for (int i = 0; i < NS_STAT_COUNT; i++) atomic_store(&g_nsStats[i], 0);
+    atomic_store(&g_nsRearm, 1);
+    pthread_mutex_lock(&g_agcTraceLock);
+    g_agcTraceCount = 0;
+    pthread_mutex_unlock(&g_agcTraceLock);
+    level_reset();
+    if (g_warmThreadAlive && atomic_load(&g_warmActive)) {
+        trace_stamp(TRACE_DEVICE_OPEN, now);
+        ring_init();
+        preroll_splice_locked();
+        g_warmIdleSamples = 0;
+        g_warmServing = 1;
+        atomic_store(&g_isRecording, 1);
+        pthread_mutex_unlock(&g_warmLock);
+        return 1;
+    }
+    pthread_mutex_unlock(&g_warmLock);
+
+    /* 上一个线程读出错自己退了、没人 join 过 */
+    audio_join_capture_thread(100);
     ring_init();
     atomic_store(&g_isRecording, 1);
 
     if (pthread_create(&g_audioThread, NULL, audio_capture_thread, NULL) != 0) {
-        fprintf(stderr, "[Audio] Failed to create audio thread\n");
+        native_log("[Audio] Failed to create audio thread");
         atomic_store(&g_isRecording, 0);
         return 0;
     }
-    pthread_detach(g_audioThread);
+    g_audioThreadJoinable = 1;
     return 1;
 }
 
 EXPORT int stop_audio_recording(void) {
+    pthread_mutex_lock(&g_warmLock);
+    g_warmServing = 0;
+    g_warmIdleSamples = 0;
     atomic_store(&g_isRecording, 0);
-    /* Wait briefly for thread to finish */
-    usleep(100000); /* 100ms */
+    pthread_mutex_unlock(&g_warmLock);
+    /* 常驻模式没有冷启动线程，立即返回 */
+    audio_join_capture_thread(100);
+    return 1;
+}
+
+/* 停源，等在途的最后一块收进 ring（pa_simple_read 只交整块，最多 20ms），
+ * 返回 ring 的结束位置 —— 本次录音写进 ring 的样本总数（含常驻模式拼进来的
+ * pre-roll）。调用方读到这个位置就是全部音频，不必在松键后固定等一段时间
+ * 「给最后的音频留时间」。超过 timeoutMs 还没收完就按已经收到的算。 */
+EXPORT long long stop_audio_recording_and_drain(int timeoutMs) {
+    if (timeoutMs < 0) timeoutMs = 0;
+    pthread_mutex_lock(&g_warmLock);
+    if (g_warmServing) {
+        g_warmDrainPending = 1;
+        struct timespec deadline = deadline_after_ms(timeoutMs);
+        while (g_warmDrainPending) {
+            if (pthread_cond_timedwait(&g_warmDrainCond, &g_warmLock, &deadline) == ETIMEDOUT) {
+                native_log("[Audio] drain timed out after %dms", timeoutMs);
+                break;
+            }
+        }
+        if (g_warmServing) warm_end_recording_locked();
+        pthread_mutex_unlock(&g_warmLock);
+    } else {
+        atomic_store(&g_isRecording, 0);
+        pthread_mutex_unlock(&g_warmLock);
+        audio_join_capture_thread(timeoutMs);
+    }
+
+    return (long long)audio_ring_written(&g_ring);
+}
+
+/* 挂上常驻采集。已经挂着时只更新参数；正在录（冷启动那一路）时返回 0，
+ * 由调用方录完再挂。设备在后台线程里打开，打开失败会自己退回未挂状态。 */
+EXPORT int audio_warm_start(int prerollMs, int idleReleaseMs) {
+    log_writer_ensure();
+    if (prerollMs < 0) prerollMs = 0;
+    long prerollSamples = (long)prerollMs * 16;
+    if (prerollSamples > PREROLL_MAX_SAMPLES) prerollSamples = PREROLL_MAX_SAMPLES;
+
+    pthread_mutex_lock(&g_warmLock);
+    if (atomic_load(&g_isRecording) && !g_warmServing) {
+        pthread_mutex_unlock(&g_warmLock);
+        return 0;
+    }
+    if ((int)prerollSamples != g_prerollCapacity) {
+        g_prerollCapacity = (int)prerollSamples;
+        g_prerollWritten = 0;
+    }
+    g_warmIdleLimit = idleReleaseMs > 0 ? (long)idleReleaseMs * 16 : 0;
+    g_warmIdleSamples = 0;
+    atomic_store(&g_warmActive, 1);
+    if (g_warmThreadAlive) {
+        pthread_mutex_unlock(&g_warmLock);
+        return 1;
+    }
+    g_warmThreadAlive = 1;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, audio_warm_thread, NULL) != 0) {
+        native_log("[Audio] Failed to create warm capture thread");
+        g_warmThreadAlive = 0;
+        atomic_store(&g_warmActive, 0);
+        pthread_mutex_unlock(&g_warmLock);
+        return 0;
+    }
+    pthread_detach(thread);
+    pthread_mutex_unlock(&g_warmLock);
+    return 1;
+}
+
+/* 释放常驻采集（隐私 / 省电）。线程读完手上这一块就关设备；
+ * 正在录的那次照常录完，松键后才关。 */
+EXPORT void audio_warm_stop(void) {
+    pthread_mutex_lock(&g_warmLock);
+    atomic_store(&g_warmActive, 0);
+    g_prerollWritten = 0;
+    pthread_mutex_unlock(&g_warmLock);
+}
+
+EXPORT int is_audio_warm(void) {
+    pthread_mutex_lock(&g_warmLock);
+    int warm = g_warmThreadAlive && atomic_load(&g_warmActive);
+    pthread_mutex_unlock(&g_warmLock);
+    return warm;
+}
+
+/* 打开 / 关闭采集降噪，budgetUs 是每 20ms 一块的 CPU 预算（<= 0 不限）。
+ * 下一块生效：常驻模式下开关的那一刻流里会有 16ms 的延迟线静音，所以 Dart 在
+ * provider 就绪时就按它的设置调用，不等按键。 */
+EXPORT int audio_noise_suppression_set(int enabled, int budgetUs) {
+    atomic_store(&g_nsBudgetUs, budgetUs);
+    atomic_store(&g_nsEnabled, enabled ? 1 : 0);
+    return 1;
+}
+
+/* 本次录音的降噪统计，which 见 NS_STAT_*；越界返回 -1 */
+EXPORT long long audio_noise_suppression_stat(int which) {
+    if (which < 0 || which >= NS_STAT_COUNT) return -1;
+    return atomic_load(&g_nsStats[which]);
+}
+
+/* 打开 / 关闭采集自动增益。targetDbfs 是说话段的目标电平，maxGainDb 是最多放大多少；
+ * 这两个在下次打开时生效（开着时改只记下）。 */
+EXPORT int audio_agc_set(int enabled, int targetDbfs, int maxGainDb) {
+    if (targetDbfs > 0) targetDbfs = 0;
+    if (targetDbfs < -40) targetDbfs = -40;
+    if (maxGainDb < 0) maxGainDb = 0;
+    if (maxGainDb > 40) maxGainDb = 40;
+    atomic_store(&g_agcTargetDbfs, targetDbfs);
+    atomic_store(&g_agcMaxGainDb, maxGainDb);
+    atomic_store(&g_agcEnabled, enabled ? 1 : 0);
     return 1;
 }
 
+/* 本次录音的增益轨迹，每帧（10ms）4 个 float：输入电平 dBFS、增益 dB、限幅 dB、门开（1/0），
+ * 按时间顺序写最近的 maxPoints 帧，返回帧数。最多留 30 秒（和 ring 一样长）。 */
+EXPORT int audio_agc_trace(float* out, int maxPoints) {
+    if (!out || maxPoints <= 0) return 0;
+    pthread_mutex_lock(&g_agcTraceLock);
+    long long kept = g_agcTraceCount < AGC_SESSION_TRACE_FRAMES ? g_agcTraceCount : AGC_SESSION_TRACE_FRAMES;
+    int n = kept < maxPoints ? (int)kept : maxPoints;
+    for (int i = 0; i < n; i++) {
+        const AgcTracePoint* p = &g_agcTrace[(g_agcTraceCount - n + i) % AGC_SESSION_TRACE_FRAMES];
+        out[i * 4] = p->levelDbfs;
+        out[i * 4 + 1] = p->gainDb;
+        out[i * 4 + 2] = p->limiterDb;
+        out[i * 4 + 3] = (float)p->gateOpen;
+    }
+    pthread_mutex_unlock(&g_agcTraceLock);
+    return n;
+}
+
+/* 取一个 trace 时刻（CLOCK_MONOTONIC 微秒），which 见 TRACE_* 枚举。
+ * TRACE_NOW 给 Dart 对钟用；本次还没发生或 which 越界返回 -1。 */
+EXPORT long long native_trace_stamp_us(int which) {
+    if (which == TRACE_NOW) return monotonic_us();
+    if (which < 0 || which >= TRACE_STAMP_COUNT) return -1;
+    long long us = atomic_load(&g_traceStamps[which]);
+    return us > 0 ? us : -1;
+}
+
 EXPORT int is_audio_recording(void) {
     return atomic_load(&g_isRecording) ? 1 : 0;
 }
 
 EXPORT int get_available_audio_samples(void) {
-    return ring_available();
+    return audio_ring_available(&g_ring, AUDIO_RING_DEFAULT_READER);
 }
 
 EXPORT int read_audio_buffer(int16_t* outSamples, int maxSamples) {
-    if (!outSamples || maxSamples <= 0) return 0;
-    return ring_read(outSamples, maxSamples);
+    return audio_ring_read(&g_ring, AUDIO_RING_DEFAULT_READER, outSamples, maxSamples);
+}
+
+/* 多读者：read_audio_buffer 之外再要一路样本（VAD、落盘、第二路识别……）就开一个自己的读者，
+ * 游标各走各的，谁也不抢谁的。fromOldest=1 从本次录音还留在 ring 里的最早样本开始，
+ * 0 从现在开始。返回读者编号，槽满返回 -1。用完 audio_reader_close。 */
+EXPORT int audio_reader_open(int fromOldest) {
+    return audio_ring_register(&g_ring, fromOldest ? AUDIO_RING_FROM_OLDEST : AUDIO_RING_FROM_NOW);
+}
+
+EXPORT void audio_reader_close(int reader) {
+    audio_ring_unregister(&g_ring, reader);
+}
+
+EXPORT int audio_reader_available(int reader) {
+    return audio_ring_available(&g_ring, reader);
+}
+
+EXPORT int audio_reader_read(int reader, int16_t* outSamples, int maxSamples) {
+    return audio_ring_read(&g_ring, reader, outSamples, maxSamples);
+}
+
+/* 这个读者读得太慢、被写者追上丢掉的样本数（新录音清零）；编号无效返回 -1 */
+EXPORT long long audio_reader_overrun(int reader) {
+    return audio_ring_overrun(&g_ring, reader);
 }
 
 EXPORT void native_free(void* ptr) {
@@ -406,7 +1417,11 @@ EXPORT const char* get_audio_input_devices(void) {
         /* Format: index\tname\tmodule\tsample_spec\tstate */
         char* idx_str = strtok(line, "\t");
         char* name = strtok(NULL, "\t");
+        strtok(NULL, "\t");
+        char* spec = strtok(NULL, "\t");
         if (!idx_str || !name) continue;
+        int rate = 16000, channels = 1;
+        parse_sample_spec(spec, &rate, &channels);
 
         /* Skip monitor sources (output monitors, not input) */
         if (strstr(name, ".monitor")) continue;
@@ -415,9 +1430,10 @@ EXPORT const char* get_audio_input_devices(void) {
         first = 0;
 
         offset += snprintf(g_jsonBuffer + offset, sizeof(g_jsonBuffer) - offset,
-            "{\"id\":\"%s\",\"name\":\"%s\",\"isBluetooth\":%s,\"isBuiltIn\":false,\"sampleRate\":16000}",
+            "{\"id\":\"%s\",\"name\":\"%s\",\"isBluetooth\":%s,\"isBuiltIn\":false,\"sampleRate\":%d}",
             name, name,
-            strstr(name, "bluez") ? "true" : "false"
+            strstr(name, "bluez") ? "true" : "false",
+            rate
         );
 
         if (offset >= (int)sizeof(g_jsonBuffer) - 256) break;
@@ -452,7 +1468,12 @@ EXPORT int set_input_device(const char* deviceUID) {
     if (!deviceUID) return 0;
     char cmd[1024];
     snprintf(cmd, sizeof(cmd), "pactl set-default-source '%s' 2>/dev/null", deviceUID);
-    return system(cmd) == 0 ? 1 : 0;
+    int ok = system(cmd) == 0;
+    /* 新设备的原生格式下次打开时重探 */
+    pthread_mutex_lock(&g_captureFormatLock);
+    g_captureRate = 0;
+    pthread_mutex_unlock(&g_captureFormatLock);
+    return ok ? 1 : 0;
 }
 
 EXPORT int switch_to_builtin_mic(void) {
@@ -490,17 +1511,15 @@ EXPORT void set_preferred_device_uid(const char* uid) {
 EXPORT const char* analyze_audio_quality(int16_t* samples, int sampleCount, int sampleRate) {
     if (!samples || sampleCount <= 0) return "{}";
 
-    double sum = 0.0;
-    for (int i = 0; i < sampleCount; i++) {
-        double s = (double)samples[i] / 32768.0;
-        sum += s * s;
-    }
-    double rms = sqrt(sum / sampleCount);
+    DspStats stats;
+    dsp_kernels()->stats_i16(samples, sampleCount, &stats);
+    double rms = dsp_stats_rms(&stats, sampleCount);
     double dbfs = 20.0 * log10(rms + 1e-10);
 
     snprintf(g_jsonBuffer, sizeof(g_jsonBuffer),
-        "{\"rms\":%.6f,\"dbfs\":%.1f,\"sampleRate\":%d,\"sampleCount\":%d}",
-        rms, dbfs, sampleRate, sampleCount
+        "{\"rms\":%.6f,\"dbfs\":%.1f,\"peak\":%.6f,\"clipped\":%d,"
+        "\"sampleRate\":%d,\"sampleCount\":%d}",
+        rms, dbfs, stats.peak / 32768.0, stats.clipped, sampleRate, sampleCount
     );
     return g_jsonBuffer;
 }
@@ -508,3 +1527,354 @@ EXPORT const char* analyze_audio_quality(int16_t* samples, int sampleCount, int
 EXPORT int is_likely_telephone_quality(void) {
     return 0;
 }
+
+// ============================================================
+// 8. AUDIO ENCODING (录音时压缩 / 停顿压缩，给整段识别和接受压缩格式的云端 ASR)
+// ============================================================
+//
+// 句柄式 API：Dart 每轮轮询把刚读到的 int16 喂进来，再把已编码好的字节
+// 读走交给 provider。目前只有 FLAC（无损，语音约压到 PCM 的一半）。
+
+#define SPEAKOUT_AUDIO_ENCODING_FLAC 1
+
+EXPORT void* audio_encoder_create(int format, int sampleRate) {
+    if (format != SPEAKOUT_AUDIO_ENCODING_FLAC) return NULL;
+    return flac_encoder_new(sampleRate);
+}
+
+EXPORT int audio_encoder_write(void* encoder, const int16_t* samples, int count) {
+    return flac_encoder_write((FlacEncoder*)encoder, samples, count);
+}
+
+EXPORT int audio_encoder_finish(void* encoder) {
+    return flac_encoder_finish((FlacEncoder*)encoder);
+}
+
+EXPORT int audio_encoder_read(void* encoder, uint8_t* out, int maxBytes) {
+    return flac_encoder_read((FlacEncoder*)encoder, out, maxBytes);
+}
+
+EXPORT void audio_encoder_destroy(void* encoder) {
+    flac_encoder_free((FlacEncoder*)encoder);
+}
+
+// 停顿压缩（../dsp/silence_compact.h）：同样是句柄式，Dart 在轮询里先压再编码 / 交给 provider，
+// 只给整段解码、整段上传的 provider 用。松键后取对照点，把识别结果的时间戳映射回原始录音。
+
+EXPORT void* silence_compactor_create(int minSilenceMs, int keepMs) {
+    return sc_create(minSilenceMs, keepMs);
+}
+
+/* out 至少 silence_compactor_max_output(compactor, count) 个样本 */
+EXPORT int silence_compactor_process(void* compactor, const int16_t* samples, int count, int16_t* out) {
+    return sc_process((SilenceCompactor*)compactor, samples, out, count);
+}
+
+EXPORT int silence_compactor_max_output(void* compactor, int count) {
+    return compactor ? sc_max_output((SilenceCompactor*)compactor, count) : 0;
+}
+
+EXPORT int silence_compactor_flush(void* compactor, int16_t* out) {
+    return sc_flush((SilenceCompactor*)compactor, out);
+}
+
+/* which 见 SC_STAT_*（输入 / 输出样本数、压了几段），越界返回 -1 */
+EXPORT long long silence_compactor_stat(void* compactor, int which) {
+    return sc_stat((SilenceCompactor*)compactor, which);
+}
+
+/* 对照点写成 [压缩后位置, 原始位置] 对（样本），最多 maxPoints 对，返回个数 */
+EXPORT int silence_compactor_map_points(void* compactor, long long* out, int maxPoints) {
+    return sc_map_points((SilenceCompactor*)compactor, out, maxPoints);
+}
+
+EXPORT void silence_compactor_destroy(void* compactor) {
+    sc_free((SilenceCompactor*)compactor);
+}
+
+// ============================================================
+// 9. STREAMING DECODE (sherpa-onnx 在线识别跑在 native 线程上)
+// ============================================================
+//
+// 本地流式模型（Zipformer / Paraformer）原先在 Dart 主 isolate 上解码：每 50ms
+// 轮询读 ring → 转 Float32 → acceptWaveform → while (isReady) decode。一次 decode
+// 几到几十毫秒，和悬浮窗动画、按键回调抢同一个线程，慢的那次还把下一轮轮询推后。
+// 这里开一个解码线程直接从 ring 取样本喂识别器，只把变了的字幕回调给 Dart，
+// 样本不进 Dart 堆。
+//
+// 识别器和流仍由 Dart 的 sherpa_onnx 创建、释放，这里只借指针：解码线程活着期间
+// Dart 不碰这个流，stream_decoder_destroy 返回后才还回去。sherpa 的 C API 用
+// dlopen(RTLD_NOLOAD) 取 Dart 已经加载的那一份 —— 本库不链接 sherpa，
+// 另加载一份的话指针属于另一份库的堆，不能混用。
+//
+// 解码线程在 ring 上有自己的读者（从本次录音开头读），和 Dart 的 read_audio_buffer 互不影响。
+
+#define DECODER_READ_SAMPLES (AUDIO_CHUNK_SAMPLES * 5)  /* 一次最多取 100ms */
+#define DECODER_WAIT_MS 50                              /* ring 空时最多等这么久再看标志 */
+
+/* 文字由 native malloc，Dart 读完用 native_free 释放。
+ * isFinal=1 的那条每次解码必有且只有一条（哪怕是空串），之后不再回调。 */
+typedef void (*DecoderTextCallback)(const char* text, int isFinal);
+
+/* c-api.h 里 SherpaOnnxOnlineRecognizerResult 的第一个字段，只用得到这个 */
+typedef struct {
+    const char* text;
+} SherpaResultHead;
+
+static struct {
+    void (*accept_waveform)(const void* stream, int32_t sampleRate, const float* samples, int32_t n);
+    int32_t (*is_ready)(const void* recognizer, const void* stream);
+    void (*decode)(const void* recognizer, const void* stream);
+    const SherpaResultHead* (*get_result)(const void* recognizer, const void* stream);
+    void (*destroy_result)(const SherpaResultHead* result);
+    void (*input_finished)(const void* stream);
+} g_sherpa;
+static pthread_mutex_t g_sherpaLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int sherpa_api_load(const char* libPath) {
+    pthread_mutex_lock(&g_sherpaLock);
+    if (g_sherpa.decode) {
+        pthread_mutex_unlock(&g_sherpaLock);
+        return 1;
+    }
+    const char* path = (libPath && libPath[0]) ? libPath : "libsherpa-onnx-c-api.so";
+    void* lib = dlopen(path, RTLD_NOW | RTLD_NOLOAD);
+    if (!lib) {
+        native_log("[Decoder] %s is not loaded by the app", path);
+        pthread_mutex_unlock(&g_sherpaLock);
+        return 0;
+    }
+    void* acceptWaveform = dlsym(lib, "SherpaOnnxOnlineStreamAcceptWaveform");
+    void* isReady = dlsym(lib, "SherpaOnnxIsOnlineStreamReady");
+    void* decode = dlsym(lib, "SherpaOnnxDecodeOnlineStream");
+    void* getResult = dlsym(lib, "SherpaOnnxGetOnlineStreamResult");
+    void* destroyResult = dlsym(lib, "SherpaOnnxDestroyOnlineRecognizerResult");
+    void* inputFinished = dlsym(lib, "SherpaOnnxOnlineStreamInputFinished");
+    if (!acceptWaveform || !isReady || !decode || !getResult || !destroyResult || !inputFinished) {
+        native_log("[Decoder] %s lacks the online recognizer API", path);
+        dlclose(lib);
+        pthread_mutex_unlock(&g_sherpaLock);
+        return 0;
+    }
+    /* 不 dlclose：Dart 一直持有这个库，多一个引用无妨 */
+    *(void**)&g_sherpa.accept_waveform = acceptWaveform;
+    *(void**)&g_sherpa.is_ready = isReady;
+    *(void**)&g_sherpa.get_result = getResult;
+    *(void**)&g_sherpa.destroy_result = destroyResult;
+    *(void**)&g_sherpa.input_finished = inputFinished;
+    *(void**)&g_sherpa.decode = decode; /* 最后赋值：非空即全部就绪 */
+    pthread_mutex_unlock(&g_sherpaLock);
+    return 1;
+}
+
+/* stream_decoder_stat 的参数，和 Dart 侧 kStreamDecoderStat* 对齐 */
+enum {
+    DECODER_STAT_DECODE_US = 0,     /* 累计花在 decode 上的时间 */
+    DECODER_STAT_SAMPLES = 1,       /* 从 ring 取走的样本数（不含收尾补的静音） */
+    DECODER_STAT_PARTIALS = 2,      /* 回调出去的中间结果条数 */
+    DECODER_STAT_FIRST_PARTIAL = 3, /* 第一条中间结果回调的时刻（CLOCK_MONOTONIC 微秒） */
+    DECODER_STAT_MAX_LAG_US = 4,    /* 一块样本从进 ring 到解完的最长耗时 */
+    DECODER_STAT_OVERRUN = 5,       /* 解得太慢、被采集追上丢掉的样本数 */
+    DECODER_STAT_EXITED = 6,        /* 线程已经退出（1），这之后 destroy 的 join 立即返回 */
+    DECODER_STAT_COUNT
+};
+
+typedef struct {
+    pthread_t thread;
+    const void* recognizer;
+    const void* stream;
+    DecoderTextCallback callback;
+    int paddingSamples;
+    int reader;           /* ring 上的读者编号 */
+    atomic_int finishing; /* 松键：读完 ring 里剩下的就收尾 */
+    atomic_int aborting;  /* 丢弃：解完手上这一块就退出，不收尾 */
+    atomic_llong stats[DECODER_STAT_COUNT];
+    char* lastText;       /* 上一条回调出去的字幕，没变就不再回调 */
+} StreamDecoder;
+
+/* 一次一个：sherpa 的流是 Dart 借出来的，同时解两路没有用处，只会抢 CPU */
+static atomic_int g_decoderActive = 0;
+
+static void decoder_post(StreamDecoder* d, const char* text, int isFinal) {
+    if (!isFinal && d->lastText && strcmp(d->lastText, text) == 0) return;
+    if (!isFinal) {
+        free(d->lastText);
+        d->lastText = strdup(text);
+        if (atomic_fetch_add(&d->stats[DECODER_STAT_PARTIALS], 1) == 0) {
+            atomic_store(&d->stats[DECODER_STAT_FIRST_PARTIAL], monotonic_us());
+        }
+    }
+    char* copy = strdup(text);
+    if (copy && d->callback) {
+        d->callback(copy, isFinal);
+    } else {
+        free(copy);
+    }
+}
+
+/* 每次 decode 之前看一眼 aborting：收尾时这里一口气解的是补进去的静音加剩下的全部，
+ * 不看的话取消 / 超时都得等它整段解完 */
+static void decoder_run(StreamDecoder* d) {
+    long long t0 = monotonic_us();
+    while (!atomic_load(&d->aborting) && g_sherpa.is_ready(d->recognizer, d->stream)) {
+        g_sherpa.decode(d->recognizer, d->stream);
+    }
+    atomic_fetch_add(&d->stats[DECODER_STAT_DECODE_US], monotonic_us() - t0);
+}
+
+static char* decoder_result(StreamDecoder* d) {
+    const SherpaResultHead* r = g_sherpa.get_result(d->recognizer, d->stream);
+    char* text = strdup(r && r->text ? r->text : "");
+    if (r) g_sherpa.destroy_result(r);
+    return text;
+}
+
+static void decoder_work(StreamDecoder* d) {
+    int16_t pcm[DECODER_READ_SAMPLES];
+    float samples[DECODER_READ_SAMPLES];
+
+    for (;;) {
+        if (atomic_load(&d->aborting)) return;
+        /* 先看标志再读：finish 在 drain 之后才置，看到它时最后一块一定已经在 ring 里，
+         * 这次读空就是读完了。反过来的话「读空 → 最后一块进 ring → 置 finish」会漏掉它 */
+        int finishing = atomic_load(&d->finishing);
+        long long readAt = monotonic_us();
+        int n = audio_ring_read(&g_ring, d->reader, pcm, DECODER_READ_SAMPLES);
+        atomic_store(&d->stats[DECODER_STAT_OVERRUN], audio_ring_overrun(&g_ring, d->reader));
+        if (n <= 0) {
+            if (finishing) break;
+            pthread_mutex_lock(&g_ringLock);
+            if (audio_ring_available(&g_ring, d->reader) == 0 && !atomic_load(&d->finishing) &&
+                !atomic_load(&d->aborting)) {
+                struct timespec deadline = deadline_after_ms(DECODER_WAIT_MS);
+                pthread_cond_timedwait(&g_ringCond, &g_ringLock, &deadline);
+            }
+            pthread_mutex_unlock(&g_ringLock);
+            continue;
+        }
+        dsp_kernels()->i16_to_f32(pcm, samples, n);
+        g_sherpa.accept_waveform(d->stream, 16000, samples, n);
+        atomic_fetch_add(&d->stats[DECODER_STAT_SAMPLES], n);
+        decoder_run(d);
+        long long lag = monotonic_us() - readAt;
+        if (lag > atomic_load(&d->stats[DECODER_STAT_MAX_LAG_US])) {
+            atomic_store(&d->stats[DECODER_STAT_MAX_LAG_US], lag);
+        }
+        char* text = decoder_result(d);
+        if (text && text[0]) decoder_post(d, text, 0);
+        free(text);
+    }
+
+    /* 收尾和 Dart 路径一样：补一段静音再 inputFinished，不然最后一个字解不出来 */
+    for (int left = d->paddingSamples; left > 0 && !atomic_load(&d->aborting);) {
+        int n = left < DECODER_READ_SAMPLES ? left : DECODER_READ_SAMPLES;
+        memset(samples, 0, sizeof(float) * (size_t)n);
+        g_sherpa.accept_waveform(d->stream, 16000, samples, n);
+        left -= n;
+    }
+    if (atomic_load(&d->aborting)) return;
+    g_sherpa.input_finished(d->stream);
+    decoder_run(d);
+    if (atomic_load(&d->aborting)) return;
+    char* text = decoder_result(d);
+    decoder_post(d, text ? text : "", 1);
+    free(text);
+}
+
+static void* decoder_thread(void* param) {
+    StreamDecoder* d = (StreamDecoder*)param;
+    decoder_work(d);
+    atomic_store(&d->stats[DECODER_STAT_EXITED], 1);
+    return NULL;
+}
+
+/* 开始在 native 线程上解码本次录音。recognizer / stream 是 Dart sherpa_onnx 的
+ * OnlineRecognizer.ptr / OnlineStream.ptr；sherpaLib 是 Dart 加载的 sherpa C API 库
+ * （空串 = 按 soname 找）。应在 start_audio_recording 之后调用。
+ * sherpa 库没加载、已有一个在解码、或参数不全时返回 NULL —— 调用方照旧在 Dart 里解码。 */
+EXPORT void* stream_decoder_start(void* recognizer, void* stream, const char* sherpaLib,
+                                  DecoderTextCallback callback, int paddingMs) {
+    log_writer_ensure();
+    if (!recognizer || !stream || !callback) return NULL;
+    if (!sherpa_api_load(sherpaLib)) return NULL;
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&g_decoderActive, &expected, 1)) {
+        native_log("[Decoder] another decoder is still running");
+        return NULL;
+    }
+    StreamDecoder* d = calloc(1, sizeof(StreamDecoder));
+    if (!d) {
+        atomic_store(&g_decoderActive, 0);
+        return NULL;
+    }
+    d->recognizer = recognizer;
+    d->stream = stream;
+    d->callback = callback;
+    d->paddingSamples = paddingMs > 0 ? paddingMs * 16 : 0;
+    d->reader = audio_ring_register(&g_ring, AUDIO_RING_FROM_OLDEST);
+    if (d->reader < 0) {
+        native_log("[Decoder] no free ring reader");
+        free(d);
+        atomic_store(&g_decoderActive, 0);
+        return NULL;
+    }
+    if (pthread_create(&d->thread, NULL, decoder_thread, d) != 0) {
+        native_log("[Decoder] Failed to create decoder thread");
+        audio_ring_unregister(&g_ring, d->reader);
+        free(d);
+        atomic_store(&g_decoderActive, 0);
+        return NULL;
+    }
+    return d;
+}
+
+/* 松键：stop_audio_recording_and_drain 之后调用。立即返回；线程解完 ring 里剩下的、
+ * 补完静音，回调 isFinal=1 的那条后退出 */
+EXPORT void stream_decoder_finish(void* decoder) {
+    StreamDecoder* d = (StreamDecoder*)decoder;
+    if (!d) return;
+    pthread_mutex_lock(&g_ringLock);
+    atomic_store(&d->finishing, 1);
+    pthread_cond_broadcast(&g_ringCond);
+    pthread_mutex_unlock(&g_ringLock);
+}
+
+/* 只让线程停下，不等：置 aborting 后立即返回，线程解完手上这次 decode 就走、不回调 final。
+ * 收尾超时后用这个 —— 在 UI isolate 上 destroy(abort) 会一直 join 到线程退出。
+ * 调用方等 DECODER_STAT_EXITED 变成 1 再 destroy，那时 join 立即返回 */
+EXPORT void stream_decoder_abort(void* decoder) {
+    StreamDecoder* d = (StreamDecoder*)decoder;
+    if (!d) return;
+    pthread_mutex_lock(&g_ringLock);
+    atomic_store(&d->aborting, 1);
+    pthread_cond_broadcast(&g_ringCond);
+    pthread_mutex_unlock(&g_ringLock);
+}
+
+/* 取一项统计，which 见 DECODER_STAT_*；越界返回 -1。线程还在跑时也可以读 */
+EXPORT long long stream_decoder_stat(void* decoder, int which) {
+    StreamDecoder* d = (StreamDecoder*)decoder;
+    if (!d || which < 0 || which >= DECODER_STAT_COUNT) return -1;
+    return atomic_load(&d->stats[which]);
+}
+
+/* 等解码线程退出并释放句柄，之后 Dart 才能再碰 stream。abort=1 时不收尾
+ * （取消 / dispose），线程解完手上这一块就走，不再回调 final。
+ * 返回 1 = 线程正常收完了尾。 */
+EXPORT int stream_decoder_destroy(void* decoder, int abort) {
+    StreamDecoder* d = (StreamDecoder*)decoder;
+    if (!d) return 0;
+    pthread_mutex_lock(&g_ringLock);
+    if (abort) atomic_store(&d->aborting, 1);
+    atomic_store(&d->finishing, 1);
+    pthread_cond_broadcast(&g_ringCond);
+    pthread_mutex_unlock(&g_ringLock);
+    /* 不能超时 detach：线程手上拿着 Dart 马上要释放的 stream */
+    pthread_join(d->thread, NULL);
+    int finished = !atomic_load(&d->aborting);
+    audio_ring_unregister(&g_ring, d->reader);
+    free(d->lastText);
+    free(d);
+    atomic_store(&g_decoderActive, 0);
+    return finished;
+}
@@ -16,6 +16,8 @@
 #include <unistd.h>
 #include <Accelerate/Accelerate.h>
 
+#include "dsp/audio_ring.h"
+
 // Debug logging flag — disabled by default, enabled via set_debug_logging(1)
 static atomic_int debugLoggingEnabled = 0;
 
@@ -45,7 +47,7 @@ static void flush_tap_log_sync(void);
 // 数值由 test/engine/native_batch5_invariants_test.dart 的指纹锁给出。
 // 旧 dylib 没有这个 symbol，查找失败 → Dart 明确知道版本不匹配，
 // 而不是悄悄读垃圾。
-#define SPEAKOUT_NATIVE_ABI_VERSION 0x3e3abe
+#define SPEAKOUT_NATIVE_ABI_VERSION 0x160ccb
 // 剪贴板还原最终失败的累计次数。还原发生在注入之后 800ms 的异步任务里，
 // 没法用返回值告诉 Dart —— 只记日志的话，用户的剪贴板被清空了却毫不知情。
 // Dart 侧在下一次注入时读一下这个计数，涨了就提示。
@@ -1573,14 +1575,16 @@ static AudioQueueBufferRef audioBuffers[NUM_BUFFERS];
 static atomic_bool isRecording = false;
 static AudioStreamBasicDescription audioFormat;
 
-// Lock-free ring buffer (single producer / single consumer)
+// Lock-free ring buffer：一个写者（AudioQueue 回调），多个读者各有自己的游标
+// （dsp/audio_ring.h）。read_audio_buffer 是 0 号默认读者；save_recording_wav
+// 临时开一个从头读的读者 —— 以前只有一个读位置，ASR 读走之后存 WAV 得另记
+// 一个录音起点绕开，再多一个消费者就得互相抢样本。
 static int16_t ringBuffer[RING_BUFFER_SAMPLES];
-static _Atomic uint64_t ringWritePos = 0; // monotonically increasing write cursor
-static _Atomic uint64_t ringReadPos = 0;  // monotonically increasing read cursor
-// 录音起点游标：start_audio_recording 时记录当前 wp。
-// save_recording_wav 用它而不是 ringReadPos 算起点，
-// 否则 ASR 流式消费 ring buffer 后 ringReadPos 已经追上 wp，保存的 WAV 只剩残尾。
-static _Atomic uint64_t recordingStartPos = 0;
+static AudioRing audioRing = {
+    .buf = ringBuffer,
+    .capacity = RING_BUFFER_SAMPLES,
+    .readers = {[AUDIO_RING_DEFAULT_READER] = {.active = 1}},
+};
 
 // ---- Real-time Audio Level for Waveform Visualization ----
 // RMS of latest samples → single 0.0~1.0 value for UI to scale random animation.
@@ -1648,16 +1652,15 @@ static float smoothed_level_update(float level) {
 float get_audio_level(void) {
     if (!atomic_load(&isRecording)) return 0.0f;
 
-    uint64_t wp = atomic_load_explicit(&ringWritePos, memory_order_acquire);
     // Use ~10ms of samples (160 @ 16kHz) for responsive level
-    const int windowSize = 160;
-    if (wp < (uint64_t)windowSize) return 0.0f;
+    enum { windowSize = 160 };
+    int16_t window[windowSize];
+    if (audio_ring_latest(&audioRing, window, windowSize) < windowSize) return 0.0f;
 
     // Compute RMS
     double sumSq = 0;
-    uint64_t startPos = wp - windowSize;
     for (int i = 0; i < windowSize; i++) {
-        float s = (float)ringBuffer[(startPos + i) % RING_BUFFER_SAMPLES] / 32768.0f;
+        float s = (float)window[i] / 32768.0f;
         sumSq += s * s;
     }
     float rms = sqrtf((float)(sumSq / windowSize));
@@ -1699,14 +1702,8 @@ static void AudioInputCallback(
   int sampleCount = byteSize / sizeof(int16_t);
   const int16_t *samples = (const int16_t *)inBuffer->mAudioData;
 
-  // Write samples into ring buffer (wrap around using modulo)
-  uint64_t wp = atomic_load_explicit(&ringWritePos, memory_order_relaxed);
-  for (int i = 0; i < sampleCount; i++) {
-    ringBuffer[wp % RING_BUFFER_SAMPLES] = samples[i];
-    wp++;
-  }
-  // Release barrier: ensure all buffer writes are visible before advancing cursor
-  atomic_store_explicit(&ringWritePos, wp, memory_order_release);
+  // 写者不等任何读者：读得慢的自己丢样本、记 overrun
+  audio_ring_write(&audioRing, samples, sampleCount);
 
   // Re-enqueue buffer immediately for next capture
   if (atomic_load(&isRecording)) {
@@ -1716,44 +1713,34 @@ static void AudioInputCallback(
 
 /// Returns the number of unread samples available in the ring buffer.
 int get_available_audio_samples() {
-  uint64_t wp = atomic_load_explicit(&ringWritePos, memory_order_acquire);
-  uint64_t rp = atomic_load_explicit(&ringReadPos, memory_order_relaxed);
-  int64_t avail = (int64_t)(wp - rp);
-  if (avail < 0)
-    avail = 0;
-  // Cap to ring buffer size to prevent reading stale wrapped data
-  if (avail > RING_BUFFER_SAMPLES) {
-    // Reader fell behind; skip to latest data minus a small margin
-    uint64_t newRp = wp - RING_BUFFER_SAMPLES + 1600;
-    atomic_store_explicit(&ringReadPos, newRp, memory_order_relaxed);
-    avail = (int64_t)(wp - newRp);
-  }
-  return (int)avail;
+  return audio_ring_available(&audioRing, AUDIO_RING_DEFAULT_READER);
 }
 
 /// Read samples from the ring buffer into the provided output buffer.
 /// Returns the number of samples actually read.
 /// Caller must allocate `outSamples` with at least `maxSamples` capacity.
 int read_audio_buffer(int16_t *outSamples, int maxSamples) {
-  if (outSamples == NULL || maxSamples <= 0)
-    return 0;
+  return audio_ring_read(&audioRing, AUDIO_RING_DEFAULT_READER, outSamples, maxSamples);
+}
 
-  int avail = get_available_audio_samples();
-  if (avail <= 0)
-    return 0;
+// 多读者：read_audio_buffer 之外再要一路样本（VAD、落盘、第二路识别……）就开一个
+// 自己的读者，游标各走各的。fromOldest=1 从本次录音还留在 ring 里的最早样本开始，
+// 0 从现在开始。返回读者编号，槽满返回 -1。用完 audio_reader_close。
+int audio_reader_open(int fromOldest) {
+  return audio_ring_register(&audioRing, fromOldest ? AUDIO_RING_FROM_OLDEST : AUDIO_RING_FROM_NOW);
+}
 
-  int toRead = avail < maxSamples ? avail : maxSamples;
+void audio_reader_close(int reader) { audio_ring_unregister(&audioRing, reader); }
 
-  uint64_t rp = atomic_load_explicit(&ringReadPos, memory_order_relaxed);
-  for (int i = 0; i < toRead; i++) {
-    outSamples[i] = ringBuffer[rp % RING_BUFFER_SAMPLES];
-    rp++;
-  }
-  atomic_store_explicit(&ringReadPos, rp, memory_order_relaxed);
+int audio_reader_available(int reader) { return audio_ring_available(&audioRing, reader); }
 
-  return toRead;
+int audio_reader_read(int reader, int16_t *outSamples, int maxSamples) {
+  return audio_ring_read(&audioRing, reader, outSamples, maxSamples);
 }
 
+// 这个读者读得太慢、被写者追上丢掉的样本数（新录音清零）；编号无效返回 -1
+long long audio_reader_overrun(int reader) { return audio_ring_overrun(&audioRing, reader); }
+
 // Start Audio Recording (no Dart callback needed)
 // Returns 1 on success, negative on error
 int start_audio_recording() {
@@ -1765,10 +1752,8 @@ int start_audio_recording() {
   // 波形/静音检测的平滑状态也要复位，否则上一段的高电平会被这一段继承
   smoothed_level_reset();
 
-  // Reset ring buffer cursors
-  atomic_store_explicit(&ringWritePos, 0, memory_order_relaxed);
-  atomic_store_explicit(&ringReadPos, 0, memory_order_relaxed);
-  atomic_store_explicit(&recordingStartPos, 0, memory_order_relaxed);
+  // Reset ring buffer cursors（所有读者一起归零）
+  audio_ring_reset(&audioRing);
 
   // Configure audio format: 16kHz, Mono, 16-bit signed integer
   memset(&audioFormat, 0, sizeof(audioFormat));
@@ -1880,22 +1865,35 @@ int stop_audio_recording() {
 int save_recording_wav(const char *path) {
   if (path == NULL || path[0] == '\0') return 0;
 
-  uint64_t wp = atomic_load_explicit(&ringWritePos, memory_order_relaxed);
-  uint64_t startPos = atomic_load_explicit(&recordingStartPos, memory_order_relaxed);
-  if (wp <= startPos) return 0; // no data
-
-  uint64_t sampleCount = wp - startPos;
+  // 自己开一个从头读的读者：ASR 那边的默认读者早把样本读走了，不影响这里。
   // Ring buffer 容量限制：录音超过 60s 时只能保存最新 60s（旧数据已被覆盖）
-  if (sampleCount > RING_BUFFER_SAMPLES) {
-    sampleCount = RING_BUFFER_SAMPLES;
-    startPos = wp - RING_BUFFER_SAMPLES;
+  int reader = audio_ring_register(&audioRing, AUDIO_RING_FROM_OLDEST);
+  if (reader < 0) return 0;
+  int total = audio_ring_available(&audioRing, reader);
+  int16_t *pcm = total > 0 ? malloc(sizeof(int16_t) * (size_t)total) : NULL;
+  uint64_t sampleCount = 0;
+  if (pcm) {
+    // 一般已经停止录音，一次就读完；还在录的话只存注册那一刻之前的部分
+    int n;
+    while (sampleCount < (uint64_t)total &&
+           (n = audio_ring_read(&audioRing, reader, pcm + sampleCount, total - (int)sampleCount)) > 0) {
+      sampleCount += (uint64_t)n;
+    }
+  }
+  audio_ring_unregister(&audioRing, reader);
+  if (sampleCount == 0) { // no data
+    free(pcm);
+    return 0;
   }
 
   uint32_t dataSize = (uint32_t)(sampleCount * 2); // 16-bit = 2 bytes per sample
   uint32_t fileSize = 44 + dataSize;
 
   FILE *f = fopen(path, "wb");
-  if (!f) return 0;
+  if (!f) {
+    free(pcm);
+    return 0;
+  }
 
   // WAV header
   uint16_t numChannels = 1;
@@ -1921,11 +1919,9 @@ int save_recording_wav(const char *path) {
   fwrite("data", 1, 4, f);
   fwrite(&dataSize, 4, 1, f);
 
-  // PCM data from ring buffer (startPos 已在上面计算好)
-  for (uint64_t i = 0; i < sampleCount; i++) {
-    int16_t sample = ringBuffer[(startPos + i) % RING_BUFFER_SAMPLES];
-    fwrite(&sample, 2, 1, f);
-  }
+  // PCM data from ring buffer
+  fwrite(pcm, sizeof(int16_t), (size_t)sampleCount, f);
+  free(pcm);
 
   fclose(f);
   log_to_file("Audio: Saved recording to %s (%llu samples, %.1fs)", path, sampleCount, (double)sampleCount / 16000.0);
@@ -0,0 +1,258 @@
+// 自动增益的可执行测试宿主：轻声说话被拉到目标电平、突然大声不削波、
+// 停顿里增益冻结不喘、延迟固定一帧、冲刷吐出尾巴、轨迹按帧可读。`bench` 参数跑每秒音频的 CPU 开销。
+//
+// 编译: cc -O2 -o agc_harness native_lib/tests/agc_harness.c -lm
+// 基准: ./agc_harness bench [秒数]
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/agc.c"
+
+#define RATE 16000
+#define CHUNK 320 /* 和采集线程一样按 20ms 一块喂 */
+#define FRAME AGC_FRAME_SAMPLES
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+static uint32_t rng_state = 7;
+
+static float noise_sample(void) {
+  float sum = 0;
+  for (int i = 0; i < 12; i++) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    sum += (rng_state >> 8) / (float)(1 << 24);
+  }
+  return sum - 6.0f;
+}
+
+static int16_t clamp16(float v) {
+  if (v > 32767.0f) return 32767;
+  if (v < -32768.0f) return -32768;
+  return (int16_t)lrintf(v);
+}
+
+/* 200ms 一个「音节」、停 100ms，幅度 amp（峰值约 2 × amp） */
+static float voice_sample(long i, float amp) {
+  long syllable = i / (RATE * 3 / 10);
+  long pos = i % (RATE * 3 / 10);
+  if (pos >= RATE / 5) return 0.0f;
+  double t = (double)i / RATE;
+  double f0 = 150.0 + 100.0 * ((syllable * 7) % 5) / 4.0;
+  double env = sin(M_PI * pos / (RATE / 5.0));
+  double v = sin(2 * M_PI * f0 * t) + 0.5 * sin(2 * M_PI * 2 * f0 * t) + 0.3 * sin(2 * M_PI * 4 * f0 * t);
+  return (float)(env * v * amp);
+}
+
+/* 按 CHUNK 喂，输出接在 out 后面，返回写出的总数 */
+static long run_chunks(Agc* agc, const int16_t* in, int16_t* out, long n) {
+  long written = 0;
+  for (long i = 0; i < n; i += CHUNK) {
+    int take = n - i < CHUNK ? (int)(n - i) : CHUNK;
+    written += agc_process(agc, in + i, out + written, take);
+  }
+  return written;
+}
+
+static double db_range(const int16_t* x, long from, long to) {
+  double sum = 0;
+  for (long i = from; i < to; i++) sum += (double)x[i] * x[i];
+  return 10 * log10(sum / (to - from) + 1e-9) - 20 * log10(32768.0);
+}
+
+static int peak_abs(const int16_t* x, long from, long to) {
+  int p = 0;
+  for (long i = from; i < to; i++) {
+    if (abs(x[i]) > p) p = abs(x[i]);
+  }
+  return p;
+}
+
+static int run_tests(void) {
+  const long n = RATE * 8;
+  int16_t* in = malloc(sizeof(int16_t) * n);
+  int16_t* out = malloc(sizeof(int16_t) * (n + 2 * FRAME));
+  AgcConfig cfg;
+  agc_default_config(&cfg);
+  const int ceiling = (int)(32768.0 * pow(10.0, cfg.ceilingDbfs / 20.0));
+
+  printf("== 1. 不放大不衰减时：输出 = 输入晚一帧，冲刷吐出尾巴 ==\n");
+  AgcConfig unity = cfg;
+  unity.maxGainDb = 0;
+  unity.minGainDb = 0;
+  Agc* agc = agc_create(&unity);
+  for (long i = 0; i < n; i++) in[i] = clamp16(noise_sample() * 3000.0f);
+  long written = run_chunks(agc, in, out, n);
+  expect_true("整块喂进去，写出的个数和输入一样", written == n);
+  int worst = 0, headZero = 1;
+  for (long i = 0; i < FRAME; i++) headZero &= out[i] == 0;
+  for (long i = FRAME; i < n; i++) {
+    int d = abs(out[i] - in[i - FRAME]);
+    if (d > worst) worst = d;
+  }
+  expect_true("开头一帧是垫的静音", headZero);
+  expect_true("其余逐样本一致", worst == 0);
+  /* 再喂半帧：冲刷要吐出整帧 + 这半帧 */
+  written = agc_process(agc, in, out, FRAME / 2);
+  int tail = agc_flush(agc, out + written);
+  worst = 0;
+  for (int i = 0; i < FRAME; i++) worst |= out[written + i] != in[n - FRAME + i];
+  for (int i = 0; i < FRAME / 2; i++) worst |= out[written + FRAME + i] != in[i];
+  expect_true("半帧时不出，冲刷出 1.5 帧且就是最后那段输入", written == 0 && tail == FRAME * 3 / 2 && !worst);
+  agc_free(agc);
+
+  printf("== 2. 轻声说话（约 -45dBFS）拉到目标附近 ==\n");
+  agc = agc_create(NULL);
+  for (long i = 0; i < n; i++) in[i] = clamp16(voice_sample(i, 250.0f) + noise_sample() * 8.0f);
+  run_chunks(agc, in, out, n);
+  /* 后 4 秒里各音节的中段（音节按 300ms 对齐） */
+  const long period = RATE * 3 / 10;
+  double inDb = -200, outDb = -200;
+  for (long s = (RATE * 4 / period + 1) * period; s + period <= n; s += period) {
+    double a = db_range(in, s + RATE / 20, s + RATE * 3 / 20);
+    double b = db_range(out, s + RATE / 20 + FRAME, s + RATE * 3 / 20 + FRAME);
+    if (a > inDb) inDb = a;
+    if (b > outDb) outDb = b;
+  }
+  printf("  音节峰值电平 %.1f → %.1f dBFS（目标 %.0f），增益 %.1f dB\n", inDb, outDb, cfg.targetDbfs,
+         agc_gain_db(agc));
+  expect_true("输出落在目标 ±4dB 内", fabs(outDb - cfg.targetDbfs) <= 4.0);
+  expect_true("全程不超过上限", peak_abs(out, 0, n) <= ceiling);
+
+  printf("== 3. 增益拉高之后突然大声：限幅器前瞻，不削波 ==\n");
+  /* 接着上面的状态（增益二十几 dB），下一秒音量大 30 倍 */
+  for (long i = 0; i < RATE; i++) in[i] = clamp16(voice_sample(i, 7500.0f) + noise_sample() * 8.0f);
+  run_chunks(agc, in, out, RATE);
+  int peak = peak_abs(out, 0, RATE);
+  int clipped = 0;
+  for (long i = 0; i < RATE; i++) clipped += out[i] == 32767 || out[i] == -32768;
+  printf("  输出峰值 %d（上限 %d），满幅样本 %d 个\n", peak, ceiling, clipped);
+  expect_true("峰值不超过上限、没有满幅样本", peak <= ceiling && clipped == 0);
+  AgcTracePoint pts[AGC_TRACE_FRAMES];
+  int got = agc_trace(agc, agc_frame_count(agc) - RATE / FRAME, pts, AGC_TRACE_FRAMES);
+  float deepest = 0;
+  for (int i = 0; i < got; i++) deepest = fminf(deepest, pts[i].limiterDb);
+  printf("  这一秒轨迹 %d 点，限幅器最多压 %.1f dB\n", got, deepest);
+  expect_true("轨迹里看得到限幅器动作", got == RATE / FRAME && deepest < -3.0f);
+  agc_free(agc);
+
+  printf("== 4. 停顿里不喘：增益冻结，放大部分平滑收回 ==\n");
+  agc = agc_create(NULL);
+  /* 3 秒轻声说话，接 3 秒只有底噪，再说 1 秒 */
+  for (long i = 0; i < n; i++) {
+    float v = i < RATE * 3 || (i >= RATE * 6 && i < RATE * 7) ? voice_sample(i, 250.0f) : 0.0f;
+    in[i] = clamp16(v + noise_sample() * 8.0f);
+  }
+  run_chunks(agc, in, out, RATE * 3);
+  float before = agc_gain_db(agc);
+  long long mark = agc_frame_count(agc);
+  run_chunks(agc, in + RATE * 3, out, RATE * 3);
+  float after = agc_gain_db(agc);
+  got = agc_trace(agc, mark, pts, AGC_TRACE_FRAMES);
+  float maxStep = 0;
+  int closed = 0;
+  for (int i = 1; i < got; i++) {
+    maxStep = fmaxf(maxStep, fabsf(pts[i].gainDb - pts[i - 1].gainDb));
+    closed += !pts[i].gateOpen;
+  }
+  double noiseIn = db_range(in, RATE * 5, RATE * 6);
+  double noiseOut = db_range(out, RATE * 2, RATE * 3);
+  printf("  增益 %.1f → %.1f dB；门关 %d/%d 帧，逐帧最大变化 %.2f dB；底噪 %.1f → %.1f dBFS\n",
+         before, after, closed, got, maxStep, noiseIn, noiseOut);
+  expect_true("增益有明显放大（> 15dB）", before > 15.0f);
+  expect_true("停顿期间跟踪器增益一点不动", after == before);
+  expect_true("门在停顿里关上", closed > got / 2);
+  expect_true("逐帧变化不超过 0.5dB（没有忽上忽下）", maxStep <= 0.5f);
+  expect_true("停顿末尾底噪没被抬高（±1dB）", fabs(noiseOut - noiseIn) <= 1.0);
+  /* 再开口：门一帧就开，增益直接接着用 */
+  mark = agc_frame_count(agc);
+  run_chunks(agc, in + RATE * 6, out, RATE);
+  got = agc_trace(agc, mark, pts, AGC_TRACE_FRAMES);
+  int firstOpen = -1;
+  for (int i = 0; i < got && firstOpen < 0; i++) {
+    if (pts[i].gateOpen) firstOpen = i;
+  }
+  expect_true("再开口门立刻打开，增益不从头爬",
+              firstOpen >= 0 && fabsf(pts[firstOpen].gainDb - before) < 1.0f);
+  agc_free(agc);
+
+  printf("== 5. 预置增益：第一个音节就有增益 ==\n");
+  agc = agc_create(NULL);
+  agc_seed(agc, 24.0f);
+  for (long i = 0; i < RATE; i++) in[i] = clamp16(voice_sample(i, 250.0f) + noise_sample() * 8.0f);
+  run_chunks(agc, in, out, RATE);
+  double first = db_range(out, RATE / 20 + FRAME, RATE * 3 / 20 + FRAME);
+  printf("  第一个音节 %.1f dBFS\n", first);
+  expect_true("第一个音节离目标不到 6dB", fabs(first - cfg.targetDbfs) < 6.0);
+  agc_free(agc);
+
+  printf("== 6. 数字静音：输出全 0，不出 NaN ==\n");
+  agc = agc_create(NULL);
+  memset(in, 0, sizeof(int16_t) * n);
+  written = run_chunks(agc, in, out, n);
+  int allZero = 1;
+  for (long i = 0; i < written; i++) allZero &= out[i] == 0;
+  got = agc_trace(agc, 0, pts, AGC_TRACE_FRAMES);
+  int finite = 1;
+  for (int i = 0; i < got; i++) finite &= isfinite(pts[i].gainDb) && isfinite(pts[i].limiterDb);
+  expect_true("全 0", allZero);
+  expect_true("轨迹只留最近 AGC_TRACE_FRAMES 帧，数值有限", got == AGC_TRACE_FRAMES && finite);
+  agc_free(agc);
+
+  free(in);
+  free(out);
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
+
+static double thread_cpu_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int run_bench(long seconds) {
+  const long n = RATE * seconds;
+  int16_t* in = malloc(sizeof(int16_t) * n);
+  int16_t* out = malloc(sizeof(int16_t) * (n + 2 * FRAME));
+  for (long i = 0; i < n; i++) in[i] = clamp16(voice_sample(i, 800.0f) * ((i / RATE) % 2) + noise_sample() * 30.0f);
+  Agc* agc = agc_create(NULL);
+  run_chunks(agc, in, out, RATE); /* 预热 */
+
+  double t0 = thread_cpu_us();
+  run_chunks(agc, in, out, n);
+  double perSecond = (thread_cpu_us() - t0) / seconds;
+
+  printf("音频 %ld 秒（16kHz mono int16，%d 样本一帧），DSP 变体 %s\n", seconds, FRAME, dsp_kernels()->name);
+  printf("  CPU:      %.1f µs/秒音频（单核 %.4f%%）\n", perSecond, perSecond / 1e4);
+  printf("  每帧平均: %.2f µs（帧长 10000 µs）\n", perSecond / (RATE / FRAME));
+  agc_free(agc);
+  free(in);
+  free(out);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return run_bench(argc > 2 ? atol(argv[2]) : 60);
+  }
+  return run_tests();
+}
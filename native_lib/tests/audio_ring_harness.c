@@ -0,0 +1,250 @@
+// 多读者采集 ring 的可执行测试宿主：各读者游标互不影响、慢读者被追上只丢自己的并记 overrun、
+// 注册 / 注销 / reset 的边界，再加一个写者全速写、几个读者各按自己节奏读的并发压力：
+// 读到的每个样本都得是它序号对应的值，读到的 + 丢掉的 = 写进去的。
+// `bench` 参数跑写 / 读的每样本开销。
+//
+// 编译: cc -O2 -o audio_ring_harness native_lib/tests/audio_ring_harness.c -lpthread
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../dsp/audio_ring.c"
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+/* 第 i 个样本的值就是它的序号（截到 15 位），读出来能直接核对 */
+static int16_t value_at(uint64_t i) { return (int16_t)(i & 0x7FFF); }
+
+static void write_seq(AudioRing* r, uint64_t* next, int n) {
+  int16_t tmp[4096];
+  while (n > 0) {
+    int take = n < 4096 ? n : 4096;
+    for (int i = 0; i < take; i++) tmp[i] = value_at(*next + i);
+    audio_ring_write(r, tmp, take);
+    *next += take;
+    n -= take;
+  }
+}
+
+static int is_seq(const int16_t* x, int n, uint64_t first) {
+  for (int i = 0; i < n; i++) {
+    if (x[i] != value_at(first + i)) return 0;
+  }
+  return 1;
+}
+
+#define CAP 1000
+static int16_t storage[CAP];
+
+/* ---- 并发压力 ---- */
+#define STRESS_CAP 4096
+#define STRESS_READERS 3
+static int16_t stressStorage[STRESS_CAP];
+static AudioRing stressRing;
+static volatile int stressDone = 0;
+static uint64_t stressTotal = 0;
+
+typedef struct {
+  int id;
+  int chunk;
+  int pauseUs;
+  uint64_t got;
+  uint64_t corrupt;
+} StressReader;
+
+static void* stress_reader(void* arg) {
+  StressReader* s = arg;
+  int16_t buf[2048];
+  uint64_t next = 0; /* 下一个期待的序号 */
+  long long lostSeen = 0;
+  for (;;) {
+    int done = __atomic_load_n(&stressDone, __ATOMIC_ACQUIRE);
+    int n = audio_ring_read(&stressRing, s->id, buf, s->chunk);
+    long long lost = audio_ring_overrun(&stressRing, s->id);
+    next += (uint64_t)(lost - lostSeen);
+    lostSeen = lost;
+    if (n > 0) {
+      if (!is_seq(buf, n, next)) s->corrupt++;
+      next += (uint64_t)n;
+      s->got += (uint64_t)n;
+    } else if (done) {
+      break;
+    }
+    if (s->pauseUs) usleep(s->pauseUs);
+  }
+  return NULL;
+}
+
+static void* stress_writer(void* arg) {
+  (void)arg;
+  uint64_t next = 0;
+  for (int i = 0; i < 20000; i++) {
+    write_seq(&stressRing, &next, 1 + (i * 37) % 700);
+    if (i % 50 == 0) usleep(100);
+  }
+  stressTotal = next;
+  __atomic_store_n(&stressDone, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static int run_tests(void) {
+  AudioRing r;
+  int16_t out[4 * CAP];
+  uint64_t next = 0;
+  audio_ring_init(&r, storage, CAP);
+
+  printf("== 1. 默认读者：按序读出，读完为空 ==\n");
+  write_seq(&r, &next, 300);
+  expect_true("可读 300", audio_ring_available(&r, AUDIO_RING_DEFAULT_READER) == 300);
+  int n = audio_ring_read(&r, AUDIO_RING_DEFAULT_READER, out, 1000);
+  expect_true("读到 0..299", n == 300 && is_seq(out, n, 0));
+  expect_true("读完为空", audio_ring_read(&r, AUDIO_RING_DEFAULT_READER, out, 10) == 0);
+
+  printf("== 2. 多个读者：游标互不影响 ==\n");
+  int fromNow = audio_ring_register(&r, AUDIO_RING_FROM_NOW);
+  int fromOldest = audio_ring_register(&r, AUDIO_RING_FROM_OLDEST);
+  expect_true("注册成功，编号不是 0", fromNow > 0 && fromOldest > 0 && fromNow != fromOldest);
+  write_seq(&r, &next, 200);
+  n = audio_ring_read(&r, fromOldest, out, 1000);
+  expect_true("FROM_OLDEST 从头读到 0..499", n == 500 && is_seq(out, n, 0));
+  n = audio_ring_read(&r, fromNow, out, 150);
+  expect_true("FROM_NOW 只看注册之后的 300..449", n == 150 && is_seq(out, n, 300));
+  n = audio_ring_read(&r, AUDIO_RING_DEFAULT_READER, out, 1000);
+  expect_true("默认读者不受影响：300..499", n == 200 && is_seq(out, n, 300));
+  n = audio_ring_read(&r, fromNow, out, 1000);
+  expect_true("FROM_NOW 接着读 450..499", n == 50 && is_seq(out, n, 450));
+
+  printf("== 3. 慢读者被追上：只丢它自己的，记 overrun ==\n");
+  write_seq(&r, &next, 1500); /* fromOldest 停在 500，写到 2000，容量 1000 */
+  expect_true("可读封顶为容量", audio_ring_available(&r, fromOldest) == CAP);
+  n = audio_ring_read(&r, fromOldest, out, 4 * CAP);
+  expect_true("读到最新 1000：1000..1999", n == CAP && is_seq(out, n, 1000));
+  expect_true("overrun = 500", audio_ring_overrun(&r, fromOldest) == 500);
+  n = audio_ring_read(&r, fromNow, out, 4 * CAP);
+  expect_true("另一个读者也是各算各的：overrun 500", n == CAP && audio_ring_overrun(&r, fromNow) == 500);
+  write_seq(&r, &next, 100);
+  n = audio_ring_read(&r, fromOldest, out, 4 * CAP);
+  expect_true("之后照常续上 2000..2099，不再多记", n == 100 && is_seq(out, n, 2000) &&
+                                                   audio_ring_overrun(&r, fromOldest) == 500);
+
+  printf("== 4. 注册满 / 注销 / 无效编号 ==\n");
+  int ids[AUDIO_RING_MAX_READERS];
+  int got = 0;
+  for (int i = 0; i < AUDIO_RING_MAX_READERS; i++) {
+    ids[i] = audio_ring_register(&r, AUDIO_RING_FROM_NOW);
+    if (ids[i] > 0) got++;
+  }
+  expect_true("槽满返回 -1（0 号留给默认读者）", got == AUDIO_RING_MAX_READERS - 3 && ids[got] == -1);
+  audio_ring_unregister(&r, fromNow);
+  expect_true("注销后无效编号：读 0、overrun -1", audio_ring_read(&r, fromNow, out, 10) == 0 &&
+                                                 audio_ring_overrun(&r, fromNow) == -1);
+  expect_true("空出的槽能再注册", audio_ring_register(&r, AUDIO_RING_FROM_NOW) == fromNow);
+  audio_ring_unregister(&r, AUDIO_RING_DEFAULT_READER);
+  expect_true("默认读者注销不掉", audio_ring_overrun(&r, AUDIO_RING_DEFAULT_READER) >= 0);
+  for (int i = 0; i < got; i++) audio_ring_unregister(&r, ids[i]);
+
+  printf("== 5. reset：写位置、游标、overrun 都归零 ==\n");
+  audio_ring_reset(&r);
+  next = 0;
+  write_seq(&r, &next, 10);
+  n = audio_ring_read(&r, fromOldest, out, 100);
+  expect_true("读者从新录音的 0 开始，overrun 清零", n == 10 && is_seq(out, n, 0) &&
+                                                   audio_ring_overrun(&r, fromOldest) == 0);
+  expect_true("written = 10", audio_ring_written(&r) == 10);
+
+  printf("== 6. 一次写超过容量：只留最后 capacity 个 ==\n");
+  write_seq(&r, &next, 2500);
+  n = audio_ring_read(&r, AUDIO_RING_DEFAULT_READER, out, 4 * CAP);
+  expect_true("读到 1510..2509", n == CAP && is_seq(out, n, 1510));
+
+  printf("== 7. 电平表取最新一段，不占游标 ==\n");
+  n = audio_ring_latest(&r, out, 160);
+  expect_true("最新 160：2350..2509", n == 160 && is_seq(out, n, 2350));
+  expect_true("超过容量的请求返回 0", audio_ring_latest(&r, out, CAP + 1) == 0);
+
+  printf("== 8. 并发：写者全速写，快 / 中 / 慢三个读者 ==\n");
+  audio_ring_init(&stressRing, stressStorage, STRESS_CAP);
+  StressReader readers[STRESS_READERS] = {
+      {AUDIO_RING_DEFAULT_READER, 2048, 0, 0, 0},
+      {0, 512, 50, 0, 0},
+      {0, 64, 300, 0, 0},
+  };
+  readers[1].id = audio_ring_register(&stressRing, AUDIO_RING_FROM_OLDEST);
+  readers[2].id = audio_ring_register(&stressRing, AUDIO_RING_FROM_OLDEST);
+  pthread_t tr[STRESS_READERS], tw;
+  for (int i = 0; i < STRESS_READERS; i++) pthread_create(&tr[i], NULL, stress_reader, &readers[i]);
+  pthread_create(&tw, NULL, stress_writer, NULL);
+  pthread_join(tw, NULL);
+  for (int i = 0; i < STRESS_READERS; i++) pthread_join(tr[i], NULL);
+  int allOk = 1, accounted = 1;
+  for (int i = 0; i < STRESS_READERS; i++) {
+    long long lost = audio_ring_overrun(&stressRing, readers[i].id);
+    printf("  读者 %d：读到 %llu，丢 %lld，错样本的批次 %llu\n", readers[i].id,
+           (unsigned long long)readers[i].got, lost, (unsigned long long)readers[i].corrupt);
+    allOk &= readers[i].corrupt == 0;
+    accounted &= readers[i].got + (uint64_t)lost == stressTotal;
+  }
+  expect_true("读到的样本全部是对应序号的值（没有读到写了一半的）", allOk);
+  expect_true("每个读者：读到的 + 丢掉的 = 写进去的", accounted);
+  expect_true("慢读者确实被追上过（测试有效）", audio_ring_overrun(&stressRing, readers[2].id) > 0);
+
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int run_bench(long seconds) {
+  static int16_t big[16000 * 30];
+  AudioRing r;
+  audio_ring_init(&r, big, 16000 * 30);
+  int extra[3];
+  for (int i = 0; i < 3; i++) extra[i] = audio_ring_register(&r, AUDIO_RING_FROM_NOW);
+  const long total = 16000L * seconds;
+  int16_t chunk[320], out[320];
+  for (int i = 0; i < 320; i++) chunk[i] = (int16_t)i;
+
+  double writeNs = 0, readNs = 0;
+  for (long done = 0; done < total; done += 320) {
+    double t0 = now_ns();
+    audio_ring_write(&r, chunk, 320);
+    double t1 = now_ns();
+    audio_ring_read(&r, AUDIO_RING_DEFAULT_READER, out, 320);
+    for (int i = 0; i < 3; i++) audio_ring_read(&r, extra[i], out, 320);
+    writeNs += t1 - t0;
+    readNs += now_ns() - t1;
+  }
+  printf("音频 %ld 秒（16kHz，320 样本一块），1 个写者 + 4 个读者\n", seconds);
+  printf("  写: %.2f ns/样本（每块 %.0f ns）\n", writeNs / total, writeNs / (total / 320));
+  printf("  读: %.2f ns/样本/读者\n", readNs / total / 4);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return run_bench(argc > 2 ? atol(argv[2]) : 600);
+  }
+  return run_tests();
+}
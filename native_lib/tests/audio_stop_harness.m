@@ -30,6 +30,7 @@ static OSStatus test_audio_queue_dispose(AudioQueueRef queue, Boolean immediate)
 #define AudioQueueStop test_audio_queue_stop
 #define AudioQueueDispose test_audio_queue_dispose
 #include "../native_input.m"
+#include "../dsp/audio_ring.c"
 
 static int failures = 0;
 
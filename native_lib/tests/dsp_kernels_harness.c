@@ -0,0 +1,288 @@
+// DSP 内核的可执行测试宿主：本机能跑的每个 SIMD 变体都和标量参考逐位比对
+// （点积按相对误差），覆盖 int16 两端极值、NaN/越界浮点、不是向量宽度整数倍的长度。
+// `bench` 参数跑每个内核 × 每个变体的吞吐基准。
+//
+// 编译: cc -O2 -o dsp_kernels_harness native_lib/tests/dsp_kernels_harness.c -lm
+// 基准: ./dsp_kernels_harness bench [样本数]
+// 强制变体: SPEAKOUT_DSP=scalar ./dsp_kernels_harness
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../dsp/dsp_kernels.c"
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+static uint32_t rng_state = 12345;
+
+static uint32_t rng(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state;
+}
+
+/* 随机样本，里面掺上两端极值和 ±32766 这种削波门限附近的值 */
+static void fill_i16(int16_t* x, int n) {
+  static const int16_t edges[] = {-32768, -32767, -32766, 32767, 32766, 0, -1, 1};
+  for (int i = 0; i < n; i++) {
+    uint32_t r = rng();
+    x[i] = (r & 7) == 0 ? edges[(r >> 3) & 7] : (int16_t)(r >> 16);
+  }
+}
+
+static void fill_f32(float* x, int n) {
+  for (int i = 0; i < n; i++) {
+    uint32_t r = rng();
+    switch (r & 15) {
+      case 0: x[i] = 1.5f; break;
+      case 1: x[i] = -7.0f; break;
+      case 2: x[i] = NAN; break;
+      case 3: x[i] = 1.0f; break;
+      case 4: x[i] = -1.0f; break;
+      default: x[i] = ((int32_t)(r >> 8) - (1 << 23)) / (float)(1 << 23); break;
+    }
+  }
+}
+
+static const int kLengths[] = {0, 1, 7, 8, 15, 16, 17, 31, 33, 160, 1023, 4801};
+#define N_LENGTHS ((int)(sizeof(kLengths) / sizeof(kLengths[0])))
+#define MAX_N 4801
+
+/* 每个变体 × 每个长度都和标量比，返回不一致的组合数 */
+static int compare_variant(const DspKernels* k) {
+  const DspKernels* ref = dsp_kernels_scalar();
+  static int16_t in16[MAX_N], a16[MAX_N], b16[MAX_N];
+  static float inf[MAX_N], wf[MAX_N], af[MAX_N], bf[MAX_N];
+  int bad = 0;
+  for (int li = 0; li < N_LENGTHS; li++) {
+    int n = kLengths[li];
+    fill_i16(in16, n);
+    fill_f32(inf, n);
+    for (int i = 0; i < n; i++) wf[i] = (float)(rng() >> 8) / (1 << 24);
+
+    ref->i16_to_f32(in16, af, n);
+    k->i16_to_f32(in16, bf, n);
+    if (memcmp(af, bf, sizeof(float) * n) != 0) {
+      printf("    %s i16_to_f32 n=%d 不一致\n", k->name, n);
+      bad++;
+    }
+
+    ref->f32_to_i16(inf, a16, n);
+    k->f32_to_i16(inf, b16, n);
+    if (memcmp(a16, b16, sizeof(int16_t) * n) != 0) {
+      printf("    %s f32_to_i16 n=%d 不一致\n", k->name, n);
+      bad++;
+    }
+
+    static const float gains[] = {0.0f, 0.5f, 1.0f, 1.37f, 3.0f, 40.0f, -2.5f};
+    for (int gi = 0; gi < (int)(sizeof(gains) / sizeof(gains[0])); gi++) {
+      memcpy(a16, in16, sizeof(int16_t) * n);
+      memcpy(b16, in16, sizeof(int16_t) * n);
+      ref->gain_i16(a16, n, gains[gi]);
+      k->gain_i16(b16, n, gains[gi]);
+      if (memcmp(a16, b16, sizeof(int16_t) * n) != 0) {
+        printf("    %s gain_i16 n=%d gain=%.2f 不一致\n", k->name, n, gains[gi]);
+        bad++;
+      }
+    }
+
+    memcpy(af, wf, sizeof(float) * n);
+    memcpy(bf, wf, sizeof(float) * n);
+    ref->gain_f32(af, n, 0.7f);
+    k->gain_f32(bf, n, 0.7f);
+    if (memcmp(af, bf, sizeof(float) * n) != 0) {
+      printf("    %s gain_f32 n=%d 不一致\n", k->name, n);
+      bad++;
+    }
+
+    ref->i16_to_f32(in16, af, n);
+    ref->i16_to_f32(in16, bf, n);
+    ref->mul_f32(af, wf, n);
+    k->mul_f32(bf, wf, n);
+    if (memcmp(af, bf, sizeof(float) * n) != 0) {
+      printf("    %s mul_f32 n=%d 不一致\n", k->name, n);
+      bad++;
+    }
+
+    /* 增益包络：从 0 到 40 倍再到负数，各处都有饱和和舍入 */
+    for (int i = 0; i < n; i++) af[i] = 40.0f * (float)(rng() >> 8) / (1 << 24) - 2.0f;
+    memcpy(a16, in16, sizeof(int16_t) * n);
+    memcpy(b16, in16, sizeof(int16_t) * n);
+    ref->mul_i16(a16, af, n);
+    k->mul_i16(b16, af, n);
+    if (memcmp(a16, b16, sizeof(int16_t) * n) != 0) {
+      printf("    %s mul_i16 n=%d 不一致\n", k->name, n);
+      bad++;
+    }
+
+    DspStats sa, sb;
+    ref->stats_i16(in16, n, &sa);
+    k->stats_i16(in16, n, &sb);
+    if (sa.sumSquares != sb.sumSquares || sa.peak != sb.peak || sa.clipped != sb.clipped) {
+      printf("    %s stats_i16 n=%d 不一致: %llu/%d/%d vs %llu/%d/%d\n", k->name, n,
+             (unsigned long long)sa.sumSquares, sa.peak, sa.clipped,
+             (unsigned long long)sb.sumSquares, sb.peak, sb.clipped);
+      bad++;
+    }
+
+    /* 点积：求和顺序不同，按 Σ|a·b| 归一的误差比 */
+    ref->i16_to_f32(in16, af, n);
+    double magnitude = 0;
+    for (int i = 0; i < n; i++) magnitude += fabs((double)af[i] * wf[i]);
+    float da = ref->dot_f32(af, wf, n), db = k->dot_f32(af, wf, n);
+    if (fabs((double)da - db) > 1e-5 * (magnitude + 1e-30)) {
+      printf("    %s dot_f32 n=%d 误差过大: %.9g vs %.9g\n", k->name, n, da, db);
+      bad++;
+    }
+  }
+  return bad;
+}
+
+static int run_tests(void) {
+  const DspKernels* all[4];
+  int count = dsp_kernels_all(all, 4);
+
+  printf("== 1. 分派：标量在第一个，默认选最后（最快）的一个 ==\n");
+  printf("  本机变体:");
+  for (int i = 0; i < count; i++) printf(" %s", all[i]->name);
+  printf("，默认 %s\n", dsp_kernels()->name);
+  expect_true("标量是第一个", count >= 1 && all[0] == dsp_kernels_scalar());
+  const char* forced = getenv("SPEAKOUT_DSP");
+  if (!forced || !forced[0]) {
+    expect_true("默认选最快的", dsp_kernels() == all[count - 1]);
+  } else {
+    expect_true("SPEAKOUT_DSP 指定的变体生效（不支持的名字回退到最快）",
+                strcmp(dsp_kernels()->name, forced) == 0 || dsp_kernels() == all[count - 1]);
+  }
+#if defined(__x86_64__)
+  expect_true("x86-64 上至少有 SSE2", count >= 2);
+#endif
+
+  printf("== 2. 每个变体与标量一致（%d 种长度，含非向量宽度整数倍） ==\n", N_LENGTHS);
+  for (int i = 1; i < count; i++) {
+    char label[64];
+    snprintf(label, sizeof(label), "%s 全部内核一致", all[i]->name);
+    expect_true(label, compare_variant(all[i]) == 0);
+  }
+
+  printf("== 3. 边界语义（标量参考） ==\n");
+  const DspKernels* s = dsp_kernels_scalar();
+  int16_t ext[] = {-32768, 32767, 0, -1};
+  float f[4];
+  s->i16_to_f32(ext, f, 4);
+  expect_true("-32768 → -1.0，32767 → 32767/32768", f[0] == -1.0f && f[1] == 32767.0f / 32768.0f);
+  float wild[] = {2.0f, -2.0f, NAN, 0.5f};
+  int16_t out[4];
+  s->f32_to_i16(wild, out, 4);
+  expect_true("越界夹到 ±32767，NaN 当 -1，向零取整",
+              out[0] == 32767 && out[1] == -32767 && out[2] == -32767 && out[3] == 16383);
+  int16_t g[] = {1, 3, -3, 20000, -20000};
+  s->gain_i16(g, 5, 2.5f);
+  expect_true("增益五成双、饱和", g[0] == 2 && g[1] == 8 && g[2] == -8 && g[3] == 32767 &&
+                                      g[4] == -32768);
+  DspStats st;
+  s->stats_i16(ext, 4, &st);
+  expect_true("-32768 峰值记 32768，两端都算削波", st.peak == 32768 && st.clipped == 2);
+  s->stats_i16(ext, 0, &st);
+  expect_true("空输入统计全零", st.sumSquares == 0 && st.peak == 0 && st.clipped == 0 &&
+                                    dsp_stats_rms(&st, 0) == 0.0);
+  int16_t square[64];
+  for (int i = 0; i < 64; i++) square[i] = (i & 1) ? 16384 : -16384;
+  dsp_kernels()->stats_i16(square, 64, &st);
+  expect_true("半幅方波 RMS = 0.5", fabs(dsp_stats_rms(&st, 64) - 0.5) < 1e-12);
+  float w[8];
+  dsp_hann_window(w, 8);
+  expect_true("周期 Hann：首点 0、中点 1", w[0] == 0.0f && fabsf(w[4] - 1.0f) < 1e-6f &&
+                                              fabsf(w[1] - w[7]) < 1e-6f);
+
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
+
+// ============================================================
+// 基准
+// ============================================================
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile float g_sink;
+
+/* 跑够 ~50ms 取平均；输出格式仿 Google Benchmark（BM_内核/变体/样本数），方便贴进表里比 */
+#define BENCH(kname, variant, n, body)                                            \
+  do {                                                                            \
+    char label_[64];                                                              \
+    snprintf(label_, sizeof(label_), "BM_%s/%s/%d", kname, (variant)->name, n);   \
+    long iters = 0;                                                               \
+    double t0 = now_ns(), t1;                                                     \
+    do {                                                                          \
+      for (int r_ = 0; r_ < 64; r_++) { body; }                                   \
+      iters += 64;                                                                \
+      t1 = now_ns();                                                              \
+    } while (t1 - t0 < 5e7);                                                      \
+    double ns = (t1 - t0) / iters;                                                \
+    printf("%-32s %10.1f ns %10ld  items_per_second=%.3gG/s\n", label_, ns, iters, \
+           (n) / ns);                                                             \
+  } while (0)
+
+static int run_bench(int n) {
+  int16_t* x16 = malloc(sizeof(int16_t) * n);
+  int16_t* y16 = malloc(sizeof(int16_t) * n);
+  float* xf = malloc(sizeof(float) * n);
+  float* wf = malloc(sizeof(float) * n);
+  float* yf = malloc(sizeof(float) * n);
+  fill_i16(x16, n);
+  dsp_kernels_scalar()->i16_to_f32(x16, xf, n);
+  dsp_hann_window(wf, n);
+
+  const DspKernels* all[4];
+  int count = dsp_kernels_all(all, 4);
+  printf("样本数 %d（16kHz 下 %.1f ms），默认变体 %s\n", n, n / 16.0, dsp_kernels()->name);
+  printf("%-32s %13s %10s\n", "Benchmark", "Time", "Iterations");
+  for (int v = 0; v < count; v++) {
+    const DspKernels* k = all[v];
+    DspStats st;
+    BENCH("i16_to_f32", k, n, k->i16_to_f32(x16, xf, n));
+    BENCH("f32_to_i16", k, n, k->f32_to_i16(xf, y16, n));
+    BENCH("gain_f32", k, n, k->gain_f32(xf, n, 1.0f));
+    BENCH("gain_i16", k, n, (memcpy(y16, x16, sizeof(int16_t) * n), k->gain_i16(y16, n, 0.9f)));
+    BENCH("stats_i16", k, n, k->stats_i16(x16, n, &st));
+    BENCH("dot_f32", k, n, g_sink = k->dot_f32(xf, wf, n));
+    /* 每轮从原值重来：反复乘窗会掉进非规格化数，测的就成了微码慢路径 */
+    BENCH("mul_f32", k, n, (memcpy(yf, xf, sizeof(float) * n), k->mul_f32(yf, wf, n)));
+    BENCH("mul_i16", k, n, (memcpy(y16, x16, sizeof(int16_t) * n), k->mul_i16(y16, wf, n)));
+  }
+  free(x16);
+  free(y16);
+  free(xf);
+  free(wf);
+  free(yf);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    int n = argc > 2 ? atoi(argv[2]) : 1600;
+    return run_bench(n > 0 ? n : 1600);
+  }
+  return run_tests();
+}
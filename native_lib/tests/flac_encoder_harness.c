@@ -0,0 +1,307 @@
+// 流式 FLAC 编码器的可执行测试。直接包含实现文件，用一个最小解码器
+// 逐帧校验 CRC、还原样本，确认无损；`bench` 参数跑编码耗时 / 压缩率基准。
+//
+// 编译: cc -O2 -o flac_encoder_harness native_lib/tests/flac_encoder_harness.c -lm
+// 基准: ./flac_encoder_harness bench [语音秒数]
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "../linux/flac_encoder.c"
+
+// ============================================================
+// 最小 FLAC 解码器（只认编码器会产出的子集）
+// ============================================================
+
+typedef struct {
+  const uint8_t* p;
+  size_t len;
+  size_t pos; /* bit position */
+} BitReader;
+
+static int br_ok = 1;
+
+static uint32_t br_get(BitReader* br, int n) {
+  uint32_t v = 0;
+  for (int i = 0; i < n; i++) {
+    if (br->pos >= br->len * 8) {
+      br_ok = 0;
+      return 0;
+    }
+    v = (v << 1) | ((br->p[br->pos >> 3] >> (7 - (br->pos & 7))) & 1);
+    br->pos++;
+  }
+  return v;
+}
+
+static int32_t sext16(uint32_t v) { return (int32_t)(int16_t)(uint16_t)v; }
+
+/* 返回解出的样本数；出错返回 -1，msg 说明原因 */
+static long decode_flac(const uint8_t* data, size_t len, int16_t* out, long maxOut, const char** msg) {
+  BitReader br = {data, len, 0};
+  br_ok = 1;
+  if (len < 42 || memcmp(data, "fLaC", 4) != 0) { *msg = "缺少 fLaC 标记"; return -1; }
+  br.pos = 32;
+  for (;;) {
+    uint32_t last = br_get(&br, 1);
+    br_get(&br, 7);
+    uint32_t blen = br_get(&br, 24);
+    br.pos += (size_t)blen * 8;
+    if (last) break;
+  }
+  const uint8_t* si = data + 8;
+  uint32_t rate = ((uint32_t)si[10] << 12) | ((uint32_t)si[11] << 4) | (si[12] >> 4);
+  if (rate != 16000) { *msg = "STREAMINFO 采样率不对"; return -1; }
+
+  long total = 0;
+  uint64_t expectFrame = 0;
+  while (br.pos / 8 < len) {
+    size_t frameStart = br.pos / 8;
+    if (br_get(&br, 16) != 0xFFF8) { *msg = "帧同步码错"; return -1; }
+    uint32_t bsCode = br_get(&br, 4);
+    uint32_t srCode = br_get(&br, 4);
+    uint32_t chan = br_get(&br, 4);
+    uint32_t bps = br_get(&br, 3);
+    br_get(&br, 1);
+    if (srCode != 5 || chan != 0 || bps != 4) { *msg = "帧头字段不对"; return -1; }
+    /* UTF-8 帧号 */
+    uint32_t b0 = br_get(&br, 8);
+    int extra = 0;
+    uint64_t num;
+    if (b0 < 0x80) num = b0;
+    else if (b0 == 0xFE) { num = 0; extra = 6; }
+    else {
+      int ones = 0;
+      while (b0 & (0x80 >> ones)) ones++;
+      extra = ones - 1;
+      num = b0 & (0x7F >> ones);
+    }
+    for (int i = 0; i < extra; i++) {
+      uint32_t c = br_get(&br, 8);
+      if ((c & 0xC0) != 0x80) { *msg = "帧号 UTF-8 编码错"; return -1; }
+      num = (num << 6) | (c & 0x3F);
+    }
+    if (num != expectFrame) { *msg = "帧号不连续"; return -1; }
+    expectFrame++;
+    int n;
+    if (bsCode == 12) n = 4096;
+    else if (bsCode == 6) n = (int)br_get(&br, 8) + 1;
+    else if (bsCode == 7) n = (int)br_get(&br, 16) + 1;
+    else { *msg = "块长编码不认识"; return -1; }
+    uint8_t c8 = crc8(data + frameStart, br.pos / 8 - frameStart);
+    if (br_get(&br, 8) != c8) { *msg = "帧头 CRC-8 错"; return -1; }
+    if (total + n > maxOut) { *msg = "样本比输入多"; return -1; }
+
+    int32_t* x = malloc(sizeof(int32_t) * n);
+    if (br_get(&br, 1) != 0) { *msg = "子帧 padding 位不为 0"; free(x); return -1; }
+    uint32_t type = br_get(&br, 6);
+    if (br_get(&br, 1) != 0) { *msg = "不该有 wasted bits"; free(x); return -1; }
+    if (type == 0) {
+      int32_t v = sext16(br_get(&br, 16));
+      for (int i = 0; i < n; i++) x[i] = v;
+    } else if (type == 1) {
+      for (int i = 0; i < n; i++) x[i] = sext16(br_get(&br, 16));
+    } else if (type >= 8 && type <= 12) {
+      int order = (int)type - 8;
+      for (int i = 0; i < order; i++) x[i] = sext16(br_get(&br, 16));
+      if (br_get(&br, 2) != 0) { *msg = "残差编码方式不对"; free(x); return -1; }
+      int po = (int)br_get(&br, 4);
+      int np = 1 << po;
+      int i = order;
+      for (int j = 0; j < np; j++) {
+        int k = (int)br_get(&br, 4);
+        int cnt = (n >> po) - (j == 0 ? order : 0);
+        for (int m = 0; m < cnt; m++, i++) {
+          uint32_t q = 0;
+          while (br_get(&br, 1) == 0 && br_ok) q++;
+          uint32_t u = (q << k) | br_get(&br, k);
+          x[i] = (u & 1) ? -(int32_t)(u >> 1) - 1 : (int32_t)(u >> 1);
+        }
+      }
+      for (i = order; i < n; i++) {
+        switch (order) {
+          case 0: break;
+          case 1: x[i] += x[i - 1]; break;
+          case 2: x[i] += 2 * x[i - 1] - x[i - 2]; break;
+          case 3: x[i] += 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3]; break;
+          default: x[i] += 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4]; break;
+        }
+      }
+    } else {
+      *msg = "子帧类型不认识";
+      free(x);
+      return -1;
+    }
+    if (!br_ok) { *msg = "数据截断"; free(x); return -1; }
+    while (br.pos & 7) {
+      if (br_get(&br, 1) != 0) { *msg = "对齐位不为 0"; free(x); return -1; }
+    }
+    uint16_t c16 = crc16(data + frameStart, br.pos / 8 - frameStart);
+    if (br_get(&br, 16) != c16) { *msg = "帧尾 CRC-16 错"; free(x); return -1; }
+    for (int i = 0; i < n; i++) out[total + i] = (int16_t)x[i];
+    total += n;
+    free(x);
+  }
+  return total;
+}
+
+// ============================================================
+// 测试
+// ============================================================
+
+/* 类语音信号：基频缓慢漂移的谐波 + 音节包络 + 少量底噪 */
+static void synth_speech(int16_t* out, long n, unsigned seed) {
+  srand(seed);
+  double phase = 0;
+  for (long i = 0; i < n; i++) {
+    double t = (double)i / 16000.0;
+    double f0 = 140 + 30 * sin(2 * M_PI * 0.7 * t);
+    phase += 2 * M_PI * f0 / 16000.0;
+    double env = 0.5 + 0.5 * sin(2 * M_PI * 3.0 * t);
+    double v = 0;
+    for (int h = 1; h <= 8; h++) v += sin(h * phase) / h;
+    v = v * env * 6000 + ((rand() % 201) - 100);
+    out[i] = (int16_t)v;
+  }
+}
+
+/* 按不规则的块长喂给编码器，边喂边取，模拟 50ms 轮询 */
+static size_t encode_all(const int16_t* pcm, long n, uint8_t* out, size_t cap) {
+  FlacEncoder* enc = flac_encoder_new(16000);
+  static const int steps[] = {800, 17, 4096, 1, 3000, 800, 9000};
+  size_t len = 0;
+  long pos = 0;
+  int s = 0;
+  while (pos < n) {
+    int c = steps[s++ % 7];
+    if (c > n - pos) c = (int)(n - pos);
+    flac_encoder_write(enc, pcm + pos, c);
+    pos += c;
+    len += flac_encoder_read(enc, out + len, (int)(cap - len));
+  }
+  flac_encoder_finish(enc);
+  int r;
+  while ((r = flac_encoder_read(enc, out + len, 7)) > 0) len += r; /* 小块读也要读全 */
+  flac_encoder_free(enc);
+  return len;
+}
+
+static int failures = 0;
+
+static void roundtrip(const char* name, const int16_t* pcm, long n, double maxRatio) {
+  size_t cap = (size_t)n * 2 + 65536;
+  uint8_t* flac = malloc(cap);
+  int16_t* back = malloc(sizeof(int16_t) * (n + 1));
+  size_t len = encode_all(pcm, n, flac, cap);
+  const char* msg = "";
+  long got = decode_flac(flac, len, back, n, &msg);
+  double ratio = (double)len / (n * 2.0);
+  if (got < 0) {
+    printf("FAIL %s: 解码失败（%s）\n", name, msg);
+    failures++;
+  } else if (got != n || memcmp(back, pcm, sizeof(int16_t) * n) != 0) {
+    printf("FAIL %s: 还原样本不一致（%ld / %ld）\n", name, got, n);
+    failures++;
+  } else if (ratio > maxRatio) {
+    printf("FAIL %s: 压缩比 %.3f 超过 %.3f\n", name, ratio, maxRatio);
+    failures++;
+  } else {
+    printf("ok   %s: %ld 样本 → %zu 字节（%.1f%% of PCM）\n", name, n, len, ratio * 100);
+  }
+  free(flac);
+  free(back);
+}
+
+static int run_tests(void) {
+  /* CRC 标准校验值：解码器和编码器共用同一份 CRC，这里单独对一遍 */
+  if (crc8((const uint8_t*)"123456789", 9) != 0xF4 || crc16((const uint8_t*)"123456789", 9) != 0xFEE8) {
+    printf("FAIL CRC 校验值不符合 FLAC 规范\n");
+    return 1;
+  }
+
+  const long n = 16000L * 60 + 123; /* 60 秒多一点：帧号过 128 走多字节 UTF-8，尾块不满 */
+  int16_t* pcm = malloc(sizeof(int16_t) * n);
+
+  memset(pcm, 0, sizeof(int16_t) * n);
+  roundtrip("静音", pcm, n, 0.01);
+
+  synth_speech(pcm, n, 1);
+  roundtrip("类语音", pcm, n, 0.7);
+
+  srand(2);
+  for (long i = 0; i < n; i++) pcm[i] = (int16_t)((rand() & 0xFFFF) - 32768);
+  pcm[0] = -32768;
+  pcm[1] = 32767;
+  roundtrip("满幅白噪声", pcm, n, 1.01);
+
+  for (long i = 0; i < n; i++) pcm[i] = (i / 37) % 2 ? 32767 : -32768;
+  roundtrip("满幅方波", pcm, n, 1.01);
+
+  synth_speech(pcm, 100, 3);
+  roundtrip("短于一块", pcm, 100, 1.5);
+  roundtrip("单样本", pcm, 1, 60);
+
+  /* 什么都没喂：一个字节都不该产出 */
+  FlacEncoder* enc = flac_encoder_new(16000);
+  uint8_t buf[64];
+  if (flac_encoder_finish(enc) != 0 || flac_encoder_read(enc, buf, sizeof(buf)) != 0) {
+    printf("FAIL 空录音: 不应产出任何字节\n");
+    failures++;
+  } else {
+    printf("ok   空录音: 0 字节\n");
+  }
+  /* finish 之后再 write 不得改变输出 */
+  flac_encoder_write(enc, pcm, 100);
+  if (flac_encoder_read(enc, buf, sizeof(buf)) != 0) {
+    printf("FAIL finish 后 write 仍在产出\n");
+    failures++;
+  }
+  flac_encoder_free(enc);
+
+  if (flac_encoder_new(0) != NULL) {
+    printf("FAIL 采样率 0 应返回 NULL\n");
+    failures++;
+  }
+
+  free(pcm);
+  if (failures) return 1;
+  printf("ALL PASSED\n");
+  return 0;
+}
+
+static double now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int run_bench(long seconds) {
+  const long n = 16000L * seconds;
+  int16_t* pcm = malloc(sizeof(int16_t) * n);
+  synth_speech(pcm, n, 7);
+  size_t cap = (size_t)n * 2 + 65536;
+  uint8_t* flac = malloc(cap);
+
+  encode_all(pcm, n, flac, cap); /* 预热 */
+  const int rounds = 5;
+  size_t len = 0;
+  double t0 = now_us();
+  for (int r = 0; r < rounds; r++) len = encode_all(pcm, n, flac, cap);
+  double perSecond = (now_us() - t0) / rounds / seconds;
+
+  printf("语音 %ld 秒（16kHz mono int16，%ld 字节/秒 PCM）\n", seconds, 16000L * 2);
+  printf("  编码耗时:   %.1f µs/秒语音（单核 %.3f%%）\n", perSecond, perSecond / 1e4);
+  printf("  压缩后:     %.0f 字节/秒（%.1f%% of PCM）\n", (double)len / seconds, len * 100.0 / (n * 2));
+  printf("  每秒省下:   %.0f 字节上行\n", 32000.0 - (double)len / seconds);
+  free(pcm);
+  free(flac);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return run_bench(argc > 2 ? atol(argv[2]) : 600);
+  }
+  return run_tests();
+}
@@ -10,6 +10,7 @@
 
 #define CGEventPost(tap, event) ((void)0)
 #include "../native_input.m"
+#include "../dsp/audio_ring.c"
 
 static pthread_mutex_t harnessMutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t harnessCondition = PTHREAD_COND_INITIALIZER;
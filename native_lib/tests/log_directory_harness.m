@@ -9,6 +9,7 @@
 
 #define CGEventPost(tap, event) ((void)0)
 #include "../native_input.m"
+#include "../dsp/audio_ring.c"
 
 int main(void) {
   char path[1024];
@@ -0,0 +1,212 @@
+// Linux native 日志的可执行测试宿主：多生产者入环、写线程落盘、滚动、切目录。
+// PulseAudio 全部替换成桩，不会打开麦克风；日志写在 mkdtemp 出来的临时目录里。
+//
+// 编译: cc -o native_log_harness native_lib/tests/native_log_harness.c -lpthread -lm
+
+#define _GNU_SOURCE
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static pa_simple* test_pa_simple_new(const char* server, const char* name,
+                                     pa_stream_direction_t dir, const char* dev,
+                                     const char* stream, const pa_sample_spec* ss,
+                                     const pa_channel_map* map,
+                                     const pa_buffer_attr* attr, int* error) {
+  (void)server; (void)name; (void)dir; (void)dev; (void)stream;
+  (void)ss; (void)map; (void)attr;
+  if (error) *error = 1;
+  return NULL;
+}
+
+static int test_pa_simple_read(pa_simple* s, void* data, size_t bytes, int* error) {
+  (void)s; (void)data; (void)bytes; (void)error;
+  return -1;
+}
+
+static void test_pa_simple_free(pa_simple* s) { (void)s; }
+
+#define pa_simple_new test_pa_simple_new
+#define pa_simple_read test_pa_simple_read
+#define pa_simple_free test_pa_simple_free
+/* 调小滚动阈值，一两千行就能触发 */
+#define LOG_ROTATE_BYTES 65536
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/noise_suppress.c"
+#include "../dsp/agc.c"
+#include "../dsp/resampler.c"
+#include "../dsp/audio_ring.c"
+#include "../dsp/silence_compact.c"
+#include "../linux/flac_encoder.c"
+#include "../linux/native_input.c"
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+static char* read_file(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* buf = malloc((size_t)n + 1);
+  size_t got = fread(buf, 1, (size_t)n, f);
+  buf[got] = 0;
+  fclose(f);
+  return buf;
+}
+
+static long file_size(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static int count_of(const char* text, const char* needle) {
+  int n = 0;
+  for (const char* p = text; (p = strstr(p, needle)) != NULL; p += strlen(needle)) n++;
+  return n;
+}
+
+#define PRODUCERS 4
+#define LINES_PER_PRODUCER 100
+
+static void* producer(void* arg) {
+  int id = (int)(long)arg;
+  for (int i = 0; i < LINES_PER_PRODUCER; i++) native_log("[test] p%d line %03d", id, i);
+  return NULL;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(void) {
+  char root[] = "/tmp/speakout_native_log_XXXXXX";
+  if (!mkdtemp(root)) return 2;
+  char dirA[256], dirB[256], xdg[256], fileA[300], fileB[300], rotated[310], fileDefault[320];
+  snprintf(dirA, sizeof(dirA), "%s/a", root);
+  snprintf(dirB, sizeof(dirB), "%s/b", root);
+  snprintf(xdg, sizeof(xdg), "%s/xdg", root);
+  mkdir(dirA, 0700);
+  mkdir(dirB, 0700);
+  mkdir(xdg, 0700);
+  snprintf(fileA, sizeof(fileA), "%s/speakout_native.log", dirA);
+  snprintf(fileB, sizeof(fileB), "%s/speakout_native.log", dirB);
+  snprintf(rotated, sizeof(rotated), "%s.1", fileA);
+  snprintf(fileDefault, sizeof(fileDefault), "%s/com.example.speakout/speakout_native.log", xdg);
+
+  printf("== 1. 多个线程同时写：每行恰好落盘一次，各自顺序不乱 ==\n");
+  set_log_directory(dirA);
+  set_debug_logging(1);
+  pthread_t threads[PRODUCERS];
+  for (long i = 0; i < PRODUCERS; i++) pthread_create(&threads[i], NULL, producer, (void*)i);
+  for (int i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+  set_debug_logging(0); /* 关之前同步排空 */
+  char* text = read_file(fileA);
+  expect_true("日志文件已创建", text != NULL);
+  int exact = 1, ordered = 1;
+  for (int p = 0; p < PRODUCERS && text; p++) {
+    const char* last = text;
+    for (int i = 0; i < LINES_PER_PRODUCER; i++) {
+      char needle[64];
+      snprintf(needle, sizeof(needle), "p%d line %03d\n", p, i);
+      if (count_of(text, needle) != 1) exact = 0;
+      const char* at = strstr(text, needle);
+      if (!at || at < last) ordered = 0;
+      if (at) last = at;
+    }
+  }
+  expect_true("400 行各出现一次", exact);
+  expect_true("同一线程的行按写入顺序", ordered);
+  expect_true("行首带时间戳", text && text[0] == '[' && text[3] == ':' && text[9] == '.');
+  free(text);
+
+  printf("== 2. 写线程卡住：生产者照样立即返回，满了丢新的并记数 ==\n");
+  truncate(fileA, 0);
+  set_debug_logging(1);
+  pthread_mutex_lock(&g_logDrainLock); /* 模拟磁盘卡住，写线程拿不到锁 */
+  double t0 = now_ms();
+  for (int i = 0; i < 2000; i++) native_log("[test] stalled %04d", i);
+  double spent = now_ms() - t0;
+  expect_true("2000 行在 50ms 内返回", spent < 50);
+  expect_true("环里留 512 行，其余计为丢弃",
+              atomic_load(&g_logDropped) == 2000 - LOG_SLOTS);
+  pthread_mutex_unlock(&g_logDrainLock);
+  set_debug_logging(0);
+  text = read_file(fileA);
+  expect_true("先到的 512 行都在", text && count_of(text, "stalled ") == LOG_SLOTS &&
+                                       strstr(text, "stalled 0000\n") &&
+                                       strstr(text, "stalled 0511\n"));
+  expect_true("丢弃数写进日志", text && strstr(text, "[log] dropped 1488 lines (ring full)"));
+  free(text);
+
+  printf("== 3. 超过大小滚成 .1，只留一份旧的 ==\n");
+  truncate(fileA, 0);
+  set_debug_logging(1);
+  for (int i = 0; i < 1500; i++) {
+    native_log("[test] rotate %04d padding padding padding padding", i);
+    if (i % 100 == 99) log_drain();
+  }
+  set_debug_logging(0);
+  expect_true(".1 已生成", file_size(rotated) >= LOG_ROTATE_BYTES);
+  expect_true("当前文件没超过阈值太多", file_size(fileA) < LOG_ROTATE_BYTES + LOG_LINE + 32);
+  text = read_file(fileA);
+  expect_true("最后一行在当前文件里", text && strstr(text, "rotate 1499 "));
+  free(text);
+
+  printf("== 4. 切换目录：之前的留在旧目录，之后的写新目录 ==\n");
+  truncate(fileA, 0);
+  set_debug_logging(1);
+  native_log("[test] before switch");
+  set_log_directory(dirB);
+  native_log("[test] after switch");
+  set_debug_logging(0);
+  char* a = read_file(fileA);
+  char* b = read_file(fileB);
+  expect_true("旧目录有切换前的", a && strstr(a, "before switch") && !strstr(a, "after switch"));
+  expect_true("新目录有切换后的", b && strstr(b, "after switch") && !strstr(b, "before switch"));
+  free(a);
+  free(b);
+
+  printf("== 5. 空目录回到默认位置，目录不存在就建 ==\n");
+  setenv("XDG_DATA_HOME", xdg, 1);
+  set_log_directory("");
+  set_debug_logging(1);
+  native_log("[test] default dir");
+  set_debug_logging(0);
+  text = read_file(fileDefault);
+  expect_true("写到 $XDG_DATA_HOME/com.example.speakout", text && strstr(text, "default dir"));
+  free(text);
+
+  printf("== 6. 落盘关着：照样出环（镜像到 stderr），文件不增长 ==\n");
+  long before = file_size(fileDefault);
+  native_log("[test] not persisted");
+  log_drain();
+  expect_true("文件没变", file_size(fileDefault) == before);
+  expect_true("环已排空", g_logDequeue == atomic_load(&g_logEnqueue));
+
+  char cmd[300];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+  if (system(cmd) != 0) printf("  (临时目录没删掉: %s)\n", root);
+
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
@@ -0,0 +1,226 @@
+// 流式降噪的可执行测试宿主：旁路时逐样本还原、稳态噪声压下去而语音留住、
+// 旁路开关切换不出断点、冲刷吐出延迟线里的尾巴。`bench` 参数跑每秒音频的 CPU 开销。
+//
+// 编译: cc -O2 -o noise_suppress_harness native_lib/tests/noise_suppress_harness.c -lm
+// 基准: ./noise_suppress_harness bench [秒数]
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/noise_suppress.c"
+
+#define RATE 16000
+#define CHUNK 320 /* 和采集线程一样按 20ms 一块喂 */
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+static uint32_t rng_state = 2024;
+
+/* 近似高斯的白噪声（12 个均匀分布相加） */
+static float noise_sample(void) {
+  float sum = 0;
+  for (int i = 0; i < 12; i++) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    sum += (rng_state >> 8) / (float)(1 << 24);
+  }
+  return sum - 6.0f;
+}
+
+static int16_t clamp16(float v) {
+  if (v > 32767.0f) return 32767;
+  if (v < -32768.0f) return -32768;
+  return (int16_t)lrintf(v);
+}
+
+/* 像说话的信号：200ms 一个「音节」、中间停 100ms，基频在 150~250Hz 之间滑动，
+ * 带几个谐波。停顿是必要的 —— 最小值统计本来就靠说话间隙看到噪底 */
+static float voice_sample(long i) {
+  long syllable = i / (RATE * 3 / 10);
+  long pos = i % (RATE * 3 / 10);
+  if (pos >= RATE / 5) return 0.0f;
+  double t = (double)i / RATE;
+  double f0 = 150.0 + 100.0 * ((syllable * 7) % 5) / 4.0;
+  double env = sin(M_PI * pos / (RATE / 5.0));
+  double v = sin(2 * M_PI * f0 * t) + 0.5 * sin(2 * M_PI * 2 * f0 * t) +
+             0.3 * sin(2 * M_PI * 4 * f0 * t) + 0.2 * sin(2 * M_PI * 8 * f0 * t);
+  return (float)(env * v * 4000.0);
+}
+
+static void run_chunks(NoiseSuppressor* ns, const int16_t* in, int16_t* out, long n) {
+  for (long i = 0; i < n; i += CHUNK) {
+    int take = n - i < CHUNK ? (int)(n - i) : CHUNK;
+    ns_process(ns, in + i, out + i, take);
+  }
+}
+
+static double rms_range(const int16_t* x, long from, long to) {
+  double sum = 0;
+  for (long i = from; i < to; i++) sum += (double)x[i] * x[i];
+  return sqrt(sum / (to - from));
+}
+
+static int run_tests(void) {
+  const long n = RATE * 4;
+  int16_t* in = malloc(sizeof(int16_t) * n);
+  int16_t* out = malloc(sizeof(int16_t) * n);
+  int16_t* clean = malloc(sizeof(int16_t) * n);
+  NoiseSuppressor* ns = ns_create();
+
+  printf("== 1. 旁路：输出 = 输入晚 %d 个样本 ==\n", NS_DELAY_SAMPLES);
+  for (long i = 0; i < n; i++) in[i] = clamp16(noise_sample() * 6000.0f);
+  ns_set_bypass(ns, 1);
+  run_chunks(ns, in, out, n);
+  int worst = 0, headZero = 1;
+  for (long i = 0; i < NS_DELAY_SAMPLES; i++) headZero &= out[i] == 0;
+  for (long i = NS_DELAY_SAMPLES; i < n; i++) {
+    int d = abs(out[i] - in[i - NS_DELAY_SAMPLES]);
+    if (d > worst) worst = d;
+  }
+  expect_true("开头是延迟线里的静音", headZero);
+  expect_true("其余逐样本一致（±1 LSB）", worst <= 1);
+
+  printf("== 2. 冲刷：吐出延迟线里剩下的尾巴 ==\n");
+  int16_t tail[NS_DELAY_SAMPLES];
+  int got = ns_flush(ns, tail);
+  worst = 0;
+  for (int i = 0; i < got; i++) {
+    int d = abs(tail[i] - in[n - NS_DELAY_SAMPLES + i]);
+    if (d > worst) worst = d;
+  }
+  expect_true("冲刷出 NS_DELAY_SAMPLES 个，正好是最后那段输入", got == NS_DELAY_SAMPLES && worst <= 1);
+
+  printf("== 3. 稳态噪声压下去，语音留住 ==\n");
+  ns_reset(ns);
+  /* 前 2 秒只有噪声（约 -40dBFS），后 2 秒噪声 + 语音 */
+  for (long i = 0; i < n; i++) {
+    float v = i >= n / 2 ? voice_sample(i) : 0.0f;
+    clean[i] = clamp16(v);
+    in[i] = clamp16(v + noise_sample() * 330.0f);
+  }
+  run_chunks(ns, in, out, n);
+  double noiseIn = rms_range(in, RATE, n / 2);
+  double noiseOut = rms_range(out, RATE + NS_DELAY_SAMPLES, n / 2 + NS_DELAY_SAMPLES);
+  double reduction = 20 * log10(noiseIn / (noiseOut + 1e-9));
+  printf("  纯噪声段: %.1f → %.1f（压低 %.1f dB）\n", noiseIn, noiseOut, reduction);
+  expect_true("纯噪声段压低 ≥ 10dB", reduction >= 10.0);
+  /* 语音段：输出投影到干净语音上，留住的比例 */
+  double dot = 0, energy = 0, errIn = 0, errOut = 0;
+  for (long i = n / 2 + RATE / 2; i < n - NS_DELAY_SAMPLES; i++) {
+    double c = clean[i], o = out[i + NS_DELAY_SAMPLES];
+    dot += c * o;
+    energy += c * c;
+    errIn += (in[i] - c) * (in[i] - c);
+    errOut += (o - c) * (o - c);
+  }
+  double kept = dot / energy;
+  double snrIn = 10 * log10(energy / errIn), snrOut = 10 * log10(energy / errOut);
+  printf("  语音段: 留住 %.2f，信噪比 %.1f → %.1f dB\n", kept, snrIn, snrOut);
+  expect_true("语音能量留住 ≥ 85%", kept >= 0.85 && kept <= 1.05);
+  expect_true("语音段信噪比变好", snrOut > snrIn);
+
+  printf("== 4. 处理中途切旁路再切回：没有断点 ==\n");
+  /* 200Hz 稳音：跟踪器一会儿就把它当噪底压到 -20dB，这时切旁路电平要跳 10 倍。
+   * 重叠相加让这一跳摊在一帧里：相邻样本之差不该比原信号本身的最大斜率大多少；
+   * 硬切会出现接近满幅的一步 */
+  ns_reset(ns);
+  for (long i = 0; i < n; i++) in[i] = clamp16(8000.0 * sin(2 * M_PI * 200 * i / RATE));
+  for (long i = 0, c = 0; i < n; i += CHUNK, c++) {
+    if (c == 100) ns_set_bypass(ns, 1);
+    if (c == 130) ns_set_bypass(ns, 0);
+    if (c == 131) ns_set_bypass(ns, 1);
+    ns_process(ns, in + i, out + i, CHUNK);
+  }
+  int stepIn = 0, stepOut = 0;
+  for (long i = 1; i < n; i++) {
+    if (abs(in[i] - in[i - 1]) > stepIn) stepIn = abs(in[i] - in[i - 1]);
+    if (abs(out[i] - out[i - 1]) > stepOut) stepOut = abs(out[i] - out[i - 1]);
+  }
+  double before = rms_range(out, 99 * CHUNK, 100 * CHUNK);
+  double after = rms_range(out, 140 * CHUNK, 141 * CHUNK);
+  printf("  切换前 RMS %.0f，旁路后 %.0f；最大相邻差 输入 %d / 输出 %d\n", before, after, stepIn, stepOut);
+  expect_true("切换前确实在压（电平有跳变可测）", after > before * 5);
+  expect_true("最大相邻差不超过输入的 1.25 倍", stepOut <= stepIn * 5 / 4);
+
+  printf("== 5. 就地处理（in == out）与分开处理一致 ==\n");
+  for (long i = 0; i < n; i++) in[i] = clamp16(voice_sample(i) + noise_sample() * 300.0f);
+  ns_reset(ns);
+  run_chunks(ns, in, out, n);
+  NoiseSuppressor* other = ns_create();
+  memcpy(clean, in, sizeof(int16_t) * n);
+  run_chunks(other, clean, clean, n);
+  expect_true("逐样本相同", memcmp(out, clean, sizeof(int16_t) * n) == 0);
+  ns_free(other);
+
+  printf("== 6. 数字静音：输出全 0，不出 NaN ==\n");
+  ns_reset(ns);
+  memset(in, 0, sizeof(int16_t) * n);
+  run_chunks(ns, in, out, n);
+  int allZero = 1;
+  for (long i = 0; i < n; i++) allZero &= out[i] == 0;
+  expect_true("全 0", allZero);
+
+  ns_free(ns);
+  free(in);
+  free(out);
+  free(clean);
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
+
+static double thread_cpu_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int run_bench(long seconds) {
+  const long n = RATE * seconds;
+  int16_t* in = malloc(sizeof(int16_t) * n);
+  int16_t* out = malloc(sizeof(int16_t) * n);
+  for (long i = 0; i < n; i++) in[i] = clamp16(voice_sample(i) * ((i / RATE) % 2) + noise_sample() * 300.0f);
+  NoiseSuppressor* ns = ns_create();
+  run_chunks(ns, in, out, RATE); /* 预热 */
+
+  double worstChunk = 0;
+  double t0 = thread_cpu_us();
+  for (long i = 0; i < n; i += CHUNK) {
+    double c0 = thread_cpu_us();
+    ns_process(ns, in + i, out + i, CHUNK);
+    double spent = thread_cpu_us() - c0;
+    if (spent > worstChunk) worstChunk = spent;
+  }
+  double perSecond = (thread_cpu_us() - t0) / seconds;
+
+  printf("音频 %ld 秒（16kHz mono int16，%d 样本一块），DSP 变体 %s\n", seconds, CHUNK, dsp_kernels()->name);
+  printf("  CPU:        %.1f µs/秒音频（单核 %.3f%%）\n", perSecond, perSecond / 1e4);
+  printf("  每块平均:   %.1f µs，最慢 %.1f µs（块长 20000 µs）\n", perSecond / 50, worstChunk);
+  ns_free(ns);
+  free(in);
+  free(out);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return run_bench(argc > 2 ? atol(argv[2]) : 60);
+  }
+  return run_tests();
+}
@@ -0,0 +1,239 @@
+// 停顿压缩的可执行测试宿主：长停顿压到固定间隔、短停顿和说话一个样本不丢、
+// 输出的每个样本都能经对照点映射回原始录音的同一个样本、分块方式不影响结果、
+// 半帧冲刷、全静音录音。`bench` 参数跑每秒音频的 CPU 开销。
+//
+// 编译: cc -O2 -o silence_compact_harness native_lib/tests/silence_compact_harness.c -lm
+// 基准: ./silence_compact_harness bench [秒数]
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/silence_compact.c"
+
+#define RATE 16000
+#define CHUNK 320 /* 和轮询一样按 20ms 左右一块喂 */
+#define MIN_SILENCE_MS 1000
+#define KEEP_MS 300
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+static uint32_t rng_state = 11;
+
+static float noise_sample(void) {
+  float sum = 0;
+  for (int i = 0; i < 12; i++) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    sum += (rng_state >> 8) / (float)(1 << 24);
+  }
+  return sum - 6.0f;
+}
+
+/* 200ms 一个「音节」、停 100ms：字间停顿短于 hold，整句算连续说话 */
+static float voice_sample(long i, float amp) {
+  long syllable = i / (RATE * 3 / 10);
+  long pos = i % (RATE * 3 / 10);
+  if (pos >= RATE / 5) return 0.0f;
+  double t = (double)i / RATE;
+  double f0 = 150.0 + 100.0 * ((syllable * 7) % 5) / 4.0;
+  double env = sin(M_PI * pos / (RATE / 5.0));
+  double v = sin(2 * M_PI * f0 * t) + 0.5 * sin(2 * M_PI * 2 * f0 * t) + 0.3 * sin(2 * M_PI * 4 * f0 * t);
+  return (float)(env * v * amp);
+}
+
+/* 一段录音：底噪上叠几句话，voiced 标出说话的样本 */
+typedef struct {
+  long from, to; /* 说话的区间（秒 × RATE） */
+} Span;
+
+static const Span kSpans[] = {
+    {RATE / 2, RATE * 5 / 2},       /* 0.5s 开头停顿（短，保留）后说 2s */
+    {RATE * 11 / 2, RATE * 7},      /* 3s 长停顿，再说 1.5s */
+    {RATE * 38 / 5, RATE * 43 / 5}, /* 0.6s 短停顿，再说 1s */
+};
+#define NSPANS (int)(sizeof(kSpans) / sizeof(kSpans[0]))
+#define TOTAL (RATE * 111 / 10) /* 结尾 2.5s 长停顿 */
+
+static void make_recording(int16_t* x, unsigned char* voiced) {
+  rng_state = 11;
+  for (long i = 0; i < TOTAL; i++) {
+    float v = noise_sample() * 60.0f;
+    voiced[i] = 0;
+    for (int s = 0; s < NSPANS; s++) {
+      if (i >= kSpans[s].from && i < kSpans[s].to) {
+        v += voice_sample(i - kSpans[s].from, 3000.0f);
+        voiced[i] = 1;
+      }
+    }
+    x[i] = (int16_t)lrintf(v);
+  }
+}
+
+/* 按 chunk 喂、最后 flush，返回输出总数；哪一次输出超过 sc_max_output 就置 overBound */
+static long run(SilenceCompactor* sc, const int16_t* in, long n, int chunk, int16_t* out, int* overBound) {
+  long written = 0;
+  *overBound = 0;
+  for (long i = 0; i < n; i += chunk) {
+    int take = n - i < chunk ? (int)(n - i) : chunk;
+    int w = sc_process(sc, in + i, out + written, take);
+    if (w > sc_max_output(sc, take)) *overBound = 1;
+    written += w;
+  }
+  int w = sc_flush(sc, out + written);
+  if (w > sc_max_output(sc, 0)) *overBound = 1;
+  return written + w;
+}
+
+static int run_tests(void) {
+  static int16_t in[TOTAL], out[TOTAL + RATE * 2], out2[TOTAL + RATE * 2];
+  static unsigned char voiced[TOTAL], covered[TOTAL];
+  make_recording(in, voiced);
+
+  SilenceCompactor* sc = sc_create(MIN_SILENCE_MS, KEEP_MS);
+  int overBound = 0;
+  long n = run(sc, in, TOTAL, CHUNK, out, &overBound);
+
+  printf("== 1. 长度和统计 ==\n");
+  double removedSec = (double)(TOTAL - n) / RATE;
+  printf("  原始 %.2fs → 压缩后 %.2fs（去掉 %.2fs，%lld 段）\n", (double)TOTAL / RATE, (double)n / RATE,
+         removedSec, sc_stat(sc, SC_STAT_CUTS));
+  expect_true("统计：输入 / 输出样本数对得上", sc_stat(sc, SC_STAT_INPUT) == TOTAL && sc_stat(sc, SC_STAT_OUTPUT) == n);
+  expect_true("压了两段（中间 3s、结尾 2.5s），短停顿不压", sc_stat(sc, SC_STAT_CUTS) == 2);
+  /* 每段长停顿最多留 keep + 说话后 hold 的 200ms + 一帧的取整 */
+  expect_true("去掉的在 4s 以上", removedSec > 4.0);
+  expect_true("单次输出不超过 sc_max_output", !overBound);
+
+  printf("== 2. 对照点：输出的每个样本都是原始录音里映射到的那个 ==\n");
+  int mismatch = 0;
+  long prev = -1;
+  int monotonic = 1;
+  memset(covered, 0, sizeof(covered));
+  for (long i = 0; i < n; i++) {
+    long long o = sc_map(sc, i);
+    if (o < 0 || o >= TOTAL || in[o] != out[i]) mismatch++;
+    else covered[o] = 1;
+    if (o <= prev) monotonic = 0;
+    prev = (long)o;
+  }
+  expect_true("逐样本一致", mismatch == 0);
+  expect_true("映射严格递增（顺序不乱、没有重复）", monotonic);
+  long lostVoice = 0;
+  for (long i = 0; i < TOTAL; i++) lostVoice += voiced[i] && !covered[i];
+  expect_true("说话的样本一个不丢", lostVoice == 0);
+
+  long long pts[2 * 16];
+  int np = sc_map_points(sc, pts, 16);
+  int ptsOk = np == 1;
+  for (int i = 0; i < np; i++) ptsOk &= sc_map(sc, pts[2 * i]) == pts[2 * i + 1];
+  expect_true("导出的对照点（结尾那段后面没有下一句，只有 1 个）和 sc_map 一致", ptsOk);
+
+  printf("== 3. 停顿长短 ==\n");
+  /* 短停顿 0.6s：原样保留，两边在输出里的距离不变 */
+  long a = -1, b = -1;
+  for (long i = 0; i < n; i++) {
+    long long o = sc_map(sc, i);
+    if (o == kSpans[1].to - 1) a = i;
+    if (o == kSpans[2].from) b = i;
+  }
+  expect_true("0.6s 短停顿原样保留", a >= 0 && b >= 0 && b - a == kSpans[2].from - kSpans[1].to + 1);
+  /* 长停顿 3s：压到 keep + hold 左右 */
+  a = b = -1;
+  for (long i = 0; i < n; i++) {
+    long long o = sc_map(sc, i);
+    if (o == kSpans[0].to - 1) a = i;
+    if (o == kSpans[1].from) b = i;
+  }
+  double gapMs = (b - a) * 1000.0 / RATE;
+  printf("  3s 停顿压成 %.0fms\n", gapMs);
+  expect_true("3s 长停顿压到 300~600ms", a >= 0 && b >= 0 && gapMs >= KEEP_MS && gapMs <= 600);
+  /* 开头 0.5s 短于阈值：保留 */
+  expect_true("开头 0.5s 保留", sc_map(sc, kSpans[0].from) == kSpans[0].from);
+
+  printf("== 4. 分块方式不影响结果 ==\n");
+  int sameAll = 1;
+  const int chunks[] = {1, 7, 160, 1000, 4096};
+  for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    sc_reset(sc);
+    long n2 = run(sc, in, TOTAL, chunks[c], out2, &overBound);
+    int same = n2 == n && memcmp(out, out2, sizeof(int16_t) * (size_t)n) == 0 && !overBound;
+    if (!same) printf("  块大小 %d 不一致（%ld vs %ld）\n", chunks[c], n2, n);
+    sameAll &= same;
+  }
+  expect_true("块大小 1 / 7 / 160 / 1000 / 4096 输出逐样本相同", sameAll);
+
+  printf("== 5. 半帧冲刷 ==\n");
+  sc_reset(sc);
+  long odd = kSpans[1].to + 1234; /* 停在短停顿中间，不是整帧 */
+  long n3 = run(sc, in, odd, CHUNK, out2, &overBound);
+  expect_true("结尾没到阈值的停顿（含半帧）原样交出：最后一个样本就是原始的最后一个",
+              n3 > 0 && sc_map(sc, n3 - 1) == odd - 1 && out2[n3 - 1] == in[odd - 1]);
+  expect_true("统计把半帧算进去", sc_stat(sc, SC_STAT_INPUT) == odd && sc_stat(sc, SC_STAT_OUTPUT) == n3);
+
+  printf("== 6. 全静音录音 ==\n");
+  sc_reset(sc);
+  static int16_t zeros[RATE * 5];
+  long n4 = run(sc, zeros, RATE * 5, CHUNK, out2, &overBound);
+  printf("  5s 数字静音 → %ldms\n", n4 * 1000 / RATE);
+  expect_true("只留开头一半间隔", n4 <= KEEP_MS * RATE / 1000);
+
+  printf("== 7. 参数夹取 ==\n");
+  SilenceCompactor* odd2 = sc_create(500, 5000);
+  long n5 = run(odd2, zeros, RATE * 5, CHUNK, out2, &overBound);
+  expect_true("keep 大于阈值时被夹到阈值以内，仍然在压", n5 < RATE / 2 && !overBound);
+  sc_free(odd2);
+
+  sc_free(sc);
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int run_bench(long seconds) {
+  static int16_t in[TOTAL], out[TOTAL + RATE * 2];
+  static unsigned char voiced[TOTAL];
+  make_recording(in, voiced);
+  SilenceCompactor* sc = sc_create(MIN_SILENCE_MS, KEEP_MS);
+  int overBound = 0;
+  long rounds = seconds * RATE / TOTAL + 1;
+  long kept = 0;
+  double t0 = now_ms();
+  for (long r = 0; r < rounds; r++) {
+    sc_reset(sc);
+    kept += run(sc, in, TOTAL, CHUNK, out, &overBound);
+  }
+  double ms = now_ms() - t0;
+  double audioSec = (double)rounds * TOTAL / RATE;
+  printf("音频 %.0f 秒（16kHz，%d 样本一块，dsp=%s）\n", audioSec, CHUNK, dsp_kernels()->name);
+  printf("  %.3f ms CPU / 秒音频，压缩后剩 %.0f%%\n", ms / audioSec, kept * 100.0 / (rounds * (double)TOTAL));
+  sc_free(sc);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return run_bench(argc > 2 ? atol(argv[2]) : 600);
+  }
+  return run_tests();
+}
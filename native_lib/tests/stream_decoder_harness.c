@@ -0,0 +1,361 @@
+// native 流式解码线程的可执行测试宿主：从 ring 取数、字幕回调、松键收尾、取消。
+// sherpa-onnx 换成假识别器：每攒够 100ms 样本 decode 一次，结果文字就是已解码的
+// 样本数 —— 少喂、多喂、漏掉最后一块都能从数字上看出来。PulseAudio 同样是桩，
+// 样本由测试直接写进 ring（就是采集线程做的事）。
+//
+// 编译: cc -o stream_decoder_harness native_lib/tests/stream_decoder_harness.c -lpthread -lm -ldl
+
+#define _GNU_SOURCE
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static pa_simple* test_pa_simple_new(const char* server, const char* name,
+                                     pa_stream_direction_t dir, const char* dev,
+                                     const char* stream, const pa_sample_spec* ss,
+                                     const pa_channel_map* map,
+                                     const pa_buffer_attr* attr, int* error) {
+  (void)server; (void)name; (void)dir; (void)dev; (void)stream;
+  (void)ss; (void)map; (void)attr;
+  if (error) *error = 1;
+  return NULL;
+}
+
+static int test_pa_simple_read(pa_simple* s, void* data, size_t bytes, int* error) {
+  (void)s; (void)data; (void)bytes; (void)error;
+  return -1;
+}
+
+static void test_pa_simple_free(pa_simple* s) { (void)s; }
+
+#define pa_simple_new test_pa_simple_new
+#define pa_simple_read test_pa_simple_read
+#define pa_simple_free test_pa_simple_free
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/noise_suppress.c"
+#include "../dsp/agc.c"
+#include "../dsp/resampler.c"
+#include "../dsp/audio_ring.c"
+#include "../dsp/silence_compact.c"
+#include "../linux/flac_encoder.c"
+#include "../linux/native_input.c"
+
+// ---- 假识别器 ----
+#define FAKE_FRAME 1600
+
+typedef struct {
+  long pending;    /* 收了还没解的样本 */
+  long decoded;    /* 已解码的样本 */
+  long accepted;   /* 累计收到的样本 */
+  long zeros;      /* 其中值为 0 的（收尾补的静音） */
+  int finished;    /* input_finished 调用次数 */
+  int badRate;
+  char text[32];
+  int resultsLive; /* get_result 出去还没 destroy 的 */
+} FakeStream;
+
+static int g_recognizerTag;
+static atomic_int g_decodeDelayUs = 0;
+
+static void fake_accept(const void* stream, int32_t rate, const float* samples, int32_t n) {
+  FakeStream* s = (FakeStream*)stream;
+  if (rate != 16000) s->badRate = 1;
+  for (int i = 0; i < n; i++) {
+    if (samples[i] == 0.0f) s->zeros++;
+  }
+  s->pending += n;
+  s->accepted += n;
+}
+
+static int32_t fake_is_ready(const void* recognizer, const void* stream) {
+  const FakeStream* s = (const FakeStream*)stream;
+  if (recognizer != &g_recognizerTag) return 0;
+  return s->pending >= FAKE_FRAME || (s->finished && s->pending > 0);
+}
+
+static void fake_decode(const void* recognizer, const void* stream) {
+  (void)recognizer;
+  FakeStream* s = (FakeStream*)stream;
+  long n = s->pending < FAKE_FRAME ? s->pending : FAKE_FRAME;
+  s->pending -= n;
+  s->decoded += n;
+  int delay = atomic_load(&g_decodeDelayUs);
+  if (delay > 0) usleep((useconds_t)delay);
+}
+
+static const SherpaResultHead* fake_get_result(const void* recognizer, const void* stream) {
+  (void)recognizer;
+  FakeStream* s = (FakeStream*)stream;
+  SherpaResultHead* r = malloc(sizeof(SherpaResultHead));
+  if (s->decoded > 0) {
+    snprintf(s->text, sizeof(s->text), "%ld", s->decoded);
+  } else {
+    s->text[0] = 0;
+  }
+  r->text = s->text;
+  s->resultsLive++;
+  return r;
+}
+
+static FakeStream* g_lastResultStream;
+
+static void fake_destroy_result(const SherpaResultHead* r) {
+  if (g_lastResultStream) g_lastResultStream->resultsLive--;
+  free((void*)r);
+}
+
+static void fake_input_finished(const void* stream) { ((FakeStream*)stream)->finished++; }
+
+static void install_fake_sherpa(void) {
+  g_sherpa.accept_waveform = fake_accept;
+  g_sherpa.is_ready = fake_is_ready;
+  g_sherpa.get_result = fake_get_result;
+  g_sherpa.destroy_result = fake_destroy_result;
+  g_sherpa.input_finished = fake_input_finished;
+  g_sherpa.decode = fake_decode;
+}
+
+// ---- 回调收集 ----
+#define MAX_POSTS 256
+
+static pthread_mutex_t g_postLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_postCond = PTHREAD_COND_INITIALIZER;
+static long g_posts[MAX_POSTS];
+static int g_postCount = 0;
+static int g_finalCount = 0;
+static long g_finalValue = -1;
+static int g_postedOnMain = 0;
+static pthread_t g_mainThread;
+
+static void on_text(const char* text, int isFinal) {
+  pthread_mutex_lock(&g_postLock);
+  if (pthread_equal(pthread_self(), g_mainThread)) g_postedOnMain = 1;
+  long v = text[0] ? atol(text) : 0;
+  if (isFinal) {
+    g_finalCount++;
+    g_finalValue = v;
+  } else if (g_postCount < MAX_POSTS) {
+    g_posts[g_postCount++] = v;
+  }
+  pthread_cond_broadcast(&g_postCond);
+  pthread_mutex_unlock(&g_postLock);
+  native_free((void*)text); /* Dart 侧同样是读完就还 */
+}
+
+static void reset_posts(void) {
+  pthread_mutex_lock(&g_postLock);
+  g_postCount = 0;
+  g_finalCount = 0;
+  g_finalValue = -1;
+  pthread_mutex_unlock(&g_postLock);
+}
+
+/* 等到回调满足条件（partials >= n，或出现 final），最多 ms；返回是否等到 */
+static int wait_posts(int partials, int wantFinal, int ms) {
+  struct timespec deadline = deadline_after_ms(ms);
+  pthread_mutex_lock(&g_postLock);
+  while (!(wantFinal ? g_finalCount > 0 : g_postCount >= partials)) {
+    if (pthread_cond_timedwait(&g_postCond, &g_postLock, &deadline) == ETIMEDOUT) break;
+  }
+  int ok = wantFinal ? g_finalCount > 0 : g_postCount >= partials;
+  pthread_mutex_unlock(&g_postLock);
+  return ok;
+}
+
+static void write_chunks(int chunks, int sleepMs) {
+  int16_t buf[AUDIO_CHUNK_SAMPLES];
+  for (int i = 0; i < AUDIO_CHUNK_SAMPLES; i++) buf[i] = 1000;
+  for (int c = 0; c < chunks; c++) {
+    ring_write(buf, AUDIO_CHUNK_SAMPLES);
+    if (sleepMs > 0) usleep((useconds_t)sleepMs * 1000);
+  }
+}
+
+static double now_ms(void) { return monotonic_us() / 1000.0; }
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+int main(void) {
+  g_mainThread = pthread_self();
+  FakeStream stream;
+
+  printf("== 1. sherpa 库没被加载：拒绝启动，调用方退回 Dart 解码 ==\n");
+  memset(&stream, 0, sizeof(stream));
+  expect_true("返回 NULL",
+              stream_decoder_start(&g_recognizerTag, &stream, "libspeakout-no-such-sherpa.so",
+                                   on_text, 800) == NULL);
+  expect_true("没有占住解码位", atomic_load(&g_decoderActive) == 0);
+  install_fake_sherpa();
+  expect_true("参数不全返回 NULL",
+              stream_decoder_start(&g_recognizerTag, NULL, "", on_text, 800) == NULL);
+
+  printf("== 2. 边录边解：字幕从解码线程回调，只在变了时发 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  g_lastResultStream = &stream;
+  void* d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 800);
+  expect_true("启动成功", d != NULL);
+  expect_true("同时只能有一个",
+              stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 800) == NULL);
+  write_chunks(50, 2); /* 1 秒音频 */
+  expect_true("收到中间结果", wait_posts(5, 0, 1000));
+  pthread_mutex_lock(&g_postLock);
+  int increasing = 1;
+  for (int i = 1; i < g_postCount; i++) {
+    if (g_posts[i] <= g_posts[i - 1]) increasing = 0;
+  }
+  int partials = g_postCount;
+  pthread_mutex_unlock(&g_postLock);
+  expect_true("中间结果递增、没有重复", increasing);
+  expect_true("不在调用方线程上回调", !g_postedOnMain);
+
+  printf("== 3. 松键：读完 ring 里剩下的、补静音、final 恰好一条 ==\n");
+  write_chunks(3, 0); /* 松键前最后 60ms，紧接着就 finish */
+  stream_decoder_finish(d);
+  expect_true("final 到了", wait_posts(0, 1, 2000));
+  expect_true("destroy 报告正常收尾", stream_decoder_destroy(d, 0) == 1);
+  expect_true("final 恰好一条", g_finalCount == 1);
+  expect_true("final 包含全部 53 块 + 800ms 静音",
+              g_finalValue == 53 * AUDIO_CHUNK_SAMPLES + 12800);
+  expect_true("静音正好 800ms", stream.zeros == 12800);
+  expect_true("inputFinished 一次", stream.finished == 1);
+  expect_true("采样率 16k", !stream.badRate);
+  expect_true("result 都释放了", stream.resultsLive == 0);
+  expect_true("解码位已释放", atomic_load(&g_decoderActive) == 0);
+  printf("    (%d 条中间结果)\n", partials);
+
+  printf("== 4. 统计：取走的样本数、第一条字幕时刻、越界 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 0);
+  long long before = monotonic_us();
+  write_chunks(10, 0);
+  wait_posts(1, 0, 1000);
+  stream_decoder_finish(d);
+  wait_posts(0, 1, 1000);
+  expect_true("SAMPLES = 写进 ring 的", stream_decoder_stat(d, DECODER_STAT_SAMPLES) == 3200);
+  expect_true("PARTIALS ≥ 1", stream_decoder_stat(d, DECODER_STAT_PARTIALS) >= 1);
+  expect_true("FIRST_PARTIAL 在写入之后",
+              stream_decoder_stat(d, DECODER_STAT_FIRST_PARTIAL) >= before);
+  expect_true("越界返回 -1", stream_decoder_stat(d, DECODER_STAT_COUNT) == -1);
+  expect_true("paddingMs=0 不补静音", stream.zeros == 0 && g_finalValue == 3200);
+  stream_decoder_destroy(d, 0);
+
+  printf("== 5. ring 空时阻塞等待，来数据立刻醒（不等 50ms 轮询） ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 0);
+  usleep(120 * 1000); /* 让它进入等待 */
+  double worst = 0;
+  for (int i = 0; i < 10; i++) {
+    double t0 = now_ms();
+    write_chunks(FAKE_FRAME / AUDIO_CHUNK_SAMPLES, 0);
+    wait_posts(i + 1, 0, 500);
+    double spent = now_ms() - t0;
+    if (spent > worst) worst = spent;
+    usleep(60 * 1000);
+  }
+  printf("    (写满一帧到字幕回调，最慢 %.2fms)\n", worst);
+  expect_true("10 帧各出一条字幕", g_postCount == 10);
+  expect_true("最慢一次 < 20ms", worst < 20);
+  stream_decoder_destroy(d, 0);
+
+  printf("== 6. 取消：不收尾、不回调 final，慢 decode 也能等到线程退出 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  atomic_store(&g_decodeDelayUs, 5000);
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 800);
+  write_chunks(100, 0);
+  usleep(20 * 1000);
+  expect_true("destroy(abort) 报告没收尾", stream_decoder_destroy(d, 1) == 0);
+  expect_true("没有 final", g_finalCount == 0);
+  expect_true("没有 inputFinished、没补静音", stream.finished == 0 && stream.zeros == 0);
+  expect_true("解码位已释放", atomic_load(&g_decoderActive) == 0);
+  atomic_store(&g_decodeDelayUs, 0);
+
+  printf("== 6b. 收尾超时：abort 立即返回，线程解完手上这次 decode 就退出 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  atomic_store(&g_decodeDelayUs, 20000);
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 800);
+  write_chunks(3, 0);
+  usleep(30 * 1000); /* 60ms 不够一帧，读走了还没解 */
+  stream_decoder_finish(d);
+  usleep(30 * 1000); /* 收尾：860ms 凑成 9 帧，每帧 20ms，这时正在最后一轮 decode 里 */
+  double abortAt = now_ms();
+  stream_decoder_abort(d);
+  double abortCall = now_ms() - abortAt;
+  while (!stream_decoder_stat(d, DECODER_STAT_EXITED) && now_ms() - abortAt < 2000) usleep(1000);
+  double exitedAfter = now_ms() - abortAt;
+  printf("    (abort 调用 %.2fms，线程 %.2fms 后退出)\n", abortCall, exitedAfter);
+  expect_true("abort 不等线程", abortCall < 5);
+  expect_true("线程很快退出，没有解完整段", exitedAfter < 100);
+  double joinAt = now_ms();
+  expect_true("destroy 报告没收尾", stream_decoder_destroy(d, 1) == 0);
+  expect_true("退出后 destroy 立即返回", now_ms() - joinAt < 5);
+  expect_true("没有 final", g_finalCount == 0);
+  expect_true("解码位已释放", atomic_load(&g_decoderActive) == 0);
+  atomic_store(&g_decodeDelayUs, 0);
+
+  printf("== 7. 解码慢于实时：ring 攒着，松键后照样解完 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  atomic_store(&g_decodeDelayUs, 3000);
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 0);
+  write_chunks(100, 0); /* 一下子来 2 秒 */
+  stream_decoder_finish(d);
+  expect_true("final 到了", wait_posts(0, 1, 3000));
+  expect_true("一个样本都没少", g_finalValue == 100 * AUDIO_CHUNK_SAMPLES);
+  expect_true("MAX_LAG 记到了", stream_decoder_stat(d, DECODER_STAT_MAX_LAG_US) > 0);
+  stream_decoder_destroy(d, 0);
+  atomic_store(&g_decodeDelayUs, 0);
+
+  printf("== 8. 解码线程和 read_audio_buffer 同时读：各读各的，谁也不少 ==\n");
+  ring_init();
+  reset_posts();
+  memset(&stream, 0, sizeof(stream));
+  write_chunks(5, 0); /* 解码器开起来之前的 100ms 也要解到 */
+  d = stream_decoder_start(&g_recognizerTag, &stream, "", on_text, 0);
+  static int16_t polled[40 * AUDIO_CHUNK_SAMPLES];
+  int polledCount = 0;
+  for (int c = 0; c < 35; c++) {
+    write_chunks(1, 1);
+    polledCount += read_audio_buffer(polled + polledCount, 40 * AUDIO_CHUNK_SAMPLES - polledCount);
+  }
+  polledCount += read_audio_buffer(polled + polledCount, 40 * AUDIO_CHUNK_SAMPLES - polledCount);
+  stream_decoder_finish(d);
+  expect_true("final 到了", wait_posts(0, 1, 2000));
+  expect_true("解码器拿到全部 40 块", g_finalValue == 40 * AUDIO_CHUNK_SAMPLES);
+  expect_true("轮询那边也是全部 40 块", polledCount == 40 * AUDIO_CHUNK_SAMPLES);
+  expect_true("没有被追上", stream_decoder_stat(d, DECODER_STAT_OVERRUN) == 0);
+  stream_decoder_destroy(d, 0);
+
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
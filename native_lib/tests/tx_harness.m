@@ -22,6 +22,7 @@
 
 #define CGEventPost(tap, event) ((void)0)   // 绝不真的发键
 #include "../native_input.m"
+#include "../dsp/audio_ring.c"
 
 #import <objc/runtime.h>
 
@@ -0,0 +1,416 @@
+// Linux 采集的可执行测试宿主：常驻（warm mic + pre-roll）、停止时的 drain 与延迟追踪的时刻。
+// PulseAudio 全部在测试文件里替换，不会打开真实麦克风：假设备每次 read
+// 给出 20ms 递增序号的样本，并且只在测试放行时才返回，线程走到哪一步完全可控。
+//
+// 编译: cc -o warm_capture_harness native_lib/tests/warm_capture_harness.c -lpthread
+
+#define _GNU_SOURCE
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static pthread_mutex_t g_fakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_fakeCond = PTHREAD_COND_INITIALIZER;
+static long g_allowed = 0;        /* 放行的块数 */
+static long g_returned = 0;       /* 已经返回的块数 */
+static long g_nextSample = 0;     /* 下一个样本的序号 */
+static atomic_int g_opens = 0;
+static atomic_int g_frees = 0;
+static atomic_int g_waiting = 0;  /* 有线程阻塞在 read 里 */
+static int g_openFail = 0;
+static int g_openRate = 0;        /* 最近一次打开要的格式 */
+static int g_openChannels = 0;
+
+static pa_simple* test_pa_simple_new(const char* server, const char* name,
+                                     pa_stream_direction_t dir, const char* dev,
+                                     const char* stream, const pa_sample_spec* ss,
+                                     const pa_channel_map* map,
+                                     const pa_buffer_attr* attr, int* error) {
+  (void)server; (void)name; (void)dir; (void)dev; (void)stream;
+  (void)map; (void)attr;
+  g_openRate = (int)ss->rate;
+  g_openChannels = ss->channels;
+  if (g_openFail) {
+    if (error) *error = 1;
+    return NULL;
+  }
+  atomic_fetch_add(&g_opens, 1);
+  return (pa_simple*)(uintptr_t)0x1;
+}
+
+static int test_pa_simple_read(pa_simple* s, void* data, size_t bytes, int* error) {
+  (void)s; (void)error;
+  pthread_mutex_lock(&g_fakeLock);
+  atomic_store(&g_waiting, 1);
+  while (g_returned >= g_allowed) pthread_cond_wait(&g_fakeCond, &g_fakeLock);
+  atomic_store(&g_waiting, 0);
+  int16_t* out = data;
+  for (size_t i = 0; i < bytes / 2; i++) out[i] = (int16_t)(g_nextSample++ & 0x7FFF);
+  g_returned++;
+  pthread_mutex_unlock(&g_fakeLock);
+  return 0;
+}
+
+static void test_pa_simple_free(pa_simple* s) {
+  (void)s;
+  atomic_fetch_add(&g_frees, 1);
+}
+
+#define pa_simple_new test_pa_simple_new
+#define pa_simple_read test_pa_simple_read
+#define pa_simple_free test_pa_simple_free
+#include "../dsp/dsp_kernels.c"
+#include "../dsp/noise_suppress.c"
+#include "../dsp/agc.c"
+#include "../dsp/resampler.c"
+#include "../dsp/audio_ring.c"
+#include "../dsp/silence_compact.c"
+#include "../linux/flac_encoder.c"
+#include "../linux/native_input.c"
+
+static int failures = 0;
+
+static void expect_true(const char* label, int condition) {
+  if (condition) {
+    printf("  ✓ %s\n", label);
+  } else {
+    failures++;
+    printf("  ✗ %s\n", label);
+  }
+}
+
+/* 轮询到条件成立，最多 2 秒 */
+#define WAIT_UNTIL(cond)                                      \
+  do {                                                        \
+    for (int _i = 0; _i < 2000 && !(cond); _i++) usleep(1000); \
+  } while (0)
+
+/* 放行 n 块，等采集线程把它们全部处理完、重新阻塞在下一次 read 里 */
+static void feed(int n) {
+  pthread_mutex_lock(&g_fakeLock);
+  g_allowed += n;
+  long target = g_allowed;
+  pthread_cond_broadcast(&g_fakeCond);
+  pthread_mutex_unlock(&g_fakeLock);
+  WAIT_UNTIL(g_returned == target && atomic_load(&g_waiting));
+}
+
+/* 放行 n 块，不等线程回到 read（线程可能会退出） */
+static void release(int n) {
+  pthread_mutex_lock(&g_fakeLock);
+  g_allowed += n;
+  pthread_cond_broadcast(&g_fakeCond);
+  pthread_mutex_unlock(&g_fakeLock);
+}
+
+static long sample_counter(void) {
+  pthread_mutex_lock(&g_fakeLock);
+  long n = g_nextSample;
+  pthread_mutex_unlock(&g_fakeLock);
+  return n;
+}
+
+/* ring 里的样本是否恰好是序号 [first, first+count) */
+static int ring_is_sequence(long first, int count) {
+  static int16_t buf[RING_BUFFER_SAMPLES];
+  if (get_available_audio_samples() != count) return 0;
+  int n = read_audio_buffer(buf, count);
+  if (n != count) return 0;
+  for (int i = 0; i < n; i++) {
+    if (buf[i] != (int16_t)((first + i) & 0x7FFF)) return 0;
+  }
+  return 1;
+}
+
+/* stop_audio_recording_and_drain 会等在途的那一块，放到另一个线程里调 */
+static long long g_drainEnd = -1;
+static int g_drainTimeoutMs = 0;
+static void* drain_thread(void* arg) {
+  (void)arg;
+  g_drainEnd = stop_audio_recording_and_drain(g_drainTimeoutMs);
+  return NULL;
+}
+
+static pthread_t start_drain(int timeoutMs) {
+  pthread_t t;
+  g_drainEnd = -1;
+  g_drainTimeoutMs = timeoutMs;
+  pthread_create(&t, NULL, drain_thread, NULL);
+  usleep(5000); /* 让它先走到等待 */
+  return t;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(void) {
+  /* 不去探本机 PulseAudio 的原生格式：前面的步骤都按 16k 单声道数样本 */
+  setenv("SPEAKOUT_CAPTURE_RATE", "16000", 1);
+
+  printf("== 1. 挂上常驻：不录音时只进 pre-roll ==\n");
+  expect_true("audio_warm_start 成功", audio_warm_start(500, 0) == 1);
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(40); /* 800ms */
+  expect_true("设备只打开一次", atomic_load(&g_opens) == 1);
+  expect_true("is_audio_warm", is_audio_warm() == 1);
+  expect_true("ring 是空的", get_available_audio_samples() == 0);
+  expect_true("不算在录音", is_audio_recording() == 0);
+
+  printf("== 2. 按键：pre-roll 按时间顺序拼进 ring，之后无缝续上 ==\n");
+  long end = sample_counter();
+  expect_true("start_audio_recording 成功", start_audio_recording() == 1);
+  expect_true("没有再开设备", atomic_load(&g_opens) == 1);
+  expect_true("ring 开头是按键前最后 500ms", ring_is_sequence(end - 8000, 8000));
+  feed(5);
+  expect_true("之后 100ms 紧接着续上", ring_is_sequence(end, 1600));
+
+  printf("== 3. 松键：不等线程、不关设备，之后的声音不进 ring ==\n");
+  double t0 = now_ms();
+  stop_audio_recording();
+  expect_true("stop 立即返回（< 50ms）", now_ms() - t0 < 50);
+  long afterStop = sample_counter();
+  feed(10);
+  expect_true("ring 不再增长", get_available_audio_samples() == 0);
+  expect_true("设备仍开着", atomic_load(&g_frees) == 0 && is_audio_warm() == 1);
+
+  printf("== 4. 下一次按键只带上一次松键之后的 pre-roll ==\n");
+  start_audio_recording();
+  expect_true("pre-roll 不夹带上一次会话", ring_is_sequence(afterStop, 3200));
+  stop_audio_recording();
+
+  printf("== 5. 录音中途 audio_warm_stop：这次录完，松键后释放 ==\n");
+  feed(2);
+  long mid = sample_counter();
+  start_audio_recording();
+  read_audio_buffer((int16_t[640]){0}, 640); /* 丢掉 pre-roll */
+  audio_warm_stop();
+  feed(3);
+  expect_true("释放请求后仍在录", ring_is_sequence(mid, 960));
+  expect_true("设备还没关", atomic_load(&g_frees) == 0);
+  stop_audio_recording();
+  release(1);
+  WAIT_UNTIL(atomic_load(&g_frees) == 1);
+  expect_true("松键后设备关闭", atomic_load(&g_frees) == 1);
+  expect_true("is_audio_warm 归零", is_audio_warm() == 0);
+
+  printf("== 6. 闲置超时自己释放；之后按键走冷启动 ==\n");
+  audio_warm_start(500, 200); /* 200ms = 10 块 */
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  expect_true("重新打开设备", atomic_load(&g_opens) == 2);
+  feed(9);
+  expect_true("9 块时还挂着", is_audio_warm() == 1);
+  release(1);
+  WAIT_UNTIL(atomic_load(&g_frees) == 2);
+  expect_true("第 10 块后释放", atomic_load(&g_frees) == 2 && is_audio_warm() == 0);
+  long cold = sample_counter();
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  expect_true("冷启动另开设备", atomic_load(&g_opens) == 3);
+  feed(2);
+  expect_true("冷启动没有 pre-roll", ring_is_sequence(cold, 640));
+  expect_true("冷启动录音中不能挂常驻", audio_warm_start(500, 0) == 0);
+  stop_audio_recording();
+  release(1);
+  WAIT_UNTIL(atomic_load(&g_frees) == 3);
+
+  printf("== 7. 设备打不开：退回未挂状态 ==\n");
+  g_openFail = 1;
+  audio_warm_start(500, 0);
+  WAIT_UNTIL(is_audio_warm() == 0);
+  expect_true("is_audio_warm 为 0", is_audio_warm() == 0);
+  g_openFail = 0;
+
+  printf("== 8. 冷启动 drain：在途的最后一块收进 ring，join 线程，报结束位置 ==\n");
+  int frees = atomic_load(&g_frees);
+  long coldStart = sample_counter();
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(2);
+  pthread_t t = start_drain(1000);
+  expect_true("drain 在等在途的一块", g_drainEnd == -1);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = 3 块", g_drainEnd == 960);
+  expect_true("ring 里正好是这 3 块", ring_is_sequence(coldStart, 960));
+  expect_true("采集线程已退出", atomic_load(&g_frees) == frees + 1);
+  expect_true("不再录音", is_audio_recording() == 0);
+
+  printf("== 9. 常驻 drain：收完在途的一块就返回，设备不关 ==\n");
+  audio_warm_start(500, 0);
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(5);
+  long warmStart = sample_counter() - 1600;
+  start_audio_recording();
+  feed(4);
+  t = start_drain(1000);
+  expect_true("drain 在等在途的一块", g_drainEnd == -1);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = pre-roll 5 块 + 录音 5 块", g_drainEnd == 3200);
+  expect_true("ring 里正好是这 10 块", ring_is_sequence(warmStart, 3200));
+  expect_true("不再录音", is_audio_recording() == 0);
+  feed(3);
+  expect_true("之后的声音回到 pre-roll", get_available_audio_samples() == 0);
+  expect_true("设备仍开着", is_audio_warm() == 1);
+
+  printf("== 10. 常驻 drain 超时：按已收到的算 ==\n");
+  start_audio_recording();
+  read_audio_buffer((int16_t[960]){0}, 960); /* 丢掉 pre-roll */
+  feed(2);
+  double t1 = now_ms();
+  long long drained = stop_audio_recording_and_drain(30);
+  expect_true("超时后返回（< 500ms）", now_ms() - t1 < 500);
+  expect_true("结束位置 = pre-roll 3 块 + 录音 2 块", drained == 1600);
+  expect_true("不再录音", is_audio_recording() == 0);
+  feed(1);
+  expect_true("迟到的一块不进 ring", get_available_audio_samples() == 640);
+  audio_warm_stop();
+  release(1);
+  WAIT_UNTIL(is_audio_warm() == 0 && atomic_load(&g_frees) == frees + 2);
+
+  printf("== 11. trace 时刻：冷启动依次是 开始 → 设备可读 → 第一块 ==\n");
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  long long started = native_trace_stamp_us(2);
+  long long opened = native_trace_stamp_us(3);
+  expect_true("开始时刻已记", started > 0);
+  expect_true("设备可读不早于开始", opened >= started);
+  expect_true("还没有第一块", native_trace_stamp_us(4) == -1);
+  feed(1);
+  long long firstChunk = native_trace_stamp_us(4);
+  expect_true("第一块不早于设备可读", firstChunk >= opened);
+  expect_true("TRACE_NOW 不早于第一块", native_trace_stamp_us(0) >= firstChunk);
+  feed(1);
+  expect_true("第二块不改第一块时刻", native_trace_stamp_us(4) == firstChunk);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("越界返回 -1", native_trace_stamp_us(99) == -1);
+
+  printf("== 12. trace 时刻：常驻模式下设备可读就是开始录音那一刻 ==\n");
+  audio_warm_start(500, 0);
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(2);
+  start_audio_recording();
+  expect_true("设备可读 = 开始", native_trace_stamp_us(3) == native_trace_stamp_us(2));
+  expect_true("pre-roll 不算第一块", native_trace_stamp_us(4) == -1);
+  feed(1);
+  expect_true("第一块实时音频已记", native_trace_stamp_us(4) >= native_trace_stamp_us(2));
+  stop_audio_recording();
+  audio_warm_stop();
+  release(1);
+  WAIT_UNTIL(atomic_load(&g_frees) == frees + 4);
+
+  printf("== 13. 降噪超预算：3 块之后转旁路，延迟线冲刷进 ring，统计可取 ==\n");
+  audio_noise_suppression_set(1, 1); /* 1µs：每块都超 */
+  long nsStart = sample_counter();
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(9);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = 10 块 + 延迟线 16ms", g_drainEnd == 3200 + NS_DELAY_SAMPLES);
+  static int16_t got[3200 + NS_DELAY_SAMPLES];
+  int n = read_audio_buffer(got, 3200 + NS_DELAY_SAMPLES);
+  int worst = 0;
+  for (int i = n - 1600; i < n; i++) {
+    int d = abs(got[i] - (int16_t)((nsStart + i - NS_DELAY_SAMPLES) & 0x7FFF));
+    if (d > worst) worst = d;
+  }
+  expect_true("旁路后的样本就是原样晚 16ms，尾巴也在", n == 3200 + NS_DELAY_SAMPLES && worst <= 1);
+  expect_true("转了旁路", audio_noise_suppression_stat(3) == 1);
+  expect_true("超预算的块都记了", audio_noise_suppression_stat(2) >= 3);
+  expect_true("处理过的样本 = 10 块", audio_noise_suppression_stat(1) == 3200);
+  expect_true("CPU 时间有记", audio_noise_suppression_stat(0) > 0 && audio_noise_suppression_stat(4) > 0);
+  expect_true("越界返回 -1", audio_noise_suppression_stat(99) == -1);
+
+  printf("== 14. 常驻 + 降噪不限预算：pre-roll 也过降噪，新录音清零统计 ==\n");
+  audio_noise_suppression_set(1, 0);
+  audio_warm_start(500, 0);
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(5);
+  start_audio_recording();
+  expect_true("开录清零统计", audio_noise_suppression_stat(1) == 0 && audio_noise_suppression_stat(3) == 0);
+  feed(4);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = pre-roll 5 块 + 录音 5 块 + 延迟线",
+              g_drainEnd == 3200 + NS_DELAY_SAMPLES);
+  expect_true("没有转旁路", audio_noise_suppression_stat(3) == 0 && audio_noise_suppression_stat(2) == 0);
+  expect_true("只计进 ring 的 5 块", audio_noise_suppression_stat(1) == 1600);
+  audio_noise_suppression_set(0, 0);
+  audio_warm_stop();
+  release(1);
+  WAIT_UNTIL(!g_warmThreadAlive);
+
+  printf("== 15. 自动增益：延迟一帧冲刷进 ring，轨迹按帧可读，电平表有值 ==\n");
+  audio_agc_set(1, -20, 30);
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(9);
+  expect_true("录音中电平表有值", get_audio_level() > 0.0f);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = 10 块 + 一帧", g_drainEnd == 3200 + AGC_FRAME_SAMPLES);
+  static float agcTrace[64 * 4];
+  int frames = audio_agc_trace(agcTrace, 64);
+  /* 假设备给的是逐样本 +1 的斜坡：帧电平一路往上 */
+  expect_true("每 10ms 一个轨迹点，共 20 个", frames == 20);
+  expect_true("轨迹里的电平跟着输入往上走", frames == 20 && agcTrace[19 * 4] > agcTrace[4]);
+  expect_true("只要最近 5 帧时给 5 帧", audio_agc_trace(agcTrace, 5) == 5);
+  expect_true("停止后电平表归零", get_audio_level() == 0.0f);
+
+  printf("== 16. 降噪 + 自动增益：两级延迟一起冲刷，新录音清空轨迹 ==\n");
+  audio_noise_suppression_set(1, 0);
+  start_audio_recording();
+  expect_true("开录清空轨迹", audio_agc_trace(agcTrace, 64) == 0);
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  feed(4);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("结束位置 = 5 块 + 16ms + 一帧", g_drainEnd == 1600 + NS_DELAY_SAMPLES + AGC_FRAME_SAMPLES);
+  /* 自动增益收到 5 块 + 降噪冲刷出的 16ms = 11 帧多一点，补零凑的那半帧不算 */
+  expect_true("轨迹 11 帧", audio_agc_trace(agcTrace, 64) == 11);
+  audio_noise_suppression_set(0, 0);
+  audio_agc_set(0, -20, 30);
+
+  printf("== 17. 设备原生 48k 立体声：按原生格式打开，进程内转成 16k ==\n");
+  setenv("SPEAKOUT_CAPTURE_RATE", "48000/2", 1);
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  expect_true("按 48000Hz × 2 打开", g_openRate == 48000 && g_openChannels == 2);
+  feed(4);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  /* 5 块 × 20ms，重采样器冲刷后正好 100ms 的 16k 样本 */
+  expect_true("结束位置 = 5 × 320", g_drainEnd == 1600);
+  setenv("SPEAKOUT_CAPTURE_RATE", "16000", 1);
+  start_audio_recording();
+  WAIT_UNTIL(atomic_load(&g_waiting));
+  expect_true("原生 16k 照旧单声道直开", g_openRate == 16000 && g_openChannels == 1);
+  t = start_drain(1000);
+  release(1);
+  pthread_join(t, NULL);
+  expect_true("不经重采样，一块就是 320", g_drainEnd == 320);
+
+  if (failures == 0) {
+    printf("ALL PASSED\n");
+    return 0;
+  }
+  printf("%d FAILED\n", failures);
+  return 1;
+}
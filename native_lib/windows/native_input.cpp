@@ -7,6 +7,7 @@
  *   - 文本注入: SendInput (KEYEVENTF_UNICODE)
  *   - 音频采集: WASAPI (IAudioClient + IAudioCaptureClient)
  *   - 设备管理: IMMDeviceEnumerator
+ *   - 重采样: 设备不接受 16k 单声道时按混音格式打开，进程内转（../dsp/resampler.c）
  *
  * 编译: 参见同目录 CMakeLists.txt (MSVC C++)
  */
@@ -25,6 +26,8 @@
 #include <audioclient.h>
 #include <functiondiscoverykeys_devpkey.h>
 #include <endpointvolume.h>
+#include <mmreg.h>
+#include <ksmedia.h>
 
 // COM helpers
 #include <objbase.h>
@@ -33,6 +36,10 @@
 // For _beginthreadex
 #include <process.h>
 
+#include "../dsp/audio_ring.h"
+#include "../dsp/dsp_kernels.h"
+#include "../dsp/resampler.h"
+
 extern "C" {
 
 // ============================================================
@@ -55,50 +62,18 @@ typedef void (*DeviceChangeCallback)(const char* deviceId, const char* deviceNam
 // ============================================================
 #define RING_BUFFER_SAMPLES (16000 * 30)  // 30 seconds max
 
+// 一个写者（采集线程）、多个读者各有自己的游标（../dsp/audio_ring.h）。
+// read_audio_buffer 是 0 号默认读者；以前这里是一把 CRITICAL_SECTION 包着的
+// 单读位置 ring，写者要等读者拷完才能写。
 static int16_t g_ringBuffer[RING_BUFFER_SAMPLES];
-static volatile long g_ringWritePos = 0;
-static volatile long g_ringReadPos = 0;
-static CRITICAL_SECTION g_ringLock;
-static int g_ringLockInitialized = 0;
+static AudioRing g_ring;
 
 static void ring_init(void) {
-    if (!g_ringLockInitialized) {
-        InitializeCriticalSection(&g_ringLock);
-        g_ringLockInitialized = 1;
-    }
-    g_ringWritePos = 0;
-    g_ringReadPos = 0;
+    audio_ring_reset(&g_ring);
 }
 
 static void ring_write(const int16_t* samples, int count) {
-    EnterCriticalSection(&g_ringLock);
-    for (int i = 0; i < count; i++) {
-        g_ringBuffer[g_ringWritePos % RING_BUFFER_SAMPLES] = samples[i];
-        g_ringWritePos++;
-    }
-    // If writer overtakes reader, advance reader
-    if (g_ringWritePos - g_ringReadPos > RING_BUFFER_SAMPLES) {
-        g_ringReadPos = g_ringWritePos - RING_BUFFER_SAMPLES;
-    }
-    LeaveCriticalSection(&g_ringLock);
-}
-
-static int ring_read(int16_t* out, int maxSamples) {
-    EnterCriticalSection(&g_ringLock);
-    long available = (long)(g_ringWritePos - g_ringReadPos);
-    if (available < 0) available = 0;
-    int toRead = (available < maxSamples) ? (int)available : maxSamples;
-    for (int i = 0; i < toRead; i++) {
-        out[i] = g_ringBuffer[g_ringReadPos % RING_BUFFER_SAMPLES];
-        g_ringReadPos++;
-    }
-    LeaveCriticalSection(&g_ringLock);
-    return toRead;
-}
-
-static int ring_available(void) {
-    long available = (long)(g_ringWritePos - g_ringReadPos);
-    return (available < 0) ? 0 : (int)available;
+    audio_ring_write(&g_ring, samples, count);
 }
 
 // ============================================================
@@ -157,7 +132,7 @@ static unsigned __stdcall keyboard_thread_proc(void* param) {
 // ABI 版本握手，必须与 macOS 侧的 SPEAKOUT_NATIVE_ABI_VERSION 保持一致。
 // Dart 初始化时校验：旧 dylib 没有这个 symbol 就明确报错，
 // 而不是按新签名去调旧函数、读到返回寄存器里的垃圾。
-#define SPEAKOUT_NATIVE_ABI_VERSION 0x3e3abe
+#define SPEAKOUT_NATIVE_ABI_VERSION 0x160ccb
 EXPORT int native_input_abi_version(void) { return SPEAKOUT_NATIVE_ABI_VERSION; }
 
 EXPORT int start_keyboard_listener(KeyCallback callback) {
@@ -296,6 +271,44 @@ EXPORT int check_microphone_permission(void) {
 // 5. AUDIO RECORDING (WASAPI + Ring Buffer)
 // ============================================================
 
+/*
+ * 先按 16k 单声道 int16 要；不少 USB / 蓝牙设备在共享模式下只接受混音格式
+ * （通常 48k 立体声 float），Initialize 直接失败 —— 以前到这里就放弃了，录不了音。
+ * 现在退到 GetMixFormat 的格式，采集线程上用 Resampler 转成 16k 单声道再进 ring。
+ */
+static int mix_format_is_float(const WAVEFORMATEX* fmt) {
+    if (fmt->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) return 1;
+    if (fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        const WAVEFORMATEXTENSIBLE* ext = (const WAVEFORMATEXTENSIBLE*)fmt;
+        return IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) ? 1 : 0;
+    }
+    return 0;
+}
+
+static int mix_format_is_pcm16(const WAVEFORMATEX* fmt) {
+    if (fmt->wBitsPerSample != 16) return 0;
+    if (fmt->wFormatTag == WAVE_FORMAT_PCM) return 1;
+    if (fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        const WAVEFORMATEXTENSIBLE* ext = (const WAVEFORMATEXTENSIBLE*)fmt;
+        return IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_PCM) ? 1 : 0;
+    }
+    return 0;
+}
+
+/*
+ * 声道数超过 RS_MAX_CHANNELS 的混音格式（阵列麦、虚拟声卡）rs_create 不接，
+ * 整个采集就失败了。只取每帧前 RS_MAX_CHANNELS 个声道再下混，
+ * 和 Linux 向 PulseAudio 要格式时截到 RS_MAX_CHANNELS 是同一个口径。
+ */
+static void pick_first_channels(const BYTE* in, BYTE* out, UINT32 frames,
+                                int inChannels, int outChannels, int bytesPerSample) {
+    size_t inStride = (size_t)inChannels * bytesPerSample;
+    size_t outStride = (size_t)outChannels * bytesPerSample;
+    for (UINT32 f = 0; f < frames; f++) {
+        memcpy(out + f * outStride, in + f * inStride, outStride);
+    }
+}
+
 static unsigned __stdcall audio_capture_thread(void* param) {
     (void)param;
 
@@ -310,6 +323,14 @@ static unsigned __stdcall audio_capture_thread(void* param) {
     IMMDevice* device = NULL;
     IAudioClient* audioClient = NULL;
     IAudioCaptureClient* captureClient = NULL;
+    WAVEFORMATEX* mix = NULL;
+    Resampler* rs = NULL;     // NULL = 设备直接给 16k 单声道
+    int mixFloat = 0;
+    int mixChannels = 0;
+    int rsChannels = 0;
+    BYTE* picked = NULL;      // 非 NULL = 混音格式声道太多，只取前 rsChannels 个
+    int16_t* converted = NULL;
+    UINT32 bufferFrames = 0;
 
     hr = CoCreateInstance(
         __uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL,
@@ -346,7 +367,46 @@ static unsigned __stdcall audio_capture_thread(void* param) {
         );
         if (FAILED(hr)) {
             fprintf(stderr, "[Audio] WASAPI Initialize failed (hr=0x%08lX), trying mix format\n", hr);
-            goto cleanup;
+            hr = audioClient->GetMixFormat(&mix);
+            if (FAILED(hr)) goto cleanup;
+            mixFloat = mix_format_is_float(mix) && mix->wBitsPerSample == 32;
+            if (!mixFloat && !mix_format_is_pcm16(mix)) {
+                fprintf(stderr, "[Audio] unsupported mix format (tag=%u, %u bits)\n",
+                        mix->wFormatTag, mix->wBitsPerSample);
+                hr = E_FAIL;
+                goto cleanup;
+            }
+            mixChannels = mix->nChannels;
+            rsChannels = mixChannels > RS_MAX_CHANNELS ? RS_MAX_CHANNELS : mixChannels;
+            rs = rs_create((int)mix->nSamplesPerSec, rsChannels, 16000);
+            if (!rs) {
+                hr = E_FAIL;
+                goto cleanup;
+            }
+            hr = audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, 0, bufferDuration, 0, mix, NULL);
+            if (FAILED(hr)) {
+                fprintf(stderr, "[Audio] WASAPI Initialize with mix format failed (hr=0x%08lX)\n", hr);
+                goto cleanup;
+            }
+            // 一个包最多一整个缓冲，按这个分配转换输出
+            hr = audioClient->GetBufferSize(&bufferFrames);
+            if (FAILED(hr)) goto cleanup;
+            converted = (int16_t*)malloc(sizeof(int16_t) * rs_max_output(rs, (int)bufferFrames));
+            if (!converted) {
+                hr = E_OUTOFMEMORY;
+                goto cleanup;
+            }
+            if (rsChannels < mixChannels) {
+                picked = (BYTE*)malloc((size_t)bufferFrames * rsChannels * (mix->wBitsPerSample / 8));
+                if (!picked) {
+                    hr = E_OUTOFMEMORY;
+                    goto cleanup;
+                }
+                fprintf(stderr, "[Audio] mix format has %d channels, using the first %d\n",
+                        mixChannels, rsChannels);
+            }
+            fprintf(stderr, "[Audio] capturing mix format %luHz x%u %s, resampling to 16k (%d taps)\n",
+                    mix->nSamplesPerSec, mix->nChannels, mixFloat ? "float" : "int16", rs_taps(rs));
         }
     }
 
@@ -373,7 +433,20 @@ static unsigned __stdcall audio_capture_thread(void* param) {
             if (FAILED(hr)) break;
 
             if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT) && data && numFrames > 0) {
-                ring_write((const int16_t*)data, (int)numFrames);
+                if (!rs) {
+                    ring_write((const int16_t*)data, (int)numFrames);
+                } else {
+                    const BYTE* frames = data;
+                    if (picked) {
+                        pick_first_channels(data, picked, numFrames, mixChannels, rsChannels,
+                                            mix->wBitsPerSample / 8);
+                        frames = picked;
+                    }
+                    int n = mixFloat
+                        ? rs_process_f32(rs, (const float*)frames, (int)numFrames, converted)
+                        : rs_process_i16(rs, (const int16_t*)frames, (int)numFrames, converted);
+                    ring_write(converted, n);
+                }
             }
 
             captureClient->ReleaseBuffer(numFrames);
@@ -384,8 +457,14 @@ static unsigned __stdcall audio_capture_thread(void* param) {
     }
 
     audioClient->Stop();
+    // 滤波器里压着的最后几毫秒
+    if (rs) ring_write(converted, rs_flush(rs, converted));
 
 cleanup:
+    rs_free(rs);
+    free(picked);
+    free(converted);
+    if (mix) CoTaskMemFree(mix);
     if (captureClient) captureClient->Release();
     if (audioClient) audioClient->Release();
     if (device) device->Release();
@@ -426,12 +505,35 @@ EXPORT int is_audio_recording(void) {
 }
 
 EXPORT int get_available_audio_samples(void) {
-    return ring_available();
+    return audio_ring_available(&g_ring, AUDIO_RING_DEFAULT_READER);
 }
 
 EXPORT int read_audio_buffer(int16_t* outSamples, int maxSamples) {
     if (!outSamples || maxSamples <= 0) return 0;
-    return ring_read(outSamples, maxSamples);
+    return audio_ring_read(&g_ring, AUDIO_RING_DEFAULT_READER, outSamples, maxSamples);
+}
+
+// 额外的读者（VAD、落盘、第二路识别……），游标各走各的，和 read_audio_buffer 互不抢样本。
+// fromOldest=1 从 ring 里还留着的最早样本开始，0 从现在开始；槽满返回 -1
+EXPORT int audio_reader_open(int fromOldest) {
+    return audio_ring_register(&g_ring, fromOldest ? AUDIO_RING_FROM_OLDEST : AUDIO_RING_FROM_NOW);
+}
+
+EXPORT void audio_reader_close(int reader) {
+    audio_ring_unregister(&g_ring, reader);
+}
+
+EXPORT int audio_reader_available(int reader) {
+    return audio_ring_available(&g_ring, reader);
+}
+
+EXPORT int audio_reader_read(int reader, int16_t* outSamples, int maxSamples) {
+    return audio_ring_read(&g_ring, reader, outSamples, maxSamples);
+}
+
+// 这个读者被写者追上丢掉的样本数（新录音清零）；编号无效返回 -1
+EXPORT long long audio_reader_overrun(int reader) {
+    return audio_ring_overrun(&g_ring, reader);
 }
 
 EXPORT void native_free(void* ptr) {
@@ -606,18 +708,15 @@ EXPORT void set_preferred_device_uid(const char* uid) {
 EXPORT const char* analyze_audio_quality(int16_t* samples, int sampleCount, int sampleRate) {
     if (!samples || sampleCount <= 0) return "{}";
 
-    // Simple RMS calculation
-    double sum = 0.0;
-    for (int i = 0; i < sampleCount; i++) {
-        double s = (double)samples[i] / 32768.0;
-        sum += s * s;
-    }
-    double rms = sqrt(sum / sampleCount);
+    DspStats stats;
+    dsp_kernels()->stats_i16(samples, sampleCount, &stats);
+    double rms = dsp_stats_rms(&stats, sampleCount);
     double dbfs = 20.0 * log10(rms + 1e-10);
 
     snprintf(g_jsonBuffer, sizeof(g_jsonBuffer),
-        "{\"rms\":%.6f,\"dbfs\":%.1f,\"sampleRate\":%d,\"sampleCount\":%d}",
-        rms, dbfs, sampleRate, sampleCount
+        "{\"rms\":%.6f,\"dbfs\":%.1f,\"peak\":%.6f,\"clipped\":%d,"
+        "\"sampleRate\":%d,\"sampleCount\":%d}",
+        rms, dbfs, stats.peak / 32768.0, stats.clipped, sampleRate, sampleCount
     );
     return g_jsonBuffer;
 }
@@ -636,7 +735,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID reserved) {
 
     switch (reason) {
     case DLL_PROCESS_ATTACH:
-        ring_init();
+        audio_ring_init(&g_ring, g_ringBuffer, RING_BUFFER_SAMPLES);
         break;
     case DLL_PROCESS_DETACH:
         stop_keyboard_listener();
@@ -645,10 +744,6 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID reserved) {
             g_deviceEnumerator->Release();
             g_deviceEnumerator = NULL;
         }
-        if (g_ringLockInitialized) {
-            DeleteCriticalSection(&g_ringLock);
-            g_ringLockInitialized = 0;
-        }
         break;
     }
     return TRUE;
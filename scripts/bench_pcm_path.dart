@@ -0,0 +1,79 @@
+// ignore_for_file: avoid_print, dangling_library_doc_comments
+
+/// 云端 ASR 音频路径基准：Float32 往返 vs int16 直通（acceptPcm16）
+///
+/// 模拟 CoreEngine 每 50ms 从 ring buffer 取一块 int16 交给云端 provider，
+/// 报告每秒语音的缓冲分配次数 / 字节数，以及处理耗时。
+/// 「之前」照抄原实现：Core 拷出 → ByteData 逐样本转 Float32 → provider 再逐样本转回 int16。
+/// 「之后」：Core 拷出 → 原样交给 provider。
+/// 运行: dart run scripts/bench_pcm_path.dart [语音秒数]
+
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:speakout/config/app_constants.dart';
+
+int _allocs = 0;
+int _allocBytes = 0;
+
+T _count<T extends TypedData>(T buf) {
+  _allocs++;
+  _allocBytes += buf.lengthInBytes;
+  return buf;
+}
+
+/// 原 CoreEngine._processAudioData + 原 provider._float32ToInt16Bytes
+Uint8List _before(Uint8List native) {
+  final data = _count(Uint8List.fromList(native));
+  final sampleCount = data.length ~/ 2;
+  final floatSamples = _count(Float32List(sampleCount));
+  final byteData = ByteData.sublistView(data);
+  for (var i = 0; i < sampleCount; i++) {
+    floatSamples[i] = byteData.getInt16(i * 2, Endian.little) / 32768.0;
+  }
+  final bytes = _count(ByteData(floatSamples.length * 2));
+  for (var i = 0; i < floatSamples.length; i++) {
+    final s = floatSamples[i].clamp(-1.0, 1.0);
+    bytes.setInt16(i * 2, (s * 32767).toInt(), Endian.little);
+  }
+  return bytes.buffer.asUint8List();
+}
+
+/// 现 CoreEngine._processAudioData → provider.acceptPcm16
+Uint8List _after(Uint8List native) => _count(Uint8List.fromList(native));
+
+void main(List<String> args) {
+  final seconds = args.isNotEmpty ? int.parse(args[0]) : 600;
+  const chunkSamples = AppConstants.kSampleRate * AppConstants.kAudioPollIntervalMs ~/ 1000;
+  final chunks = seconds * 1000 ~/ AppConstants.kAudioPollIntervalMs;
+
+  final rnd = Random(7);
+  final native = Int16List(chunkSamples);
+  for (var i = 0; i < chunkSamples; i++) {
+    native[i] = rnd.nextInt(65536) - 32768;
+  }
+  final nativeBytes = native.buffer.asUint8List();
+
+  void run(String label, Uint8List Function(Uint8List) path) {
+    // 预热 JIT
+    for (var i = 0; i < 200; i++) {
+      path(nativeBytes);
+    }
+    _allocs = 0;
+    _allocBytes = 0;
+    var sink = 0;
+    final sw = Stopwatch()..start();
+    for (var i = 0; i < chunks; i++) {
+      sink += path(nativeBytes)[i % (chunkSamples * 2)];
+    }
+    sw.stop();
+    print('  $label  ${(_allocs / seconds).toStringAsFixed(0)} 次分配/秒语音，'
+        '${(_allocBytes / seconds / 1024).toStringAsFixed(1)} KiB/秒，'
+        '${(sw.elapsedMicroseconds / seconds).toStringAsFixed(1)} µs/秒语音'
+        '（checksum $sink）');
+  }
+
+  print('语音 $seconds 秒，每块 $chunkSamples 样本（${AppConstants.kAudioPollIntervalMs}ms）');
+  run('之前 Float32 往返:', _before);
+  run('之后 int16 直通:  ', _after);
+}
@@ -125,8 +125,11 @@ class _ConnectVisitor extends RecursiveAstVisitor<void> {
   @override
   void visitMethodInvocation(MethodInvocation node) {
     final s = node.toSource();
+    // WsWarmPool.acquire() 每次交出一条没人用过的连接（备用的或现连的），
+    // 与直接 connect 等价
     if (s.contains('WebSocketChannel.connect') ||
-        s.startsWith('_connectWebSocket(')) {
+        s.startsWith('_connectWebSocket(') ||
+        s.endsWith('_pool!.acquire()')) {
       _check(node);
     }
     super.visitMethodInvocation(node);
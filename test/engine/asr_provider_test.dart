@@ -11,6 +11,7 @@ class MockCloudProvider implements ASRProvider {
   bool startCalled = false;
   bool stopCalled = false;
   List<Float32List> audioChunks = [];
+  List<Uint8List> pcmChunks = [];
 
   @override
   Stream<String> get textStream => _controller.stream;
@@ -39,6 +40,19 @@ class MockCloudProvider implements ASRProvider {
     _controller.add("Received ${samples.length} samples");
   }
 
+  @override
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+
+  @override
+  void acceptPcm16(Uint8List pcm) {
+    pcmChunks.add(pcm);
+    _controller.add("Received ${pcm.length ~/ 2} samples");
+  }
+
   @override
   Duration get stopTimeout => AppConstants.kAsrStopTimeout;
 
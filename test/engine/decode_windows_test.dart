@@ -0,0 +1,170 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/decode_windows.dart';
+
+/// 有窗口限制的离线模型：切窗不超过上限、切在停顿里，重叠处的字对齐去重。
+void main() {
+  const rate = 16000;
+
+  /// [seconds] 秒的「说话」（200Hz 正弦），[pauses] 里的区间（秒）是静音
+  Float32List speech(double seconds, List<List<double>> pauses) {
+    final out = Float32List((seconds * rate).round());
+    for (var i = 0; i < out.length; i++) {
+      final t = i / rate;
+      final silent = pauses.any((p) => t >= p[0] && t < p[1]);
+      out[i] = silent ? 0 : 0.3 * math.sin(2 * math.pi * 200 * t);
+    }
+    return out;
+  }
+
+  group('DecodeWindowPlanner', () {
+    final planner = DecodeWindowPlanner(maxSamples: 30 * rate, overlapSamples: rate);
+
+    test('不超过一个窗口：整段一窗', () {
+      final windows = planner.plan(speech(29.5, const []));
+      expect(windows.length, 1);
+      expect(windows.single.start, 0);
+      expect(windows.single.end, (29.5 * rate).round());
+    });
+
+    test('长录音：每窗不超过上限、切在停顿里、相邻重叠固定、首尾覆盖全段', () {
+      const pauses = [
+        [22.0, 23.5],
+        [47.0, 48.5],
+      ];
+      final samples = speech(75, pauses);
+      final windows = planner.plan(samples);
+      expect(windows.length, 3);
+      expect(windows.first.start, 0);
+      expect(windows.last.end, samples.length);
+      for (final w in windows) {
+        expect(w.length, lessThanOrEqualTo(planner.maxSamples));
+      }
+      for (var i = 0; i + 1 < windows.length; i++) {
+        expect(windows[i + 1].start, windows[i].end - planner.overlapSamples);
+        final cutSec = windows[i].end / rate;
+        expect(cutSec, inInclusiveRange(pauses[i][0], pauses[i][1]), reason: '第 ${i + 1} 个切点 ${cutSec}s');
+      }
+    });
+
+    test('一直没有停顿也不超过上限', () {
+      final samples = speech(95, const []);
+      final windows = planner.plan(samples);
+      expect(windows.length, greaterThan(3));
+      for (final w in windows) {
+        expect(w.length, lessThanOrEqualTo(planner.maxSamples));
+        expect(w.length, greaterThan(planner.maxSamples ~/ 2 - planner.overlapSamples));
+      }
+      expect(windows.last.end, samples.length);
+    });
+
+    test('只有 Whisper / Moonshine 这类有窗口的模型才切', () {
+      expect(DecodeWindowPlanner.forModelType('whisper')?.maxSamples, 30 * rate);
+      expect(DecodeWindowPlanner.forModelType('moonshine'), isNotNull);
+      expect(DecodeWindowPlanner.forModelType('sense_voice'), isNull);
+      expect(DecodeWindowPlanner.forModelType('offline_paraformer'), isNull);
+    });
+  });
+
+  group('joinDecodedText', () {
+    test('英文两段之间补空格；中文、标点开头、空段直接接', () {
+      expect(joinDecodedText('at the end of', 'the day'), 'at the end of the day');
+      expect(joinDecodedText('It works.', 'Next'), 'It works. Next');
+      expect(joinDecodedText('今天天气', '很好'), '今天天气很好');
+      expect(joinDecodedText('ok', ', fine'), 'ok, fine');
+      expect(joinDecodedText('', 'the day'), 'the day');
+      expect(['a', 'b', 'c'].fold('', joinDecodedText), 'a b c');
+    });
+  });
+
+  group('DecodeWindowMerger', () {
+    test('不重叠的窗口原样接上，时间戳加上窗口起点', () {
+      final m = DecodeWindowMerger();
+      expect(m.add(start: 0, end: 2 * rate, text: '你好', windowTokens: ['你', '好'], windowTimestamps: [0.2, 0.5]), '你好');
+      expect(m.add(start: 2 * rate, end: 4 * rate, text: '世界', windowTokens: ['世', '界'], windowTimestamps: [0.1, 0.4]),
+          '世界');
+      expect(m.tokens, ['你', '好', '世', '界']);
+      expect(m.timestamps[2], closeTo(2.1, 1e-9));
+    });
+
+    test('重叠里两边认出同样几个字：按 token 对齐，新窗口去掉重复的', () {
+      final m = DecodeWindowMerger();
+      // 第一窗 [0, 10s)，最后「天气很」落在重叠 [9s, 10s) 里
+      m.add(
+        start: 0,
+        end: 10 * rate,
+        text: '今天天气很',
+        windowTokens: ['今', '天', '天', '气', '很'],
+        windowTimestamps: [8.0, 8.5, 9.1, 9.4, 9.8],
+      );
+      // 第二窗从 9s 开始，开头重新认出「天气很」，时间戳稍有出入
+      final text = m.add(
+        start: 9 * rate,
+        end: 15 * rate,
+        text: '天气很好',
+        windowTokens: ['天', '气', '很', '好'],
+        windowTimestamps: [0.15, 0.45, 0.75, 1.2],
+      );
+      expect(text, '好');
+      expect(m.tokens.join(), '今天天气很好');
+      expect(m.timestamps.last, closeTo(10.2, 1e-9));
+    });
+
+    test('第一窗结尾被切掉的半个字：对齐点之后以新窗口为准', () {
+      final m = DecodeWindowMerger();
+      m.add(
+        start: 0,
+        end: 10 * rate,
+        text: ' the quick brown',
+        windowTokens: [' the', ' quick', ' brown'],
+        windowTimestamps: [9.1, 9.4, 9.9],
+      );
+      final text = m.add(
+        start: 9 * rate,
+        end: 12 * rate,
+        text: ' the quick brown fox',
+        windowTokens: [' the', ' quick', ' brown', ' fox'],
+        windowTimestamps: [0.1, 0.4, 0.9, 1.3],
+      );
+      expect(text, 'fox');
+    });
+
+    test('对不齐时按时间戳：不晚于上一窗最后一个字的丢掉', () {
+      final m = DecodeWindowMerger();
+      m.add(start: 0, end: 10 * rate, text: '甲乙', windowTokens: ['甲', '乙'], windowTimestamps: [8.0, 9.5]);
+      final text = m.add(
+        start: 9 * rate,
+        end: 12 * rate,
+        text: '已丙丁',
+        windowTokens: ['已', '丙', '丁'],
+        windowTimestamps: [0.4, 0.8, 1.5],
+      );
+      expect(text, '丙丁');
+    });
+
+    test('文本和 token 对不上、也找不到开头时整段保留（宁可重复不丢字）', () {
+      final m = DecodeWindowMerger();
+      m.add(start: 0, end: 10 * rate, text: '天气很', windowTokens: ['天', '气', '很'], windowTimestamps: [9.1, 9.4, 9.8]);
+      final text = m.add(
+        start: 9 * rate,
+        end: 12 * rate,
+        text: '今天气候很好',
+        windowTokens: ['天', '气', '很', '好'],
+        windowTimestamps: [0.1, 0.4, 0.8, 1.2],
+      );
+      expect(text, '今天气候很好');
+      expect(m.tokens.last, '好');
+    });
+
+    test('reset 之后从头开始', () {
+      final m = DecodeWindowMerger();
+      m.add(start: 0, end: 10 * rate, text: '天气', windowTokens: ['天', '气'], windowTimestamps: [9.1, 9.5]);
+      m.reset();
+      expect(m.add(start: 9 * rate, end: 12 * rate, text: '天气', windowTokens: ['天', '气'], windowTimestamps: [0.1, 0.5]),
+          '天气');
+      expect(m.tokens, ['天', '气']);
+    });
+  });
+}
@@ -0,0 +1,73 @@
+import 'dart:async';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/dictation_pipeline.dart';
+
+/// 连着口述：后一句的收尾可以先跑完，但交出去的顺序按松键顺序。
+void main() {
+  group('DictationPipeline', () {
+    test('后一句先润色完也要等前一句交完', () async {
+      final pipeline = DictationPipeline();
+      final injected = <String>[];
+      final slowLlm = Completer<void>();
+
+      Future<void> dictate(String text, Future<void> llm) async {
+        final ticket = pipeline.enter();
+        try {
+          await llm;
+          await ticket.turn;
+          injected.add(text);
+        } finally {
+          ticket.done();
+        }
+      }
+
+      final a = dictate('第一句', slowLlm.future);
+      final b = dictate('第二句', Future.value());
+      await Future<void>.delayed(Duration.zero);
+      expect(injected, isEmpty, reason: '第二句不能插到还在润色的第一句前面');
+      expect(pipeline.inFlight, 2);
+
+      slowLlm.complete();
+      await Future.wait([a, b]);
+      expect(injected, ['第一句', '第二句']);
+      expect(pipeline.inFlight, 0);
+    });
+
+    test('没轮到就提前放弃的一句不放后面的插队', () async {
+      final pipeline = DictationPipeline();
+      final first = pipeline.enter();
+      final second = pipeline.enter();
+      final third = pipeline.enter();
+      var thirdTurn = false;
+      unawaited(third.turn.then((_) => thirdTurn = true));
+
+      second.done(); // 识别为空，直接收尾
+      await Future<void>.delayed(Duration.zero);
+      expect(thirdTurn, isFalse);
+
+      first.done();
+      await Future<void>.delayed(Duration.zero);
+      expect(thirdTurn, isTrue);
+      third.done();
+      third.done(); // 重复调用忽略
+      expect(pipeline.inFlight, 0);
+    });
+
+    test('drain 等排着的全部交完；序号按进入顺序', () async {
+      final pipeline = DictationPipeline();
+      final a = pipeline.enter();
+      final b = pipeline.enter();
+      expect([a.seq, b.seq], [1, 2]);
+
+      var drained = false;
+      unawaited(pipeline.drain().then((_) => drained = true));
+      a.done();
+      await Future<void>.delayed(Duration.zero);
+      expect(drained, isFalse);
+      b.done();
+      await Future<void>.delayed(Duration.zero);
+      expect(drained, isTrue);
+    });
+  });
+}
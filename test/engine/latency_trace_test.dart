@@ -0,0 +1,173 @@
+import 'dart:convert';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/latency_trace.dart';
+
+void main() {
+  group('LatencyTracer', () {
+    test('阶段按起止落成事件，导出的时间从会话开始算起', () async {
+      final t = LatencyTracer();
+      final session = t.beginSession(args: {'mode': 'ptt', 'asr': 'openai', 'model': 'whisper-1'});
+      final asr = t.span('asr stop', track: 'asr');
+      await Future<void>.delayed(const Duration(milliseconds: 20));
+      asr.end(args: {'chars': 12});
+      t.instant('first token', track: 'llm');
+      t.endSession(args: {'outcome': 'ok'});
+
+      expect(t.current, isNull);
+      expect(t.sessions.single, same(session));
+      final trace = jsonDecode(t.toChromeTraceJson()) as Map<String, dynamic>;
+      final events = (trace['traceEvents'] as List).cast<Map<String, dynamic>>();
+
+      final process = events.firstWhere((e) => e['name'] == 'process_name');
+      expect(process['args']['name'], '#1 ptt openai whisper-1');
+
+      final stop = events.firstWhere((e) => e['name'] == 'asr stop');
+      expect(stop['ph'], 'X');
+      expect(stop['ts'], greaterThanOrEqualTo(0));
+      expect(stop['dur'], greaterThanOrEqualTo(20000));
+      expect(stop['args'], {'chars': 12});
+
+      final token = events.firstWhere((e) => e['name'] == 'first token');
+      expect(token['ph'], 'i');
+      expect(token.containsKey('dur'), isFalse);
+      expect(token['ts'], greaterThanOrEqualTo(stop['ts'] + stop['dur']));
+
+      final whole = events.firstWhere((e) => e['name'] == 'session');
+      expect(whole['ts'], 0);
+      expect(whole['args']['outcome'], 'ok');
+
+      final threads = {
+        for (final e in events.where((e) => e['name'] == 'thread_name')) e['args']['name']: e['tid'],
+      };
+      expect(threads.keys, containsAll(['asr', 'llm']));
+      expect(stop['tid'], threads['asr']);
+    });
+
+    test('native 时刻对钟：早于会话开始的按键时刻也能作为起点', () {
+      final t = LatencyTracer();
+      // native 钟的「现在」是 5_000_000，按键发生在 3ms 之前
+      final keyUs = t.alignNative(4_997_000, nativeNowUs: 5_000_000);
+      final now = t.nowUs();
+      expect(now - keyUs, inInclusiveRange(3000, 3000 + 50000));
+
+      t.beginSession(atUs: keyUs);
+      t.complete('key down → engine', keyUs, t.nowUs(), track: 'native-key');
+      t.endSession();
+      final events = (t.toChromeTrace()['traceEvents'] as List).cast<Map<String, dynamic>>();
+      final key = events.firstWhere((e) => e['name'] == 'key down → engine');
+      expect(key['ts'], 0);
+      expect(key['dur'], greaterThanOrEqualTo(3000));
+    });
+
+    test('会话结束时还开着的阶段按未完成收掉，之后再 end 不重复记', () {
+      final t = LatencyTracer();
+      t.beginSession();
+      final llm = t.span('llm polish', track: 'llm');
+      t.endSession();
+      llm.end();
+
+      final events = t.sessions.single.events;
+      expect(events.length, 1);
+      expect(events.single.name, 'llm polish');
+      expect(events.single.args['unfinished'], isTrue);
+    });
+
+    test('没有会话时记录全部忽略，不抛', () {
+      final t = LatencyTracer();
+      t.span('inject').end();
+      t.instant('first partial');
+      t.complete('device open', 0, 10);
+      t.annotate({'outcome': 'ok'});
+      t.endSession();
+      expect(t.sessions, isEmpty);
+    });
+
+    test('上一次没结束就开新会话：旧的按 superseded 收进环', () {
+      final t = LatencyTracer();
+      t.beginSession();
+      t.beginSession();
+      expect(t.sessions.single.args['outcome'], 'superseded');
+      expect(t.current, isNotNull);
+    });
+
+    test('detach 出去的会话在后台收尾：新会话不把它当 superseded，各记各的', () {
+      final t = LatencyTracer();
+      t.beginSession(args: {'mode': 'ptt'});
+      final first = t.detach();
+      expect(t.current, isNull);
+
+      final second = t.beginSession(args: {'mode': 'ptt'});
+      t.span('llm polish', track: 'llm', session: first).end();
+      t.instant('first partial', track: 'asr');
+      t.annotate({'outcome': 'ok'}, session: first);
+      t.endSession(session: first);
+
+      expect(t.current, same(second));
+      expect(t.sessions.single, same(first));
+      expect(first.args['outcome'], 'ok');
+      expect(first.events.map((e) => e.name), ['llm polish']);
+      t.endSession();
+      expect(second.events.map((e) => e.name), ['first partial']);
+      expect(second.args.containsKey('outcome'), isFalse);
+    });
+
+    test('没有会话时 detach 出来的是空会话，往上记什么都不留', () {
+      final t = LatencyTracer();
+      final none = t.detach();
+      t.span('inject', session: none).end();
+      t.endSession(session: none);
+      expect(t.sessions, isEmpty);
+    });
+
+    test('环形缓冲只留最近 N 次；单次事件数有上限，超出计数', () {
+      final t = LatencyTracer(capacity: 3, maxEventsPerSession: 4);
+      for (var i = 0; i < 5; i++) {
+        t.beginSession(args: {'mode': 'ptt'});
+        for (var j = 0; j < 6; j++) {
+          t.span('typewriter batch', track: 'inject').end();
+        }
+        t.endSession();
+      }
+      expect(t.sessions.map((s) => s.id), [3, 4, 5]);
+      expect(t.sessions.last.events.length, 4);
+      expect(t.sessions.last.droppedEvents, 2);
+
+      final events = (t.toChromeTrace()['traceEvents'] as List).cast<Map<String, dynamic>>();
+      expect(events.map((e) => e['pid']).toSet(), {3, 4, 5});
+      final whole = events.firstWhere((e) => e['name'] == 'session' && e['pid'] == 5);
+      expect(whole['args']['droppedEvents'], 2);
+    });
+
+    test('结束早于开始的阶段不记（native 时刻缺失或钟没对上）', () {
+      final t = LatencyTracer();
+      t.beginSession();
+      t.complete('first chunk', 100, 50, track: 'native-capture');
+      t.endSession();
+      expect(t.sessions.single.events, isEmpty);
+    });
+  });
+
+  group('FrameStats', () {
+    test('一帧取 build / raster 中长的；超预算计掉帧', () {
+      final f = FrameStats(budgetUs: 16667);
+      f.add(4000, 9000);
+      f.add(30000, 2000);
+      f.add(8000, 8000);
+      expect(f.toArgs(), {
+        'frames': 3,
+        'frameAvgMs': '15.67',
+        'frameWorstMs': '30.00',
+        'framesOverBudget': 1,
+      });
+    });
+
+    test('没有帧时不往会话里写；reset 后重新计', () {
+      final f = FrameStats();
+      expect(f.toArgs(), isEmpty);
+      f.add(20000, 0);
+      f.reset();
+      expect(f.toArgs(), isEmpty);
+    });
+  });
+}
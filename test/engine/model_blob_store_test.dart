@@ -0,0 +1,149 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:path_provider_platform_interface/path_provider_platform_interface.dart';
+import 'package:speakout/engine/model_blob_store.dart';
+import 'package:speakout/engine/model_manager.dart';
+
+import '../helpers/test_helpers.dart';
+
+/// 内容寻址模型库：同内容文件只存一份、清单比对能发现被写坏的模型。
+///
+/// 硬链接靠系统 `ln`，Windows CI 不跑这组（mklink 需要额外权限）。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  late Directory tmp;
+  late Directory modelsRoot;
+
+  setUp(() async {
+    tmp = await Directory.systemTemp.createTemp('speakout_blob_store');
+    PathProviderPlatform.instance = MockPathProviderPlatform(tmp.path);
+    modelsRoot = Directory('${tmp.path}/Models')..createSync(recursive: true);
+  });
+  tearDown(() {
+    if (tmp.existsSync()) tmp.deleteSync(recursive: true);
+  });
+
+  /// 大于 kMinBlobBytes 才会入库
+  List<int> weights(int seed) =>
+      List.generate(ModelBlobStore.kMinBlobBytes + 1024, (i) => (i * seed) & 0xff);
+
+  Directory seedDir(String name, Map<String, List<int>> files) {
+    final d = Directory('${modelsRoot.path}/$name')..createSync(recursive: true);
+    for (final e in files.entries) {
+      File('${d.path}/${e.key}').writeAsBytesSync(e.value);
+    }
+    return d;
+  }
+
+  int blobCount(ModelBlobStore store) => store.blobDir
+      .listSync(recursive: true)
+      .whereType<File>()
+      .where((f) => !f.path.endsWith('manifest.json'))
+      .length;
+
+  test('两个模型共用同一份权重：只存一个 blob，两边内容都不变', () async {
+    final shared = weights(7);
+    final a = seedDir('model_a', {'model.int8.onnx': shared, 'tokens.txt': 'a'.codeUnits});
+    final b = seedDir('model_b', {'model.int8.onnx': shared, 'tokens.txt': 'b'.codeUnits});
+
+    final store = ModelBlobStore(modelsRoot);
+    await store.ingest(a);
+    await store.ingest(b);
+
+    expect(blobCount(store), 1, reason: 'tokens.txt 太小不入库，权重只该有一份');
+    expect(File('${a.path}/model.int8.onnx').readAsBytesSync(), shared);
+    expect(File('${b.path}/model.int8.onnx').readAsBytesSync(), shared);
+    expect(File('${b.path}/tokens.txt').readAsStringSync(), 'b');
+
+    // 共用的 blob 删掉 a 也释放不了，不能算进 a 的独占大小
+    expect(await store.exclusiveSize(a), 1, reason: '只剩 a 自己的 tokens.txt');
+  }, skip: Platform.isWindows);
+
+  test('清单比对：完好 → intact，权重被截断 → damaged，没记录 → unknown', () async {
+    final d = seedDir('model_c', {'model.int8.onnx': weights(3), 'tokens.txt': 't'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    expect(await store.verify(d), BlobCheck.unknown);
+
+    await store.ingest(d);
+    expect(await store.verify(d), BlobCheck.intact);
+
+    // 新实例从磁盘读清单 —— 启动时走的就是这条路
+    expect(await ModelBlobStore(modelsRoot).verify(d), BlobCheck.intact);
+
+    File('${d.path}/model.int8.onnx').writeAsBytesSync([1, 2, 3]);
+    expect(await ModelBlobStore(modelsRoot).verify(d), BlobCheck.damaged);
+  }, skip: Platform.isWindows);
+
+  test('只被 touch 过（mtime 变、内容没变）不算损坏', () async {
+    final d = seedDir('model_d', {'model.int8.onnx': weights(5), 'tokens.txt': 't'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    await store.ingest(d);
+
+    File('${d.path}/tokens.txt')
+        .setLastModifiedSync(DateTime.now().add(const Duration(hours: 1)));
+    expect(await store.verify(d), BlobCheck.intact);
+  }, skip: Platform.isWindows);
+
+  test('校验途中写清单出错：按 unknown 交回，不从查模型路径抛出去', () async {
+    final d = seedDir('model_g', {'model.int8.onnx': weights(13), 'tokens.txt': 't'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    await store.ingest(d);
+
+    File('${d.path}/tokens.txt')
+        .setLastModifiedSync(DateTime.now().add(const Duration(hours: 1)));
+    // 临时文件的位置被一个目录占着，写清单必然失败
+    Directory('${store.blobDir.path}/manifest.json.tmp').createSync();
+    expect(await store.verify(d), BlobCheck.unknown);
+  }, skip: Platform.isWindows);
+
+  test('并发入库：清单落盘排队，两个目录都记上、清单完整', () async {
+    final a = seedDir('model_h', {'model.int8.onnx': weights(15), 'tokens.txt': 'a'.codeUnits});
+    final b = seedDir('model_i', {'model.int8.onnx': weights(17), 'tokens.txt': 'b'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    await Future.wait([store.ingest(a), store.ingest(b)]);
+
+    final fresh = ModelBlobStore(modelsRoot);
+    expect(await fresh.verify(a), BlobCheck.intact);
+    expect(await fresh.verify(b), BlobCheck.intact);
+  }, skip: Platform.isWindows);
+
+  test('forget 后 GC 回收无人引用的 blob，仍被引用的保留', () async {
+    final a = seedDir('model_e', {'model.int8.onnx': weights(9), 'tokens.txt': 'a'.codeUnits});
+    final b = seedDir('model_f', {'model.int8.onnx': weights(11), 'tokens.txt': 'b'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    await store.ingest(a);
+    await store.ingest(b);
+    expect(blobCount(store), 2);
+
+    a.deleteSync(recursive: true);
+    await store.forget(a);
+    final freed = await store.collectGarbage();
+
+    expect(freed, weights(9).length);
+    expect(blobCount(store), 1);
+    expect(await store.verify(b), BlobCheck.intact);
+  }, skip: Platform.isWindows);
+
+  test('中断安装：新目录文件齐全但内容与清单不符时，回滚到可用的备份', () async {
+    const modelId = 'sensevoice_zh_en_int8';
+    final model = ModelManager.allModels.firstWhere((m) => m.id == modelId);
+    final dirName = model.url.split('/').last.replaceAll('.tar.bz2', '');
+
+    final good = weights(13);
+    final finalDir = seedDir(dirName, {'model.int8.onnx': good, 'tokens.txt': 'tok'.codeUnits});
+    final store = ModelBlobStore(modelsRoot);
+    await store.ingest(finalDir);
+
+    // 备份是一份完好的拷贝；正式目录里的权重被写坏但仍「非空」
+    final backup = Directory('${finalDir.path}.old')..createSync();
+    File('${backup.path}/model.int8.onnx').writeAsBytesSync(good);
+    File('${backup.path}/tokens.txt').writeAsStringSync('tok');
+    File('${finalDir.path}/model.int8.onnx').writeAsBytesSync([9, 9, 9]);
+
+    expect(await ModelManager().hasLocalCopy(modelId), isTrue);
+    expect(backup.existsSync(), isFalse, reason: '备份应已被 rename 回正式目录');
+    expect(File('${finalDir.path}/model.int8.onnx').readAsBytesSync(), good);
+  }, skip: Platform.isWindows);
+}
@@ -0,0 +1,24 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('native 多读者 ring：游标互不影响、慢读者只丢自己的、并发下读不到半截数据', () {
+    const src = 'native_lib/tests/audio_ring_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final out = Directory.systemTemp.createTempSync('speakout_audio_ring_harness');
+    try {
+      final bin = '${out.path}/audio_ring_harness';
+      final build = Process.runSync('cc', ['-O2', '-o', bin, src, '-lpthread']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      expect(run.exitCode, 0, reason: 'ring 行为不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  }, skip: Platform.isWindows ? '测试宿主用 cc + pthread 编译' : null);
+}
@@ -0,0 +1,27 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('DSP 内核：各 SIMD 变体与标量参考一致', () {
+    const src = 'native_lib/tests/dsp_kernels_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final out = Directory.systemTemp.createTempSync('speakout_dsp_kernels_harness');
+    try {
+      final bin = '${out.path}/dsp_kernels_harness';
+      final build = Process.runSync('cc', ['-O2', '-o', bin, src, '-lm']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      // 默认分派一遍，再强制标量一遍（分派走环境变量的那条路也要能跑通）
+      for (final env in [<String, String>{}, {'SPEAKOUT_DSP': 'scalar'}]) {
+        final run = Process.runSync(bin, [], environment: env);
+        expect(run.exitCode, 0, reason: 'DSP 内核结果不符 $env:\n${run.stdout}');
+        expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+            reason: run.stdout as String);
+      }
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  }, skip: !Platform.isLinux ? 'DSP 内核宿主用 cc 编译，目前只在 Linux 上跑' : null);
+}
@@ -0,0 +1,38 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('Linux native 日志：多线程入环、落盘、滚动与切换目录', () {
+    const src = 'native_lib/tests/native_log_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    // 键盘/采集线程上不能有阻塞 I/O：库里不该再有直接写 stderr 的日志
+    final lib = File('native_lib/linux/native_input.c').readAsLinesSync();
+    final direct = [
+      for (final line in lib)
+        if (line.contains('fprintf(stderr') && !line.trimLeft().startsWith('//')) line.trim(),
+    ];
+    expect(direct, ['fprintf(stderr, "%s%s\\n", stamp, line);'],
+        reason: '只有写线程可以写 stderr，其余一律走 native_log');
+
+    final out = Directory.systemTemp.createTempSync('speakout_native_log_harness');
+    try {
+      final bin = '${out.path}/native_log_harness';
+      final build = Process.runSync('cc', ['-o', bin, src, '-lpthread', '-lm']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      expect(run.exitCode, 0, reason: '日志行为不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  },
+      skip: !Platform.isLinux
+          ? '这套日志只在 Linux 库里'
+          : !File('/usr/include/pulse/simple.h').existsSync()
+              ? '缺 PulseAudio 头文件（libpulse-dev）'
+              : null);
+}
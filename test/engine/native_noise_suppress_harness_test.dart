@@ -0,0 +1,24 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('native 降噪：旁路还原、稳态噪声压低、切换无断点', () {
+    const src = 'native_lib/tests/noise_suppress_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final out = Directory.systemTemp.createTempSync('speakout_noise_suppress_harness');
+    try {
+      final bin = '${out.path}/noise_suppress_harness';
+      final build = Process.runSync('cc', ['-O2', '-o', bin, src, '-lm']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      expect(run.exitCode, 0, reason: '降噪结果不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  }, skip: !Platform.isLinux ? '降噪目前只在 Linux 库里' : null);
+}
@@ -0,0 +1,24 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('native 重采样：48k/44.1k/32k/8k → 16k 通带平坦、混叠 ≤ -80dB、分块无关', () {
+    const src = 'native_lib/tests/resampler_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final out = Directory.systemTemp.createTempSync('speakout_resampler_harness');
+    try {
+      final bin = '${out.path}/resampler_harness';
+      final build = Process.runSync('cc', ['-O2', '-o', bin, src, '-lm']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      expect(run.exitCode, 0, reason: '重采样结果不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  }, skip: !Platform.isLinux ? '测试宿主按 Linux 工具链编译' : null);
+}
@@ -0,0 +1,32 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('Linux native 流式解码线程：从 ring 取数、字幕回调、松键收尾与取消', () {
+    const src = 'native_lib/tests/stream_decoder_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final out = Directory.systemTemp.createTempSync('speakout_stream_decoder_harness');
+    try {
+      final bin = '${out.path}/stream_decoder_harness';
+      final build = Process.runSync('cc', ['-o', bin, src, '-lpthread', '-lm', '-ldl']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      // 宿主打印了「写满一帧到字幕回调」的耗时，留在测试输出里
+      // ignore: avoid_print
+      print((run.stdout as String).split('\n').where((l) => l.contains('ms)')).join('\n'));
+      expect(run.exitCode, 0, reason: '解码线程行为不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  },
+      skip: !Platform.isLinux
+          ? '解码线程只在 Linux 库里'
+          : !File('/usr/include/pulse/simple.h').existsSync()
+              ? '缺 PulseAudio 头文件（libpulse-dev）'
+              : null);
+}
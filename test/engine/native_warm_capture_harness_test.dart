@@ -0,0 +1,33 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  test('Linux 采集：pre-roll 拼接、设备释放、停止 drain 与 trace 时刻', () {
+    const src = 'native_lib/tests/warm_capture_harness.c';
+    expect(File(src).existsSync(), isTrue, reason: '找不到测试宿主源码');
+
+    final harness = File(src).readAsStringSync();
+    expect(harness.contains('#define pa_simple_new'), isTrue,
+        reason: '宿主不得打开真实麦克风');
+
+    final out = Directory.systemTemp.createTempSync('speakout_warm_capture_harness');
+    try {
+      final bin = '${out.path}/warm_capture_harness';
+      final build = Process.runSync('cc', ['-o', bin, src, '-lpthread', '-lm']);
+      expect(build.exitCode, 0, reason: '宿主编译失败:\n${build.stderr}');
+
+      final run = Process.runSync(bin, []);
+      expect(run.exitCode, 0, reason: '采集行为不符:\n${run.stdout}');
+      expect((run.stdout as String).contains('ALL PASSED'), isTrue,
+          reason: run.stdout as String);
+    } finally {
+      out.deleteSync(recursive: true);
+    }
+  },
+      skip: !Platform.isLinux
+          ? '常驻采集目前只在 Linux 库里'
+          : !File('/usr/include/pulse/simple.h').existsSync()
+              ? '缺 PulseAudio 头文件（libpulse-dev）'
+              : null);
+}
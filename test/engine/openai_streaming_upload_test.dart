@@ -0,0 +1,221 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/engine/providers/openai_asr_provider.dart';
+import 'package:speakout/services/config_service.dart';
+
+/// Whisper 边录边传：对着本地的 OpenAI 兼容替身服务跑。
+///
+/// 替身按固定「带宽」读请求体（每 16KB 停 10ms，靠 TCP 背压把上传拖慢），
+/// 读完后从 multipart 里抠出 WAV、数 PCM 字节数当作转写结果返回
+/// （FLAC 则报文件名和 FLAC 流的字节数）。
+/// `/reject/...` 路径模拟不收 chunked 请求体的网关（411），
+/// `/gw400/...` 是只对 chunked 回 400 的网关，`/bad/...` 不管怎么传都回 400
+/// （音频太短之类的普通 API 错误）。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  late HttpServer server;
+  late String base;
+  final chunkedSeen = <bool>[];
+
+  setUpAll(() async {
+    // 测试绑定默认把 HttpClient 全拦成 400，这里要连真的本地端口
+    HttpOverrides.global = null;
+    server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    base = 'http://${server.address.address}:${server.port}';
+    server.listen((request) async {
+      final chunked = request.headers.chunkedTransferEncoding;
+      chunkedSeen.add(chunked);
+      final body = BytesBuilder(copy: false);
+      var nextPause = 16 * 1024;
+      try {
+        await for (final chunk in request) {
+          body.add(chunk);
+          while (body.length >= nextPause) {
+            await Future<void>.delayed(const Duration(milliseconds: 10));
+            nextPause += 16 * 1024;
+          }
+        }
+      } catch (_) {
+        return; // 客户端中止了请求
+      }
+      if (request.uri.path.startsWith('/reject') && chunked) {
+        request.response.statusCode = 411;
+        await request.response.close();
+        return;
+      }
+      if (request.uri.path.startsWith('/bad') ||
+          (request.uri.path.startsWith('/gw400') && chunked)) {
+        request.response.statusCode = 400;
+        request.response.write('{"error": {"message": "Audio file is too short"}}');
+        await request.response.close();
+        return;
+      }
+      final bytes = body.takeBytes();
+      final boundary = request.headers.contentType!.parameters['boundary']!;
+      request.response.headers.contentType = ContentType.json;
+      final flac = _indexOf(bytes, ascii.encode('fLaC'));
+      if (flac >= 0) {
+        final end = _indexOf(bytes, ascii.encode('\r\n--$boundary--'), flac);
+        final partHeader = latin1.decode(bytes.sublist(0, flac));
+        final named = partHeader.contains('filename="audio.flac"');
+        request.response.write(jsonEncode({
+          'text': 'flac=${end - flac} named=$named',
+        }));
+        await request.response.close();
+        return;
+      }
+      final riff = _indexOf(bytes, ascii.encode('RIFF'));
+      final end = _indexOf(bytes, ascii.encode('\r\n--$boundary--'), riff);
+      final pcm = end - riff - 44;
+      final declared = ByteData.sublistView(bytes, riff + 40, riff + 44).getUint32(0, Endian.little);
+      request.response.write(jsonEncode({
+        'text': 'pcm=$pcm declared=${declared == 0xFFFFFFFF ? 'stream' : declared}',
+      }));
+      await request.response.close();
+    });
+
+    SharedPreferences.setMockInitialValues({});
+    await ConfigService().init();
+  });
+
+  tearDownAll(() => server.close(force: true));
+  setUp(chunkedSeen.clear);
+
+  Future<OpenAIASRProvider> make(String path, {bool streaming = true}) async {
+    final p = OpenAIASRProvider();
+    await p.initialize({
+      'apiKey': 'k',
+      'baseUrl': '$base$path',
+      'streamingUpload': streaming,
+    });
+    return p;
+  }
+
+  /// 「录音」：[chunks] 块、每块 0.5 秒 int16，块间隔 [gap]；返回松键到出字的耗时
+  Future<(String, Duration)> dictate(OpenAIASRProvider p,
+      {int chunks = 20, Duration gap = const Duration(milliseconds: 25)}) async {
+    await p.start();
+    for (var i = 0; i < chunks; i++) {
+      p.acceptPcm16(Uint8List(16000));
+      await Future<void>.delayed(gap);
+    }
+    final sw = Stopwatch()..start();
+    final result = await p.stop();
+    return (result.text, sw.elapsed);
+  }
+
+  test('边录边传：请求体 chunked，WAV 长度按流式填，PCM 一字节不少', () async {
+    final p = await make('/v1');
+    final (text, _) = await dictate(p, chunks: 4);
+    expect(text, 'pcm=64000 declared=stream');
+    expect(chunkedSeen, [true]);
+    await p.dispose();
+  });
+
+  test('松键到出字：边录边传明显快于整段上传', () async {
+    final whole = await make('/v1', streaming: false);
+    final (wholeText, wholeLatency) = await dictate(whole);
+    final streamed = await make('/v1');
+    final (streamText, streamLatency) = await dictate(streamed);
+
+    // ignore: avoid_print
+    print('key-up → text: whole-file ${wholeLatency.inMilliseconds}ms, '
+        'streamed ${streamLatency.inMilliseconds}ms (320000 bytes PCM)');
+    expect(wholeText, 'pcm=320000 declared=320000');
+    expect(streamText, 'pcm=320000 declared=stream');
+    // 替身读 320KB 至少要 20 × 10ms；边录边传时这段已经在录音期间读完
+    expect(wholeLatency, greaterThan(const Duration(milliseconds: 190)));
+    expect(streamLatency, lessThan(wholeLatency));
+    await whole.dispose();
+    await streamed.dispose();
+  });
+
+  test('服务端拒收 chunked → 本次整段重传成功，之后直接整段', () async {
+    final p = await make('/reject/v1');
+    final (first, _) = await dictate(p, chunks: 2);
+    expect(first, 'pcm=32000 declared=32000');
+    expect(chunkedSeen, [true, false]);
+
+    chunkedSeen.clear();
+    final (second, _) = await dictate(p, chunks: 2);
+    expect(second, 'pcm=32000 declared=32000');
+    expect(chunkedSeen, [false], reason: '拒过一次就不该再先试 chunked');
+    await p.dispose();
+  });
+
+  test('chunked 和整段都回 400：是普通 API 错误，报错但边录边传不关', () async {
+    final p = await make('/bad/v1');
+    await p.start();
+    p.acceptPcm16(Uint8List(16000));
+    final first = await p.stop();
+    expect(first.error, contains('HTTP 400'));
+    expect(chunkedSeen, [true, false]);
+
+    chunkedSeen.clear();
+    await p.start();
+    p.acceptPcm16(Uint8List(16000));
+    await p.stop();
+    expect(chunkedSeen.first, isTrue, reason: '一次 400 不能把边录边传永久关掉');
+    await p.dispose();
+  });
+
+  test('只有 chunked 回 400、整段收了 → 记下网关不收 chunked，之后直接整段', () async {
+    final p = await make('/gw400/v1');
+    final (first, _) = await dictate(p, chunks: 2);
+    expect(first, 'pcm=32000 declared=32000');
+    expect(chunkedSeen, [true, false]);
+
+    chunkedSeen.clear();
+    await dictate(p, chunks: 2);
+    expect(chunkedSeen, [false]);
+    await p.dispose();
+  });
+
+  /// 原生编码器产出的 FLAC 流：首块带 "fLaC" 头，之后是帧
+  Future<String> dictateFlac(OpenAIASRProvider p) async {
+    await p.start();
+    p.acceptEncoded(Uint8List.fromList([...ascii.encode('fLaC'), ...List.filled(38, 0)]));
+    for (var i = 0; i < 3; i++) {
+      p.acceptEncoded(Uint8List(1000));
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+    return (await p.stop()).text;
+  }
+
+  test('FLAC：边录边传按 audio.flac 上传，字节原样拼接', () async {
+    final p = await make('/v1');
+    expect(await dictateFlac(p), 'flac=3042 named=true');
+    expect(chunkedSeen, [true]);
+    await p.dispose();
+  });
+
+  test('FLAC：服务端拒收 chunked 时整段重传同一条 FLAC 流', () async {
+    final p = await make('/reject-flac/v1');
+    expect(await dictateFlac(p), 'flac=3042 named=true');
+    expect(chunkedSeen, [true, false]);
+    await p.dispose();
+  });
+
+  test('一点音都没录到：中止请求，不出结果', () async {
+    final p = await make('/v1');
+    await p.start();
+    expect((await p.stop()).text, '');
+    await p.dispose();
+  });
+}
+
+int _indexOf(List<int> haystack, List<int> needle, [int from = 0]) {
+  outer:
+  for (var i = from; i <= haystack.length - needle.length; i++) {
+    for (var j = 0; j < needle.length; j++) {
+      if (haystack[i + j] != needle[j]) continue outer;
+    }
+    return i;
+  }
+  return -1;
+}
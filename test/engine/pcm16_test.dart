@@ -0,0 +1,70 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/asr_provider.dart';
+import 'package:speakout/engine/pcm16.dart';
+import 'package:speakout/engine/providers/aliyun_provider.dart';
+import 'package:speakout/engine/providers/dashscope_asr_provider.dart';
+import 'package:speakout/engine/providers/offline_sherpa_provider.dart';
+import 'package:speakout/engine/providers/openai_asr_provider.dart';
+import 'package:speakout/engine/providers/sherpa_provider.dart';
+import 'package:speakout/engine/providers/tencent_asr_provider.dart';
+import 'package:speakout/engine/providers/volcengine_asr_provider.dart';
+import 'package:speakout/engine/providers/xfyun_asr_provider.dart';
+
+import '../helpers/mock_services.dart';
+
+/// int16 直通：云端 provider 拿原生字节，本地模型才转 Float32。
+void main() {
+  Uint8List le(List<int> samples) {
+    final d = ByteData(samples.length * 2);
+    for (var i = 0; i < samples.length; i++) {
+      d.setInt16(i * 2, samples[i], Endian.little);
+    }
+    return d.buffer.asUint8List();
+  }
+
+  test('pcm16ToFloat32 与原先 ByteData 逐样本读法逐位一致', () {
+    final pcm = le([0, 1, -1, 32767, -32768, 12345, -20000]);
+    final f = pcm16ToFloat32(pcm);
+    final d = ByteData.sublistView(pcm);
+    for (var i = 0; i < f.length; i++) {
+      expect(f[i], Float32List.fromList([d.getInt16(i * 2, Endian.little) / 32768.0])[0]);
+    }
+  });
+
+  test('奇数偏移的切片（不能直接开 Int16List 视图）结果相同', () {
+    final backing = Uint8List(1 + 8)..setRange(1, 9, le([100, -100, 32767, -32768]));
+    final odd = Uint8List.sublistView(backing, 1);
+    expect(pcm16ToFloat32(odd), pcm16ToFloat32(le([100, -100, 32767, -32768])));
+  });
+
+  test('float32ToPcm16 夹到 [-1, 1]，与各 provider 原实现一致', () {
+    final bytes = float32ToPcm16(Float32List.fromList([0, 0.5, -0.5, 1.0, -1.0, 1.7, -3]));
+    final d = ByteData.sublistView(bytes);
+    final out = [for (var i = 0; i < bytes.length ~/ 2; i++) d.getInt16(i * 2, Endian.little)];
+    expect(out, [0, 16383, -16383, 32767, -32767, 32767, -32767]);
+  });
+
+  test('云端 provider 声明 pcm16（Whisper 要 FLAC），流式 Sherpa 仍要 Float32', () {
+    final pcm16 = <ASRProvider>[
+      VolcengineASRProvider(),
+      TencentASRProvider(),
+      XfyunASRProvider(),
+      DashScopeASRProvider(),
+      AliyunProvider(),
+      OfflineSherpaProvider(),
+    ];
+    for (final p in pcm16) {
+      expect(p.preferredFormat, AudioSampleFormat.pcm16, reason: p.type);
+    }
+    expect(OpenAIASRProvider().preferredFormat, AudioSampleFormat.flac);
+    expect(SherpaProvider().preferredFormat, AudioSampleFormat.float32);
+  });
+
+  test('要 Float32 的 provider 收到原始字节时自己转换', () {
+    final fake = FakeASRProvider();
+    fake.acceptPcm16(le([16384, -16384]));
+    expect(fake.receivedSamples.single, Float32List.fromList([0.5, -0.5]));
+  });
+}
@@ -0,0 +1,266 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/engine/asr_provider.dart';
+import 'package:speakout/engine/asr_result.dart';
+import 'package:speakout/engine/providers/asr_provider_factory.dart';
+import 'package:speakout/engine/providers/openai_asr_provider.dart';
+import 'package:speakout/engine/providers/racing_asr_provider.dart';
+import 'package:speakout/engine/providers/sherpa_provider.dart';
+import 'package:speakout/services/config_service.dart';
+
+/// 云端 + 本地竞速：云端是真的 OpenAIASRProvider，对着本地替身服务跑。
+///
+/// 替身读完请求体后按路径里的毫秒数（`/delay/<ms>/v1`）人为拖延再回
+/// `{"text": "cloud"}`，模拟云端长尾；`/fail/v1` 回 500。
+/// 本地一路用假 provider，stop() 按设定的耗时返回设定的文本。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  late HttpServer server;
+  late String base;
+
+  setUpAll(() async {
+    // 测试绑定默认把 HttpClient 全拦成 400，这里要连真的本地端口
+    HttpOverrides.global = null;
+    server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    base = 'http://${server.address.address}:${server.port}';
+    server.listen((request) async {
+      try {
+        await request.drain<void>();
+      } catch (_) {
+        return; // 客户端中止了请求
+      }
+      final segments = request.uri.pathSegments;
+      if (segments.first == 'fail') {
+        request.response.statusCode = 500;
+        request.response.write('upstream overloaded');
+        await request.response.close();
+        return;
+      }
+      if (segments.first == 'delay') {
+        await Future<void>.delayed(Duration(milliseconds: int.parse(segments[1])));
+      }
+      request.response.headers.contentType = ContentType.json;
+      request.response.write(jsonEncode({'text': 'cloud'}));
+      await request.response.close();
+    });
+
+    SharedPreferences.setMockInitialValues({});
+    await ConfigService().init();
+  });
+
+  tearDownAll(() => server.close(force: true));
+
+  Future<RacingASRProvider> make(String path,
+      {required _FakeLocal local, int deadlineMs = 300}) async {
+    final p = RacingASRProvider(cloud: OpenAIASRProvider(), local: local);
+    await p.initialize({
+      'cloud': {'apiKey': 'k', 'baseUrl': '$base$path'},
+      'local': <String, dynamic>{},
+      'cloudDeadlineMs': deadlineMs,
+    });
+    return p;
+  }
+
+  /// 录 1 秒（20 块 × 50ms），返回结果和松键到出字的耗时
+  Future<(ASRResult, Duration)> dictate(RacingASRProvider p) async {
+    await p.start();
+    for (var i = 0; i < 20; i++) {
+      p.acceptPcm16(Uint8List(1600));
+    }
+    await Future<void>.delayed(const Duration(milliseconds: 20));
+    final sw = Stopwatch()..start();
+    final result = await p.stop();
+    return (result, sw.elapsed);
+  }
+
+  test('云端在期限内回来：用云端，两路收到同一份音频', () async {
+    final local = _FakeLocal('local', after: const Duration(milliseconds: 10));
+    final p = await make('/v1', local: local, deadlineMs: 2000);
+    final (result, _) = await dictate(p);
+    expect(result.text, 'cloud');
+    expect(p.lastWinner, 'cloud');
+    expect(local.bytes, 32000);
+    await p.dispose();
+  });
+
+  test('云端拖过期限：到点就用本地结果，不等云端', () async {
+    final local = _FakeLocal('local', after: const Duration(milliseconds: 10));
+    final p = await make('/delay/3000/v1', local: local, deadlineMs: 300);
+    final (result, latency) = await dictate(p);
+    // ignore: avoid_print
+    print('cloud +3000ms, deadline 300ms → ${p.lastWinner} in ${latency.inMilliseconds}ms');
+    expect(result.text, 'local');
+    expect(p.lastWinner, 'local');
+    expect(latency, greaterThanOrEqualTo(const Duration(milliseconds: 290)));
+    expect(latency, lessThan(const Duration(milliseconds: 1500)));
+    await p.dispose();
+  });
+
+  test('本地一路在 stop() 里同步解码：期限与解码重叠，不是解码完再等满期限', () async {
+    final local = _FakeLocal('local',
+        after: Duration.zero, blockFor: const Duration(milliseconds: 600));
+    final p = await make('/delay/3000/v1', local: local, deadlineMs: 500);
+    final (result, latency) = await dictate(p);
+    // ignore: avoid_print
+    print('local blocks 600ms, deadline 500ms → ${p.lastWinner} in ${latency.inMilliseconds}ms');
+    expect(result.text, 'local');
+    expect(latency, greaterThanOrEqualTo(const Duration(milliseconds: 590)));
+    expect(latency, lessThan(const Duration(milliseconds: 1000)),
+        reason: '先解码再计期限就是 600 + 500ms');
+    await p.dispose();
+  });
+
+  test('本地没认出字：过了期限继续等云端', () async {
+    final local = _FakeLocal('', after: const Duration(milliseconds: 10));
+    final p = await make('/delay/800/v1', local: local, deadlineMs: 200);
+    final (result, latency) = await dictate(p);
+    expect(result.text, 'cloud');
+    expect(p.lastWinner, 'cloud');
+    expect(latency, greaterThanOrEqualTo(const Duration(milliseconds: 790)));
+    await p.dispose();
+  });
+
+  test('云端报错：本地一出结果就用，不必等到期限', () async {
+    final local = _FakeLocal('local', after: const Duration(milliseconds: 50));
+    final p = await make('/fail/v1', local: local, deadlineMs: 5000);
+    final (result, latency) = await dictate(p);
+    expect(result.text, 'local');
+    expect(p.lastWinner, 'local');
+    expect(latency, lessThan(const Duration(milliseconds: 2000)));
+    await p.dispose();
+  });
+
+  test('两路都没字：带回云端的错误', () async {
+    final local = _FakeLocal('', after: const Duration(milliseconds: 10));
+    final p = await make('/fail/v1', local: local);
+    final (result, _) = await dictate(p);
+    expect(result.text, isEmpty);
+    expect(result.error, isNotNull);
+    expect(p.lastWinner, isNull);
+    await p.dispose();
+  });
+
+  test('字幕：云端出中间结果之前跟本地，之后只跟云端；stop 后不再转发', () async {
+    final cloud = _FakeLocal('c', after: Duration.zero);
+    final local = _FakeLocal('l', after: Duration.zero);
+    final p = RacingASRProvider(cloud: cloud, local: local);
+    await p.initialize({'cloud': <String, dynamic>{}, 'local': <String, dynamic>{}});
+    final seen = <String>[];
+    final sub = p.textStream.listen(seen.add);
+
+    // 每条之后让事件投递完，跨两个 controller 的先后才确定
+    Future<void> emit(_FakeLocal from, String t) {
+      from.partial(t);
+      return Future<void>.delayed(Duration.zero);
+    }
+
+    await p.start();
+    await emit(local, 'l1');
+    await emit(cloud, '');
+    await emit(local, 'l2');
+    await emit(cloud, 'c1');
+    await emit(local, 'l3');
+    await emit(cloud, 'c2');
+    await p.stop();
+    await emit(cloud, 'late');
+
+    expect(seen, ['l1', 'l2', 'c1', 'c2']);
+    await sub.cancel();
+    await p.dispose();
+  });
+
+  test('一路 start 失败：另一路单独撑完本次会话', () async {
+    final cloud = _FakeLocal('c', after: Duration.zero, failStart: true);
+    final local = _FakeLocal('l', after: Duration.zero);
+    final p = RacingASRProvider(cloud: cloud, local: local);
+    await p.initialize({'cloud': <String, dynamic>{}, 'local': <String, dynamic>{}});
+    await p.start();
+    p.acceptPcm16(Uint8List(3200));
+    expect(cloud.bytes, 0);
+    expect(local.bytes, 3200);
+    expect((await p.stop()).text, 'l');
+    await p.dispose();
+  });
+
+  test('本地一路在 native 线程上自己读 ring：Dart 轮询到的只喂云端，下次 start 复位', () async {
+    final cloud = _FakeLocal('c', after: Duration.zero);
+    final local = _FakeLocal('l', after: Duration.zero);
+    final p = RacingASRProvider(cloud: cloud, local: local);
+    await p.initialize({'cloud': <String, dynamic>{}, 'local': <String, dynamic>{}});
+    await p.start();
+    expect(p.localActive, isTrue);
+    p.localDecodesNatively = true;
+    p.acceptPcm16(Uint8List(3200));
+    expect(cloud.bytes, 3200);
+    expect(local.bytes, 0);
+    await p.stop();
+
+    await p.start();
+    expect(p.localDecodesNatively, isFalse);
+    p.acceptPcm16(Uint8List(3200));
+    expect(local.bytes, 3200);
+    await p.stop();
+    await p.dispose();
+  });
+
+  test('工厂按本地模型是否流式选 Sherpa 实现', () {
+    final p = ASRProviderFactory.createRacing('openai', localOffline: false);
+    expect(p.cloud, isA<OpenAIASRProvider>());
+    expect(p.local, isA<SherpaProvider>());
+    expect(p.stopTimeout, const Duration(seconds: 35), reason: '取两路里长的');
+    expect(p.preferredFormat, AudioSampleFormat.pcm16);
+  });
+}
+
+class _FakeLocal implements ASRProvider {
+  _FakeLocal(this.text,
+      {required this.after, this.failStart = false, this.blockFor = Duration.zero});
+
+  final String text;
+  final Duration after;
+  /// stop() 先同步占住 isolate 这么久（离线模型在 UI isolate 上解码）
+  final Duration blockFor;
+  final bool failStart;
+  int bytes = 0;
+  final _controller = StreamController<String>.broadcast();
+
+  void partial(String t) => _controller.add(t);
+
+  @override
+  Stream<String> get textStream => _controller.stream;
+  @override
+  Future<void> initialize(Map<String, dynamic> config) async {}
+  @override
+  Future<void> start() async {
+    if (failStart) throw StateError('start failed');
+  }
+  @override
+  void acceptWaveform(Float32List samples) => bytes += samples.length * 2;
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.pcm16;
+  @override
+  void acceptPcm16(Uint8List pcm) => bytes += pcm.length;
+  @override
+  void acceptEncoded(Uint8List bytes) => throw UnsupportedError('fake');
+  @override
+  Future<ASRResult> stop() async {
+    final busy = Stopwatch()..start();
+    while (busy.elapsed < blockFor) {}
+    await Future<void>.delayed(after);
+    return ASRResult.textOnly(text);
+  }
+  @override
+  Duration get stopTimeout => const Duration(seconds: 6);
+  @override
+  Future<void> dispose() async {}
+  @override
+  bool get isReady => true;
+  @override
+  String get type => 'fake';
+}
@@ -128,6 +128,11 @@ void main() {
     expect(awaitStartIdx, greaterThanOrEqualTo(0));
     expect(awaitStopIdx, greaterThan(awaitStartIdx));
     expect(providerDisposeIdx, greaterThan(awaitStopIdx));
+    // stop 在识别完就放行了（状态回 idle），润色 / 注入 / 存笔记还排在流水线里
+    final drainIdx = disposeBody.indexOf('await _dictationPipeline.drain()');
+    expect(drainIdx, greaterThan(awaitStopIdx));
+    expect(providerDisposeIdx, greaterThan(drainIdx),
+        reason: '识别完的几句还没交完就拆，正在存的闪念会丢');
     expect(streamCloseIdx, greaterThan(providerDisposeIdx),
         reason: '否则在途识别/闪念落盘会被退出流程截断');
   });
@@ -0,0 +1,41 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/asr_result.dart';
+import 'package:speakout/engine/native_silence_compactor.dart';
+
+/// 停顿压缩的对照点：压缩后的时间戳映射回原始录音。
+void main() {
+  // 16kHz：原始 2s 处压掉 2.5s（压缩后 2s 接回原始 4.5s），压缩后 5s 再压掉 1s
+  final map = SilenceOffsetMap([32000, 80000], [72000, 136000]);
+
+  test('第一个对照点之前两边相同', () {
+    expect(map.toOriginalSample(0), 0);
+    expect(map.toOriginalSample(31999), 31999);
+    expect(map.toOriginalSeconds(1.25), 1.25);
+  });
+
+  test('对照点之后按该点平移，不缩放', () {
+    expect(map.toOriginalSample(32000), 72000);
+    expect(map.toOriginalSample(79999), 119999);
+    expect(map.toOriginalSample(80000), 136000);
+    expect(map.toOriginalSeconds(3.0), closeTo(5.5, 1e-9));
+    expect(map.toOriginalSeconds(6.0), closeTo(9.5, 1e-9));
+  });
+
+  test('apply 只改时间戳，文本、tokens 和错误原样保留', () {
+    const r = ASRResult(text: '你好世界', tokens: ['你', '好', '世', '界'], timestamps: [0.5, 1.0, 2.5, 5.5]);
+    final mapped = map.apply(r);
+    expect(mapped.text, r.text);
+    expect(mapped.tokens, r.tokens);
+    expect(mapped.timestamps[0], 0.5);
+    expect(mapped.timestamps[1], 1.0);
+    expect(mapped.timestamps[2], closeTo(5.0, 1e-9));
+    expect(mapped.timestamps[3], closeTo(9.0, 1e-9));
+  });
+
+  test('没压过或没有时间戳时原样返回', () {
+    const r = ASRResult(text: 'x', timestamps: [1.0]);
+    expect(identical(SilenceOffsetMap.identity.apply(r), r), isTrue);
+    const noTs = ASRResult(text: 'y');
+    expect(identical(map.apply(noTs), noTs), isTrue);
+  });
+}
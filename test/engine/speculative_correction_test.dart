@@ -0,0 +1,141 @@
+import 'dart:convert';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:http/http.dart' as http;
+import 'package:http/testing.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/engine/speculative_correction.dart';
+import 'package:speakout/services/config_service.dart';
+import 'package:speakout/services/llm_service.dart';
+
+/// 边说边润色：预分段在录音中就送润色，松键后只补最后一段。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  /// 记录每次调用 (段, 上下文)；润色结果 = 「[段]」
+  late List<(String, String?)> calls;
+  late Set<String> failOn;
+
+  SpeculativeCorrector make({Duration delay = Duration.zero}) {
+    return SpeculativeCorrector((segment, context) async {
+      calls.add((segment, context));
+      await Future<void>.delayed(delay);
+      if (failOn.contains(segment)) return null;
+      return '[$segment]';
+    });
+  }
+
+  setUp(() {
+    calls = [];
+    failOn = {};
+  });
+
+  test('串行：每段拿上一段的润色结果当上下文；收尾只补最后一段', () async {
+    final spec = make();
+    spec.submit('第一段');
+    spec.submit('第二段');
+    await Future<void>.delayed(Duration.zero);
+
+    final text = await spec.finish(['第一段', '第二段', '最后']);
+    expect(text, '[第一段][第二段][最后]');
+    expect(calls, [
+      ('第一段', null),
+      ('第二段', '[第一段]'),
+      ('最后', '[第二段]'),
+    ]);
+  });
+
+  test('收尾等待的只有最后一段，与之前段数无关', () async {
+    const delay = Duration(milliseconds: 40);
+    final spec = make(delay: delay);
+    for (var i = 0; i < 6; i++) {
+      spec.submit('段$i');
+    }
+    // 模拟用户还在说：让预分段润色在「录音期间」跑完
+    await Future<void>.delayed(delay * 8);
+
+    final callsBeforeKeyUp = calls.length;
+    final text = await spec.finish([for (var i = 0; i < 6; i++) '段$i', '尾巴']);
+    expect(calls.length - callsBeforeKeyUp, 1, reason: '松键后只该再发一次请求');
+    expect(text, endsWith('[尾巴]'));
+  });
+
+  test('英文分段：润色后的各段之间补回空格，不粘成一个词', () async {
+    final spec = SpeculativeCorrector((segment, context) async => segment.trim());
+    spec.submit(' at the end of');
+    await Future<void>.delayed(Duration.zero);
+    expect(await spec.finish([' at the end of', 'the day', 'we shipped it.']),
+        'at the end of the day we shipped it.');
+  });
+
+  test('松键时恰好没有新内容：直接拼已润色的段', () async {
+    final spec = make();
+    spec.submit('唯一一段');
+    expect(await spec.finish(['唯一一段']), '[唯一一段]');
+    expect(calls.length, 1);
+  });
+
+  test('任一段失败 → null（调用方退回整段润色），后续段不再白发', () async {
+    failOn = {'第一段'};
+    final spec = make();
+    spec.submit('第一段');
+    spec.submit('第二段');
+
+    expect(await spec.finish(['第一段', '第二段', '最后']), isNull);
+    expect(calls.map((c) => c.$1), ['第一段']);
+  });
+
+  test('一段都没提前送、或分段对不上 → null', () async {
+    expect(await make().finish(['整段']), isNull);
+
+    final spec = make();
+    spec.submit('甲');
+    expect(await spec.finish(['乙', '丙']), isNull);
+  });
+
+  test('cancel 之后提交的段被忽略，finish 返回 null', () async {
+    final spec = make();
+    spec.cancel();
+    spec.submit('甲');
+    expect(spec.submittedCount, 0);
+    expect(await spec.finish(['甲']), isNull);
+    expect(calls, isEmpty);
+  });
+
+  group('LLMService 上下文注入', () {
+    setUpAll(() async {
+      SharedPreferences.setMockInitialValues({
+        'ai_correct_enabled': true,
+        'llm_base_url': 'https://api.test.com/v1',
+        'llm_provider_type': 'cloud',
+      });
+      await ConfigService().init();
+      await ConfigService().setLlmApiKey('test_key');
+    });
+
+    test('context 以 preceding_text 放在 speech_text 之前；不传时消息不变', () async {
+      final userMessages = <String>[];
+      LLMService().setClient(MockClient((request) async {
+        final body = jsonDecode(request.body) as Map<String, dynamic>;
+        userMessages.add((body['messages'] as List).last['content'] as String);
+        return http.Response(
+            jsonEncode({
+              'choices': [
+                {'message': {'content': '好'}}
+              ]
+            }),
+            200,
+            headers: {'content-type': 'application/json; charset=utf-8'});
+      }));
+
+      await LLMService().correctText('这一段', context: '上一段润色结果。');
+      await LLMService().correctText('这一段');
+
+      expect(userMessages[0],
+          startsWith('<preceding_text>\n上一段润色结果。\n</preceding_text>\n'));
+      expect(userMessages[0], contains('<speech_text>\n这一段\n</speech_text>'));
+      expect(userMessages[1], startsWith('<speech_text>'));
+      expect(userMessages.length, 2, reason: '上下文不同不能共用缓存');
+    });
+  });
+}
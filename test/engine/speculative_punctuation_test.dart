@@ -0,0 +1,114 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/speculative_punctuation.dart';
+
+/// 边说边加标点：预分段 / 流式停顿前的字幕说话期间就加好，松键后只补最后一段。
+void main() {
+  /// 记录每次送进标点模型的文本；假模型每 6 个字插一个「，」、结尾补「。」
+  late List<String> calls;
+  late String Function(String) model;
+
+  String chunked(String text) {
+    final parts = <String>[];
+    for (var i = 0; i < text.length; i += 6) {
+      parts.add(text.substring(i, i + 6 > text.length ? text.length : i + 6));
+    }
+    return '${parts.join('，')}。';
+  }
+
+  SpeculativePunctuator make() => SpeculativePunctuator((text) async {
+        calls.add(text);
+        return model(text);
+      });
+
+  setUp(() {
+    calls = [];
+    model = chunked;
+  });
+
+  test('每段带前文送进去、结果去掉前文；收尾只补最后一段', () async {
+    final punct = make();
+    punct.submit('今天天气很好');
+    punct.submit('我们去公园吧');
+    final text = await punct.finish('今天天气很好我们去公园吧然后吃饭');
+    expect(text, '今天天气很好。我们去公园吧。然后吃饭。');
+    expect(calls, ['今天天气很好', '今天天气很好我们去公园吧', '今天天气很好我们去公园吧然后吃饭']);
+    expect(punct.submittedCount, 2);
+  });
+
+  test('前文只带最后 contextChars 个字', () async {
+    final punct = SpeculativePunctuator((text) async {
+      calls.add(text);
+      return '$text。';
+    }, contextChars: 4);
+    punct.submit('一二三四五六七八');
+    punct.submit('九十');
+    await punct.finish('一二三四五六七八九十');
+    expect(calls.last, '五六七八九十');
+  });
+
+  test('最终文本不是以提前送的段开头（被润色 / 词库改过）→ null，调用方整段加', () async {
+    final punct = make();
+    punct.submit('今天天气很好');
+    expect(await punct.finish('今天天气真好我们去公园吧'), isNull);
+  });
+
+  test('一段都没提前送 → null', () async {
+    expect(await make().finish('今天天气很好'), isNull);
+  });
+
+  test('流式：按整段字幕提交新增部分，英文词间空格保留', () async {
+    model = (text) => '$text.';
+    final punct = make();
+    punct.submitUpTo('hello world');
+    punct.submitUpTo('hello world how are you');
+    final text = await punct.finish('hello world how are you today');
+    expect(calls[1], 'hello world how are you');
+    expect(text, 'hello world. how are you. today.');
+  });
+
+  test('离线预分段：英文按 joinDecodedText 的拼法对前缀，走提前加好的段', () async {
+    model = (text) => '$text.';
+    final punct = make();
+    punct.submit('hello world');
+    punct.submit('how are you');
+    final text = await punct.finish('hello world how are you today');
+    expect(text, 'hello world. how are you. today.');
+    expect(calls, hasLength(3));
+    expect(calls[1], 'hello world how are you', reason: '前文和这一段之间的空格要带上');
+    expect(calls, isNot(contains('hello world how are you today')),
+        reason: '没有退回整段加标点');
+  });
+
+  test('流式：前面已提交的字幕被改写就不提交这一段', () async {
+    final punct = make();
+    punct.submitUpTo('今天天气');
+    punct.submitUpTo('今天天汽很好');
+    expect(punct.submittedCount, 1);
+  });
+
+  test('带前文的结果对不上前文（模型改了字）→ 退回这一段单独加', () async {
+    final punct = make();
+    punct.submit('今天天气很好');
+    model = (text) => chunked(text.replaceAll('很', '狠'));
+    punct.submit('我们去公园吧');
+    final text = await punct.finish('今天天气很好我们去公园吧');
+    expect(calls.last, '我们去公园吧');
+    expect(text, '今天天气很好。我们去公园吧。');
+  });
+
+  test('stripContext：跳过插入的标点和空格、前文后的标点归上一段', () {
+    expect(SpeculativePunctuator.stripContext('今天，天气很好，我们走。', '今天天气很好'), '我们走。');
+    expect(SpeculativePunctuator.stripContext('Hello world, how are you?', 'hello world'), 'how are you?');
+    expect(SpeculativePunctuator.stripContext('今天天气', '今天天气很好'), isNull);
+    expect(SpeculativePunctuator.stripContext('明天天气很好我们走', '今天天气很好'), isNull);
+  });
+
+  test('cancel 之后不再提交，finish 返回 null', () async {
+    final punct = make();
+    punct.submit('今天天气很好');
+    punct.cancel();
+    punct.submit('我们去公园吧');
+    expect(punct.submittedCount, 1);
+    expect(await punct.finish('今天天气很好我们去公园吧'), isNull);
+  });
+}
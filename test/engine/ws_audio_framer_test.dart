@@ -0,0 +1,86 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:speakout/engine/providers/ws_audio_framer.dart';
+
+void main() {
+  /// 每字节写自己的序号（mod 256），拼回来能直接核对顺序和完整性
+  Uint8List pcm(int start, int length) =>
+      Uint8List.fromList([for (var i = 0; i < length; i++) (start + i) & 0xFF]);
+
+  group('WsAudioFramer', () {
+    test('50ms 小块攒成 200ms 一帧，字节顺序不乱', () {
+      final frames = <Uint8List>[];
+      final framer = WsAudioFramer(frameMs: 200, emit: (f, n, last) {
+        expect(n, f.length);
+        expect(last, isFalse);
+        frames.add(f);
+      });
+      expect(framer.frameBytes, 6400);
+
+      // 1 秒语音 = 20 块 × 1600 字节
+      for (var i = 0; i < 20; i++) {
+        framer.add(pcm(i * 1600, 1600));
+      }
+      expect(frames.length, 5);
+      expect(frames.expand((f) => f).toList(), pcm(0, 32000));
+    });
+
+    test('协议头预留在帧开头，尾巴 flush 出的帧长度刚好', () {
+      final frames = <(Uint8List, int, bool)>[];
+      final framer = WsAudioFramer(
+          frameMs: 100, headerBytes: 8, emit: (f, n, last) => frames.add((f, n, last)));
+
+      framer.add(pcm(0, 4000));
+      expect(frames.length, 1);
+      final (full, n, last) = frames.single;
+      expect(full.length, 8 + 3200);
+      expect(n, 3200);
+      expect(last, isFalse);
+      expect(full.sublist(8), pcm(0, 3200));
+
+      framer.flush(isLast: true);
+      final (tail, tailN, tailLast) = frames.last;
+      expect(tail.length, 8 + 800);
+      expect(tailN, 800);
+      expect(tailLast, isTrue);
+      expect(tail.sublist(8), pcm(3200, 800));
+    });
+
+    test('没有尾巴时：flush() 不发，flush(isLast) 发一个只有头的结束帧', () {
+      final frames = <(Uint8List, int, bool)>[];
+      final framer = WsAudioFramer(
+          frameMs: 100, headerBytes: 8, emit: (f, n, last) => frames.add((f, n, last)));
+      framer.flush();
+      expect(frames, isEmpty);
+      framer.flush(isLast: true);
+      expect(frames.single.$1.length, 8);
+      expect(frames.single.$2, 0);
+      expect(frames.single.$3, isTrue);
+    });
+
+    test('无协议头且块够一整帧：直接切视图发出，不拷贝', () {
+      final frames = <Uint8List>[];
+      final framer = WsAudioFramer(frameMs: 40, emit: (f, _, __) => frames.add(f));
+      final chunk = pcm(0, 1600); // 50ms，切成 40ms + 10ms 尾巴
+      framer.add(chunk);
+
+      expect(frames.length, 1);
+      expect(frames.single.buffer, same(chunk.buffer));
+      expect(framer.bytesCopied, 320, reason: '只有凑不满一帧的尾巴需要拷贝');
+
+      framer.add(pcm(1600, 1600));
+      expect(frames.length, 2);
+      expect(frames.expand((f) => f).toList(), pcm(0, 2560));
+    });
+
+    test('reset 丢掉上一会话没发出的尾巴', () {
+      final frames = <Uint8List>[];
+      final framer = WsAudioFramer(frameMs: 100, emit: (f, _, __) => frames.add(f));
+      framer.add(pcm(0, 1000));
+      framer.reset();
+      framer.add(pcm(50, 3200));
+      expect(frames.single, pcm(50, 3200));
+    });
+  });
+}
@@ -0,0 +1,218 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/engine/providers/volcengine_asr_provider.dart';
+import 'package:speakout/engine/providers/ws_warm_pool.dart';
+import 'package:speakout/services/config_service.dart';
+
+/// 流式云端 ASR 的预热连接：对着一个本地的火山协议替身服务跑。
+///
+/// 替身只做最少的事：数连接数、累计收到的音频字节，收到最后一帧时
+/// 回一个带 sequence 的 0x9 响应帧（is_end=true），文本里带上字节数，
+/// 这样「建连前攒下的音频有没有补发」能直接从结果里看出来。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  late HttpServer server;
+  late String endpoint;
+  var connections = 0;
+  var closedByClient = 0;
+  var closeOnConnect = false;
+  var audioMessages = 0;
+
+  Uint8List responseFrame(Map<String, dynamic> json) {
+    final payload = utf8.encode(jsonEncode(json));
+    final frame = ByteData(12 + payload.length)
+      ..setUint8(0, 0x11)
+      ..setUint8(1, 0x91) // msgType=9, flags bit0 = 带 sequence
+      ..setUint8(2, 0x10)
+      ..setUint32(4, 1)
+      ..setUint32(8, payload.length);
+    final bytes = frame.buffer.asUint8List();
+    bytes.setRange(12, bytes.length, payload);
+    return bytes;
+  }
+
+  setUpAll(() async {
+    // 测试绑定默认把 HttpClient 全拦成 400，这里要连真的本地端口
+    HttpOverrides.global = null;
+    server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    endpoint = 'ws://${server.address.address}:${server.port}/';
+    server.listen((request) async {
+      connections++;
+      final ws = await WebSocketTransformer.upgrade(request);
+      if (closeOnConnect) {
+        await ws.close();
+        return;
+      }
+      var audioBytes = 0;
+      ws.listen((data) {
+        final bytes = Uint8List.fromList(data as List<int>);
+        final msgType = bytes[1] >> 4;
+        final flags = bytes[1] & 0xF;
+        final size = ByteData.sublistView(bytes, 4, 8).getUint32(0);
+        if (msgType != 0x2) return; // FullClientRequest 不计
+        audioMessages++;
+        audioBytes += size;
+        if (flags & 0x2 != 0) {
+          ws.add(responseFrame({
+            'result': {'text': '收到$audioBytes字节'},
+            'is_end': true,
+          }));
+        }
+      }, onDone: () => closedByClient++);
+    });
+
+    SharedPreferences.setMockInitialValues({});
+    await ConfigService().init();
+  });
+
+  tearDownAll(() => server.close(force: true));
+
+  setUp(() {
+    connections = 0;
+    closedByClient = 0;
+    closeOnConnect = false;
+    audioMessages = 0;
+  });
+
+  Future<void> waitFor(bool Function() cond) async {
+    for (var i = 0; i < 200 && !cond(); i++) {
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+    expect(cond(), isTrue);
+  }
+
+  Future<VolcengineASRProvider> makeProvider() async {
+    final p = VolcengineASRProvider();
+    await p.initialize({'apiKey': 'k', 'endpoint': endpoint});
+    return p;
+  }
+
+  group('VolcengineASRProvider', () {
+    test('initialize 就建好连接，start() 直接用；stop 后再备下一条', () async {
+      final p = await makeProvider();
+      await waitFor(() => connections == 1);
+
+      await p.start();
+      p.acceptWaveform(Float32List(160));
+      final result = await p.stop();
+
+      expect(result.text, '收到320字节');
+      expect(p.warmHits, 1);
+      expect(p.coldConnects, 0);
+      expect(p.lastHandshake, isNotNull);
+
+      await waitFor(() => connections == 2);
+      await p.start();
+      p.acceptWaveform(Float32List(80));
+      expect((await p.stop()).text, '收到160字节');
+      expect(p.warmHits, 2);
+      await p.dispose();
+    });
+
+    test('连接还没好就开始说话：攒着的音频接上后全部补发', () async {
+      final p = await makeProvider();
+      // 不等预热完成，直接开录
+      await p.start();
+      for (var i = 0; i < 5; i++) {
+        p.acceptWaveform(Float32List(100));
+      }
+      expect((await p.stop()).text, '收到1000字节');
+      await p.dispose();
+    });
+
+    test('50ms 一块的音频攒成 200ms 一包发，尾巴随结束帧带出', () async {
+      final p = await makeProvider();
+      await waitFor(() => connections == 1);
+      await p.start();
+      // 1.05 秒：21 块 × 50ms
+      for (var i = 0; i < 21; i++) {
+        p.acceptPcm16(Uint8List(1600));
+        await Future<void>.delayed(Duration.zero);
+      }
+      expect((await p.stop()).text, '收到33600字节');
+      expect(audioMessages, 6, reason: '5 个整包 + 1 个带 50ms 尾巴的结束帧（原先是 21 + 1）');
+      await p.dispose();
+    });
+
+    test('预热失败（对端拒绝）→ start() 现连，识别照常', () async {
+      closeOnConnect = true;
+      final p = await makeProvider();
+      await waitFor(() => connections == 1);
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+      closeOnConnect = false;
+
+      await p.start();
+      p.acceptWaveform(Float32List(10));
+      expect((await p.stop()).text, '收到20字节');
+      expect(p.coldConnects, 1);
+      await p.dispose();
+    });
+  });
+
+  group('WsWarmPool', () {
+    test('过了续备期限：备用连接闲置超时后自己关掉，下次退回现连', () async {
+      final pool = WsWarmPool(() => WebSocket.connect(endpoint),
+          tag: 'test', idleTimeout: const Duration(milliseconds: 50), keepAlive: Duration.zero);
+      pool.prewarm();
+      await waitFor(() => closedByClient == 1);
+
+      final socket = await pool.acquire();
+      expect(socket.warm, isFalse);
+      expect(pool.coldConnects, 1);
+      expect(pool.warmHits, 0);
+      expect(connections, 2);
+      await socket.close();
+      await pool.dispose();
+    });
+
+    test('说一句、停过闲置超时、再说：续备期内换了新连接，第二句仍是热的', () async {
+      final pool = WsWarmPool(() => WebSocket.connect(endpoint),
+          tag: 'test', idleTimeout: const Duration(milliseconds: 200));
+      pool.prewarm(); // 上一句 stop 之后
+      await waitFor(() => closedByClient == 1);
+      await waitFor(() => connections == 2);
+
+      final socket = await pool.acquire();
+      expect(socket.warm, isTrue);
+      expect(pool.warmHits, 1);
+      expect(pool.coldConnects, 0);
+      expect(connections, 2, reason: '取用时不该再现连');
+      await socket.close();
+      await pool.dispose();
+    });
+
+    test('指纹变了（如切换语言）→ 备用连接作废', () async {
+      var lang = 'zh';
+      final pool = WsWarmPool(() => WebSocket.connect(endpoint),
+          tag: 'test', fingerprint: () => lang);
+      pool.prewarm();
+      await waitFor(() => connections == 1);
+
+      lang = 'en';
+      final socket = await pool.acquire();
+      expect(pool.coldConnects, 1);
+      expect(pool.warmHits, 0);
+      await waitFor(() => closedByClient == 1);
+      await socket.close();
+      await pool.dispose();
+    });
+
+    test('dispose 关掉备用连接，之后 prewarm 不再建连', () async {
+      final pool = WsWarmPool(() => WebSocket.connect(endpoint), tag: 'test');
+      pool.prewarm();
+      await waitFor(() => connections == 1);
+      await pool.dispose();
+      await waitFor(() => closedByClient == 1);
+
+      pool.prewarm();
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+      expect(connections, 1);
+    });
+  });
+}
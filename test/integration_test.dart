@@ -1,6 +1,7 @@
 import 'package:flutter_test/flutter_test.dart';
 import 'package:speakout/engine/asr_provider.dart';
 import 'package:speakout/engine/asr_result.dart';
+import 'package:speakout/engine/pcm16.dart';
 import 'dart:typed_data';
 import 'dart:async';
 import 'package:speakout/config/app_constants.dart';
@@ -38,6 +39,16 @@ class FakeASRProvider implements ASRProvider {
     }
   }
 
+  @override
+  void acceptEncoded(Uint8List bytes) =>
+      throw UnsupportedError('$type does not accept encoded audio');
+
+  @override
+  AudioSampleFormat get preferredFormat => AudioSampleFormat.float32;
+
+  @override
+  void acceptPcm16(Uint8List pcm) => acceptWaveform(pcm16ToFloat32(pcm));
+
   @override
   Duration get stopTimeout => AppConstants.kAsrStopTimeout;
 
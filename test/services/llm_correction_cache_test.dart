@@ -0,0 +1,191 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:http/http.dart' as http;
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/services/config_service.dart';
+import 'package:speakout/services/llm_correction_cache.dart';
+import 'package:speakout/services/llm_service.dart';
+
+import '../helpers/test_helpers.dart';
+
+/// 润色缓存：对着一个本地的 OpenAI 兼容替身服务器跑，数它收到几次请求。
+///
+/// 命中 = 不发请求；换了词库 / 翻译目标 / 模型 = 新 key；失败结果不缓存。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  late HttpServer server;
+  late Directory tmp;
+  var requestCount = 0;
+  var failNext = false;
+
+  setUpAll(() async {
+    // 测试绑定默认把 HttpClient 全拦成 400，这里要连真的本地端口
+    HttpOverrides.global = null;
+    server = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+    server.listen((request) async {
+      requestCount++;
+      final body = jsonDecode(await utf8.decodeStream(request)) as Map<String, dynamic>;
+      final user = (body['messages'] as List).last['content'] as String;
+      final speech = RegExp(r'<speech_text>\n([\s\S]*?)\n</speech_text>').firstMatch(user)!.group(1)!;
+      final reply = '润色#$requestCount:$speech';
+      if (failNext) {
+        failNext = false;
+        request.response.statusCode = 500;
+        request.response.write('boom');
+      } else if (body['stream'] == true) {
+        request.response.headers.contentType = ContentType('text', 'event-stream');
+        for (final piece in [reply.substring(0, 3), reply.substring(3)]) {
+          request.response.write('data: ${jsonEncode({
+                'choices': [
+                  {'delta': {'content': piece}}
+                ]
+              })}\n\n');
+        }
+        request.response.write('data: [DONE]\n\n');
+      } else {
+        request.response.headers.contentType = ContentType.json;
+        request.response.write(jsonEncode({
+          'choices': [
+            {'message': {'content': reply}}
+          ]
+        }));
+      }
+      await request.response.close();
+    });
+
+    SharedPreferences.setMockInitialValues({
+      'ai_correct_enabled': true,
+      'llm_provider_type': 'cloud',
+    });
+    await ConfigService().init();
+    await ConfigService().setLlmApiKey('test_key');
+    await ConfigService().setLlmBaseUrl('http://${server.address.address}:${server.port}/v1');
+    await ConfigService().setLlmModel('stand-in-model');
+  });
+
+  tearDownAll(() => server.close(force: true));
+
+  late LLMService service;
+  late File cacheFile;
+
+  setUp(() async {
+    tmp = createTempDir('llm_cache');
+    cacheFile = File('${tmp.path}/llm_cache.json');
+    requestCount = 0;
+    await ConfigService().setLlmCacheEnabled(true);
+    service = LLMService()
+      ..setClient(http.Client())
+      ..setCorrectionCache(LlmCorrectionCache(file: cacheFile));
+  });
+  tearDown(() => cleanupTempDir(tmp));
+
+  test('同一句第二次命中缓存：不发请求，结果一致，算成功', () async {
+    final first = await service.correctText('好的 收到');
+    expect(requestCount, 1);
+
+    final second = await service.correctText('  好的   收到 ');
+    expect(requestCount, 1, reason: '空白差异不该错过命中');
+    expect(second, first);
+    expect(service.lastCallSucceeded, isTrue);
+    expect(service.correctionCache.hits, 1);
+    expect(service.correctionCache.misses, 1);
+  });
+
+  test('词库提示 / 翻译目标 / 模型任一不同都是新 key', () async {
+    await service.correctText('收到');
+    await service.correctText('收到', vocabHints: ['Flutter']);
+    await service.correctText('收到', translateTo: 'en');
+    await ConfigService().setLlmModel('another-model');
+    await service.correctText('收到');
+    await ConfigService().setLlmModel('stand-in-model');
+    expect(requestCount, 4);
+
+    await service.correctText('收到', vocabHints: ['Flutter']);
+    expect(requestCount, 4);
+  });
+
+  test('bypassCache 既不读也不写；关掉开关同样直连', () async {
+    await service.correctText('好的');
+    await service.correctText('好的', bypassCache: true);
+    expect(requestCount, 2);
+
+    await ConfigService().setLlmCacheEnabled(false);
+    await service.correctText('好的');
+    expect(requestCount, 3);
+  });
+
+  test('失败时返回的原文不进缓存', () async {
+    failNext = true;
+    expect(await service.correctText('好的'), '好的');
+    expect(service.lastCallSucceeded, isFalse);
+
+    await service.correctText('好的');
+    expect(requestCount, 2, reason: '上次失败，这次必须真的去请求');
+  });
+
+  test('流式与非流式共用缓存；流式结果也会写入', () async {
+    final streamed = (await service.correctTextStream('没问题').toList()).join();
+    expect(requestCount, 1);
+    expect(await service.correctText('没问题'), streamed);
+
+    final cached = await service.correctTextStream('没问题').toList();
+    expect(cached, [streamed], reason: '命中时整段一次吐出');
+    expect(requestCount, 1);
+  });
+
+  test('长句不缓存', () async {
+    final long = '这是一段很长的口述' * 10;
+    await service.correctText(long);
+    await service.correctText(long);
+    expect(requestCount, 2);
+  });
+
+  test('写盘后新实例能读回（重启后继续命中）', () async {
+    final first = await service.correctText('辛苦了');
+    await service.correctionCache.flush();
+
+    service.setCorrectionCache(LlmCorrectionCache(file: cacheFile));
+    expect(await service.correctText('辛苦了'), first);
+    expect(requestCount, 1);
+  });
+
+  group('LlmCorrectionCache', () {
+    test('超过上限淘汰最久未用的', () async {
+      final cache = LlmCorrectionCache(file: cacheFile, maxEntries: 2);
+      await cache.put('a', 'A');
+      await cache.put('b', 'B');
+      expect(await cache.get('a'), 'A'); // a 变成最近使用
+      await cache.put('c', 'C');
+
+      expect(await cache.get('b'), isNull);
+      expect(await cache.get('a'), 'A');
+      expect(await cache.get('c'), 'C');
+      expect(cache.evictions, 1);
+    });
+
+    test('过期条目视为未命中，重新加载时也会丢掉', () async {
+      var now = DateTime(2026, 1, 1);
+      LlmCorrectionCache make() => LlmCorrectionCache(
+          file: cacheFile, ttl: const Duration(days: 7), clock: () => now);
+
+      final cache = make();
+      await cache.put('k', 'v');
+      await cache.flush();
+
+      now = now.add(const Duration(days: 8));
+      expect(await make().get('k'), isNull);
+      expect(await cache.get('k'), isNull);
+    });
+
+    test('缓存文件损坏 → 当空缓存，不抛', () async {
+      cacheFile.writeAsStringSync('{not json');
+      final cache = LlmCorrectionCache(file: cacheFile);
+      expect(await cache.get('k'), isNull);
+      await cache.put('k', 'v');
+      expect(await cache.get('k'), 'v');
+    });
+  });
+}
@@ -48,6 +48,32 @@ void main() {
       expect(result, "Dirty Text");
     });
 
+    test('并发调用各自的 LlmCallStatus 不互相覆盖', () async {
+      // 慢的那句失败、快的那句成功；快的先回来，慢的后回来也改不动快的那份
+      final mockClient = MockClient((request) async {
+        if (request.body.contains('slow')) {
+          await Future<void>.delayed(const Duration(milliseconds: 30));
+          return http.Response('Error', 500);
+        }
+        return http.Response('{"choices": [{"message": {"content": "Fast done"}}]}', 200);
+      });
+      service.setClient(mockClient);
+
+      final slow = LlmCallStatus();
+      final fast = LlmCallStatus();
+      final results = await Future.wait([
+        service.correctText('slow input', status: slow, bypassCache: true),
+        service.correctText('fast input', status: fast, bypassCache: true),
+      ]);
+      expect(results, ['slow input', 'Fast done']);
+      expect(slow.succeeded, isFalse);
+      expect(fast.succeeded, isTrue);
+
+      final streamStatus = LlmCallStatus();
+      await service.correctTextStream('slow stream', status: streamStatus, bypassCache: true).toList();
+      expect(streamStatus.succeeded, isFalse);
+    });
+
     test('correctText skips if disabled', () async {
       await ConfigService().setAiCorrectionEnabled(false);
 
@@ -99,16 +99,10 @@ void main() {
         const VocabEntry(wrong: 'AAA', correct: 'BBB'),
         const VocabEntry(wrong: 'BBB', correct: 'CCC'),
       ]);
-      // Note: String.replaceAll is sequential, so AAA→BBB first, then BBB→CCC
-      // The black-box test expects no chain, but implementation uses sequential replaceAll.
-      // This test documents the actual expected behavior based on requirements.
+      // 需求：「替换是一次性的，非递归」。原实现逐条 replaceAll 会链成 CCC；
+      // 改为单遍自动机后替换结果不再参与匹配，收紧为只接受 BBB。
       final result = service.applyReplacements('文本含AAA');
-      // Requirements say "替换是一次性的，非递归" but implementation does sequential replaceAll.
-      // This test captures the actual behavior for discussion.
-      // If chain happens: AAA→BBB→CCC = "文本含CCC"
-      // If no chain: AAA→BBB = "文本含BBB"
-      // We record what actually happens to flag this as a potential issue.
-      expect(result, anyOf('文本含BBB', '文本含CCC'));
+      expect(result, '文本含BBB');
     });
 
     // TC-045: Case-sensitive replacement
@@ -0,0 +1,120 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:path_provider_platform_interface/path_provider_platform_interface.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/engine/providers/sherpa_provider.dart';
+import 'package:speakout/services/config_service.dart';
+import 'package:speakout/services/vocab_service.dart';
+
+import '../helpers/test_helpers.dart';
+
+/// 词库 → sherpa 热词：按模型词表切分、切不出的丢弃、按内容缓存复用。
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  // 双语 zipformer 的词表形态：中文单字 + 大写 BPE 子词（词首带 ▁）
+  const tokensTxt = '<blk> 0\n'
+      '深 1\n度 2\n学 3\n习 4\n模 5\n型 6\n'
+      '▁KUBER 7\nNETES 8\n▁FL 9\nUT 10\nTER 11\n▁ 12\nK 13\n8 14\nS 15\n';
+
+  group('tokenizeHotword', () {
+    final tokens = VocabService.parseTokens(tokensTxt);
+
+    test('解析 tokens.txt：取最后一个空格前的部分', () {
+      expect(tokens, containsAll(['<blk>', '深', '▁KUBER', 'NETES', '▁']));
+      expect(tokens.contains('0'), isFalse);
+    });
+
+    test('中文按字切', () {
+      expect(VocabService.tokenizeHotword('深度学习', tokens), '深 度 学 习');
+    });
+
+    test('英文贪心最长匹配，小写术语回退到大写词表', () {
+      expect(VocabService.tokenizeHotword('Kubernetes', tokens), '▁KUBER NETES');
+      expect(VocabService.tokenizeHotword('Flutter', tokens), '▁FL UT TER');
+    });
+
+    test('中英混排、词首单独切出 ▁', () {
+      expect(VocabService.tokenizeHotword('Flutter模型', tokens), '▁FL UT TER 模 型');
+      expect(VocabService.tokenizeHotword('k8s', tokens), '▁ K 8 S');
+    });
+
+    test('含词表外字符 → null（整条丢弃，不能让识别器创建失败）', () {
+      expect(VocabService.tokenizeHotword('机器学习', tokens), isNull);
+      expect(VocabService.tokenizeHotword('Docker', tokens), isNull);
+    });
+  });
+
+  group('compileHotwords', () {
+    late Directory tmp;
+    late Directory modelDir;
+
+    setUpAll(() async {
+      SharedPreferences.setMockInitialValues({});
+      await ConfigService().init();
+      await ConfigService().setVocabUserEnabled(true);
+    });
+
+    setUp(() {
+      tmp = createTempDir('hotwords');
+      PathProviderPlatform.instance = MockPathProviderPlatform(tmp.path);
+      modelDir = Directory('${tmp.path}/model')..createSync();
+      File('${modelDir.path}/tokens.txt').writeAsStringSync(tokensTxt);
+    });
+    tearDown(() => cleanupTempDir(tmp));
+
+    Future<void> setEntries(List<VocabEntry> entries) =>
+        ConfigService().setVocabUserEntriesJson(
+            jsonEncode(entries.map((e) => e.toJson()).toList()));
+
+    test('写出可切分的术语，丢掉切不出的；命中判断只认编进去的', () async {
+      await setEntries(const [
+        VocabEntry(wrong: '深度学系', correct: '深度学习'),
+        VocabEntry(wrong: '酷伯内提斯', correct: 'Kubernetes'),
+        VocabEntry(wrong: '刀克', correct: 'Docker'),
+      ]);
+      final path = await VocabService().compileHotwords(modelDir.path);
+      expect(path, isNotNull);
+      expect(File(path!).readAsLinesSync()..sort(), ['▁KUBER NETES', '深 度 学 习']);
+
+      expect(VocabService().containsHotword('我们在学深度学习'), isTrue);
+      expect(VocabService().containsHotword('用Docker部署'), isFalse,
+          reason: 'Docker 没进热词，解码器没偏置过，不能走捷径');
+    });
+
+    test('词库不变复用同一文件，改了才重编', () async {
+      await setEntries(const [VocabEntry(wrong: '深度学系', correct: '深度学习')]);
+      final first = await VocabService().compileHotwords(modelDir.path);
+      // 手动改一下内容：复用的话不会被覆盖回去
+      File(first!).writeAsStringSync('深 度 学 习\n');
+      final again = await VocabService().compileHotwords(modelDir.path);
+      expect(again, first);
+      expect(File(again!).readAsStringSync(), '深 度 学 习\n');
+
+      await setEntries(const [
+        VocabEntry(wrong: '深度学系', correct: '深度学习'),
+        VocabEntry(wrong: '模性', correct: '模型'),
+      ]);
+      final changed = await VocabService().compileHotwords(modelDir.path);
+      expect(changed, isNot(first));
+      expect(VocabService().containsHotword('模型'), isTrue);
+    });
+
+    test('没有 tokens.txt 或没有可用术语 → null，且不残留旧的命中集合', () async {
+      await setEntries(const [VocabEntry(wrong: '深度学系', correct: '深度学习')]);
+      await VocabService().compileHotwords(modelDir.path);
+      expect(VocabService().containsHotword('深度学习'), isTrue);
+
+      File('${modelDir.path}/tokens.txt').deleteSync();
+      expect(await VocabService().compileHotwords(modelDir.path), isNull);
+      expect(VocabService().containsHotword('深度学习'), isFalse);
+    });
+  });
+
+  test('只有 zipformer（transducer + beam search）声明支持热词', () {
+    expect(SherpaProvider.supportsHotwords('zipformer'), isTrue);
+    expect(SherpaProvider.supportsHotwords('paraformer'), isFalse);
+  });
+}
@@ -0,0 +1,131 @@
+import 'dart:convert';
+import 'dart:math';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+import 'package:speakout/services/config_service.dart';
+import 'package:speakout/services/vocab_matcher.dart';
+import 'package:speakout/services/vocab_service.dart';
+
+/// 逐位置取最长命中的朴素实现 —— 语义的参照物，不追求速度
+String _reference(List<(String, String)> pairs, String text) {
+  final map = <String, String>{};
+  for (final (w, c) in pairs) {
+    if (w.isNotEmpty && c.isNotEmpty) map[w] = c;
+  }
+  final out = StringBuffer();
+  var i = 0;
+  while (i < text.length) {
+    String? best;
+    for (final w in map.keys) {
+      if (text.startsWith(w, i) && (best == null || w.length > best.length)) {
+        best = w;
+      }
+    }
+    if (best != null) {
+      out.write(map[best]);
+      i += best.length;
+    } else {
+      out.write(text[i]);
+      i++;
+    }
+  }
+  return out.toString();
+}
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  group('VocabMatcher 语义', () {
+    String run(List<(String, String)> pairs, String text) =>
+        VocabMatcher.build(pairs).apply(text);
+
+    test('同起点取最长', () {
+      expect(run([('机器学系', '机器学习'), ('机器学系统', '机器学习系统')], '机器学系统很大'),
+          '机器学习系统很大');
+    });
+
+    test('重叠时起点靠左的优先，被压住的让位', () {
+      // 'abc' 从 0 起，'bcd' 从 1 起 —— 取 abc，剩下的 'd' 原样保留
+      expect(run([('abc', 'X'), ('bcd', 'Y')], 'abcd'), 'Xd');
+    });
+
+    test('替换结果不参与再匹配（不链式）', () {
+      expect(run([('AAA', 'BBB'), ('BBB', 'CCC')], 'AAA BBB'), 'BBB CCC');
+    });
+
+    test('同一 wrong 后加入的覆盖先加入的', () {
+      expect(run([('k8s', 'K8s'), ('k8s', 'Kubernetes')], '用k8s'), '用Kubernetes');
+    });
+
+    test('correct 为空的词条跳过；无命中原样返回同一个字符串', () {
+      final m = VocabMatcher.build([('嗯', '')]);
+      expect(m.isEmpty, isTrue);
+      const text = '嗯我觉得';
+      expect(identical(m.apply(text), text), isTrue);
+    });
+
+    test('失败链上的短词条不会漏：she/he/hers', () {
+      expect(run([('he', '1'), ('she', '2'), ('hers', '3')], 'ushers'), 'u2rs');
+      expect(run([('he', '1'), ('hers', '3')], 'ushers'), 'us3');
+    });
+
+    test('emoji 与代理对不受影响', () {
+      expect(run([('开心', '快乐')], '😀开心😀'), '😀快乐😀');
+    });
+  });
+
+  test('10k 词条：与朴素参照实现逐句一致', () {
+    final rnd = Random(42);
+    const alphabet = '的一是不了人我在有他这中大来上个国和到说时要就出也';
+    String word(int minLen, int maxLen) => String.fromCharCodes(List.generate(
+        minLen + rnd.nextInt(maxLen - minLen + 1),
+        (_) => alphabet.codeUnitAt(rnd.nextInt(alphabet.length))));
+
+    final pairs = List.generate(10000, (i) => (word(2, 6), 'T$i'));
+    final matcher = VocabMatcher.build(pairs);
+    // 参照实现是 O(词条×文本)，只抽一部分词条比对，否则测试本身就要跑几分钟
+    final sample = pairs.take(300).toList();
+    final small = VocabMatcher.build(sample);
+    for (var k = 0; k < 200; k++) {
+      final text = word(20, 80);
+      expect(small.apply(text), _reference(sample, text), reason: text);
+    }
+    // 全量自动机至少要能处理长文本且产出确定
+    final long = word(5000, 5000);
+    expect(matcher.apply(long), matcher.apply(long));
+  });
+
+  group('VocabService 接入', () {
+    setUpAll(() async {
+      SharedPreferences.setMockInitialValues({});
+      await ConfigService().init();
+    });
+
+    Future<void> setEntries(List<VocabEntry> entries) =>
+        ConfigService().setVocabUserEntriesJson(
+            jsonEncode(entries.map((e) => e.toJson()).toList()));
+
+    test('绕过 addUserEntry 直接改配置（导入/设置页）也能生效', () async {
+      await ConfigService().setVocabUserEnabled(true);
+      await setEntries([const VocabEntry(wrong: '福拉特', correct: 'Flutter')]);
+      expect(VocabService().applyReplacements('用福拉特写'), '用Flutter写');
+
+      await setEntries([const VocabEntry(wrong: '福拉特', correct: 'FLUTTER')]);
+      expect(VocabService().applyReplacements('用福拉特写'), '用FLUTTER写');
+
+      await ConfigService().setVocabUserEnabled(false);
+      expect(VocabService().applyReplacements('用福拉特写'), '用福拉特写');
+      await ConfigService().setVocabUserEnabled(true);
+    });
+
+    test('addUserEntry / deleteUserEntry 后立即反映', () async {
+      await setEntries([]);
+      final service = VocabService();
+      await service.addUserEntry(const VocabEntry(wrong: '深度学系', correct: '深度学习'));
+      expect(service.applyReplacements('深度学系'), '深度学习');
+      await service.deleteUserEntry(0);
+      expect(service.applyReplacements('深度学系'), '深度学系');
+    });
+  });
+}